@@ -11,6 +11,7 @@
  */
 #include <deca_device_api.h>
 #include <mac_802_15_4.h>
+#include <prof.h>
 #include <string.h>
 
 dwt_mic_size_e dwt_mic_size_from_bytes(uint8_t mic_size_in_bytes);
@@ -221,7 +222,9 @@ aes_results_e rx_aes_802_15_4(mac_frame_802_15_4_format_t *mac_frame_ptr, uint16
         dwt_set_keyreg_128(&aes_key_ptr[MAC_FRAME_AUX_KEY_IDENTIFY_802_15_4(mac_frame_ptr) - 1]);
 
         /* perform the decryption job, the unencrypted payload will be stored in aes_job->payload */
+        PROF_START(PROF_MAC_AES);
         status = dwt_do_aes(aes_job, aes_config->aes_core_type);
+        PROF_STOP(PROF_MAC_AES);
 
         /* "status" represents a last read of AES_STS_ID register.
          * See DW3000 User Manual for details.
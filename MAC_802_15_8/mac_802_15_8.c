@@ -1,4 +1,5 @@
 #include <mac_802_15_8.h>
+#include <prof.h>
 #include <string.h>
 
 /* @fn      rx_aes_802_15_8
@@ -40,7 +41,9 @@ aes_results_e rx_aes_802_15_8(uint16_t frame_length, dwt_aes_job_t *aes_job, uin
         aes_job->payload_len = payload_len;
         aes_job->header = NULL;
         aes_job->payload = payload;
+        PROF_START(PROF_MAC_AES);
         status = dwt_do_aes(aes_job, core_type); // After this command, payload will contain the received data
+        PROF_STOP(PROF_MAC_AES);
 
         /* "status" represents a last read of AES_STS_ID register.
          * See DW3000 User Manual for details.
@@ -10,7 +10,29 @@ for ex in \
 	AES_SS_TWR_INITIATOR AES_SS_TWR_RESPONDER DS_TWR_INITIATOR DS_TWR_RESPONDER \
 	DS_TWR_RESPONDER_STS DS_TWR_INITIATOR_STS DS_TWR_STS_SDC_INITIATOR DS_TWR_STS_SDC_RESPONDER \
 	CONTINUOUS_WAVE CONTINUOUS_FRAME ACK_DATA_RX ACK_DATA_TX GPIO SIMPLE_TX_STS_SDC SIMPLE_RX_STS_SDC \
-	ACK_DATA_RX_DBL_BUFF SPI_CRC SIMPLE_RX_PDOA OTP_WRITE LE_PEND_TX LE_PEND_RX:
+	ACK_DATA_RX_DBL_BUFF SPI_CRC SIMPLE_RX_PDOA OTP_WRITE LE_PEND_TX LE_PEND_RX \
+	ANT_DELAY_CAL \
+	CIR_CAPTURE \
+	TWR_BENCH_INITIATOR \
+	TWR_BENCH_RESPONDER \
+	SPI_BENCH \
+	SS_TWR_RESPONDER_EVT \
+	SS_TWR_RESPONDER_SNIFF \
+	SS_TWR_INITIATOR_SCHED \
+	SIMPLE_RX_MULTI \
+	SS_TWR_INITIATOR_AOA \
+	SS_TWR_RESPONDER_AOA \
+	SS_TWR_INITIATOR_MULTILAT \
+	TDOA_ANCHOR \
+	TX_CSMA \
+	ARQ_TX \
+	ARQ_RX \
+	INDIRECT_COORD \
+	INDIRECT_DEVICE \
+	FRAME_FILTERING_TX \
+	FRAME_FILTERING_RX \
+	RX_DBL_BUFF_PIPE \
+	SNIFFER:
 do
 	rm -r build
 	cmake -B build -DBOARD_ROOT=. -DBOARD=minew_ms151f7 -DEXAMPLE=$ex  .
@@ -14,6 +14,7 @@
 #include "deca_probe_interface.h"
 #include <deca_device_api.h>
 #include <deca_spi.h>
+#include <energy.h>
 #include <example_selection.h>
 #include <port.h>
 #include <shared_defines.h>
@@ -148,6 +149,9 @@ int tx_sleep(void)
 
         /* Increment the blink frame sequence number (modulo 256). */
         tx_msg[BLINK_FRAME_SN_IDX]++;
+
+        /* Count the blink for the energy accounting of the DW IC. See NOTE 7 below. */
+        ENERGY_EXCHANGE();
     }
 }
 #endif
@@ -168,4 +172,5 @@ int tx_sleep(void)
  * 5. The chosen method for waking the DW IC up here is by toggling the WAKEUP pin high for at least 500 us.
  * 6. Desired configuration by user may be different to the current programmed configuration. dwt_configure is called to set desired
  *    configuration.
+ * 7. Each blink is one exchange of the energy accounting, see platform/energy.h.
  ****************************************************************************************************************************************************/
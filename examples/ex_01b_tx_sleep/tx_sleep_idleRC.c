@@ -16,6 +16,7 @@
 #include "deca_probe_interface.h"
 #include <deca_device_api.h>
 #include <deca_spi.h>
+#include <energy.h>
 #include <example_selection.h>
 #include <port.h>
 #include <shared_defines.h>
@@ -150,6 +151,9 @@ int tx_sleep_idleRC(void)
 
         /* Increment the blink frame sequence number (modulo 256). */
         tx_msg[BLINK_FRAME_SN_IDX]++;
+
+        /* Count the blink for the energy accounting of the DW IC. See NOTE 7 below. */
+        ENERGY_EXCHANGE();
     }
 }
 #endif
@@ -170,4 +174,5 @@ int tx_sleep_idleRC(void)
  * 5. The chosen method for waking the DW IC up here is by toggling the WAKEUP pin high for at least 500 us.
  * 6. Desired configuration by user may be different to the current programmed configuration. dwt_configure is called to set desired
  *    configuration.
+ * 7. The energy accounting (platform/energy.h) counts one exchange per blink, from the wake-up to IDLE_RC to the next sleep.
  ****************************************************************************************************************************************************/
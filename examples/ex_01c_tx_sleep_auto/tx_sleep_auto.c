@@ -14,6 +14,7 @@
 #include "deca_probe_interface.h"
 #include <deca_device_api.h>
 #include <deca_spi.h>
+#include <energy.h>
 #include <example_selection.h>
 #include <port.h>
 #include <shared_functions.h>
@@ -142,6 +143,9 @@ int tx_sleep_auto(void)
 
         /* Increment the blink frame sequence number (modulo 256). */
         tx_msg[BLINK_FRAME_SN_IDX]++;
+
+        /* Count the blink for the energy accounting of the DW IC. See NOTE 6 below. */
+        ENERGY_EXCHANGE();
     }
 }
 #endif
@@ -163,4 +167,5 @@ int tx_sleep_auto(void)
  *    work anymore then as we would still have to indicate the full length of the frame to dwt_writetxdata()).
  * 5. Desired configuration by user may be different to the current programmed configuration. dwt_configure is called to set desired
  *    configuration.
+ * 6. A blink, with the sleep entered automatically after it, is one exchange of the energy accounting (platform/energy.h).
  ****************************************************************************************************************************************************/
@@ -14,6 +14,7 @@
 #include "deca_probe_interface.h"
 #include <deca_device_api.h>
 #include <deca_spi.h>
+#include <energy.h>
 #include <example_selection.h>
 #include <port.h>
 #include <shared_defines.h>
@@ -161,6 +162,9 @@ int tx_timed_sleep(void)
 
         /* Increment the blink frame sequence number (modulo 256). */
         tx_msg[BLINK_FRAME_SN_IDX]++;
+
+        /* Count the blink for the energy accounting of the DW IC. See NOTE 8 below. */
+        ENERGY_EXCHANGE();
     }
 }
 
@@ -207,4 +211,5 @@ static void spi_ready_cb(const dwt_cb_data_t *cb_data)
  *    configuration.
  * 7. We use polled mode of operation here to keep the example as simple as possible, but the TXFRS status event can be used to generate an interrupt.
  *    Please refer to DW IC User Manual for more details on "interrupts".
+ * 8. The energy accounting (platform/energy.h) counts each blink and the timed sleep after it as one exchange.
  ****************************************************************************************************************************************************/
@@ -0,0 +1,197 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    tx_csma.c
+ *  @brief   TX with CSMA-CA channel access example code
+ *
+ *           This example sends blinks with the unslotted CSMA-CA of IEEE 802.15.4 (see csma.h): each frame waits a random backoff, growing
+ *           exponentially with the CCA failures, before its transmission with the preamble detection CCA of the DW IC, where tx_with_cca
+ *           retries after a fixed, increasing delay. Frames are generated at a fixed rate and queued, and the MCU sleeps during the backoffs.
+ *           Several devices running this example, or the Continuous Frame example, load the channel. The frames sent, the channel access
+ *           failures and the channel access delay are displayed every second.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <binlog.h>
+#include <csma.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(TEST_TX_CSMA)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "TX CSMA v1.0"
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* The frames are 802.15.4 blinks as in the tx_with_cca example: 0xC5, sequence number, 8-byte device ID, and the 2-byte FCS set by the DW IC.
+ * Each queued frame has its own buffer, as the engine only holds a pointer until the frame is sent. */
+static const uint8_t blink_msg[] = { 0xC5, 0, 'D', 'E', 'C', 'A', 'W', 'A', 'V', 'E' };
+#define BLINK_FRAME_SN_IDX 1
+#define FRAME_LENGTH       (sizeof(blink_msg) + FCS_LEN)
+static uint8_t tx_msg[CSMA_QUEUE_LEN][sizeof(blink_msg)];
+
+/* Period of the frames, in microseconds. See NOTE 1 below. */
+#define TX_PERIOD_US 10000
+
+/* Period of the statistics display, in milliseconds. */
+#define CSMA_REPORT_MS 1000
+
+static csma_t csma;
+static uint32_t overflows; /* Frames not queued, the queue being full */
+static uint8_t seq;
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/*
+ * Completion of a frame, logged. A frame which failed is not retried, the next one is newer. See NOTE 4 below.
+ */
+static void tx_done_cb(void *ctx, int result, uint8_t backoffs, uint32_t delay_us)
+{
+    (void)ctx;
+    BINLOG3(BINLOG_CSMA, result, backoffs, delay_us);
+}
+
+/**
+ * Application entry point.
+ */
+int tx_csma(void)
+{
+    uint32_t next_tx_us, report_ms, now_us, wait_us, last_sent = 0;
+    char str[80];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* The CCA: a preamble searched for during CSMA_CCA_PACS PACs. */
+    dwt_setpreambledetecttimeout(CSMA_CCA_PACS);
+
+    /* Seed the backoffs differently on each device. See NOTE 2 below. */
+    csma_init(&csma, &csma_dw_radio, NULL, dwt_readsystimestamphi32() ^ port_get_time_us());
+
+    next_tx_us = port_get_time_us();
+    report_ms = port_get_tick_ms();
+
+    while (1)
+    {
+        now_us = port_get_time_us();
+        if ((int32_t)(now_us - next_tx_us) >= 0)
+        {
+            uint8_t *frame = tx_msg[seq & (CSMA_QUEUE_LEN - 1)];
+
+            /* The buffer of a frame is only reused CSMA_QUEUE_LEN frames later, once the queue is full it is not written. */
+            if (csma.count < CSMA_QUEUE_LEN)
+            {
+                memcpy(frame, blink_msg, sizeof(blink_msg));
+                frame[BLINK_FRAME_SN_IDX] = seq++;
+                csma_queue(&csma, frame, FRAME_LENGTH, tx_done_cb, NULL);
+            }
+            else
+            {
+                overflows++;
+            }
+            next_tx_us += TX_PERIOD_US;
+        }
+
+        /* Sleep until the next action of the engine or the next frame. See NOTE 3 below. */
+        wait_us = csma_process(&csma);
+        if (wait_us != 0)
+        {
+            now_us = port_get_time_us();
+            if (wait_us == CSMA_IDLE || (int32_t)(next_tx_us - now_us) < (int32_t)wait_us)
+            {
+                port_sleep_until_us(next_tx_us);
+            }
+            else
+            {
+                port_sleep_until_us(now_us + wait_us);
+            }
+        }
+
+        if (port_get_tick_ms() - report_ms >= CSMA_REPORT_MS)
+        {
+            const csma_stats_t *st = &csma.stats;
+
+            snprintf(str, sizeof(str), "CSMA %lu fr/s fail %lu ovf %lu busy %lu delay %lu us max %lu us", (unsigned long)(st->sent - last_sent),
+                (unsigned long)st->failed, (unsigned long)overflows, (unsigned long)st->cca_busy,
+                (unsigned long)(st->sent ? st->delay_sum_us / st->sent : 0), (unsigned long)st->delay_max_us);
+            test_run_info((unsigned char *)str);
+            last_sent = st->sent;
+            report_ms += CSMA_REPORT_MS;
+        }
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. A blink takes about 180 us on air with this configuration, so a device sending one every 10 ms loads the channel by 1.8%. The throughput
+ *    of a channel shared by more devices, against the load they offer, is simulated by tools/csma_sim. By default it assumes that a receiver
+ *    demodulating the data of a frame is not disturbed by the preamble of another one, see NOTE 3 of csma.c. With this assumption and 10
+ *    devices offering half of the channel time, 45% of it carries frames received, 8% of the frames being lost in collisions, and the
+ *    throughput saturates at about 63% of the channel time, against 23% for devices transmitting without CCA or backoff. If any overlap loses
+ *    the frame (csma_sim -s), the same load gives 42% with 15% of the frames lost, and the throughput peaks at about 51% of the channel time
+ *    and falls to about 45% when the devices offer more than the channel time, against 20% without CCA or backoff.
+ * 2. The system time of the DW IC when the application starts depends on the start-up time of each device, which is enough for the backoffs
+ *    of the devices not to be correlated. A unique device ID would do as well.
+ * 3. During the backoffs the MCU sleeps, until the next action of the engine. While the CCA and the transmission are in progress,
+ *    csma_process() returns 0 and the status of the DW IC is polled: they last a few hundred microseconds at most. The end of the
+ *    transmission (TXFRS) and the CCA failure (CCA_FAIL) can also be enabled as interrupts of the DW IC to sleep through them as well.
+ * 4. The outcome of each frame is written to the binary log (platform/binlog.h), read on RTT channel 1 and printed by tools/binlog_decode.py,
+ *    e.g. "CSMA res=1 nb=2 delay=412 us" for a frame sent after 2 CCA failures (res 3 for a channel access failure).
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,227 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    simple_rx_multi.c
+ *  @brief   Simple RX example code for several DW ICs on one MCU
+ *
+ *           Every DW IC of the devicetree (see dw_dev.h) receives continuously, each on its own channel, with its own interrupt line and
+ *           callbacks. The frames received by each device and in total are printed every second, so that the aggregate throughput can be
+ *           compared with the throughput of a single device. Companion of the "simple TX" or "continuous frame" examples, one transmitter per
+ *           channel.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <deca_device_api.h>
+#include <dw_dev.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <string.h>
+
+#if defined(TEST_SIMPLE_RX_MULTI)
+
+#include <zephyr.h>
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "SIMPLE RX MULTI v1.0"
+
+/* Default communication configuration, the channel being set per device. See NOTE 1 below. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Channel of each device, in turn. See NOTE 1 below. */
+static const uint8_t dev_channel[] = { 5, 9 };
+
+/* Largest number of devices handled */
+#define MAX_DEVS 4
+
+/* Buffers to store received frames, one per device. */
+static uint8_t rx_buffer[MAX_DEVS][FRAME_LEN_MAX];
+
+/* Event counters of each device, written by the callbacks and read by the report. */
+static volatile uint32_t num_frames[MAX_DEVS];
+static volatile uint32_t num_bytes[MAX_DEVS];
+static volatile uint32_t num_rx_err[MAX_DEVS];
+
+/* Period of the report, in seconds. */
+#define REPORT_PERIOD_S 1
+
+static void rx_ok_cb(const dwt_cb_data_t *cb_data);
+static void rx_err_cb(const dwt_cb_data_t *cb_data);
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn simple_rx_multi_start()
+ *
+ * @brief Initialise a device and turn its receiver on. The device is locked for the whole sequence. See NOTE 2 below.
+ *
+ * @param  dev  device to start
+ * @param  idx  index of the device
+ *
+ * @return  0 on success, -1 on error
+ */
+static int simple_rx_multi_start(struct dw_dev *dev, unsigned int idx)
+{
+    int ret = -1;
+
+    dw_dev_set_spi_slowrate(dev);
+    dw_dev_reset(dev);
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver, with a driver state per device. */
+    if (dw_dev_probe(dev) != DWT_SUCCESS)
+    {
+        return -1;
+    }
+
+    dw_dev_lock(dev);
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+    dw_dev_set_spi_fastrate(dev);
+    if (dwt_initialise(DWT_DW_INIT) == DWT_SUCCESS)
+    {
+        config.chan = dev_channel[idx % sizeof(dev_channel)];
+        if (dwt_configure(&config) == DWT_SUCCESS)
+        {
+            /* The callbacks are kept in the driver state of the device. */
+            dwt_setcallbacks(NULL, &rx_ok_cb, &rx_err_cb, &rx_err_cb, NULL, NULL, NULL);
+            dwt_setinterrupt(DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR, 0, DWT_ENABLE_INT);
+            dwt_writesysstatuslo(DWT_INT_RCINIT_BIT_MASK | DWT_INT_SPIRDY_BIT_MASK);
+            dwt_setrxtimeout(0);
+            dwt_setpreambledetecttimeout(0);
+            dwt_rxenable(DWT_START_RX_IMMEDIATE);
+            ret = 0;
+        }
+    }
+    dw_dev_unlock(dev);
+
+    /* Install the IRQ handling of the device, dwt_isr() run with the device current. */
+    if (ret == 0 && dw_dev_set_isr(dev, NULL) != 0)
+    {
+        ret = -1;
+    }
+    return ret;
+}
+
+/**
+ * Application entry point.
+ */
+int simple_rx_multi(void)
+{
+    uint32_t last_frames[MAX_DEVS] = { 0 }, last_bytes[MAX_DEVS] = { 0 };
+    unsigned int num_devs, i;
+    char str[64];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    if (dw_dev_init() <= 0)
+    {
+        test_run_info((unsigned char *)"NO DEVICE");
+        while (1) { };
+    }
+    num_devs = dw_dev_count();
+    if (num_devs > MAX_DEVS)
+    {
+        num_devs = MAX_DEVS;
+    }
+
+    for (i = 0; i < num_devs; i++)
+    {
+        if (simple_rx_multi_start(dw_dev_get(i), i) != 0)
+        {
+            snprintf(str, sizeof(str), "DEV%u INIT FAILED", i);
+            test_run_info((unsigned char *)str);
+            while (1) { };
+        }
+    }
+
+    /* Everything else is done by the callbacks, print the frames received by each device and by all of them. See NOTE 3 below. */
+    while (1)
+    {
+        uint32_t frames, bytes, total_frames = 0, total_bytes = 0;
+
+        Sleep(REPORT_PERIOD_S * 1000);
+        for (i = 0; i < num_devs; i++)
+        {
+            frames = num_frames[i] - last_frames[i];
+            bytes = num_bytes[i] - last_bytes[i];
+            last_frames[i] += frames;
+            last_bytes[i] += bytes;
+            total_frames += frames;
+            total_bytes += bytes;
+
+            snprintf(str, sizeof(str), "DEV%u ch%u frames/s=%lu kbit/s=%lu rxerr=%lu irq=%lu", i, dev_channel[i % sizeof(dev_channel)],
+                (unsigned long)(frames / REPORT_PERIOD_S), (unsigned long)(bytes * 8 / 1000 / REPORT_PERIOD_S), (unsigned long)num_rx_err[i],
+                (unsigned long)dw_dev_irq_count(dw_dev_get(i)));
+            test_run_info((unsigned char *)str);
+        }
+        snprintf(str, sizeof(str), "ALL frames/s=%lu kbit/s=%lu", (unsigned long)(total_frames / REPORT_PERIOD_S),
+            (unsigned long)(total_bytes * 8 / 1000 / REPORT_PERIOD_S));
+        test_run_info((unsigned char *)str);
+    }
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn rx_ok_cb()
+ *
+ * @brief Callback to process RX good frame events of any device: the frame is read and the receiver turned on again.
+ *
+ * @param  cb_data  callback data
+ *
+ * @return  none
+ */
+static void rx_ok_cb(const dwt_cb_data_t *cb_data)
+{
+    unsigned int idx = dw_dev_index(dw_dev_current());
+
+    if (cb_data->datalength <= FRAME_LEN_MAX)
+    {
+        dwt_readrxdata(rx_buffer[idx], cb_data->datalength, 0);
+        num_frames[idx]++;
+        num_bytes[idx] += cb_data->datalength;
+    }
+    dwt_rxenable(DWT_START_RX_IMMEDIATE);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn rx_err_cb()
+ *
+ * @brief Callback to process RX error and timeout events of any device. The receiver is turned on again immediately.
+ *
+ * @param  cb_data  callback data
+ *
+ * @return  none
+ */
+static void rx_err_cb(const dwt_cb_data_t *cb_data)
+{
+    (void)cb_data;
+    num_rx_err[dw_dev_index(dw_dev_current())]++;
+    dwt_rxenable(DWT_START_RX_IMMEDIATE);
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The devices use channels 5 and 9 in turn, e.g. for channel diversity on an anchor with two radios, each with its own transmitter. With
+ *    the same channel for every device, e.g. for PDoA, each device receives the same frames.
+ * 2. The DW IC driver works on the device made current by dw_dev_lock(), and dw_dev_probe() gives each device its own driver state, in which
+ *    dwt_setcallbacks() keeps the callbacks. The same callbacks are used by all devices here, dw_dev_current() telling which device an event is
+ *    for. The IRQ line of each device runs dwt_isr() from the system work queue with the device locked, so the callbacks may use the driver.
+ * 3. The radios receive at the same time, only the SPI accesses are serialized: with a 127 byte frame read in about 40 us at 32 MHz and a frame
+ *    of about 200 us on air, two devices receive twice the frames of one, until the SPI bus or the CPU is busy most of the time. The irq
+ *    counts are the interrupts of each line.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,382 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    cir_capture.c
+ *  @brief   CIR streaming capture example code
+ *
+ *           This application receives frames (as sent by the companion "simple TX STS SDC" example) and, for every frame received with a good
+ *           CRC, captures a window of the Ipatov and STS channel impulse responses (CIR) from the accumulator. The samples are read with large SPI
+ *           bursts, packed to 16 bits and queued into a ring buffer, from where they are streamed to the host over the binary stream of the port
+ *           (RTT channel 2, or the console UART when RTT is not used) while the receiver waits for the next frame.
+ *           When the host does not keep up, complete captures are dropped and counted. The number of captures per second, the stream throughput
+ *           and the dropped captures are displayed every second.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(TEST_CIR_CAPTURE)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "CIR CAPTURE v1.0"
+
+/* Default communication configuration. STS is used so that both the Ipatov and the STS CIR are available. */
+static dwt_config_t config = {
+    5,               /* Channel number. */
+    DWT_PLEN_128,    /* Preamble length. Used in TX only. */
+    DWT_PAC8,        /* Preamble acquisition chunk size. Used in RX only. */
+    9,               /* TX preamble code. Used in TX only. */
+    9,               /* RX preamble code. Used in RX only. */
+    3,               /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,      /* Data rate. */
+    DWT_PHRMODE_STD, /* PHY header mode. */
+    DWT_PHRRATE_STD, /* PHY header rate. */
+    (129 + 8 - 8),   /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_1 | DWT_STS_MODE_SDC, /* STS mode 1 with deterministic code, as sent by the simple TX STS SDC example */
+    DWT_STS_LEN_64,                    /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0                        /* PDOA mode off */
+};
+
+/* Location of the CIRs in the accumulator memory, in samples. See NOTE 1 below. */
+#define CIR_IPATOV_OFFSET 0
+#define CIR_IPATOV_LEN    1016
+#define CIR_STS_OFFSET    1024
+#define CIR_STS_LEN       512
+
+/* Window captured from each CIR, at most the length of the CIR. "cmake -DCIR_CAPTURE_FULL=1" captures the whole CIRs. */
+#ifndef CIR_CAPTURE_FULL
+#define CIR_CAPTURE_FULL 0
+#endif
+#define CIR_WIN_PRE 32 /* Samples captured before the first path */
+#if CIR_CAPTURE_FULL
+#define CIR_IPATOV_WIN_LEN CIR_IPATOV_LEN
+#define CIR_STS_WIN_LEN    CIR_STS_LEN
+#else
+#define CIR_IPATOV_WIN_LEN 256
+#define CIR_STS_WIN_LEN    256
+#endif
+#if (CIR_IPATOV_WIN_LEN > CIR_IPATOV_LEN) || (CIR_STS_WIN_LEN > CIR_STS_LEN)
+#error "CIR window longer than its CIR"
+#endif
+
+/* Samples read from the accumulator with one SPI burst. See NOTE 2 below. */
+#define CIR_CHUNK_SAMPLES 64
+#define CIR_SAMPLE_LEN    6 /* 24-bit real and imaginary parts */
+
+/* Capture record layout. See NOTE 3 below. */
+#define CIR_REC_SYNC      0xACC1
+#define CIR_REC_HDR_LEN   16
+#define CIR_WIN_HDR_LEN   6
+#define CIR_NUM_CHUNKS(n)  (((n) + CIR_CHUNK_SAMPLES - 1) / CIR_CHUNK_SAMPLES)
+#define CIR_WIN_REC_LEN(n) (CIR_WIN_HDR_LEN + CIR_NUM_CHUNKS(n) * 1 + (n) * 4)
+#define CIR_ID_IPATOV     0
+#define CIR_ID_STS        1
+
+/* Ring buffer between capture and streaming, must be a power of 2 and hold a whole record. */
+#define CIR_RING_SIZE (16 * 1024)
+#if (CIR_REC_HDR_LEN + CIR_WIN_REC_LEN(CIR_IPATOV_WIN_LEN) + CIR_WIN_REC_LEN(CIR_STS_WIN_LEN)) > CIR_RING_SIZE
+#error "CIR_RING_SIZE too small for a capture record"
+#endif
+
+/* Period of the statistics display, in milliseconds. */
+#define CAPTURE_REPORT_MS 1000
+
+static uint8_t ring[CIR_RING_SIZE];
+static uint32_t ring_head; /* Free-running write index */
+static uint32_t ring_tail; /* Free-running read index */
+
+/* Accumulator data read in one burst, plus the dummy first byte, and its sign extended values. */
+static uint8_t acc_chunk[CIR_CHUNK_SAMPLES * CIR_SAMPLE_LEN + 1];
+static int32_t acc_val[CIR_CHUNK_SAMPLES * 2];
+
+/* Hold copy of diagnostics data so that it can be examined at a debug breakpoint. */
+static dwt_rxdiag_t rx_diag;
+
+/* Hold copy of status register state here for reference, so reader can examine it at a breakpoint. */
+static uint32_t status_reg = 0;
+
+/* Capture counters, cumulative since start, so that they can be examined at a debug breakpoint. */
+static uint32_t captures;
+static uint32_t dropped;
+static uint32_t streamed_bytes;
+
+static uint32_t ring_free(void)
+{
+    return CIR_RING_SIZE - (ring_head - ring_tail);
+}
+
+static void ring_put(const uint8_t *data, uint32_t len)
+{
+    while (len--)
+    {
+        ring[ring_head++ & (CIR_RING_SIZE - 1)] = *data++;
+    }
+}
+
+static void ring_put_u16(uint16_t val)
+{
+    uint8_t b[2] = { (uint8_t)val, (uint8_t)(val >> 8) };
+
+    ring_put(b, 2);
+}
+
+/*
+ * Stream as much of the ring as the host side can take without blocking.
+ */
+static void cir_drain(void)
+{
+    uint32_t len, space, written;
+
+    while (ring_head != ring_tail)
+    {
+        len = ring_head - ring_tail;
+        /* Contiguous part only, the rest is sent in the next iteration. */
+        if (len > CIR_RING_SIZE - (ring_tail & (CIR_RING_SIZE - 1)))
+        {
+            len = CIR_RING_SIZE - (ring_tail & (CIR_RING_SIZE - 1));
+        }
+        space = port_stream_space(PORT_STREAM_DATA);
+        if (space == 0)
+        {
+            break;
+        }
+        if (len > space)
+        {
+            len = space;
+        }
+        written = port_stream_write(PORT_STREAM_DATA, &ring[ring_tail & (CIR_RING_SIZE - 1)], len);
+        ring_tail += written;
+        streamed_bytes += written;
+        if (written < len)
+        {
+            break;
+        }
+    }
+}
+
+/*
+ * Read a window of one CIR from the accumulator chunk by chunk and queue it packed into the ring. See NOTE 4 below.
+ */
+static void cir_capture_window(uint8_t cir_id, uint16_t cir_offset, uint16_t cir_len, uint16_t win_len, uint16_t fp_index)
+{
+    int32_t start = (fp_index >> 6) - CIR_WIN_PRE;
+    uint16_t done, n, i;
+
+    /* The window stays within the CIR, the whole CIR when it is as long. */
+    if (win_len > cir_len)
+    {
+        win_len = cir_len;
+    }
+    if (start > cir_len - win_len)
+    {
+        start = cir_len - win_len;
+    }
+    if (start < 0)
+    {
+        start = 0;
+    }
+
+    ring_put(&cir_id, 1);
+    ring_put((const uint8_t *)"\0", 1);
+    ring_put_u16((uint16_t)start);
+    ring_put_u16(win_len);
+
+    for (done = 0; done < win_len; done += n)
+    {
+        int32_t max = 0;
+        uint8_t shift = 0;
+
+        n = win_len - done;
+        if (n > CIR_CHUNK_SAMPLES)
+        {
+            n = CIR_CHUNK_SAMPLES;
+        }
+
+        /* The first byte read from the accumulator is a dummy byte. */
+        dwt_readaccdata(acc_chunk, n * CIR_SAMPLE_LEN + 1, cir_offset + start + done);
+
+        for (i = 0; i < n * 2; i++)
+        {
+            const uint8_t *p = &acc_chunk[1 + i * 3];
+            int32_t v = (int32_t)(((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16)) << 8) >> 8;
+
+            acc_val[i] = v;
+            if (v < 0)
+            {
+                v = -v;
+            }
+            if (v > max)
+            {
+                max = v;
+            }
+        }
+
+        /* Common scaling of the chunk so that all its values fit 16 bits. */
+        while ((max >> shift) > INT16_MAX)
+        {
+            shift++;
+        }
+        ring_put(&shift, 1);
+        for (i = 0; i < n * 2; i++)
+        {
+            ring_put_u16((uint16_t)(int16_t)(acc_val[i] >> shift));
+        }
+    }
+}
+
+static void cir_capture_frame(uint16_t seq)
+{
+    uint8_t num_win = (config.stsMode == DWT_STS_MODE_OFF) ? 1 : 2;
+    uint16_t rec_len = CIR_REC_HDR_LEN + CIR_WIN_REC_LEN(CIR_IPATOV_WIN_LEN) + ((num_win > 1) ? CIR_WIN_REC_LEN(CIR_STS_WIN_LEN) : 0);
+
+    /* Drop the whole capture, without reading the accumulator, if the host does not keep up. */
+    if (ring_free() < rec_len)
+    {
+        dropped++;
+        return;
+    }
+
+    dwt_readdiagnostics(&rx_diag);
+
+    ring_put_u16(CIR_REC_SYNC);
+    ring_put_u16(rec_len);
+    ring_put_u16(seq);
+    ring_put_u16((uint16_t)dropped);
+    ring_put_u16(rx_diag.ipatovFpIndex);
+    ring_put_u16(rx_diag.stsFpIndex);
+    ring_put(&num_win, 1);
+    ring_put((const uint8_t *)"\0\0\0", 3);
+
+    cir_capture_window(CIR_ID_IPATOV, CIR_IPATOV_OFFSET, CIR_IPATOV_LEN, CIR_IPATOV_WIN_LEN, rx_diag.ipatovFpIndex);
+    if (num_win > 1)
+    {
+        cir_capture_window(CIR_ID_STS, CIR_STS_OFFSET, CIR_STS_LEN, CIR_STS_WIN_LEN, rx_diag.stsFpIndex);
+    }
+
+    captures++;
+}
+
+/**
+ * Application entry point.
+ */
+int cir_capture(void)
+{
+    uint32_t report_ms, now_ms;
+    uint32_t last_captures = 0, last_bytes = 0;
+    uint16_t seq = 0;
+    char str[64];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    if (port_stream_init(PORT_STREAM_DATA) < 0)
+    {
+        test_run_info((unsigned char *)"STREAM INIT FAILED");
+        while (1) { };
+    }
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Enable IC diagnostic calculation and logging */
+    dwt_configciadiag(DW_CIA_DIAG_LOG_ALL);
+
+    report_ms = port_get_tick_ms();
+
+    /* Loop forever receiving frames. */
+    while (1)
+    {
+        /* Activate reception immediately. */
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+
+        /* Stream queued captures while waiting for a frame or an error. See NOTE 5 below. */
+        while (!((status_reg = dwt_readsysstatuslo()) & (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_ERR)))
+        {
+            cir_drain();
+        }
+
+        if (status_reg & DWT_INT_RXFCG_BIT_MASK)
+        {
+            /* Clear good RX frame event in the DW IC status register. */
+            dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+
+            /* The accumulator must be read before the receiver is enabled again. */
+            cir_capture_frame(seq++);
+        }
+        else
+        {
+            /* Clear RX error events in the DW IC status register. */
+            dwt_writesysstatuslo(SYS_STATUS_ALL_RX_ERR);
+        }
+
+        now_ms = port_get_tick_ms();
+        if (now_ms - report_ms >= CAPTURE_REPORT_MS)
+        {
+            snprintf(str, sizeof(str), "CIR %lu cap/s %lu B/s drop %lu", (unsigned long)((captures - last_captures) * 1000 / (now_ms - report_ms)),
+                (unsigned long)((uint64_t)(streamed_bytes - last_bytes) * 1000 / (now_ms - report_ms)), (unsigned long)dropped);
+            test_run_info((unsigned char *)str);
+            last_captures = captures;
+            last_bytes = streamed_bytes;
+            report_ms = now_ms;
+        }
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The accumulator memory holds the Ipatov CIR (1016 samples for 64 MHz PRF, 992 for 16 MHz PRF) from sample 0 and the STS CIR (512 samples)
+ *    from sample 1024. Each sample is a complex number made of a 24-bit real part and a 24-bit imaginary part. The window captured starts
+ *    CIR_WIN_PRE samples before the integer part of the first path index reported in the diagnostics (10.6 bits fixed point value), see
+ *    rx_diagnostics.c, and is moved back when it would go past the end of its CIR. Each CIR has its own window length, 256 samples by
+ *    default; with CIR_CAPTURE_FULL the windows are the whole CIRs, 1016 and 512 samples, and a record is about 6 KB.
+ * 2. Every call to dwt_readaccdata() is one SPI transaction, and the first byte read is always garbage. Reading 64 samples (385 bytes) per burst
+ *    keeps the SPI overhead low while the chunk buffer stays small. The whole window is never held in memory in its 24-bit form.
+ * 3. The stream is a sequence of little endian records:
+ *        record header (16 bytes): sync 0xACC1, record length in bytes (header included), sequence number, dropped captures (16 LSBs),
+ *                                  Ipatov first path index, STS first path index, number of windows, 3 reserved bytes
+ *        window header (6 bytes):  CIR ID (0 = Ipatov, 1 = STS), reserved byte, first sample index, number of samples
+ *        chunks:                   shift (1 byte), then up to 64 pairs of int16 real and imaginary values
+ *    The original value of a sample is the int16 value shifted left by the shift of its chunk. A host reader resynchronises on the sync word
+ *    and checks it against the record length. The sequence number increments for each frame received, including the dropped ones, so gaps
+ *    can be detected.
+ * 4. The 24-bit values are packed to 16 bits with one scaling shift per chunk (block floating point), which halves the data to stream at the
+ *    cost of the least significant bits of the strongest chunks only. Delta coding was not used: the noise floor of the CIR makes the
+ *    differences between consecutive samples as wide as the samples themselves.
+ * 5. Streaming is done while the receiver is active, so that it overlaps with waiting for the next frame. A capture only takes place if the
+ *    ring buffer has room for all of it, otherwise it is dropped and counted. With RTT the host must read channel 2 (e.g. with JLinkRTTLogger)
+ *    for the data to flow, with UART the writes block and the capture rate is limited by the baud rate.
+ ****************************************************************************************************************************************************/
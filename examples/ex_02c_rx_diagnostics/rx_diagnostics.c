@@ -25,6 +25,7 @@
 #include <port.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
+#include <telem.h>
 
 #if defined(TEST_RX_DIAG)
 
@@ -59,7 +60,7 @@ static uint32_t status_reg = 0;
 /* Hold copy of frame length of frame received (if good), so reader can examine it at a breakpoint. */
 static uint16_t frame_len = 0;
 
-/* Hold copy of event counters so that it can be examined at a debug breakpoint. */
+/* Hold copy of the events of the last reception so that it can be examined at a debug breakpoint. See NOTE 7. */
 static dwt_deviceentcnts_t event_cnt;
 
 /* Hold copy of diagnostics data so that it can be examined at a debug breakpoint. */
@@ -105,7 +106,7 @@ int rx_diagnostics(void)
     }
 
     /* Activate event counters. */
-    dwt_configeventcounters(1);
+    telem_hw_enable();
 
     /* Enable IC diagnostic calculation and logging */
     dwt_configciadiag(1);
@@ -167,7 +168,7 @@ int rx_diagnostics(void)
         }
 
         /* Read event counters. See NOTE 7. */
-        dwt_readeventcounters(&event_cnt);
+        telem_hw_update(&event_cnt);
     }
 }
 #endif
@@ -189,8 +190,9 @@ int rx_diagnostics(void)
  *    the relevant offset and length parameters. Reading the whole accumulator will require 4064 bytes of memory. First path value gotten from
  *    dwt_readdiagnostics is a 10.6 bits fixed point value calculated by the DW IC. By dividing this value by 64, we end up with the integer part of
  *    it. This value can be used to access the accumulator samples around the calculated first path index as it is done here.
- * 7. Event counters are never reset in this example but this can be done by re-enabling them (i.e. calling again dwt_configeventcounters with
- *    "enable" parameter set).
+ * 7. The event counters of the DW IC are 8 or 12 bits wide and saturate. After each reception telem_hw_update() adds them to the telemetry
+ *    counters of telem.h, exported periodically on the binary log (or the console), and clears them by re-enabling them (i.e. calling again
+ *    dwt_configeventcounters with "enable" parameter set). event_cnt holds the events counted during the last reception only.
  * 8. The user is referred to DecaRanging ARM application (distributed with EVK1000 product) for additional practical example of usage, and to the
  *    DW IC API Guide for more details on the DW IC driver functions.
  ****************************************************************************************************************************************************/
@@ -13,6 +13,7 @@
 #include "deca_probe_interface.h"
 #include <deca_device_api.h>
 #include <deca_spi.h>
+#include <energy.h>
 #include <example_selection.h>
 #include <port.h>
 #include <shared_defines.h>
@@ -134,6 +135,9 @@ int rx_sniff(void)
             if (frame_len <= FRAME_LEN_MAX)
             {
                 dwt_readrxdata(rx_buffer, frame_len, 0);
+
+                /* Count the frame for the energy accounting of the DW IC. See NOTE 6 below. */
+                ENERGY_EXCHANGE();
             }
         }
         else
@@ -157,4 +161,5 @@ int rx_sniff(void)
  *    interrupts. Please refer to DW IC User Manual for more details on "interrupts".
  * 5. The user is referred to DecaRanging ARM application (distributed with EVK1000 product) for additional practical example of usage, and to the
  *    DW IC API Guide for more details on the DW IC driver functions.
+ * 6. Each good frame received is one exchange of the energy accounting (platform/energy.h), the SNIFF time waiting for it included.
  ****************************************************************************************************************************************************/
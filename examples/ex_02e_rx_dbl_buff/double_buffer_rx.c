@@ -31,10 +31,13 @@ extern void test_run_info(unsigned char *data);
 #define APP_NAME "RX DBL BUFF v1.0"
 
 /* The following can be enabled to use manual RX enable instead of auto RX re-enable
- * NOTE: when using DW30xx devices, only the manual RX enable should be used
+ * NOTE: when using DW30xx devices, only the manual RX enable can be used, it is selected regardless of this setting,
  *       with DW37xx devices either manual or auto RX enable can be used. */
 #define USE_MANUAL_RX_ENABLE 0
 
+/* Manual RX re-enable in use, see above */
+static int manual_rx_enable = USE_MANUAL_RX_ENABLE;
+
 /* Default communication configuration. We use default non-STS DW mode. */
 static dwt_config_t config = {
     5,                /* Channel number. */
@@ -80,15 +83,12 @@ int double_buffer_rx(void)
 
     dev_id = dwt_readdevid();
 
-#if (USE_MANUAL_RX_ENABLE == 0)
+    /* Double buffer in auto RX re-enable mode is not supported by DW3x00, see NOTE 2 below. */
     if ((dev_id == (uint32_t)DWT_DW3000_DEV_ID) || (dev_id == (uint32_t)DWT_DW3000_PDOA_DEV_ID))
     {
-        /* Double buffer example in auto RX re-enable mode in not supported by DW3x00 */
-        test_run_info((unsigned char *)"ERROR - NOT SUPPORTED ");
-        while (1) { };
+        manual_rx_enable = 1;
     }
-    else
-#endif
+
     {
         while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
 
@@ -124,11 +124,14 @@ int double_buffer_rx(void)
         /* Install DW IC IRQ handler. */
         port_set_dwic_isr(dwt_isr);
 
-#if (USE_MANUAL_RX_ENABLE == 0)
-        dwt_setdblrxbuffmode(DBL_BUF_STATE_EN, DBL_BUF_MODE_AUTO); // Enable double buffer - auto RX re-enable mode, see NOTE 4.
-#else
-        dwt_setdblrxbuffmode(DBL_BUF_STATE_EN, DBL_BUF_MODE_MAN); // Enable double buffer - manual RX re-enable mode, see NOTE 4.
-#endif
+        if (!manual_rx_enable)
+        {
+            dwt_setdblrxbuffmode(DBL_BUF_STATE_EN, DBL_BUF_MODE_AUTO); // Enable double buffer - auto RX re-enable mode, see NOTE 4.
+        }
+        else
+        {
+            dwt_setdblrxbuffmode(DBL_BUF_STATE_EN, DBL_BUF_MODE_MAN); // Enable double buffer - manual RX re-enable mode, see NOTE 4.
+        }
 
         dwt_rxenable(DWT_START_RX_IMMEDIATE); // Enable RX
 
@@ -149,9 +152,10 @@ int double_buffer_rx(void)
 
 static void rx_ok_cb(const dwt_cb_data_t *cb_data)
 {
-#if (USE_MANUAL_RX_ENABLE == 1)
-    dwt_rxenable(DWT_START_RX_IMMEDIATE); // When using manual RX re-enable then we can re-enable RX before processing the received packet.
-#endif
+    if (manual_rx_enable)
+    {
+        dwt_rxenable(DWT_START_RX_IMMEDIATE); // When using manual RX re-enable then we can re-enable RX before processing the received packet.
+    }
     /* TESTING BREAKPOINT LOCATION #1 */
 
     /* A frame has been received, copy it to our local buffer. See NOTE 5 below. */
@@ -186,7 +190,9 @@ static void rx_err_cb(const dwt_cb_data_t *cb_data)
  *    frame length (up to 1023 bytes long) mode which is not used in this example.
  * 2. This example shows how automatic or manual reception activation is performed. The DW IC offers several other features that can be used to handle more
  *    complex scenarios or to optimise system's overall performance (e.g. timeout after a given time, etc.).
- *    DW30xx only supports manual re-enable mode. DW37xx supports both modes.
+ *    DW30xx only supports manual re-enable mode, used on these devices regardless of USE_MANUAL_RX_ENABLE. DW37xx supports both modes.
+ *    The frame is read in the callback here, see the "RX DBL BUFF PIPE" example (rx_pipe.h) for a reception at line rate, with the
+ *    frames read after the receiver is turned on again and processed in a thread.
  * 3. There is nothing to do in the loop here as frame reception and RX re-enabling is automatic and switching inside the INT. In a less trivial real-world
  *    application the RX data callback would generally signal the reception event to some background protocol layer to further process each RX frame.
  * 4. When using double buffering either a manual or automatic mode can be used. In the manual mode, the RX can be re-enabled before reading all the frame
@@ -0,0 +1,173 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    rx_dbl_buff_pipe.c
+ *  @brief   Continuous RX at line rate with the double RX buffer, example code
+ *
+ *           This example receives every frame on air with the RX pipeline of rx_pipe.h: double buffer in manual re-enable mode, receiver
+ *           turned on again before each frame is read, frames handed to this thread through a ring. Every second it displays the frames and
+ *           bytes received, the RX errors, the frames dropped by the pipeline, and the frames missed on air, found from the RX timestamps of
+ *           a periodic transmitter such as the "CONTINUOUS FRAME" example. See NOTE 1 below.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <dw_dev.h>
+#include <example_selection.h>
+#include <port.h>
+#include <rx_pipe.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+#include <telem.h>
+
+#if defined(TEST_RX_DBL_BUFF_PIPE)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "RX DBL BUFF PIPE v1.0"
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Display period, in milliseconds */
+#define REPORT_MS 1000
+
+/* RX timestamps are 40-bit, in units of about 15.65 ps */
+#define DWT_TIME_MASK 0xFFFFFFFFFFULL
+
+/* Device time units per 10 us (499.2 MHz * 128), to display the period in microseconds */
+#define DWT_TIME_PER_US_X10 638976ULL
+
+/**
+ * Application entry point.
+ */
+int rx_dbl_buff_pipe(void)
+{
+    struct dw_dev *dev;
+    struct rx_pipe_frame *f;
+    struct rx_pipe_stats st;
+    uint64_t last_ts = 0, dt, period = 0;
+    uint32_t next_ms, missed = 0, last_frames = 0, last_bytes = 0;
+    int32_t wait_ms;
+    char str[128];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    if (dw_dev_init() <= 0)
+    {
+        test_run_info((unsigned char *)"NO DEVICE");
+        while (1) { };
+    }
+    dev = dw_dev_get(0);
+
+    dw_dev_set_spi_slowrate(dev);
+    dw_dev_reset(dev);
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    if (dw_dev_probe(dev) != DWT_SUCCESS)
+    {
+        test_run_info((unsigned char *)"PROBE FAILED");
+        while (1) { };
+    }
+
+    dw_dev_lock(dev);
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+    dw_dev_set_spi_fastrate(dev);
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+    telem_hw_enable();
+    dw_dev_unlock(dev);
+
+    /* The event counters of the DW IC go to the telemetry. See NOTE 3 below. */
+    telem_hw_attach(dev);
+
+    if (rx_pipe_start(dev, 0) != 0)
+    {
+        test_run_info((unsigned char *)"RX PIPE FAILED");
+        while (1) { };
+    }
+
+    next_ms = port_get_tick_ms() + REPORT_MS;
+    while (1)
+    {
+        wait_ms = (int32_t)(next_ms - port_get_tick_ms());
+        f = rx_pipe_get(wait_ms > 0 ? wait_ms : 0);
+        if (f)
+        {
+            /* Frames missed on air: gaps of more than one period between two frames. See NOTE 2 below. */
+            if (last_ts)
+            {
+                dt = (f->rx_ts - last_ts) & DWT_TIME_MASK;
+                if (period == 0 || dt < period - period / 8)
+                {
+                    period = dt;
+                }
+                else if (dt > period + period / 2)
+                {
+                    missed += (uint32_t)((dt + period / 2) / period) - 1;
+                }
+            }
+            last_ts = f->rx_ts;
+            rx_pipe_release();
+        }
+
+        if ((int32_t)(port_get_tick_ms() - next_ms) >= 0)
+        {
+            next_ms += REPORT_MS;
+            rx_pipe_get_stats(&st, 1);
+            snprintf(str, sizeof(str), "RX fr/s %lu kbit/s %lu err %lu drop %lu missed %lu period %lu us fill %u rearm %u us busy %u us",
+                (unsigned long)((st.frames - last_frames) * 1000 / REPORT_MS), (unsigned long)((st.bytes - last_bytes) * 8 / REPORT_MS),
+                (unsigned long)st.rx_errors, (unsigned long)(st.overruns + st.too_long), (unsigned long)missed,
+                (unsigned long)(period * 10 / DWT_TIME_PER_US_X10), st.fill_max, st.rearm_us_max, st.busy_us_max);
+            test_run_info((unsigned char *)str);
+            last_frames = st.frames;
+            last_bytes = st.bytes;
+        }
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. A shortest 802.15.4 frame at 6.8 Mbps with a 128 symbol preamble, e.g. the 12-byte blink of the "CONTINUOUS FRAME" example, is about
+ *    180 us on air. Built with "-DCONT_FRAME_PERIOD=49920" (200 us), that example sends them back to back, 20 us apart. Each frame then
+ *    costs the receiver one IRQ handling: the receiver must be on again before the preamble of the next frame is over ("rearm", a status
+ *    read, a status write and the RX enable, a few tens of microseconds on the SPI), and the whole handling of a frame ("busy") must be
+ *    shorter than the frame period, else the IRQs pile up and frames are missed. Both maxima are displayed, they are the margins to
+ *    check when the configuration (preamble length, data rate) or the SPI rate changes. A consumer slower than the frames only fills the
+ *    ring ("fill") and, once it is full, drops frames ("drop") without stopping the receiver.
+ * 2. The period of the transmitter is the shortest interval seen between two frames, in DW IC time, and each longer interval counts the
+ *    frames missed in it: the receiver was still off, or the frame was lost on air. With several transmitters or random traffic this
+ *    count is meaningless, the "drop" count of the pipeline is the one to watch.
+ * 3. The telemetry thread reads and clears the event counters of the DW IC twice a second, under the lock of the device, so the frames
+ *    with a bad FCS, PHY header errors, preamble rejections etc. counted by the DW IC itself are exported with the other counters of
+ *    telem.h. Build with "-DTELEM_EXPORT=3" to see them on the console.
+ ****************************************************************************************************************************************************/
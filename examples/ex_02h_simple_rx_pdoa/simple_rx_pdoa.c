@@ -3,6 +3,7 @@
  *  @brief   This examples prints the PDOA value to the virtual COM.
  *           The transmitter should be simple_tx_pdoa.c
  *           See note 3 regarding calibration and offset
+ *           The PDoA values are also converted to an angle of arrival, see note 6
  *
  * @attention
  *
@@ -14,12 +15,16 @@
  */
 
 #include "deca_probe_interface.h"
+#include <aoa.h>
+#include <binlog.h>
 #include <deca_device_api.h>
 #include <deca_spi.h>
 #include <example_selection.h>
 #include <port.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #if defined(TEST_SIMPLE_RX_PDOA)
 
@@ -48,7 +53,19 @@ static dwt_config_t config = {
 };
 
 int16_t pdoa_val = 0;
-uint8_t pdoa_message_data[40]; // Will hold the data to send to the virtual COM
+uint8_t pdoa_message_data[48]; // Will hold the data to send to the virtual COM
+
+/* Angle of arrival estimation. See NOTE 6 below. */
+static const aoa_config_t aoa_config = {
+    5,                     /* Channel, as config */
+    23000,                 /* Antenna spacing, um */
+    0,                     /* PDoA offset, see NOTE 3 below */
+    8,                     /* PDoAs averaged */
+    AOA_STS_QUAL(70, 256), /* STS quality index of a PDoA to be used */
+    AOA_STS_QUAL(85, 256)  /* STS quality index of a PDoA to be unwrapped */
+};
+static aoa_t aoa;
+static volatile int16_t aoa_cdeg; /* Last angle of arrival, 0.01 degree */
 
 /**
  * Application entry point.
@@ -61,6 +78,8 @@ int simple_rx_pdoa(void)
     /* Sends application name to test_run_info function. */
     test_run_info((unsigned char *)APP_NAME);
 
+    aoa_init(&aoa, &aoa_config);
+
     port_set_dw_ic_spi_fastrate();
 
     /* Reset DW IC */
@@ -104,15 +123,19 @@ int simple_rx_pdoa(void)
     /* Activate reception immediately. See NOTE 1 below. */
     dwt_rxenable(DWT_START_RX_IMMEDIATE);
 
-    /*loop forever receiving frames*/
+    /* Loop forever receiving frames, printing the PDoA values received by the RX callback. See NOTE 5 below. */
     while (1)
     {
         if (last_pdoa_val != pdoa_val)
         {
+            int16_t cdeg = aoa_cdeg;
+
             last_pdoa_val = pdoa_val;
-            sprintf((char *)&pdoa_message_data, "PDOA val = %d", last_pdoa_val);
+            sprintf((char *)&pdoa_message_data, "PDOA val = %d AOA = %s%d.%02d deg", last_pdoa_val, (cdeg < 0) ? "-" : "", abs(cdeg) / 100,
+                abs(cdeg) % 100);
             test_run_info((unsigned char *)&pdoa_message_data);
         }
+        Sleep(10);
     }
     return DWT_SUCCESS;
 }
@@ -135,7 +158,17 @@ static void rx_ok_cb(const dwt_cb_data_t *cb_data)
     // Checking STS quality and STS status. See note 4
     if (((goodSts = dwt_readstsquality(&stsQual)) >= 0))
     {
+        aoa_result_t res;
+
         pdoa_val = dwt_readpdoa();
+        BINLOG1(BINLOG_PDOA, pdoa_val);
+
+        /* Average the PDoAs and log the angle of arrival. See NOTE 6 below. */
+        if (aoa_add(&aoa, pdoa_val, 1, stsQual) == AOA_OK && aoa_get(&aoa, &res) == 0)
+        {
+            BINLOG3(BINLOG_AOA, res.pdoa_q11, res.angle_cdeg, res.count);
+            aoa_cdeg = res.angle_cdeg;
+        }
     }
     dwt_rxenable(DWT_START_RX_IMMEDIATE);
 }
@@ -168,4 +201,11 @@ static void rx_err_cb(const dwt_cb_data_t *cb_data)
  *    with a real PDOA of 0 degrees. When the PDOA is calculated this will return a non-zero value. This value should be subtracted from all
  *    PDOA values obtained by the receiver in order to obtain a calibrated PDOA.
  * 4. If the STS quality is poor the returned PDoA value will not be accurate and as such will not be recorded
+ * 5. The PDoA values and angles are printed on the console by the main loop, at most one line every 10 ms, so the RX callback does not format
+ *    strings. With RTT they are also written to the binary log (platform/binlog.h), a few tens of cycles in the callback, with every value
+ *    and its timestamp, read on RTT channel 1 and printed by tools/binlog_decode.py, e.g. "PDOA val = -312".
+ * 6. The angle of arrival is computed by aoa.c from the average of the last 8 PDoAs, corrected by the offset of NOTE 3 (aoa_config), and logged
+ *    as e.g. "AOA pdoa=-312 a=-2.78 deg n=8". The antenna spacing is the one of the PDoA board, about half the wavelength of channel 5. A PDoA
+ *    is only used with an STS quality index of 70 % of the STS length, above the 60 % the driver reports as good, and only unwrapped from
+ *    85 %, as the phase of a weak first path is unreliable. The ss_twr_initiator_aoa example adds the range to the transmitter to locate it.
  ****************************************************************************************************************************************************/
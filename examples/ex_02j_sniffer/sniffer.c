@@ -0,0 +1,258 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    sniffer.c
+ *  @brief   Packet sniffer streaming every frame on air to the host, example code
+ *
+ *           This example keeps the receiver on with the frame filter off and the RX pipeline of rx_pipe.h, and streams every good frame
+ *           received to the host on the PORT_STREAM_DATA binary stream (RTT channel 2, or the console UART), with its 40-bit RX timestamp and
+ *           RX diagnostics. tools/sniff2pcap.py converts the stream to a pcap file with IEEE 802.15.4 TAP headers (received signal level,
+ *           channel, start of frame time) for Wireshark. Every second the frames received and lost are displayed. See NOTE 1 below.
+ *
+ *           Stream record, little endian:
+ *             - sync (u16, 0xA5F1), frame length (u8, FCS excluded), flags (u8, bit 0: diagnostics present)
+ *             - record number (u16), frames lost since the previous record (u16, saturated)
+ *             - RX timestamp (40 bits), channel (u8)
+ *             - if diagnostics: CIR power (u32), first path amplitudes F1, F2, F3 (u32 each), preamble accumulation count (u16),
+ *               first path index (u16), crystal offset (s16), DGC decision (u8), padding (u8)
+ *             - frame, FCS excluded
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <dw_dev.h>
+#include <example_selection.h>
+#include <port.h>
+#include <rx_pipe.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(TEST_SNIFFER)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "SNIFFER v1.0"
+
+/* Channel listened to, 5 or 9, e.g. "cmake -DEXAMPLE=SNIFFER -DSNIFFER_CHANNEL=9" */
+#ifndef SNIFFER_CHANNEL
+#define SNIFFER_CHANNEL 5
+#endif
+
+/* Set to 0 to stream the frames without their RX diagnostics. See NOTE 2 below. */
+#ifndef SNIFFER_DIAG
+#define SNIFFER_DIAG 1
+#endif
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    SNIFFER_CHANNEL,  /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Stream record, see above */
+#define SNIFF_REC_SYNC      0xA5F1
+#define SNIFF_REC_HDR_LEN   14
+#define SNIFF_REC_DIAG_LEN  24
+#define SNIFF_REC_FLAG_DIAG 0x01
+
+/* Display period, in milliseconds */
+#define REPORT_MS 1000
+
+static uint8_t rec[SNIFF_REC_HDR_LEN + SNIFF_REC_DIAG_LEN + RX_PIPE_FRAME_MAX];
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+}
+
+/*
+ * Stream a frame, or return -1 if there is no room for its record
+ */
+static int sniffer_stream(const struct rx_pipe_frame *f, uint16_t seq, uint32_t lost)
+{
+    uint8_t *p = rec;
+    uint32_t len;
+    int i;
+
+    len = SNIFF_REC_HDR_LEN + (SNIFFER_DIAG ? SNIFF_REC_DIAG_LEN : 0) + f->len;
+    if (port_stream_space(PORT_STREAM_DATA) < len)
+    {
+        return -1;
+    }
+
+    put16(p, SNIFF_REC_SYNC);
+    p[2] = (uint8_t)f->len;
+    p[3] = SNIFFER_DIAG ? SNIFF_REC_FLAG_DIAG : 0;
+    put16(p + 4, seq);
+    put16(p + 6, lost > 0xFFFF ? 0xFFFF : (uint16_t)lost);
+    for (i = 0; i < 5; i++)
+    {
+        p[8 + i] = (uint8_t)(f->rx_ts >> (8 * i));
+    }
+    p[13] = config.chan;
+    p += SNIFF_REC_HDR_LEN;
+    if (SNIFFER_DIAG)
+    {
+        put32(p, f->diag.cir_power);
+        put32(p + 4, f->diag.f1);
+        put32(p + 8, f->diag.f2);
+        put32(p + 12, f->diag.f3);
+        put16(p + 16, f->diag.accum_count);
+        put16(p + 18, f->diag.fp_index);
+        put16(p + 20, (uint16_t)f->diag.xtal_offset);
+        p[22] = f->diag.dgc;
+        p[23] = 0;
+        p += SNIFF_REC_DIAG_LEN;
+    }
+    memcpy(p, f->data, f->len);
+    port_stream_write(PORT_STREAM_DATA, rec, len);
+    return 0;
+}
+
+/**
+ * Application entry point.
+ */
+int sniffer(void)
+{
+    struct dw_dev *dev;
+    struct rx_pipe_frame *f;
+    struct rx_pipe_stats st;
+    uint32_t next_ms, streamed = 0, stream_lost = 0, pipe_lost = 0, lost = 0, last_frames = 0, dropped;
+    uint16_t seq = 0;
+    int32_t wait_ms;
+    char str[128];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    if (port_stream_init(PORT_STREAM_DATA) < 0)
+    {
+        test_run_info((unsigned char *)"STREAM FAILED");
+        while (1) { };
+    }
+
+    if (dw_dev_init() <= 0)
+    {
+        test_run_info((unsigned char *)"NO DEVICE");
+        while (1) { };
+    }
+    dev = dw_dev_get(0);
+
+    dw_dev_set_spi_slowrate(dev);
+    dw_dev_reset(dev);
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    if (dw_dev_probe(dev) != DWT_SUCCESS)
+    {
+        test_run_info((unsigned char *)"PROBE FAILED");
+        while (1) { };
+    }
+
+    dw_dev_lock(dev);
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+    dw_dev_set_spi_fastrate(dev);
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Promiscuous: every frame with a good FCS is received, whatever its type and addresses */
+    dwt_configureframefilter(DWT_FF_DISABLE, 0);
+    if (SNIFFER_DIAG)
+    {
+        dwt_configciadiag(DW_CIA_DIAG_LOG_ALL);
+    }
+    dw_dev_unlock(dev);
+
+    if (rx_pipe_start(dev, SNIFFER_DIAG ? RX_PIPE_DIAG : 0) != 0)
+    {
+        test_run_info((unsigned char *)"RX PIPE FAILED");
+        while (1) { };
+    }
+
+    next_ms = port_get_tick_ms() + REPORT_MS;
+    while (1)
+    {
+        wait_ms = (int32_t)(next_ms - port_get_tick_ms());
+        f = rx_pipe_get(wait_ms > 0 ? wait_ms : 0);
+        if (f)
+        {
+            /* Frames dropped by the pipeline since the last record are added to the frames the stream had no room for. See NOTE 3 below. */
+            rx_pipe_get_stats(&st, 0);
+            dropped = st.overruns + st.too_long;
+            lost += dropped - pipe_lost;
+            pipe_lost = dropped;
+
+            if (sniffer_stream(f, seq, lost) == 0)
+            {
+                seq++;
+                streamed++;
+                lost = 0;
+            }
+            else
+            {
+                stream_lost++;
+                lost++;
+            }
+            rx_pipe_release();
+        }
+
+        if ((int32_t)(port_get_tick_ms() - next_ms) >= 0)
+        {
+            next_ms += REPORT_MS;
+            rx_pipe_get_stats(&st, 1);
+            snprintf(str, sizeof(str), "SNIFF ch%u fr/s %lu streamed %lu lost pipe %lu stream %lu err %lu busy %u us", config.chan,
+                (unsigned long)((st.frames - last_frames) * 1000 / REPORT_MS), (unsigned long)streamed,
+                (unsigned long)(st.overruns + st.too_long), (unsigned long)stream_lost, (unsigned long)st.rx_errors, st.busy_us_max);
+            test_run_info((unsigned char *)str);
+            last_frames = st.frames;
+        }
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. Capture with RTT, the console staying on channel 0, and convert:
+ *        JLinkRTTLogger -Device NRF52832_XXAA -If SWD -Speed 4000 -RTTChannel 2 sniff.bin
+ *        tools/sniff2pcap.py sniff.bin sniff.pcap
+ *    Without RTT the records share the console UART with the text lines, which the converter skips, but at 115200 bit/s only a few
+ *    hundred frames per second get through, the others being counted as lost.
+ * 2. The diagnostics cost about 24 bytes of stream and a few SPI reads per frame, in the IRQ handling: on a saturated channel with short
+ *    frames, build with -DSNIFFER_DIAG=0 to keep the handling of a frame shorter than the frame. The received signal level in the pcap
+ *    file is then missing.
+ * 3. Frames are lost in two places, each counted: the ring of the RX pipeline when this thread falls behind, and the stream when the host
+ *    does not read fast enough (the RTT buffer is full). The count in each record tells the host how many frames are missing before it,
+ *    so a capture of a saturated channel is incomplete but never silently so. Frames missed by the DW IC itself (receiver still off, or
+ *    collisions) cannot be counted.
+ ****************************************************************************************************************************************************/
@@ -27,7 +27,9 @@ extern void test_run_info(unsigned char *data);
 #define APP_NAME "CONT FRAME v1.0"
 
 /* Start-to-start delay between frames, expressed in halves of the 499.2 MHz fundamental frequency (around 4 ns). See NOTE 1 below. */
+#ifndef CONT_FRAME_PERIOD
 #define CONT_FRAME_PERIOD 249600
+#endif
 
 /* Continuous frame duration, in milliseconds. */
 #define CONT_FRAME_DURATION_MS 120000
@@ -34,6 +34,7 @@
 #include <shared_defines.h>
 #include <shared_functions.h>
 #include <stdlib.h>
+#include <telem.h>
 
 #if defined(TEST_DS_TWR_INITIATOR_STS)
 
@@ -85,9 +86,6 @@ static uint32_t status_reg = 0;
 /* Receive response timeout. See NOTE 5 below. */
 #define RESP_RX_TIMEOUT_UUS 300
 
-/* Hold the amount of errors that have occurred */
-static uint32_t errors[23] = { 0 };
-
 extern dwt_config_t config_options;
 extern dwt_txconfig_t txconfig_options;
 extern dwt_txconfig_t txconfig_options_ch9;
@@ -319,32 +317,36 @@ int ds_twr_initiator_sts(void)
                         /* Increment frame sequence number after transmission of the final message (modulo 256). */
                         frame_seq_nb++;
                     }
+                    else
+                    {
+                        telem_inc(TELEM_TX_LATE);
+                    }
                 }
                 else
                 {
-                    errors[BAD_FRAME_ERR_IDX] += 1;
+                    telem_inc(BAD_FRAME_ERR_IDX);
                 }
             }
             else
             {
-                errors[RTO_ERR_IDX] += 1;
+                telem_inc(RTO_ERR_IDX);
             }
         }
         else
         {
-            check_for_status_errors(status_reg, errors);
+            check_for_status_errors(status_reg);
 
             if (!(status_reg & DWT_INT_RXFCG_BIT_MASK))
             {
-                errors[BAD_FRAME_ERR_IDX] += 1;
+                telem_inc(BAD_FRAME_ERR_IDX);
             }
             if (goodSts < 0)
             {
-                errors[PREAMBLE_COUNT_ERR_IDX] += 1;
+                telem_inc(PREAMBLE_COUNT_ERR_IDX);
             }
             if (stsQual <= 0)
             {
-                errors[CP_QUAL_ERR_IDX] += 1;
+                telem_inc(CP_QUAL_ERR_IDX);
             }
         }
 
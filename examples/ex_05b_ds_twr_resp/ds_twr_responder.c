@@ -23,6 +23,8 @@
 #include <deca_spi.h>
 #include <example_selection.h>
 #include <port.h>
+#include <prof.h>
+#include <range_stats.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
 
@@ -98,6 +100,9 @@ static uint64_t final_rx_ts;
 /* Hold copies of computed time of flight and distance here for reference so that it can be examined at a debug breakpoint. */
 static double tof;
 static double distance;
+
+/* Statistics of the computed distances, see range_stats.h */
+static range_stats_t range_stats;
 /* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
  * temperature. These values can be calibrated prior to taking reference measurements. See NOTE 2 below. */
 extern dwt_txconfig_t txconfig_options;
@@ -116,6 +121,8 @@ int ds_twr_responder(void)
     /* Display application name on LCD. */
     test_run_info((unsigned char *)APP_NAME);
 
+    range_stats_init(&range_stats);
+
     /* Configure SPI rate, DW3000 supports up to 36 MHz */
     port_set_dw_ic_spi_fastrate();
 
@@ -171,6 +178,9 @@ int ds_twr_responder(void)
         {
             uint16_t frame_len;
 
+            /* Measure the time from the poll reception to the programming of the response. See NOTE 16 below. */
+            PROF_START(PROF_RESP_TURNAROUND);
+
             /* Clear good RX frame event in the DW IC status register. */
             dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
 
@@ -204,9 +214,12 @@ int ds_twr_responder(void)
 
                 /* Write and send the response message. See NOTE 10 below.*/
                 tx_resp_msg[ALL_MSG_SN_IDX] = frame_seq_nb;
+                PROF_START(PROF_TX_DATA);
                 dwt_writetxdata(sizeof(tx_resp_msg), tx_resp_msg, 0); /* Zero offset in TX buffer. */
                 dwt_writetxfctrl(sizeof(tx_resp_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
+                PROF_STOP(PROF_TX_DATA);
                 ret = dwt_starttx(DWT_START_TX_DELAYED | DWT_RESPONSE_EXPECTED);
+                PROF_STOP(PROF_RESP_TURNAROUND);
 
                 /* If dwt_starttx() returns an error, abandon this ranging exchange and proceed to the next one. See NOTE 11 below. */
                 if (ret == DWT_ERROR)
@@ -252,6 +265,7 @@ int ds_twr_responder(void)
                         final_msg_get_ts(&rx_buffer[FINAL_MSG_FINAL_TX_TS_IDX], &final_tx_ts);
 
                         /* Compute time of flight. 32-bit subtractions give correct answers even if clock has wrapped. See NOTE 12 below. */
+                        PROF_START(PROF_TOF);
                         poll_rx_ts_32 = (uint32_t)poll_rx_ts;
                         resp_tx_ts_32 = (uint32_t)resp_tx_ts;
                         final_rx_ts_32 = (uint32_t)final_rx_ts;
@@ -263,9 +277,16 @@ int ds_twr_responder(void)
 
                         tof = tof_dtu * DWT_TIME_UNITS;
                         distance = tof * SPEED_OF_LIGHT;
-                        /* Display computed distance on LCD. */
-                        sprintf(dist_str, "DIST: %3.2f m", distance);
-                        test_run_info((unsigned char *)dist_str);
+                        PROF_STOP(PROF_TOF);
+
+                        /* Accumulate computed distance, a summary is displayed periodically. */
+                        PROF_START(PROF_REPORT);
+                        range_stats_add_and_report(&range_stats, distance);
+                        PROF_STOP(PROF_REPORT);
+                        if (range_stats.count % RANGE_STATS_REPORT_PERIOD == 0)
+                        {
+                            PROF_DUMP();
+                        }
 
                         /* as DS-TWR initiator is waiting for RNG_DELAY_MS before next poll transmission
                          * we can add a delay here before RX is re-enabled again
@@ -382,4 +403,7 @@ int ds_twr_responder(void)
  *     thereafter.
  * 15. Desired configuration by user may be different to the current programmed configuration. dwt_configure is called to set desired
  *     configuration.
+ * 16. The PROF_START()/PROF_STOP() pairs (see prof.h) measure the time from the detection of the poll to the call of dwt_starttx(), which has
+ *     to fit in POLL_RX_TO_RESP_TX_DLY_UUS, as well as the ToF computation and the reporting, in CPU cycles. The histograms are printed with the
+ *     distance statistics. They expand to nothing unless the application is built with "cmake -DPROF=1".
  ****************************************************************************************************************************************************/
@@ -31,9 +31,11 @@
 #include <deca_spi.h>
 #include <example_selection.h>
 #include <port.h>
+#include <range_stats.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
 #include <stdlib.h>
+#include <telem.h>
 
 #if defined(TEST_DS_TWR_RESPONDER_STS)
 
@@ -82,14 +84,8 @@ static uint32_t status_reg = 0;
 static uint64_t poll_rx_ts;
 static uint64_t resp_tx_ts;
 
-/*
- * Array to keep distance values when running tests
- */
-static double distance_array[RANGE_COUNT] = { 0 };
-static int distance_array_index = 0;
-
-/* Hold the amount of errors that have occurred */
-static uint32_t errors[23] = { 0 };
+/* Statistics of the distances measured when running tests, see range_stats.h */
+static range_stats_t range_stats;
 
 extern dwt_config_t config_options;
 extern dwt_txconfig_t txconfig_options;
@@ -154,6 +150,8 @@ int ds_twr_responder_sts(void)
     /* Display application name on UART. */
     test_run_info((unsigned char *)APP_NAME);
 
+    range_stats_init(&range_stats);
+
     /* Configure SPI rate, DW3000 supports up to 36 MHz */
 #ifdef CONFIG_SPI_FAST_RATE
     port_set_dw_ic_spi_fastrate();
@@ -326,6 +324,10 @@ int ds_twr_responder_sts(void)
                          */
                         messageFlag = 1;
                     }
+                    else
+                    {
+                        telem_inc(TELEM_TX_LATE);
+                    }
                 }
                 else if (memcmp(rx_buffer, rx_final_msg, ALL_MSG_COMMON_LEN) == 0)
                 {
@@ -357,13 +359,8 @@ int ds_twr_responder_sts(void)
                     tof = tof_dtu * DWT_TIME_UNITS;
                     distance = tof * SPEED_OF_LIGHT;
 
-                    distance_array[distance_array_index] = distance;
-
-                    distance_array_index++;
-
-                    /* Display computed distance on UART. */
-                    sprintf(dist_str, "DIST: %3.2f m", distance);
-                    test_run_info((unsigned char *)dist_str);
+                    /* Accumulate computed distance, a summary is displayed periodically. */
+                    range_stats_add_and_report(&range_stats, distance);
                     /* as DS-TWR initiator is waiting for RNG_DELAY_MS before next poll transmission
                      * we can add a delay here before RX is re-enabled again
                      */
@@ -378,7 +375,7 @@ int ds_twr_responder_sts(void)
                 }
                 else
                 {
-                    errors[BAD_FRAME_ERR_IDX] += 1;
+                    telem_inc(BAD_FRAME_ERR_IDX);
                     /*
                      * If any error occurs, we can reset the STS count back to default value.
                      */
@@ -387,7 +384,7 @@ int ds_twr_responder_sts(void)
             }
             else
             {
-                errors[RTO_ERR_IDX] += 1;
+                telem_inc(RTO_ERR_IDX);
                 /*
                  * If any error occurs, we can reset the STS count back to default value.
                  */
@@ -396,19 +393,19 @@ int ds_twr_responder_sts(void)
         }
         else
         {
-            check_for_status_errors(status_reg, errors);
+            check_for_status_errors(status_reg);
 
             if (!(status_reg & DWT_INT_RXFCG_BIT_MASK))
             {
-                errors[BAD_FRAME_ERR_IDX] += 1;
+                telem_inc(BAD_FRAME_ERR_IDX);
             }
             if (goodSts < 0)
             {
-                errors[PREAMBLE_COUNT_ERR_IDX] += 1;
+                telem_inc(PREAMBLE_COUNT_ERR_IDX);
             }
             if (stsQual <= 0)
             {
-                errors[CP_QUAL_ERR_IDX] += 1;
+                telem_inc(CP_QUAL_ERR_IDX);
             }
             /* Clear RX error events in the DW IC status register. */
             dwt_writesysstatuslo(SYS_STATUS_ALL_RX_ERR);
@@ -25,6 +25,7 @@
 #include <deca_spi.h>
 #include <example_selection.h>
 #include <port.h>
+#include <range_stats.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
 
@@ -101,6 +102,9 @@ static uint64_t final_rx_ts;
 static double tof;
 static double distance;
 
+/* Statistics of the computed distances, see range_stats.h */
+static range_stats_t range_stats;
+
 /* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
  * temperature. These values can be calibrated prior to taking reference measurements. See NOTE 2 below. */
 extern dwt_txconfig_t txconfig_options;
@@ -120,6 +124,8 @@ int ds_twr_sts_sdc_responder(void)
     /* Display application name on LCD. */
     test_run_info((unsigned char *)APP_NAME);
 
+    range_stats_init(&range_stats);
+
     /* Configure SPI rate, DW3000 supports up to 36 MHz */
     port_set_dw_ic_spi_fastrate();
 
@@ -280,6 +286,9 @@ int ds_twr_sts_sdc_responder(void)
                                 tof = tof_dtu * DWT_TIME_UNITS;
                                 distance = tof * SPEED_OF_LIGHT;
 
+                                /* Accumulate computed distance, a summary is displayed periodically. */
+                                range_stats_add_and_report(&range_stats, distance);
+
                                 range_ok = 1;
                             }
                         } // if STS good on the Final message reception
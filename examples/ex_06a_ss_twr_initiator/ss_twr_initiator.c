@@ -18,11 +18,17 @@
  */
 
 #include "deca_probe_interface.h"
+#include <binlog.h>
 #include <config_options.h>
 #include <deca_device_api.h>
 #include <deca_spi.h>
 #include <example_selection.h>
+#include <nlos.h>
 #include <port.h>
+#include <prof.h>
+#include <range_filter.h>
+#include <range_stats.h>
+#include <resp_timing.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
 
@@ -59,7 +65,7 @@ static dwt_config_t config = {
 
 /* Frames used in the ranging process. See NOTE 3 below. */
 static uint8_t tx_poll_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'W', 'A', 'V', 'E', 0xE0, 0, 0 };
-static uint8_t rx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static uint8_t rx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 /* Length of the common part of the message (up to and including the function code, see NOTE 3 below). */
 #define ALL_MSG_COMMON_LEN 10
 /* Indexes to access some of the fields in the frames defined above. */
@@ -67,12 +73,14 @@ static uint8_t rx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A',
 #define RESP_MSG_POLL_RX_TS_IDX 10
 #define RESP_MSG_RESP_TX_TS_IDX 14
 #define RESP_MSG_TS_LEN         4
+#define RESP_MSG_SRC_ADDR_IDX   7
+#define RESP_MSG_DLY_IDX        18
 /* Frame sequence number, incremented after each transmission. */
 static uint8_t frame_seq_nb = 0;
 
 /* Buffer to store received response message.
  * Its size is adjusted to longest frame that this example code is supposed to handle. */
-#define RX_BUF_LEN 20
+#define RX_BUF_LEN 22
 static uint8_t rx_buffer[RX_BUF_LEN];
 
 /* Hold copy of status register state here for reference so that it can be examined at a debug breakpoint. */
@@ -83,10 +91,22 @@ static uint32_t status_reg = 0;
 /* Receive response timeout. See NOTE 5 below. */
 #define RESP_RX_TIMEOUT_UUS 400
 
+/* Response delay of the responder, from the delay field of its responses. See NOTE 16 below. */
+static uint16_t resp_dly_uus;
+static uint8_t resp_misses; /* Exchanges without response since the last one */
+static const struct uwb_phy resp_phy = { 5, 128, 9, 1, 0, 8 }; /* As config */
+
 /* Hold copies of computed time of flight and distance here for reference so that it can be examined at a debug breakpoint. */
 static double tof;
 static double distance;
 
+/* Statistics of the computed distances, see range_stats.h */
+static range_stats_t range_stats;
+
+/* Range filter of the responders and its last output, see range_filter.h */
+static range_filter_t range_filter;
+static range_filter_out_t filtered;
+
 /* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
  * temperature. These values can be calibrated prior to taking reference measurements. See NOTE 2 below. */
 extern dwt_txconfig_t txconfig_options;
@@ -102,10 +122,14 @@ extern dwt_txconfig_t txconfig_options;
  */
 int ss_twr_initiator(void)
 {
+    uint32_t dev_id; /* Device ID, needed to estimate the NLOS probability */
 
     /* Display application name on LCD. */
     test_run_info((unsigned char *)APP_NAME);
 
+    range_stats_init(&range_stats);
+    range_filter_init(&range_filter);
+
     /* Configure SPI rate, DW3000 supports up to 36 MHz */
     port_set_dw_ic_spi_fastrate();
 
@@ -117,6 +141,8 @@ int ss_twr_initiator(void)
     /* Probe for the correct device driver. */
     dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
 
+    dev_id = dwt_readdevid();
+
     while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
     if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
     {
@@ -138,12 +164,15 @@ int ss_twr_initiator(void)
     /* Configure the TX spectrum parameters (power, PG delay and PG count) */
     dwt_configuretxrf(&txconfig_options);
 
+    /* Log all CIA diagnostics so that the NLOS probability of each response can be estimated. See NOTE 14 below. */
+    dwt_configciadiag(DW_CIA_DIAG_LOG_ALL);
+
     /* Apply default antenna delay value. See NOTE 2 below. */
     dwt_setrxantennadelay(RX_ANT_DLY);
     dwt_settxantennadelay(TX_ANT_DLY);
 
     /* Set expected response's delay and timeout. See NOTE 1 and 5 below.
-     * As this example only handles one incoming frame with always the same delay and timeout, those values can be set here once for all. */
+     * They are set here once for all, unless the responder sends its response delay. See NOTE 16 below. */
     dwt_setrxaftertxdelay(POLL_TX_TO_RESP_RX_DLY_UUS);
     dwt_setrxtimeout(RESP_RX_TIMEOUT_UUS);
 
@@ -154,11 +183,18 @@ int ss_twr_initiator(void)
     /* Loop forever initiating ranging exchanges. */
     while (1)
     {
+        int report = 0;
+
+        /* Measure where the time of an exchange goes, compiled out unless profiling is enabled. See NOTE 15 below. */
+        PROF_START(PROF_EXCHANGE);
+
         /* Write frame data to DW IC and prepare transmission. See NOTE 7 below. */
         tx_poll_msg[ALL_MSG_SN_IDX] = frame_seq_nb;
         dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+        PROF_START(PROF_TX_DATA);
         dwt_writetxdata(sizeof(tx_poll_msg), tx_poll_msg, 0); /* Zero offset in TX buffer. */
         dwt_writetxfctrl(sizeof(tx_poll_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
+        PROF_STOP(PROF_TX_DATA);
 
         /* Start transmission, indicating that a response is expected so that reception is enabled automatically after the frame is sent and the delay
          * set by dwt_setrxaftertxdelay() has elapsed. */
@@ -189,6 +225,7 @@ int ss_twr_initiator(void)
                 if (memcmp(rx_buffer, rx_resp_msg, ALL_MSG_COMMON_LEN) == 0)
                 {
                     uint32_t poll_tx_ts, resp_rx_ts, poll_rx_ts, resp_tx_ts;
+                    uint16_t peer;
                     int32_t rtd_init, rtd_resp;
                     float clockOffsetRatio;
 
@@ -204,14 +241,41 @@ int ss_twr_initiator(void)
                     resp_msg_get_ts(&rx_buffer[RESP_MSG_RESP_TX_TS_IDX], &resp_tx_ts);
 
                     /* Compute time of flight and distance, using clock offset ratio to correct for differing local and remote clock rates */
+                    PROF_START(PROF_TOF);
                     rtd_init = resp_rx_ts - poll_tx_ts;
                     rtd_resp = resp_tx_ts - poll_rx_ts;
 
                     tof = ((rtd_init - rtd_resp * (1 - clockOffsetRatio)) / 2.0) * DWT_TIME_UNITS;
                     distance = tof * SPEED_OF_LIGHT;
-                    /* Display computed distance on LCD. */
-                    snprintf(dist_str, sizeof(dist_str), "DIST: %3.2f m", distance);
-                    test_run_info((unsigned char *)dist_str);
+                    PROF_STOP(PROF_TOF);
+
+                    /* Accumulate computed distance, a summary is displayed periodically. */
+                    PROF_START(PROF_REPORT);
+                    range_stats_add_and_report(&range_stats, distance);
+                    PROF_STOP(PROF_REPORT);
+
+                    /* Follow the response delay of the responder. See NOTE 16 below. */
+                    resp_misses = 0;
+                    if (frame_len == sizeof(rx_resp_msg) && resp_timing_get_field(&rx_buffer[RESP_MSG_DLY_IDX]) != resp_dly_uus)
+                    {
+                        uint32_t rx_dly_uus, rx_timeout_uus;
+
+                        resp_dly_uus = resp_timing_get_field(&rx_buffer[RESP_MSG_DLY_IDX]);
+                        resp_timing_rx_window(resp_dly_uus, &resp_phy, sizeof(tx_poll_msg), frame_len, &rx_dly_uus, &rx_timeout_uus);
+                        dwt_setrxaftertxdelay(rx_dly_uus);
+                        dwt_setrxtimeout(rx_timeout_uus);
+                    }
+
+                    /* Filter the range of the responder, weighting it with the NLOS probability. See NOTE 14 below. */
+                    peer = rx_buffer[RESP_MSG_SRC_ADDR_IDX] | ((uint16_t)rx_buffer[RESP_MSG_SRC_ADDR_IDX + 1] << 8);
+                    range_filter_update(&range_filter, peer, (int32_t)(distance * 1000), port_get_tick_ms(),
+                        nlos_probability(&config, dev_id), 100, &filtered);
+                    BINLOG3(BINLOG_RANGE_FILTER, peer, filtered.range_mm, filtered.velocity_mm_s);
+                    if (range_stats.count % RANGE_STATS_REPORT_PERIOD == 0)
+                    {
+                        range_filter_report(peer, &filtered);
+                        report = 1;
+                    }
                 }
             }
         }
@@ -219,6 +283,25 @@ int ss_twr_initiator(void)
         {
             /* Clear RX error/timeout events in the DW IC status register. */
             dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+
+            /* The fixed window, or the one placed from the delay, misses the responses: wide window until the next response. See NOTE 16 below. */
+            if (++resp_misses >= RESP_TIMING_FALLBACK_MISSES)
+            {
+                uint32_t rx_dly_uus, rx_timeout_uus;
+
+                resp_timing_rx_fallback(&resp_phy, sizeof(tx_poll_msg), sizeof(rx_resp_msg), &rx_dly_uus, &rx_timeout_uus);
+                dwt_setrxaftertxdelay(rx_dly_uus);
+                dwt_setrxtimeout(rx_timeout_uus);
+                resp_dly_uus = 0;
+                resp_misses = 0;
+            }
+        }
+
+        /* The exchange ends here whatever its outcome, so that timeouts and errors are measured too, and before the histograms are printed. */
+        PROF_STOP(PROF_EXCHANGE);
+        if (report)
+        {
+            PROF_DUMP();
         }
 
         /* Execute a delay between ranging exchanges. */
@@ -266,6 +349,7 @@ int ss_twr_initiator(void)
  *    Response message:
  *     - byte 10 -> 13: poll message reception timestamp.
  *     - byte 14 -> 17: response message transmission timestamp.
+ *     - byte 18/19: response delay in UWB microseconds, sent by responders using the response timing service, see NOTE 16 below.
  *    All messages end with a 2-byte checksum automatically set by DW IC.
  * 4. Source and destination addresses are hard coded constants in this example to keep it simple but for a real product every device should have a
  *    unique ID. Here, 16-bit addressing is used to keep the messages as short as possible but, in an actual application, this should be done only
@@ -294,4 +378,18 @@ int ss_twr_initiator(void)
  *     thereafter.
  * 13. Desired configuration by user may be different to the current programmed configuration. dwt_configure is called to set desired
  *     configuration.
+ * 14. The range filter (see range_filter.c) smooths the computed distance and estimates the range rate of each responder. Each measurement is
+ *     weighted by its probability of being NLOS, estimated from the CIR diagnostics as in the simple_rx_nlos example. Measurements too far
+ *     from the prediction are rejected. The filter output is available in "filtered" after each ranging exchange and is displayed with the
+ *     distance statistics.
+ * 15. The PROF_START()/PROF_STOP() pairs (see prof.h) measure the SPI transfer of the poll, the status polling, the timestamp reads, the ToF
+ *     computation, the reporting and the complete exchange in CPU cycles, the exchange including the ones which end in an RX timeout or error
+ *     or with an unexpected frame. The histograms are printed with the distance statistics. They expand to nothing unless the application is
+ *     built with "cmake -DPROF=1".
+ * 16. The response delay of ss_twr_responder.c is chosen by its response timing service (see resp_timing.h) from the latency it measures, and sent
+ *     in the response. When it changes, the RX window is placed again from it with resp_timing_rx_window(), the timeout covering the later
+ *     retries of a response which was late. Responses without the delay field (20 bytes) keep the fixed delay and timeout set at start-up.
+ *     After RESP_TIMING_FALLBACK_MISSES exchanges in a row without response, the initiator goes back to the wide window of
+ *     resp_timing_rx_fallback(), which covers every delay the responder can use, until a response gives the delay again. This also holds
+ *     before the first response, for a responder whose delay has already grown beyond the fixed window.
  ****************************************************************************************************************************************************/
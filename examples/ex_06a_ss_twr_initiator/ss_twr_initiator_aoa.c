@@ -0,0 +1,267 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    ss_twr_initiator_aoa.c
+ *  @brief   Single-sided two-way ranging (SS TWR) initiator example code, with the angle of arrival of the response
+ *
+ *           This is the PDoA anchor of a SS TWR exchange with the ss_twr_responder_aoa example. It sends a "poll" frame and receives the
+ *           "response" of the tag as ss_twr_initiator.c, which gives the range to the tag. The PDoA of the response, measured between the two
+ *           antennas of the anchor, gives the angle of arrival (see aoa.h), and with the range the position of the tag relative to the anchor,
+ *           which is logged after each exchange and printed periodically.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <aoa.h>
+#include <binlog.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+
+#if defined(TEST_SS_TWR_INITIATOR_AOA)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "SS TWR INIT AOA v1.0"
+
+/* Communication configuration of the PDoA examples, with the STS and PDoA mode 3. See NOTE 1 below. */
+static dwt_config_t config = {
+    5,                                   /* Channel number. */
+    DWT_PLEN_128,                        /* Preamble length. Used in TX only. */
+    DWT_PAC8,                            /* Preamble acquisition chunk size. Used in RX only. */
+    9,                                   /* TX preamble code. Used in TX only. */
+    9,                                   /* RX preamble code. Used in RX only. */
+    1,                                   /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,                          /* Data rate. */
+    DWT_PHRMODE_STD,                     /* PHY header mode. */
+    DWT_PHRRATE_STD,                     /* PHY header rate. */
+    (129 + 8 - 8),                       /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    (DWT_STS_MODE_1 | DWT_STS_MODE_SDC), /* STS enabled, deterministic code */
+    DWT_STS_LEN_256,                     /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M3                          /* PDOA mode 3 */
+};
+
+/* Angle of arrival estimation, see aoa.h. See NOTE 2 below. */
+static const aoa_config_t aoa_config = {
+    5,                     /* Channel, as config */
+    23000,                 /* Antenna spacing, um */
+    0,                     /* PDoA with the tag on the boresight */
+    8,                     /* PDoAs averaged */
+    AOA_STS_QUAL(70, 256), /* STS quality index of a PDoA to be used */
+    AOA_STS_QUAL(85, 256)  /* STS quality index of a PDoA to be unwrapped */
+};
+static aoa_t aoa;
+
+/* Inter-ranging delay period, in milliseconds. */
+#define RNG_DELAY_MS 100
+
+/* Number of exchanges between two prints of the position. */
+#define AOA_REPORT_PERIOD 10
+
+/* Default antenna delay values for 64 MHz PRF. */
+#define TX_ANT_DLY 16385
+#define RX_ANT_DLY 16385
+
+/* Frames used in the ranging process, as ss_twr_initiator.c. */
+static uint8_t tx_poll_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'W', 'A', 'V', 'E', 0xE0, 0, 0 };
+static uint8_t rx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+/* Length of the common part of the message (up to and including the function code). */
+#define ALL_MSG_COMMON_LEN 10
+/* Indexes to access some of the fields in the frames defined above. */
+#define ALL_MSG_SN_IDX          2
+#define RESP_MSG_POLL_RX_TS_IDX 10
+#define RESP_MSG_RESP_TX_TS_IDX 14
+/* Frame sequence number, incremented after each transmission. */
+static uint8_t frame_seq_nb = 0;
+
+/* Buffer to store received response message. */
+#define RX_BUF_LEN 20
+static uint8_t rx_buffer[RX_BUF_LEN];
+
+/* Hold copy of status register state here for reference so that it can be examined at a debug breakpoint. */
+static uint32_t status_reg = 0;
+
+/* Delay between frames, in UWB microseconds, for the response delay of ss_twr_responder_aoa.c. See NOTE 3 below. */
+#define POLL_TX_TO_RESP_RX_DLY_UUS 700
+/* Receive response timeout, covering the preamble, STS and data of the response. */
+#define RESP_RX_TIMEOUT_UUS 700
+
+/* Hold copies of computed distance and position here for reference so that it can be examined at a debug breakpoint. */
+static double distance;
+static int32_t pos_x_mm, pos_y_mm;
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn ss_twr_initiator_aoa()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int ss_twr_initiator_aoa(void)
+{
+    uint32_t exchanges = 0;
+    char str[80];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    aoa_init(&aoa, &aoa_config);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset and initialize DW chip. */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW3000 low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Enabling LEDs here for debug so that for each TX the D1 LED will flash on DW3000 red eval-shield boards. */
+    dwt_setleds(DWT_LEDS_ENABLE | DWT_LEDS_INIT_BLINK);
+
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* Apply default antenna delay value. */
+    dwt_setrxantennadelay(RX_ANT_DLY);
+    dwt_settxantennadelay(TX_ANT_DLY);
+
+    /* Set expected response's delay and timeout. */
+    dwt_setrxaftertxdelay(POLL_TX_TO_RESP_RX_DLY_UUS);
+    dwt_setrxtimeout(RESP_RX_TIMEOUT_UUS);
+
+    dwt_setlnapamode(DWT_LNA_ENABLE | DWT_PA_ENABLE);
+
+    /* Loop forever initiating ranging exchanges. */
+    while (1)
+    {
+        /* Write frame data to DW IC and prepare transmission. */
+        tx_poll_msg[ALL_MSG_SN_IDX] = frame_seq_nb;
+        dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+        dwt_writetxdata(sizeof(tx_poll_msg), tx_poll_msg, 0); /* Zero offset in TX buffer. */
+        dwt_writetxfctrl(sizeof(tx_poll_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
+
+        /* Start transmission, reception being enabled automatically after the frame is sent and the delay set by dwt_setrxaftertxdelay(). */
+        dwt_starttx(DWT_START_TX_IMMEDIATE | DWT_RESPONSE_EXPECTED);
+
+        /* Poll for reception of a frame or error/timeout. */
+        waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+
+        /* Increment frame sequence number after transmission of the poll message (modulo 256). */
+        frame_seq_nb++;
+
+        if (status_reg & DWT_INT_RXFCG_BIT_MASK)
+        {
+            uint16_t frame_len;
+
+            /* Clear good RX frame event in the DW IC status register. */
+            dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+
+            /* A frame has been received, read it into the local buffer. */
+            frame_len = dwt_getframelength();
+            if (frame_len <= sizeof(rx_buffer))
+            {
+                dwt_readrxdata(rx_buffer, frame_len, 0);
+
+                /* Check that the frame is the expected response from the companion "SS TWR responder AOA" example.
+                 * As the sequence number field of the frame is not relevant, it is cleared to simplify the validation of the frame. */
+                rx_buffer[ALL_MSG_SN_IDX] = 0;
+                if (memcmp(rx_buffer, rx_resp_msg, ALL_MSG_COMMON_LEN) == 0)
+                {
+                    uint32_t poll_tx_ts, resp_rx_ts, poll_rx_ts, resp_tx_ts;
+                    int32_t rtd_init, rtd_resp;
+                    float clockOffsetRatio;
+                    int16_t stsQual;
+                    int goodSts;
+                    aoa_result_t res;
+
+                    /* Retrieve poll transmission and response reception timestamps. */
+                    poll_tx_ts = dwt_readtxtimestamplo32();
+                    resp_rx_ts = dwt_readrxtimestamplo32();
+
+                    /* Read carrier integrator value and calculate clock offset ratio. */
+                    clockOffsetRatio = ((float)dwt_readclockoffset()) / (uint32_t)(1 << 26);
+
+                    /* Get timestamps embedded in response message. */
+                    resp_msg_get_ts(&rx_buffer[RESP_MSG_POLL_RX_TS_IDX], &poll_rx_ts);
+                    resp_msg_get_ts(&rx_buffer[RESP_MSG_RESP_TX_TS_IDX], &resp_tx_ts);
+
+                    /* Compute time of flight and distance, using clock offset ratio to correct for differing local and remote clock rates */
+                    rtd_init = resp_rx_ts - poll_tx_ts;
+                    rtd_resp = resp_tx_ts - poll_rx_ts;
+                    distance = ((rtd_init - rtd_resp * (1 - clockOffsetRatio)) / 2.0) * DWT_TIME_UNITS * SPEED_OF_LIGHT;
+
+                    /* Angle of arrival of the response from its PDoA, if its STS is good enough. See NOTE 2 below. */
+                    goodSts = dwt_readstsquality(&stsQual);
+                    aoa_add(&aoa, dwt_readpdoa(), goodSts >= 0, stsQual);
+
+                    /* Position of the tag from the averaged angle and the last range. See NOTE 4 below. */
+                    if (aoa_get(&aoa, &res) == 0)
+                    {
+                        aoa_position(&res, (int32_t)(distance * 1000), &pos_x_mm, &pos_y_mm);
+                        BINLOG3(BINLOG_AOA_POS, res.angle_cdeg, pos_x_mm, pos_y_mm);
+
+                        if (++exchanges % AOA_REPORT_PERIOD == 0)
+                        {
+                            snprintf(str, sizeof(str), "DIST: %3.2f m AOA: %3.2f deg X: %ld mm Y: %ld mm REJ: %lu", distance, res.angle_cdeg / 100.0,
+                                (long)pos_x_mm, (long)pos_y_mm, (unsigned long)aoa.rejected);
+                            test_run_info((unsigned char *)str);
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            /* Clear RX error/timeout events in the DW IC status register. */
+            dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+        }
+
+        /* Execute a delay between ranging exchanges. */
+        Sleep(RNG_DELAY_MS);
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The PDoA is measured on the STS of a frame received by a DW3120 with two antennas, in PDoA mode 3, which needs an STS of at least 256
+ *    blocks. The SS TWR examples use no STS or a 64 block STS with tight delays, so this pair has the configuration of simple_tx_pdoa.c, with
+ *    the deterministic code (no STS key or IV to exchange) and longer delays.
+ * 2. The antenna spacing is the one of the PDoA board, about half the wavelength of channel 5, and the PDoA offset is measured as in NOTE 3 of
+ *    simple_rx_pdoa.c. PDoAs of responses with an STS quality index below 70 % of the STS length are discarded, and a PDoA which wrapped
+ *    around +/- pi is only unwrapped from 85 % (see NOTE 2 of aoa.c), as in NOTE 6 of simple_rx_pdoa.c. The rejected PDoAs are counted in
+ *    aoa.rejected.
+ * 3. With STS mode 1 the RMARKER is at the start of the STS, which is followed by the PHR and data: the poll ends about 290 us after its
+ *    RMARKER. The response RMARKER is 1200 us after the poll one, its preamble starting about 140 us before it, so the RX window opens 700 us
+ *    after the end of the poll, and the timeout covers the preamble, the STS and the data of the response.
+ * 4. The position is along the boresight (X) and the baseline of the antennas (Y), in the plane of the antennas, from the averaged angle and
+ *    the last range. It is logged after each exchange in the binary log (e.g. "AOA a=12.50 deg x=2.154 m y=0.477 m" with
+ *    tools/binlog_decode.py) and printed every AOA_REPORT_PERIOD exchanges.
+ ****************************************************************************************************************************************************/
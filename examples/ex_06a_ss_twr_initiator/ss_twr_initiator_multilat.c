@@ -0,0 +1,307 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    ss_twr_initiator_multilat.c
+ *  @brief   Single-sided two-way ranging (SS TWR) tag ranging to several anchors and computing its position
+ *
+ *           The tag ranges in turn to each anchor of its anchor table, addressing its poll to the anchor as ss_twr_initiator.c does to its
+ *           responder. Each anchor is the ss_twr_responder example built with its own address (see RESP_ADDR in ss_twr_responder.c). After
+ *           each round, the position of the tag is computed from the ranges with the multilateration solver (see multilat.h), logged, and
+ *           printed every MULTILAT_REPORT_PERIOD rounds, without sending the ranges anywhere.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <binlog.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <multilat.h>
+#include <port.h>
+#include <resp_timing.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+
+#if defined(TEST_SS_TWR_INITIATOR_MULTILAT)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "SS TWR MULTILAT v1.0"
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Anchors: short address ("A1" to "A4") and position in cm. See NOTE 1 below. */
+static const multilat_anchor_t anchors[] = {
+    { 0x3141, 0, 0, 250 },
+    { 0x3241, 1000, 0, 250 },
+    { 0x3341, 1000, 800, 250 },
+    { 0x3441, 0, 800, 250 },
+};
+#define NUM_ANCHORS (sizeof(anchors) / sizeof(anchors[0]))
+
+/* 2 for a position in the plane of the anchors, 3 to also compute the height. See NOTE 1 below. */
+#define MULTILAT_DIM 2
+
+/* Inter-round delay period, in milliseconds. */
+#define RNG_DELAY_MS 100
+
+/* Number of rounds between two prints of the position. */
+#define MULTILAT_REPORT_PERIOD 10
+
+/* Default antenna delay values for 64 MHz PRF. */
+#define TX_ANT_DLY 16385
+#define RX_ANT_DLY 16385
+
+/* Frames used in the ranging process, as ss_twr_initiator.c, the address of the anchor being set in each. */
+static uint8_t tx_poll_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'W', 'A', 'V', 'E', 0xE0, 0, 0 };
+static uint8_t rx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+/* Length of the common part of the message (up to and including the function code). */
+#define ALL_MSG_COMMON_LEN 10
+/* Indexes to access some of the fields in the frames defined above. */
+#define ALL_MSG_SN_IDX          2
+#define POLL_MSG_DST_ADDR_IDX   5
+#define RESP_MSG_SRC_ADDR_IDX   7
+#define RESP_MSG_POLL_RX_TS_IDX 10
+#define RESP_MSG_RESP_TX_TS_IDX 14
+#define RESP_MSG_DLY_IDX        18
+/* Frame sequence number, incremented after each transmission. */
+static uint8_t frame_seq_nb = 0;
+
+/* Buffer to store received response message. */
+#define RX_BUF_LEN 22
+static uint8_t rx_buffer[RX_BUF_LEN];
+
+/* Hold copy of status register state here for reference so that it can be examined at a debug breakpoint. */
+static uint32_t status_reg = 0;
+
+/* Response delay of each anchor, from the delay field of its responses. See NOTE 2 below. */
+static uint16_t resp_dly_uus[NUM_ANCHORS];
+static uint8_t resp_misses[NUM_ANCHORS];
+static const struct uwb_phy resp_phy = { 5, 128, 9, 1, 0, 8 }; /* As config */
+
+/* Ranges of the last round and position, kept here for reference so that they can be examined at a debug breakpoint. */
+static int32_t range_mm[NUM_ANCHORS];
+static multilat_result_t position;
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn range_to_anchor()
+ *
+ * @brief One SS TWR exchange with an anchor of the table.
+ *
+ * @param  idx  index of the anchor
+ *
+ * @return  range in mm, or MULTILAT_NO_RANGE if the exchange failed
+ */
+static int32_t range_to_anchor(unsigned int idx)
+{
+    uint16_t addr = anchors[idx].addr;
+    uint32_t rx_dly_uus, rx_timeout_uus;
+    int32_t range = MULTILAT_NO_RANGE;
+
+    /* Address the poll to the anchor, and expect the response from it. */
+    tx_poll_msg[POLL_MSG_DST_ADDR_IDX] = rx_resp_msg[RESP_MSG_SRC_ADDR_IDX] = (uint8_t)addr;
+    tx_poll_msg[POLL_MSG_DST_ADDR_IDX + 1] = rx_resp_msg[RESP_MSG_SRC_ADDR_IDX + 1] = (uint8_t)(addr >> 8);
+
+    /* RX window for the response delay of this anchor, or the wide one when it is not known. */
+    if (resp_dly_uus[idx])
+    {
+        resp_timing_rx_window(resp_dly_uus[idx], &resp_phy, sizeof(tx_poll_msg), sizeof(rx_resp_msg), &rx_dly_uus, &rx_timeout_uus);
+    }
+    else
+    {
+        resp_timing_rx_fallback(&resp_phy, sizeof(tx_poll_msg), sizeof(rx_resp_msg), &rx_dly_uus, &rx_timeout_uus);
+    }
+    dwt_setrxaftertxdelay(rx_dly_uus);
+    dwt_setrxtimeout(rx_timeout_uus);
+
+    /* Write frame data to DW IC and start the transmission, with the reception of the response. */
+    tx_poll_msg[ALL_MSG_SN_IDX] = frame_seq_nb++;
+    dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+    dwt_writetxdata(sizeof(tx_poll_msg), tx_poll_msg, 0); /* Zero offset in TX buffer. */
+    dwt_writetxfctrl(sizeof(tx_poll_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
+    dwt_starttx(DWT_START_TX_IMMEDIATE | DWT_RESPONSE_EXPECTED);
+
+    /* Poll for reception of a frame or error/timeout. */
+    waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+
+    if (status_reg & DWT_INT_RXFCG_BIT_MASK)
+    {
+        uint16_t frame_len;
+
+        /* Clear good RX frame event in the DW IC status register. */
+        dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+
+        /* A frame has been received, read it into the local buffer. */
+        frame_len = dwt_getframelength();
+        if (frame_len <= sizeof(rx_buffer))
+        {
+            dwt_readrxdata(rx_buffer, frame_len, 0);
+
+            /* Check that the frame is the response of the anchor, the sequence number being cleared. */
+            rx_buffer[ALL_MSG_SN_IDX] = 0;
+            if (memcmp(rx_buffer, rx_resp_msg, ALL_MSG_COMMON_LEN) == 0)
+            {
+                uint32_t poll_tx_ts, resp_rx_ts, poll_rx_ts, resp_tx_ts;
+                int32_t rtd_init, rtd_resp;
+                float clockOffsetRatio;
+
+                /* Retrieve the timestamps, and compute the range as ss_twr_initiator.c. */
+                poll_tx_ts = dwt_readtxtimestamplo32();
+                resp_rx_ts = dwt_readrxtimestamplo32();
+                clockOffsetRatio = ((float)dwt_readclockoffset()) / (uint32_t)(1 << 26);
+                resp_msg_get_ts(&rx_buffer[RESP_MSG_POLL_RX_TS_IDX], &poll_rx_ts);
+                resp_msg_get_ts(&rx_buffer[RESP_MSG_RESP_TX_TS_IDX], &resp_tx_ts);
+
+                rtd_init = resp_rx_ts - poll_tx_ts;
+                rtd_resp = resp_tx_ts - poll_rx_ts;
+                range = (int32_t)(((rtd_init - rtd_resp * (1 - clockOffsetRatio)) / 2.0) * DWT_TIME_UNITS * SPEED_OF_LIGHT * 1000);
+
+                /* Follow the response delay of the anchor. */
+                resp_misses[idx] = 0;
+                if (frame_len == sizeof(rx_resp_msg))
+                {
+                    resp_dly_uus[idx] = resp_timing_get_field(&rx_buffer[RESP_MSG_DLY_IDX]);
+                }
+            }
+        }
+    }
+    else
+    {
+        /* Clear RX error/timeout events in the DW IC status register. */
+        dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+
+        /* Wide window for this anchor until its next response. See NOTE 2 below. */
+        if (resp_dly_uus[idx] && ++resp_misses[idx] >= RESP_TIMING_FALLBACK_MISSES)
+        {
+            resp_dly_uus[idx] = 0;
+            resp_misses[idx] = 0;
+        }
+    }
+    return range;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn ss_twr_initiator_multilat()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int ss_twr_initiator_multilat(void)
+{
+    uint32_t rounds = 0, fails = 0;
+    unsigned int i;
+    char str[80];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    for (i = 0; i < NUM_ANCHORS; i++)
+    {
+        resp_dly_uus[i] = RESP_TIMING_INIT_UUS;
+    }
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset and initialize DW chip. */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW3000 low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Enabling LEDs here for debug so that for each TX the D1 LED will flash on DW3000 red eval-shield boards. */
+    dwt_setleds(DWT_LEDS_ENABLE | DWT_LEDS_INIT_BLINK);
+
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* Apply default antenna delay value. */
+    dwt_setrxantennadelay(RX_ANT_DLY);
+    dwt_settxantennadelay(TX_ANT_DLY);
+
+    dwt_setlnapamode(DWT_LNA_ENABLE | DWT_PA_ENABLE);
+
+    /* Loop forever ranging to the anchors and computing the position. */
+    while (1)
+    {
+        for (i = 0; i < NUM_ANCHORS; i++)
+        {
+            range_mm[i] = range_to_anchor(i);
+        }
+
+        /* Position from the ranges of this round. See NOTE 3 below. */
+        if (multilat_solve(anchors, range_mm, NUM_ANCHORS, MULTILAT_DIM, &position) == 0)
+        {
+            BINLOG3(BINLOG_POS, position.x_mm, position.y_mm, position.z_mm);
+            BINLOG3(BINLOG_POS_QUAL, position.rms_mm, position.anchors, position.iter);
+        }
+        else
+        {
+            fails++;
+        }
+
+        if (++rounds % MULTILAT_REPORT_PERIOD == 0)
+        {
+            snprintf(str, sizeof(str), "POS X: %ld Y: %ld Z: %ld mm RMS: %lu mm ANCHORS: %u FAIL: %lu", (long)position.x_mm, (long)position.y_mm,
+                (long)position.z_mm, (unsigned long)position.rms_mm, position.anchors, (unsigned long)fails);
+            test_run_info((unsigned char *)str);
+        }
+
+        /* Execute a delay between rounds. */
+        Sleep(RNG_DELAY_MS);
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The anchors are ss_twr_responder built with "cmake -DRESP_ADDR=0x3141" to "0x3441", at the corners of a 10 x 8 m room, 2.5 m high. Their
+ *    antenna delays should be calibrated, a range bias being a position error. In 2D the tag is assumed at about the height of the anchors:
+ *    a difference of height adds to the RMS of the residuals. In 3D, anchors all at the same height put the tag below them (see NOTE 3 of
+ *    multilat.c), and at least 4 ranges are needed.
+ * 2. The anchors choose their response delay (see resp_timing.h) and send it in their responses, so the RX window is placed for each anchor
+ *    from its last response, starting from the fixed delay of the SS TWR examples. After RESP_TIMING_FALLBACK_MISSES polls in a row without
+ *    response, the window of the anchor is the wide one of resp_timing_rx_fallback() until it responds again.
+ * 3. The position is computed at the ranging rate from the ranges of the round, an anchor which did not respond being left out as long as
+ *    enough remain. It is logged with the RMS of the range residuals (e.g. "POS rms=85 mm anchors=4 iter=2" with tools/binlog_decode.py), which
+ *    grows when a range is biased, e.g. by NLOS. The printed position is the last one computed.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,324 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    ss_twr_initiator_sched.c
+ *  @brief   Single-sided two-way ranging (SS TWR) tag ranging in a slot of the anchor superframe and sleeping between rounds
+ *
+ *           This example is the SS TWR initiator of ss_twr_initiator.c turned into a low power tag. Between two ranging rounds the DW IC is in
+ *           DEEPSLEEP and the MCU waits on a kernel timer. Each round is planned by the wake-on-schedule planner (see tag_sched.h): the tag wakes
+ *           up just in time, sends the poll with a delayed TX at the start of its slot in the superframe defined by the anchor, and goes back
+ *           to sleep once the response is received. The poll reception time reported in the response keeps the tag in its slot. Each round
+ *           prints the alignment error, the wake-up latency and the energy of the DW IC, and a summary of the jitter and the average current
+ *           is printed every TAG_SCHED_REPORT_PERIOD rounds. Any of the SS TWR responder examples can be used as the anchor.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <config_options.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <range_stats.h>
+#include <resp_timing.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <tag_sched.h>
+#include <uwb_phy.h>
+
+#if defined(TEST_SS_TWR_INITIATOR_SCHED)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "SS TWR SCHED v1.0"
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Air interface of the frames, for the time spent sending the poll and the supply currents */
+static const struct uwb_phy phy = { 5, 128, 9, 1, 0, 8 };
+
+/* Slot of the tag in the superframe, slot length and round period in superframes (about 67.2 ms each). See NOTE 1 below. */
+#define TAG_SLOT      3
+#define TAG_SLOT_US   2000
+#define TAG_PERIOD_SF 15
+
+/* Default antenna delay values for 64 MHz PRF. */
+#define TX_ANT_DLY 16385
+#define RX_ANT_DLY 16385
+
+/* Frames used in the ranging process, the same as in ss_twr_initiator.c. */
+static uint8_t tx_poll_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'W', 'A', 'V', 'E', 0xE0, 0, 0 };
+static uint8_t rx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+/* Length of the common part of the message (up to and including the function code). */
+#define ALL_MSG_COMMON_LEN 10
+/* Indexes to access some of the fields in the frames defined above. */
+#define ALL_MSG_SN_IDX          2
+#define RESP_MSG_POLL_RX_TS_IDX 10
+#define RESP_MSG_RESP_TX_TS_IDX 14
+#define RESP_MSG_DLY_IDX        18
+/* Frame sequence number, incremented after each transmission. */
+static uint8_t frame_seq_nb = 0;
+
+/* Buffer to store received response message, with or without the delay field. */
+#define RX_BUF_LEN 22
+static uint8_t rx_buffer[RX_BUF_LEN];
+
+/* Hold copy of status register state here for reference so that it can be examined at a debug breakpoint. */
+static uint32_t status_reg = 0;
+
+/* Delay between frames, in UWB microseconds, and receive response timeout, as in ss_twr_initiator.c. */
+#define POLL_TX_TO_RESP_RX_DLY_UUS 240
+#define RESP_RX_TIMEOUT_UUS        400
+
+/* Response delay of the responder and the RX window it gives, updated from the delay field of the responses. See NOTE 5 below. */
+static uint16_t resp_dly_uus;
+static uint32_t resp_rx_dly_uus = POLL_TX_TO_RESP_RX_DLY_UUS;
+static uint32_t resp_rx_timeout_uus = RESP_RX_TIMEOUT_UUS;
+static uint8_t resp_misses; /* Rounds without response since the last one */
+
+/* Hold copies of computed time of flight and distance here for reference so that it can be examined at a debug breakpoint. */
+static double tof;
+static double distance;
+
+/* Statistics of the computed distances, see range_stats.h */
+static range_stats_t range_stats;
+
+/* Planner of the rounds, see tag_sched.h */
+static tag_sched_t tag_sched;
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn ss_twr_initiator_sched_wakeup()
+ *
+ * @brief Wake the DW IC up from DEEPSLEEP and restore its configuration. See NOTE 2 below.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+static void ss_twr_initiator_sched_wakeup(void)
+{
+    port_set_dw_ic_spi_slowrate();
+    dwt_wakeup_ic();
+    while (!dwt_checkidlerc()) { };
+    port_set_dw_ic_spi_fastrate();
+    dwt_restoreconfig();
+
+    /* The delay and timeout of the response are not part of the configuration kept in the AON memory. */
+    dwt_setrxaftertxdelay(resp_rx_dly_uus);
+    dwt_setrxtimeout(resp_rx_timeout_uus);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn ss_twr_initiator_sched_range()
+ *
+ * @brief Send the poll of a round at the planned time and process the response.
+ *
+ * @param  plan - plan of the round
+ *
+ * @return 1 if the round got a valid response, 0 otherwise
+ */
+static int ss_twr_initiator_sched_range(const tag_sched_plan_t *plan)
+{
+    uint32_t poll_tx_ts, resp_rx_ts, poll_rx_ts, resp_tx_ts;
+    int32_t rtd_init, rtd_resp;
+    float clockOffsetRatio;
+    uint16_t frame_len;
+    int ret = 0;
+
+    /* Write frame data to DW IC and prepare the transmission at the start of the slot. See NOTE 3 below. */
+    tx_poll_msg[ALL_MSG_SN_IDX] = frame_seq_nb++;
+    dwt_writetxdata(sizeof(tx_poll_msg), tx_poll_msg, 0); /* Zero offset in TX buffer. */
+    dwt_writetxfctrl(sizeof(tx_poll_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
+    dwt_setdelayedtrxtime(tag_sched_tx_time(plan, port_get_time_us(), dwt_readsystimestamphi32()));
+
+    if (dwt_starttx(DWT_START_TX_DELAYED | DWT_RESPONSE_EXPECTED) != DWT_SUCCESS)
+    {
+        /* Too late for the slot. */
+        return 0;
+    }
+
+    waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+
+    if (status_reg & DWT_INT_RXFCG_BIT_MASK)
+    {
+        frame_len = dwt_getframelength();
+        if (frame_len <= sizeof(rx_buffer))
+        {
+            dwt_readrxdata(rx_buffer, frame_len, 0);
+
+            /* Check that the frame is the expected response, the sequence number being cleared to simplify the validation of the frame. */
+            rx_buffer[ALL_MSG_SN_IDX] = 0;
+            if (memcmp(rx_buffer, rx_resp_msg, ALL_MSG_COMMON_LEN) == 0)
+            {
+                poll_tx_ts = dwt_readtxtimestamplo32();
+                resp_rx_ts = dwt_readrxtimestamplo32();
+                clockOffsetRatio = ((float)dwt_readclockoffset()) / (uint32_t)(1 << 26);
+                resp_msg_get_ts(&rx_buffer[RESP_MSG_POLL_RX_TS_IDX], &poll_rx_ts);
+                resp_msg_get_ts(&rx_buffer[RESP_MSG_RESP_TX_TS_IDX], &resp_tx_ts);
+
+                rtd_init = resp_rx_ts - poll_tx_ts;
+                rtd_resp = resp_tx_ts - poll_rx_ts;
+                tof = ((rtd_init - rtd_resp * (1 - clockOffsetRatio)) / 2.0) * DWT_TIME_UNITS;
+                distance = tof * SPEED_OF_LIGHT;
+                range_stats_add_and_report(&range_stats, distance);
+
+                /* Follow the response delay of the responder, used from the next wake-up. */
+                if (frame_len == sizeof(rx_resp_msg) && resp_timing_get_field(&rx_buffer[RESP_MSG_DLY_IDX]) != resp_dly_uus)
+                {
+                    resp_dly_uus = resp_timing_get_field(&rx_buffer[RESP_MSG_DLY_IDX]);
+                    resp_timing_rx_window(resp_dly_uus, &phy, sizeof(tx_poll_msg), frame_len, &resp_rx_dly_uus, &resp_rx_timeout_uus);
+                }
+
+                /* The poll reception time of the anchor is the position of the poll in the superframe. */
+                tag_sched_sync(&tag_sched, poll_rx_ts);
+                ret = 1;
+            }
+        }
+    }
+
+    if (ret)
+    {
+        resp_misses = 0;
+    }
+    else if (++resp_misses >= RESP_TIMING_FALLBACK_MISSES)
+    {
+        /* The fixed window, or the one placed from the delay, misses the responses: wide window until the next response. See NOTE 5 below. */
+        resp_timing_rx_fallback(&phy, sizeof(tx_poll_msg), sizeof(rx_resp_msg), &resp_rx_dly_uus, &resp_rx_timeout_uus);
+        resp_dly_uus = 0;
+        resp_misses = 0;
+    }
+    return ret;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn ss_twr_initiator_sched()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int ss_twr_initiator_sched(void)
+{
+    tag_sched_plan_t plan;
+    tag_sched_times_t times;
+    uint32_t t_end, t_woke, t_ready, t_tx, poll_us;
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    range_stats_init(&range_stats);
+    tag_sched_init(&tag_sched, &phy, TAG_SLOT, TAG_SLOT_US, TAG_PERIOD_SF);
+    poll_us = uwb_phy_airtime_us(&phy, 0, sizeof(tx_poll_msg), NULL);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset and initialize DW chip. */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW3000 low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+    if (dwt_initialise(DWT_DW_IDLE) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* Apply default antenna delay value. */
+    dwt_setrxantennadelay(RX_ANT_DLY);
+    dwt_settxantennadelay(TX_ANT_DLY);
+
+    /* Keep the configuration in the AON memory during DEEPSLEEP, and wake up on the WAKEUP pin or SPI CS. See NOTE 2 below. */
+    dwt_configuresleep(DWT_CONFIG | DWT_PGFCAL, DWT_PRES_SLEEP | DWT_WAKE_CSN | DWT_WAKE_WUP | DWT_SLP_EN);
+    dwt_entersleep(DWT_DW_IDLE);
+    t_end = port_get_time_us();
+
+    /* Loop forever, one ranging round per iteration. */
+    while (1)
+    {
+        /* Sleep until the planned wake-up, then wake the DW IC up. */
+        tag_sched_plan(&tag_sched, port_get_time_us(), &plan);
+        port_sleep_until_us(plan.wake_us);
+        t_woke = port_get_time_us();
+        ss_twr_initiator_sched_wakeup();
+        t_ready = port_get_time_us();
+
+        if (!tag_sched_woke(&tag_sched, &plan, t_woke, t_ready) || !ss_twr_initiator_sched_range(&plan))
+        {
+            tag_sched_miss(&tag_sched);
+        }
+
+        /* Back to DEEPSLEEP until the next round. */
+        dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK | DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+        dwt_entersleep(DWT_DW_IDLE);
+
+        /* Time spent in each state of the DW IC, the poll being sent at the planned time. See NOTE 4 below. */
+        t_tx = ((int32_t)(plan.tx_us - t_ready) > 0) ? plan.tx_us : t_ready;
+        times.sleep_us = t_woke - t_end;
+        times.wake_us = t_ready - t_woke;
+        times.idle_us = t_tx - t_ready;
+        t_end = port_get_time_us();
+        times.tx_us = ((int32_t)(t_end - t_tx) > (int32_t)poll_us) ? poll_us : 0;
+        times.rx_us = ((int32_t)(t_end - t_tx) > (int32_t)poll_us) ? t_end - t_tx - poll_us : 0;
+        tag_sched_end(&tag_sched, &times);
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The superframe is the wrap period of the 32 bit timestamps of the anchor, 2^32 device time units or about 67.2 ms, so that the anchor
+ *    needs no change: the poll reception timestamp it sends in every response tells where the poll arrived in its superframe. With 2 ms slots
+ *    the superframe holds 33 slots, each tag using its own TAG_SLOT so that the polls of the tags do not collide. A round every 15 superframes
+ *    is about one per second.
+ * 2. The DW3000 timers stop in DEEPSLEEP and its sleep counter only counts in units of about 0.2 s of a low accuracy RC oscillator, so the
+ *    wake-up is planned with the kernel timer of the MCU, which keeps running. dwt_wakeup_ic() wakes the DW IC up with its WAKEUP line, or by
+ *    holding the SPI CS line low on boards without it, both enabled by dwt_configuresleep() (DWT_WAKE_WUP and DWT_WAKE_CSN). The time needed
+ *    to start the crystal and restore the configuration varies from round to round: it is measured and calibrated by the planner, see NOTE 1
+ *    in tag_sched.c.
+ * 3. The delayed TX, programmed from the system time of the DW IC just read, gives the poll its exact time in the slot, whatever the delays of
+ *    the MCU before. If the MCU is so late that the time has passed, the round is counted as missed and the tag keeps its schedule.
+ * 4. The times are measured with the microsecond clock of the MCU, except the time spent sending the poll which is its air time. The receiver
+ *    is counted on from the end of the poll to the end of the round, which includes the reading of the response. See NOTE 3 in tag_sched.c
+ *    for the currents used to turn them into energy.
+ * 5. A responder using the response timing service (see resp_timing.h) sends its response delay in the response, as ss_twr_responder.c does, and
+ *    the RX window is placed from it, the delay changing as the responder measures its latency. The window of ss_twr_initiator.c is kept until
+ *    then, and with responders sending the 20 byte response without delay field. After RESP_TIMING_FALLBACK_MISSES rounds without response
+ *    the tag goes back to the wide window of resp_timing_rx_fallback(), which covers every delay of the responder, until the next response,
+ *    also before the first response, for a responder whose delay has already grown beyond the fixed window.
+ ****************************************************************************************************************************************************/
@@ -25,15 +25,20 @@
  */
 
 #include "deca_probe_interface.h"
+#include <binlog.h>
 #include <config_options.h>
 #include <deca_device_api.h>
 #include <deca_spi.h>
 #include <deca_types.h>
 #include <example_selection.h>
+#include <nlos.h>
 #include <port.h>
+#include <range_filter.h>
+#include <range_stats.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
 #include <stdlib.h>
+#include <telem.h>
 
 #if defined(TEST_SS_TWR_INITIATOR_STS)
 
@@ -60,6 +65,7 @@ static uint8_t rx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A',
 #define RESP_MSG_POLL_RX_TS_IDX 10
 #define RESP_MSG_RESP_TX_TS_IDX 14
 #define RESP_MSG_TS_LEN         4
+#define RESP_MSG_SRC_ADDR_IDX   7
 /* Frame sequence number, incremented after each transmission. */
 static uint8_t frame_seq_nb = 0;
 
@@ -80,8 +86,12 @@ static uint32_t status_reg = 0;
 static double tof;
 static double distance;
 
-/* Hold the amount of errors that have occurred */
-static uint32_t errors[23] = { 0 };
+/* Statistics of the computed distances, see range_stats.h */
+static range_stats_t range_stats;
+
+/* Range filter of the responders and its last output, see range_filter.h */
+static range_filter_t range_filter;
+static range_filter_out_t filtered;
 
 extern dwt_config_t config_options;
 extern dwt_txconfig_t txconfig_options;
@@ -147,10 +157,14 @@ int ss_twr_initiator_sts(void)
     int16_t stsQual;           /* This will contain STS quality index */
     uint16_t stsStatus;        /* Used to check for good STS status (no errors). */
     uint8_t firstLoopFlag = 0; /* Used to track if the program has gone through the first loop or not. */
+    uint32_t dev_id;           /* Device ID, needed to estimate the NLOS probability */
 
     /* Display application name on UART. */
     test_run_info((unsigned char *)APP_NAME);
 
+    range_stats_init(&range_stats);
+    range_filter_init(&range_filter);
+
     /* Configure SPI rate, DW3000 supports up to 36 MHz */
 #ifdef CONFIG_SPI_FAST_RATE
     port_set_dw_ic_spi_fastrate();
@@ -167,6 +181,8 @@ int ss_twr_initiator_sts(void)
     /* Probe for the correct device driver. */
     dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
 
+    dev_id = dwt_readdevid();
+
     while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
 
     if (dwt_initialise(DWT_DW_IDLE) == DWT_ERROR)
@@ -197,6 +213,9 @@ int ss_twr_initiator_sts(void)
         dwt_configuretxrf(&txconfig_options_ch9);
     }
 
+    /* Log all CIA diagnostics so that the NLOS probability of each response can be estimated. See NOTE 17 below. */
+    dwt_configciadiag(DW_CIA_DIAG_LOG_ALL);
+
     /* Apply default antenna delay value. See NOTE 2 below. */
     dwt_setrxantennadelay(RX_ANT_DLY);
     dwt_settxantennadelay(TX_ANT_DLY);
@@ -280,6 +299,7 @@ int ss_twr_initiator_sts(void)
                 if (memcmp(rx_buffer, rx_resp_msg, ALL_MSG_COMMON_LEN) == 0)
                 {
                     uint32_t poll_tx_ts, resp_rx_ts, poll_rx_ts, resp_tx_ts;
+                    uint16_t peer;
                     int32_t rtd_init, rtd_resp;
                     float clockOffsetRatio;
 
@@ -301,35 +321,45 @@ int ss_twr_initiator_sts(void)
                     tof = ((rtd_init - rtd_resp * (1 - clockOffsetRatio)) / 2.0) * DWT_TIME_UNITS;
                     distance = tof * SPEED_OF_LIGHT;
 
-                    /* Display computed distance on LCD. */
-                    snprintf(dist_str, sizeof(dist_str), "DIST: %3.2f m", distance);
-                    test_run_info((unsigned char *)dist_str);
+                    /* Accumulate computed distance, a summary is displayed periodically. */
+                    range_stats_add_and_report(&range_stats, distance);
+
+                    /* Filter the range of the responder, weighting it with the NLOS probability and the STS quality. See NOTE 17 below. */
+                    peer = rx_buffer[RESP_MSG_SRC_ADDR_IDX] | ((uint16_t)rx_buffer[RESP_MSG_SRC_ADDR_IDX + 1] << 8);
+                    range_filter_update(&range_filter, peer, (int32_t)(distance * 1000), port_get_tick_ms(),
+                        nlos_probability(&config_options, dev_id), range_filter_sts_pct(stsQual, (1 << (config_options.stsLength + 2)) * 8),
+                        &filtered);
+                    BINLOG3(BINLOG_RANGE_FILTER, peer, filtered.range_mm, filtered.velocity_mm_s);
+                    if (range_stats.count % RANGE_STATS_REPORT_PERIOD == 0)
+                    {
+                        range_filter_report(peer, &filtered);
+                    }
                 }
                 else
                 {
-                    errors[BAD_FRAME_ERR_IDX] += 1;
+                    telem_inc(BAD_FRAME_ERR_IDX);
                 }
             }
             else
             {
-                errors[RTO_ERR_IDX] += 1;
+                telem_inc(RTO_ERR_IDX);
             }
         }
         else
         {
-            check_for_status_errors(status_reg, errors);
+            check_for_status_errors(status_reg);
 
             if (!(status_reg & DWT_INT_RXFCG_BIT_MASK))
             {
-                errors[BAD_FRAME_ERR_IDX] += 1;
+                telem_inc(BAD_FRAME_ERR_IDX);
             }
             if (goodSts < 0)
             {
-                errors[PREAMBLE_COUNT_ERR_IDX] += 1;
+                telem_inc(PREAMBLE_COUNT_ERR_IDX);
             }
             if (stsQual <= 0)
             {
-                errors[CP_QUAL_ERR_IDX] += 1;
+                telem_inc(CP_QUAL_ERR_IDX);
             }
         }
 
@@ -438,4 +468,8 @@ int ss_twr_initiator_sts(void)
  *     sync with the responder device (which does the same), it should be noted that this is not a 'secure' implementation as the count is reset upon
  *     each iteration of the loop. An attacker could potentially recognise this pattern if the signal was being monitored. While it serves it's
  *     purpose in this simple example, it should not be utilised in any final solution.
+ * 17. The range filter (see range_filter.c) smooths the computed distance and estimates the range rate of each responder. Each measurement is
+ *     weighted by its probability of being NLOS, estimated from the CIR diagnostics as in the simple_rx_nlos example, and by its STS
+ *     quality. Measurements too far from the prediction are rejected. The filter output is available in "filtered" after each ranging
+ *     exchange and is displayed with the distance statistics.
  ****************************************************************************************************************************************************/
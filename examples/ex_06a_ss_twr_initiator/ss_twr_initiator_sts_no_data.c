@@ -52,9 +52,11 @@
 #include <deca_types.h>
 #include <example_selection.h>
 #include <port.h>
+#include <range_stats.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
 #include <stdlib.h>
+#include <telem.h>
 
 #if defined(TEST_SS_TWR_INITIATOR_STS_NO_DATA)
 
@@ -99,8 +101,8 @@ static uint32_t status_reg = 0;
 static double tof;
 static double distance;
 
-/* Hold the amount of errors that have occurred */
-static uint32_t errors[23] = { 0 };
+/* Statistics of the computed distances, see range_stats.h */
+static range_stats_t range_stats;
 
 extern dwt_config_t config_option_sp3;
 extern dwt_config_t config_option_sp0;
@@ -171,6 +173,8 @@ int ss_twr_initiator_sts_no_data(void)
     /* Display application name on UART. */
     test_run_info((unsigned char *)APP_NAME);
 
+    range_stats_init(&range_stats);
+
     /* Configure SPI rate, DW3000 supports up to 36 MHz */
 #ifdef CONFIG_SPI_FAST_RATE
     port_set_dw_ic_spi_fastrate();
@@ -347,41 +351,40 @@ int ss_twr_initiator_sts_no_data(void)
                             tof = ((rtd_init - rtd_resp * (1 - clockOffsetRatio)) / 2.0) * DWT_TIME_UNITS;
                             distance = tof * SPEED_OF_LIGHT;
 
-                            /* Display computed distance on LCD. */
-                            snprintf(dist_str, sizeof(dist_str), "DIST: %3.2f m", distance);
-                            test_run_info((unsigned char *)dist_str);
+                            /* Accumulate computed distance, a summary is displayed periodically. */
+                            range_stats_add_and_report(&range_stats, distance);
                         }
                         else
                         {
-                            errors[BAD_FRAME_ERR_IDX] += 1;
+                            telem_inc(BAD_FRAME_ERR_IDX);
                         }
                     }
                     else
                     {
-                        errors[RTO_ERR_IDX] += 1;
+                        telem_inc(RTO_ERR_IDX);
                     }
                 }
                 else
                 {
-                    check_for_status_errors(status_reg, errors);
+                    check_for_status_errors(status_reg);
                 }
             }
             else
             {
-                errors[PREAMBLE_COUNT_ERR_IDX] += 1;
+                telem_inc(PREAMBLE_COUNT_ERR_IDX);
             }
         }
         else
         {
-            check_for_status_errors(status_reg, errors);
+            check_for_status_errors(status_reg);
 
             if (goodSts < 0)
             {
-                errors[PREAMBLE_COUNT_ERR_IDX] += 1;
+                telem_inc(PREAMBLE_COUNT_ERR_IDX);
             }
             if (stsQual <= 0)
             {
-                errors[CP_QUAL_ERR_IDX] += 1;
+                telem_inc(CP_QUAL_ERR_IDX);
             }
         }
 
@@ -21,6 +21,8 @@
 #include <deca_spi.h>
 #include <example_selection.h>
 #include <port.h>
+#include <prof.h>
+#include <resp_timing.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
 
@@ -54,7 +56,7 @@ static dwt_config_t config = {
 
 /* Frames used in the ranging process. See NOTE 3 below. */
 static uint8_t rx_poll_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'W', 'A', 'V', 'E', 0xE0, 0, 0 };
-static uint8_t tx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static uint8_t tx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 /* Length of the common part of the message (up to and including the function code, see NOTE 3 below). */
 #define ALL_MSG_COMMON_LEN 10
 /* Index to access some of the fields in the frames involved in the process. */
@@ -62,6 +64,14 @@ static uint8_t tx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A',
 #define RESP_MSG_POLL_RX_TS_IDX 10
 #define RESP_MSG_RESP_TX_TS_IDX 14
 #define RESP_MSG_TS_LEN         4
+#define RESP_MSG_DLY_IDX        18
+#define POLL_MSG_DST_ADDR_IDX   5
+#define RESP_MSG_SRC_ADDR_IDX   7
+
+/* Address of the responder, "WA" unless built with another one, e.g. "cmake -DRESP_ADDR=0x3141". See NOTE 4 below. */
+#ifndef RESP_ADDR
+#define RESP_ADDR 0x4157
+#endif
 /* Frame sequence number, incremented after each transmission. */
 static uint8_t frame_seq_nb = 0;
 
@@ -73,8 +83,9 @@ static uint8_t rx_buffer[RX_BUF_LEN];
 /* Hold copy of status register state here for reference so that it can be examined at a debug breakpoint. */
 static uint32_t status_reg = 0;
 
-/* Delay between frames, in UWB microseconds. See NOTE 1 below. */
-#define POLL_RX_TO_RESP_TX_DLY_UUS 650
+/* Delay between frames, in UWB microseconds, chosen by the response timing service. See NOTE 1 and NOTE 15 below. */
+static resp_timing_t resp_timing;
+static const struct uwb_phy resp_phy = { 5, 128, 9, 1, 0, 8 }; /* As config */
 
 /* Timestamps of frames transmission/reception. */
 static uint64_t poll_rx_ts;
@@ -138,6 +149,12 @@ int ss_twr_responder(void)
      * Note, in real low power applications the LEDs should not be used. */
     dwt_setlnapamode(DWT_LNA_ENABLE | DWT_PA_ENABLE);
 
+    resp_timing_init(&resp_timing, &resp_phy, sizeof(rx_poll_msg));
+
+    /* Address of the responder, as destination of the polls it answers and source of its responses. */
+    rx_poll_msg[POLL_MSG_DST_ADDR_IDX] = tx_resp_msg[RESP_MSG_SRC_ADDR_IDX] = (uint8_t)RESP_ADDR;
+    rx_poll_msg[POLL_MSG_DST_ADDR_IDX + 1] = tx_resp_msg[RESP_MSG_SRC_ADDR_IDX + 1] = (uint8_t)(RESP_ADDR >> 8);
+
     /* Loop forever responding to ranging requests. */
     while (1)
     {
@@ -151,6 +168,9 @@ int ss_twr_responder(void)
         {
             uint16_t frame_len;
 
+            /* Measure the time from the poll reception to the programming of the response. See NOTE 14 below. */
+            PROF_START(PROF_RESP_TURNAROUND);
+
             /* Clear good RX frame event in the DW IC status register. */
             dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
 
@@ -166,29 +186,56 @@ int ss_twr_responder(void)
                 if (memcmp(rx_buffer, rx_poll_msg, ALL_MSG_COMMON_LEN) == 0)
                 {
                     uint32_t resp_tx_time;
+                    uint16_t delay_uus;
+                    int first = 1;
                     int ret;
 
                     /* Retrieve poll reception timestamp. */
                     poll_rx_ts = get_rx_timestamp_u64();
 
-                    /* Compute response message transmission time. See NOTE 7 below. */
-                    resp_tx_time = (poll_rx_ts + (POLL_RX_TO_RESP_TX_DLY_UUS * UUS_TO_DWT_TIME)) >> 8;
-                    dwt_setdelayedtrxtime(resp_tx_time);
-
-                    /* Response TX timestamp is the transmission time we programmed plus the antenna delay. */
-                    resp_tx_ts = (((uint64_t)(resp_tx_time & 0xFFFFFFFEUL)) << 8) + TX_ANT_DLY;
-
-                    /* Write all timestamps in the final message. See NOTE 8 below. */
-                    resp_msg_set_ts(&tx_resp_msg[RESP_MSG_POLL_RX_TS_IDX], poll_rx_ts);
-                    resp_msg_set_ts(&tx_resp_msg[RESP_MSG_RESP_TX_TS_IDX], resp_tx_ts);
-
-                    /* Write and send the response message. See NOTE 9 below. */
+                    /* Send the response with the delay of the service, then at the next feasible time while it is late. See NOTE 15 below. */
+                    delay_uus = resp_timing.delay_uus;
                     tx_resp_msg[ALL_MSG_SN_IDX] = frame_seq_nb;
-                    dwt_writetxdata(sizeof(tx_resp_msg), tx_resp_msg, 0); /* Zero offset in TX buffer. */
-                    dwt_writetxfctrl(sizeof(tx_resp_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
-                    ret = dwt_starttx(DWT_START_TX_DELAYED);
-
-                    /* If dwt_starttx() returns an error, abandon this ranging exchange and proceed to the next one. See NOTE 10 below. */
+                    resp_msg_set_ts(&tx_resp_msg[RESP_MSG_POLL_RX_TS_IDX], poll_rx_ts);
+                    do
+                    {
+                        /* Compute response message transmission time. See NOTE 7 below. */
+                        resp_tx_time = resp_timing_tx_time(poll_rx_ts, delay_uus);
+                        dwt_setdelayedtrxtime(resp_tx_time);
+
+                        /* Response TX timestamp is the transmission time we programmed plus the antenna delay. */
+                        resp_tx_ts = (((uint64_t)(resp_tx_time & 0xFFFFFFFEUL)) << 8) + TX_ANT_DLY;
+
+                        /* Write the timestamps and the delay in the response message. See NOTE 8 below. */
+                        resp_msg_set_ts(&tx_resp_msg[RESP_MSG_RESP_TX_TS_IDX], resp_tx_ts);
+                        resp_timing_set_field(&tx_resp_msg[RESP_MSG_DLY_IDX], delay_uus);
+
+                        /* Write and send the response message. See NOTE 9 below. */
+                        PROF_START(PROF_TX_DATA);
+                        dwt_writetxdata(sizeof(tx_resp_msg), tx_resp_msg, 0); /* Zero offset in TX buffer. */
+                        dwt_writetxfctrl(sizeof(tx_resp_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
+                        PROF_STOP(PROF_TX_DATA);
+                        if (first)
+                        {
+                            /* First attempt: measure the latency to adapt the delay to it. */
+                            uint32_t sys_time = dwt_readsystimestamphi32();
+
+                            ret = dwt_starttx(DWT_START_TX_DELAYED);
+                            PROF_STOP(PROF_RESP_TURNAROUND);
+                            resp_timing_started(&resp_timing, (uint32_t)poll_rx_ts, sys_time, ret != DWT_SUCCESS);
+                            first = 0;
+                        }
+                        else
+                        {
+                            ret = dwt_starttx(DWT_START_TX_DELAYED);
+                        }
+                        if (ret != DWT_SUCCESS)
+                        {
+                            delay_uus = resp_timing_retry(&resp_timing, (uint32_t)poll_rx_ts, dwt_readsystimestamphi32(), delay_uus);
+                        }
+                    } while (ret != DWT_SUCCESS && delay_uus != 0);
+
+                    /* If no attempt of dwt_starttx() succeeded, abandon this ranging exchange and proceed to the next one. See NOTE 10 below. */
                     if (ret == DWT_SUCCESS)
                     {
                         /* Poll DW IC until TX frame sent event set. See NOTE 6 below. */
@@ -199,6 +246,11 @@ int ss_twr_responder(void)
 
                         /* Increment frame sequence number after transmission of the poll message (modulo 256). */
                         frame_seq_nb++;
+                        if (frame_seq_nb == 0)
+                        {
+                            PROF_DUMP();
+                            resp_timing_report(&resp_timing);
+                        }
                     }
                 }
             }
@@ -227,7 +279,7 @@ int ss_twr_responder(void)
  *
  *                       <--TDLY->                   - POLL_TX_TO_RESP_RX_DLY_UUS (RDLY-RLEN)
  *                               <-RLEN->            - RESP_RX_TIMEOUT_UUS   (length of response frame)
- *                    <----RDLY------>               - POLL_RX_TO_RESP_TX_DLY_UUS (depends on how quickly responder can turn around and reply)
+ *                    <----RDLY------>               - response delay (depends on how quickly responder can turn around and reply, see NOTE 15)
  *
  *
  * 2. The sum of the values is the TX to RX antenna delay, experimentally determined by a calibration process. Here we use a hard coded typical value
@@ -251,10 +303,13 @@ int ss_twr_responder(void)
  *    Response message:
  *     - byte 10 -> 13: poll message reception timestamp.
  *     - byte 14 -> 17: response message transmission timestamp.
+ *     - byte 18/19: response delay in UWB microseconds, see NOTE 15 below.
  *    All messages end with a 2-byte checksum automatically set by DW IC.
  * 4. Source and destination addresses are hard coded constants in this example to keep it simple but for a real product every device should have a
  *    unique ID. Here, 16-bit addressing is used to keep the messages as short as possible but, in an actual application, this should be done only
  *    after an exchange of specific messages used to define those short addresses for each device participating to the ranging exchange.
+ *    The address of the responder can be changed at build time with RESP_ADDR, e.g. to give each anchor of the ss_twr_initiator_multilat
+ *    example its own.
  * 5. In a real application, for optimum performance within regulatory limits, it may be necessary to set TX pulse bandwidth and TX power, (using
  *    the dwt_configuretxrf API call) to per device calibrated values saved in the target system or the DW IC OTP memory.
  * 6. We use polled mode of operation here to keep the example as simple as possible but all status events can be used to generate interrupts. Please
@@ -272,16 +327,25 @@ int ss_twr_responder(void)
  * 9. dwt_writetxdata() takes the full size of the message as a parameter but only copies (size - 2) bytes as the check-sum at the end of the frame is
  *    automatically appended by the DW IC. This means that our variable could be two bytes shorter without losing any data (but the sizeof would not
  *    work anymore then as we would still have to indicate the full length of the frame to dwt_writetxdata()).
- * 10. When running this example on the DW3000 platform with the POLL_RX_TO_RESP_TX_DLY response delay provided, the dwt_starttx() is always
- *     successful. However, in cases where the delay is too short (or something else interrupts the code flow), then the dwt_starttx() might be issued
- *     too late for the configured start time. The code below provides an example of how to handle this condition: In this case it abandons the
- *     ranging exchange and simply goes back to awaiting another poll message. If this error handling code was not here, a late dwt_starttx() would
- *     result in the code flow getting stuck waiting subsequent RX event that will will never come. The companion "initiator" example (ex_06a) should
- *     timeout from awaiting the "response" and proceed to send another poll in due course to initiate another ranging exchange.
+ * 10. The response delay is chosen so that the dwt_starttx() is normally successful. However, if something interrupts the code flow for longer than
+ *     the latencies seen so far, then the dwt_starttx() might be issued too late for the configured start time. The response is then programmed
+ *     again for a later time (see NOTE 15), and if that is out of the RX window of the initiator the code abandons the ranging exchange and simply
+ *     goes back to awaiting another poll message. If this error handling code was not here, a late dwt_starttx() would result in the code flow
+ *     getting stuck waiting subsequent RX event that will will never come. The companion "initiator" example (ex_06a) should timeout from awaiting
+ *     the "response" and proceed to send another poll in due course to initiate another ranging exchange.
  * 11. The user is referred to DecaRanging ARM application (distributed with EVK1000 product) for additional practical example of usage, and to the
  *     DW IC API Guide for more details on the DW IC driver functions.
  * 12. In this example, the DW IC is put into IDLE state after calling dwt_initialise(). This means that a fast SPI rate of up to 20 MHz can be used
  *     thereafter.
  * 13. Desired configuration by user may be different to the current programmed configuration. dwt_configure is called to set desired
  *     configuration.
+ * 14. The PROF_START()/PROF_STOP() pairs (see prof.h) measure the time from the detection of the poll to the call of dwt_starttx(), which has
+ *     to fit in the response delay, and the SPI transfer of the response, in CPU cycles. The histograms are printed every 256 responses.
+ *     They expand to nothing unless the application is built with "cmake -DPROF=1".
+ * 15. The response delay is not fixed: the response timing service (see resp_timing.h) measures the time from the poll RMARKER to dwt_starttx() with
+ *     the system time of the DW IC and keeps the delay as short as the recent latencies allow, starting from 650 UUS. A late dwt_starttx() raises the
+ *     delay and the response is sent at the next feasible time, up to RESP_TIMING_SPAN_UUS later. The delay used is sent in the response so that the
+ *     initiator can place its RX window, and the latency statistics and counters of late, retried and dropped responses are printed every 256
+ *     responses. The delay moves by small steps, so that each response falls in the RX window placed from the previous one, and never below
+ *     the opening of the fixed RX window of the initiator (see NOTE 3 in resp_timing.c).
  ****************************************************************************************************************************************************/
@@ -0,0 +1,207 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    ss_twr_responder_aoa.c
+ *  @brief   Single-sided two-way ranging (SS TWR) responder example code, tag of the angle of arrival example
+ *
+ *           This is the responder of ss_twr_initiator_aoa.c, the tag located by a PDoA anchor. It waits for a "poll" message, and then sends a
+ *           "response" message with the poll RX and response TX time-stamps, as ss_twr_responder.c. The frames carry an STS with the
+ *           configuration of simple_tx_pdoa.c, so that the anchor measures the PDoA of the response.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+
+#if defined(TEST_SS_TWR_RESPONDER_AOA)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "SS TWR RESP AOA v1.0"
+
+/* Communication configuration of the PDoA examples, with the STS. See NOTE 1 below. */
+static dwt_config_t config = {
+    5,                                   /* Channel number. */
+    DWT_PLEN_128,                        /* Preamble length. Used in TX only. */
+    DWT_PAC8,                            /* Preamble acquisition chunk size. Used in RX only. */
+    9,                                   /* TX preamble code. Used in TX only. */
+    9,                                   /* RX preamble code. Used in RX only. */
+    1,                                   /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,                          /* Data rate. */
+    DWT_PHRMODE_STD,                     /* PHY header mode. */
+    DWT_PHRRATE_STD,                     /* PHY header rate. */
+    (129 + 8 - 8),                       /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    (DWT_STS_MODE_1 | DWT_STS_MODE_SDC), /* STS enabled, deterministic code */
+    DWT_STS_LEN_256,                     /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0                          /* PDOA mode off, the tag has a single antenna */
+};
+
+/* Default antenna delay values for 64 MHz PRF. */
+#define TX_ANT_DLY 16385
+#define RX_ANT_DLY 16385
+
+/* Frames used in the ranging process, as ss_twr_responder.c without the delay field. */
+static uint8_t rx_poll_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'W', 'A', 'V', 'E', 0xE0, 0, 0 };
+static uint8_t tx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+/* Length of the common part of the message (up to and including the function code). */
+#define ALL_MSG_COMMON_LEN 10
+/* Index to access some of the fields in the frames involved in the process. */
+#define ALL_MSG_SN_IDX          2
+#define RESP_MSG_POLL_RX_TS_IDX 10
+#define RESP_MSG_RESP_TX_TS_IDX 14
+/* Frame sequence number, incremented after each transmission. */
+static uint8_t frame_seq_nb = 0;
+
+/* Buffer to store received messages. */
+#define RX_BUF_LEN 12
+static uint8_t rx_buffer[RX_BUF_LEN];
+
+/* Hold copy of status register state here for reference so that it can be examined at a debug breakpoint. */
+static uint32_t status_reg = 0;
+
+/* Delay between the poll and the response RMARKERs, in UWB microseconds. See NOTE 2 below. */
+#define POLL_RX_TO_RESP_TX_DLY_UUS 1200
+
+/* Timestamps of frames transmission/reception. */
+static uint64_t poll_rx_ts;
+static uint64_t resp_tx_ts;
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn ss_twr_responder_aoa()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int ss_twr_responder_aoa(void)
+{
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset and initialize DW chip. */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW3000 low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Enabling LEDs here for debug so that for each TX the D1 LED will flash on DW3000 red eval-shield boards. */
+    dwt_setleds(DWT_LEDS_ENABLE | DWT_LEDS_INIT_BLINK);
+
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* Apply default antenna delay value. */
+    dwt_setrxantennadelay(RX_ANT_DLY);
+    dwt_settxantennadelay(TX_ANT_DLY);
+
+    dwt_setlnapamode(DWT_LNA_ENABLE | DWT_PA_ENABLE);
+
+    /* Loop forever responding to ranging requests. */
+    while (1)
+    {
+        /* Activate reception immediately. */
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+
+        /* Poll for reception of a frame or error/timeout. */
+        waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_ERR), 0);
+
+        if (status_reg & DWT_INT_RXFCG_BIT_MASK)
+        {
+            uint16_t frame_len;
+
+            /* Clear good RX frame event in the DW IC status register. */
+            dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+
+            /* A frame has been received, read it into the local buffer. */
+            frame_len = dwt_getframelength();
+            if (frame_len <= sizeof(rx_buffer))
+            {
+                dwt_readrxdata(rx_buffer, frame_len, 0);
+
+                /* Check that the frame is a poll sent by "SS TWR initiator AOA" example.
+                 * As the sequence number field of the frame is not relevant, it is cleared to simplify the validation of the frame. */
+                rx_buffer[ALL_MSG_SN_IDX] = 0;
+                if (memcmp(rx_buffer, rx_poll_msg, ALL_MSG_COMMON_LEN) == 0)
+                {
+                    uint32_t resp_tx_time;
+
+                    /* Retrieve poll reception timestamp. */
+                    poll_rx_ts = get_rx_timestamp_u64();
+
+                    /* Compute response message transmission time. */
+                    resp_tx_time = (poll_rx_ts + (POLL_RX_TO_RESP_TX_DLY_UUS * UUS_TO_DWT_TIME)) >> 8;
+                    dwt_setdelayedtrxtime(resp_tx_time);
+
+                    /* Response TX timestamp is the transmission time we programmed plus the antenna delay. */
+                    resp_tx_ts = (((uint64_t)(resp_tx_time & 0xFFFFFFFEUL)) << 8) + TX_ANT_DLY;
+
+                    /* Write all timestamps in the final message. */
+                    resp_msg_set_ts(&tx_resp_msg[RESP_MSG_POLL_RX_TS_IDX], poll_rx_ts);
+                    resp_msg_set_ts(&tx_resp_msg[RESP_MSG_RESP_TX_TS_IDX], resp_tx_ts);
+
+                    /* Write and send the response message. */
+                    tx_resp_msg[ALL_MSG_SN_IDX] = frame_seq_nb;
+                    dwt_writetxdata(sizeof(tx_resp_msg), tx_resp_msg, 0); /* Zero offset in TX buffer. */
+                    dwt_writetxfctrl(sizeof(tx_resp_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
+
+                    /* If dwt_starttx() is late, abandon this ranging exchange and wait for the next poll. */
+                    if (dwt_starttx(DWT_START_TX_DELAYED) == DWT_SUCCESS)
+                    {
+                        /* Poll DW IC until TX frame sent event set. */
+                        waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+
+                        /* Clear TXFRS event. */
+                        dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+
+                        /* Increment frame sequence number after transmission of the response message (modulo 256). */
+                        frame_seq_nb++;
+                    }
+                }
+            }
+        }
+        else
+        {
+            /* Clear RX error events in the DW IC status register. */
+            dwt_writesysstatuslo(SYS_STATUS_ALL_RX_ERR);
+        }
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The PDoA needs a long STS, which the SS TWR examples do not use, so this pair has the configuration of simple_tx_pdoa.c. With the
+ *    deterministic code (DWT_STS_MODE_SDC) no STS key or IV is exchanged between the devices.
+ * 2. With STS mode 1 the RMARKER is at the start of the STS, so the poll is received about 290 us after its RMARKER, and the response preamble
+ *    starts about 140 us before its own. The response delay covers both in addition to the turnaround of the responder. It is longer than in
+ *    ss_twr_responder.c, which makes the clock offset correction of the initiator more important to the accuracy of the range.
+ ****************************************************************************************************************************************************/
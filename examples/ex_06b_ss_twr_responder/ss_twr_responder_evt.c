@@ -0,0 +1,316 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    ss_twr_responder_evt.c
+ *  @brief   Event driven single-sided two-way ranging (SS TWR) responder example code
+ *
+ *           Same exchange as the "SS TWR responder" example and companion of the "SS TWR initiator" example, but the responder never waits for
+ *           the DW IC: the poll is answered from the RX good frame callback of the driver and the receiver is turned back on by the DW IC itself
+ *           at the end of the response. The application returns once the device is armed, and the CPU idles between frames. As the responder is
+ *           listening at all times except while sending a response, one responder serves any number of initiators, up to the capacity of the air
+ *           time. The number of exchanges per second is printed every second from a low priority work queue.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <prof.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+
+#if defined(TEST_SS_TWR_RESPONDER_EVT)
+
+#include <zephyr.h>
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "SS TWR RESP EVT v1.0"
+
+/* Default communication configuration, same as the "SS TWR responder" example. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Default antenna delay values for 64 MHz PRF. */
+#define TX_ANT_DLY 16385
+#define RX_ANT_DLY 16385
+
+/* Frames used in the ranging process, see the "SS TWR responder" example. */
+static uint8_t rx_poll_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'W', 'A', 'V', 'E', 0xE0, 0, 0 };
+static uint8_t tx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+/* Length of the common part of the message (up to and including the function code). */
+#define ALL_MSG_COMMON_LEN 10
+/* Index to access some of the fields in the frames involved in the process. */
+#define ALL_MSG_SN_IDX          2
+#define RESP_MSG_POLL_RX_TS_IDX 10
+#define RESP_MSG_RESP_TX_TS_IDX 14
+/* Frame sequence number, incremented after each transmission. */
+static uint8_t frame_seq_nb = 0;
+
+/* Buffer to store received messages. */
+#define RX_BUF_LEN 12
+static uint8_t rx_buffer[RX_BUF_LEN];
+
+/* Delay between the poll reception and the response transmission, in UWB microseconds. See NOTE 2 below. */
+#define POLL_RX_TO_RESP_TX_DLY_UUS 650
+
+/* Period of the capacity report, in seconds. */
+#define REPORT_PERIOD_S 1
+
+/* Work queue of the capacity report. See NOTE 3 below. */
+#define REPORT_STACK_SIZE 1024
+K_THREAD_STACK_DEFINE(report_stack, REPORT_STACK_SIZE);
+static struct k_work_q report_queue;
+static struct k_work_delayable report_work;
+
+/* Event counters, written by the callbacks and read by the report. */
+static volatile uint32_t num_exchanges; /* responses sent */
+static volatile uint32_t num_late;      /* responses abandoned, dwt_starttx() too late */
+static volatile uint32_t num_other;     /* good frames which are not a poll */
+static volatile uint32_t num_rx_err;    /* RX errors and timeouts */
+static volatile uint32_t busy_us;       /* time spent in the RX good frame callback */
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+static void rx_ok_cb(const dwt_cb_data_t *cb_data);
+static void rx_err_cb(const dwt_cb_data_t *cb_data);
+static void tx_conf_cb(const dwt_cb_data_t *cb_data);
+static void report_handler(struct k_work *work);
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn ss_twr_responder_evt()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int ss_twr_responder_evt(void)
+{
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset and initialize DW chip. */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW3000 low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* Apply default antenna delay value. */
+    dwt_setrxantennadelay(RX_ANT_DLY);
+    dwt_settxantennadelay(TX_ANT_DLY);
+
+    /* Register the call-backs, an RX timeout is handled as an RX error (SPI CRC error callback is not used). */
+    dwt_setcallbacks(&tx_conf_cb, &rx_ok_cb, &rx_err_cb, &rx_err_cb, NULL, NULL, NULL);
+
+    /* Enable wanted interrupts (TX confirmation, RX good frames, RX timeouts and RX errors). */
+    dwt_setinterrupt(DWT_INT_TXFRS_BIT_MASK | DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR, 0, DWT_ENABLE_INT);
+
+    /*Clearing the SPI ready interrupt*/
+    dwt_writesysstatuslo(DWT_INT_RCINIT_BIT_MASK | DWT_INT_SPIRDY_BIT_MASK);
+
+    /* Install DW IC IRQ handler. See NOTE 1 below. */
+    port_set_dwic_isr(dwt_isr);
+
+    /* The receiver is turned on as soon as a response has been sent, and stays on until the next frame. See NOTE 1 below. */
+    dwt_setrxaftertxdelay(0);
+    dwt_setrxtimeout(0);
+    dwt_setpreambledetecttimeout(0);
+
+    /* Start the capacity report. */
+    k_work_queue_start(&report_queue, report_stack, K_THREAD_STACK_SIZEOF(report_stack), K_LOWEST_APPLICATION_THREAD_PRIO, NULL);
+    k_work_init_delayable(&report_work, report_handler);
+    k_work_schedule_for_queue(&report_queue, &report_work, K_SECONDS(REPORT_PERIOD_S));
+
+    /* Activate reception immediately, everything else is done by the callbacks. */
+    dwt_rxenable(DWT_START_RX_IMMEDIATE);
+
+    return 0;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn rx_ok_cb()
+ *
+ * @brief Callback to process RX good frame events. Answers a poll with a delayed response, the receiver is turned on again by the DW IC
+ *        when the response has been sent. Any other frame, or a response which could not be sent in time, turns the receiver on immediately.
+ *
+ * @param  cb_data  callback data
+ *
+ * @return  none
+ */
+static void rx_ok_cb(const dwt_cb_data_t *cb_data)
+{
+    uint32_t start = port_get_time_us();
+    uint32_t resp_tx_time;
+    uint64_t poll_rx_ts, resp_tx_ts;
+
+    PROF_START(PROF_RESP_TURNAROUND);
+
+    if (cb_data->datalength != sizeof(rx_poll_msg))
+    {
+        num_other++;
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+        busy_us += port_get_time_us() - start;
+        return;
+    }
+
+    /* As the sequence number field of the frame is not relevant, it is cleared to simplify the validation of the frame. */
+    dwt_readrxdata(rx_buffer, cb_data->datalength, 0);
+    rx_buffer[ALL_MSG_SN_IDX] = 0;
+    if (memcmp(rx_buffer, rx_poll_msg, ALL_MSG_COMMON_LEN) != 0)
+    {
+        num_other++;
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+        busy_us += port_get_time_us() - start;
+        return;
+    }
+
+    /* Compute response message transmission time, and the response TX timestamp as the programmed time plus the antenna delay. */
+    poll_rx_ts = get_rx_timestamp_u64();
+    resp_tx_time = (poll_rx_ts + (POLL_RX_TO_RESP_TX_DLY_UUS * UUS_TO_DWT_TIME)) >> 8;
+    dwt_setdelayedtrxtime(resp_tx_time);
+    resp_tx_ts = (((uint64_t)(resp_tx_time & 0xFFFFFFFEUL)) << 8) + TX_ANT_DLY;
+
+    resp_msg_set_ts(&tx_resp_msg[RESP_MSG_POLL_RX_TS_IDX], poll_rx_ts);
+    resp_msg_set_ts(&tx_resp_msg[RESP_MSG_RESP_TX_TS_IDX], resp_tx_ts);
+
+    /* Write and send the response message, with the receiver turned on at its end. See NOTE 2 below. */
+    tx_resp_msg[ALL_MSG_SN_IDX] = frame_seq_nb;
+    dwt_writetxdata(sizeof(tx_resp_msg), tx_resp_msg, 0); /* Zero offset in TX buffer. */
+    dwt_writetxfctrl(sizeof(tx_resp_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
+    if (dwt_starttx(DWT_START_TX_DELAYED | DWT_RESPONSE_EXPECTED) != DWT_SUCCESS)
+    {
+        num_late++;
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+    }
+    PROF_STOP(PROF_RESP_TURNAROUND);
+    busy_us += port_get_time_us() - start;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn rx_err_cb()
+ *
+ * @brief Callback to process RX error and timeout events. The receiver is turned on again immediately.
+ *
+ * @param  cb_data  callback data
+ *
+ * @return  none
+ */
+static void rx_err_cb(const dwt_cb_data_t *cb_data)
+{
+    (void)cb_data;
+    num_rx_err++;
+    dwt_rxenable(DWT_START_RX_IMMEDIATE);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn tx_conf_cb()
+ *
+ * @brief Callback to process TX confirmation events. The response has been sent and the receiver is already on.
+ *
+ * @param  cb_data  callback data
+ *
+ * @return  none
+ */
+static void tx_conf_cb(const dwt_cb_data_t *cb_data)
+{
+    (void)cb_data;
+    num_exchanges++;
+    frame_seq_nb++;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn report_handler()
+ *
+ * @brief Prints the events of the last period and schedules the next report. See NOTE 4 below.
+ *
+ * @param  work  report work item
+ *
+ * @return  none
+ */
+static void report_handler(struct k_work *work)
+{
+    static uint32_t last_exchanges, last_late, last_other, last_rx_err, last_busy_us, last_time_us;
+    uint32_t exchanges = num_exchanges, late = num_late, other = num_other, rx_err = num_rx_err, busy = busy_us;
+    uint32_t now = port_get_time_us();
+    uint32_t elapsed = now - last_time_us;
+    char str[96];
+
+    (void)work;
+
+    snprintf(str, sizeof(str), "EVT xchg/s=%lu late=%lu other=%lu rxerr=%lu busy=%lu.%lu%%", (unsigned long)((exchanges - last_exchanges) / REPORT_PERIOD_S),
+        (unsigned long)(late - last_late), (unsigned long)(other - last_other), (unsigned long)(rx_err - last_rx_err),
+        (unsigned long)((uint64_t)(busy - last_busy_us) * 100 / elapsed), (unsigned long)((uint64_t)(busy - last_busy_us) * 1000 / elapsed % 10));
+    test_run_info((unsigned char *)str);
+
+    last_exchanges = exchanges;
+    last_late = late;
+    last_other = other;
+    last_rx_err = rx_err;
+    last_busy_us = busy;
+    last_time_us = now;
+
+    PROF_DUMP();
+
+    k_work_schedule_for_queue(&report_queue, &report_work, K_SECONDS(REPORT_PERIOD_S));
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. port_set_dwic_isr() enables the DW IC interrupt line of the dw3000 driver module, which runs dwt_isr() from the system work queue. The
+ *    callbacks therefore run in thread context and may use the driver, and the application does not poll the status register nor sleep. Unlike
+ *    ds_twr_responder_sts.c, which sleeps for most of the ranging period after each exchange and so only serves an initiator ranging in step
+ *    with it, this responder is deaf only while it sends a response (about 200 us with this configuration). The RX timeouts are disabled, so
+ *    the receiver stays on until the next frame.
+ * 2. DWT_RESPONSE_EXPECTED with a zero RX after TX delay turns the receiver on in the DW IC as soon as the response has been sent, without any
+ *    action from the host. The callback only has to program the response within POLL_RX_TO_RESP_TX_DLY_UUS of the poll. If dwt_starttx()
+ *    is late the transmission is abandoned, the initiator times out, and the receiver is turned on immediately for the next poll. The number of
+ *    late responses shows whether the response delay is long enough for the latency of the system work queue. A poll arriving while a
+ *    response is sent, or which collides with another poll, is lost and the initiator retries in its next period.
+ * 3. The report runs from its own work queue at the lowest application priority so the printing never delays the system work queue, and thus
+ *    the responses. The counters are 32 bit words written by the callbacks only.
+ * 4. Each report prints the responses sent in the last period, the late responses, the other good frames, the RX errors and the share of the
+ *    time spent in the RX callback, the rest of which is idle time of the CPU. The capacity of the responder with several initiators, and the
+ *    comparison with the sleeping and polling responders, is estimated by tools/twr_resp_sim.py.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,338 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    ss_twr_responder_sniff.c
+ *  @brief   Duty cycled single-sided two-way ranging (SS TWR) responder example code
+ *
+ *           The event driven responder of ss_twr_responder_evt.c with the receiver in SNIFF mode while it waits for polls. The SNIFF ON and
+ *           OFF times are chosen by the adaptive controller of sniff_ctrl.h from the preamble length and the traffic observed, and the RX duty
+ *           cycle and estimated current are printed every second. Companion of the "SS TWR initiator" example, for battery powered
+ *           responders and anchors.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <sniff_ctrl.h>
+
+#if defined(TEST_SS_TWR_RESPONDER_SNIFF)
+
+#include <zephyr.h>
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "SS TWR RESP SNIFF v1.0"
+
+/* Default communication configuration, same as the "SS TWR responder" example. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Air interface of the configuration above, with its PAC size, for the SNIFF controller. */
+static const struct uwb_phy sniff_phy = { 5, 128, 9, 1, 0, 8 };
+
+/* Default antenna delay values for 64 MHz PRF. */
+#define TX_ANT_DLY 16385
+#define RX_ANT_DLY 16385
+
+/* Frames used in the ranging process, see the "SS TWR responder" example. */
+static uint8_t rx_poll_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'W', 'A', 'V', 'E', 0xE0, 0, 0 };
+static uint8_t tx_resp_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'V', 'E', 'W', 'A', 0xE1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+/* Length of the common part of the message (up to and including the function code). */
+#define ALL_MSG_COMMON_LEN 10
+/* Index to access some of the fields in the frames involved in the process. */
+#define ALL_MSG_SN_IDX          2
+#define RESP_MSG_POLL_RX_TS_IDX 10
+#define RESP_MSG_RESP_TX_TS_IDX 14
+/* Frame sequence number, incremented after each transmission. */
+static uint8_t frame_seq_nb = 0;
+
+/* Buffer to store received messages. */
+#define RX_BUF_LEN 12
+static uint8_t rx_buffer[RX_BUF_LEN];
+
+/* Delay between the poll reception and the response transmission, in UWB microseconds. */
+#define POLL_RX_TO_RESP_TX_DLY_UUS 650
+
+/* Period of the SNIFF controller updates, in seconds. */
+#define UPDATE_PERIOD_S 1
+
+/* Battery capacity for the estimate of the battery life, in mAh. */
+#define BATTERY_MAH 2600
+
+/* SNIFF controller, only used from the system work queue. See NOTE 1 below. */
+static sniff_ctrl_t sniff;
+static struct k_work_delayable update_work;
+static uint32_t last_update_us;
+
+/* Work queue of the report. */
+#define REPORT_STACK_SIZE 1024
+K_THREAD_STACK_DEFINE(report_stack, REPORT_STACK_SIZE);
+static struct k_work_q report_queue;
+static struct k_work report_work;
+static sniff_ctrl_t report_snap; /* controller state of the last update */
+static uint32_t report_exchanges, report_late;
+
+static uint32_t num_exchanges; /* responses sent */
+static uint32_t num_late;      /* responses abandoned, dwt_starttx() too late */
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+static void rx_ok_cb(const dwt_cb_data_t *cb_data);
+static void rx_err_cb(const dwt_cb_data_t *cb_data);
+static void tx_conf_cb(const dwt_cb_data_t *cb_data);
+static void update_handler(struct k_work *work);
+static void report_handler(struct k_work *work);
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn ss_twr_responder_sniff()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int ss_twr_responder_sniff(void)
+{
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset and initialize DW chip. */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW3000 low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* Apply default antenna delay value. */
+    dwt_setrxantennadelay(RX_ANT_DLY);
+    dwt_settxantennadelay(TX_ANT_DLY);
+
+    /* Register the call-backs, an RX timeout is handled as an RX error (SPI CRC error callback is not used). */
+    dwt_setcallbacks(&tx_conf_cb, &rx_ok_cb, &rx_err_cb, &rx_err_cb, NULL, NULL, NULL);
+
+    /* Enable wanted interrupts (TX confirmation, RX good frames, RX timeouts and RX errors). */
+    dwt_setinterrupt(DWT_INT_TXFRS_BIT_MASK | DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR, 0, DWT_ENABLE_INT);
+
+    /*Clearing the SPI ready interrupt*/
+    dwt_writesysstatuslo(DWT_INT_RCINIT_BIT_MASK | DWT_INT_SPIRDY_BIT_MASK);
+
+    /* Install DW IC IRQ handler. */
+    port_set_dwic_isr(dwt_isr);
+
+    /* The receiver is turned on as soon as a response has been sent, and stays on (or sniffs) until the next frame. */
+    dwt_setrxaftertxdelay(0);
+    dwt_setrxtimeout(0);
+    dwt_setpreambledetecttimeout(0);
+
+    /* Start in SNIFF mode with the shortest ON time guaranteeing the acquisition of the preamble. See NOTE 2 below. */
+    sniff_ctrl_init(&sniff, &sniff_phy);
+    dwt_setsniffmode(sniff.enabled, sniff.on, sniff.off);
+    report_snap = sniff;
+
+    k_work_queue_start(&report_queue, report_stack, K_THREAD_STACK_SIZEOF(report_stack), K_LOWEST_APPLICATION_THREAD_PRIO, NULL);
+    k_work_init(&report_work, report_handler);
+    k_work_init_delayable(&update_work, update_handler);
+    last_update_us = port_get_time_us();
+    k_work_schedule(&update_work, K_SECONDS(UPDATE_PERIOD_S));
+
+    /* Activate reception immediately, everything else is done by the callbacks. */
+    dwt_rxenable(DWT_START_RX_IMMEDIATE);
+
+    return 0;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn rx_ok_cb()
+ *
+ * @brief Callback to process RX good frame events. Answers a poll with a delayed response, see ss_twr_responder_evt.c.
+ *
+ * @param  cb_data  callback data
+ *
+ * @return  none
+ */
+static void rx_ok_cb(const dwt_cb_data_t *cb_data)
+{
+    uint32_t resp_tx_time;
+    uint64_t poll_rx_ts, resp_tx_ts;
+
+    sniff_ctrl_rx_ok(&sniff, cb_data->datalength);
+
+    if (cb_data->datalength != sizeof(rx_poll_msg))
+    {
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+        return;
+    }
+
+    /* As the sequence number field of the frame is not relevant, it is cleared to simplify the validation of the frame. */
+    dwt_readrxdata(rx_buffer, cb_data->datalength, 0);
+    rx_buffer[ALL_MSG_SN_IDX] = 0;
+    if (memcmp(rx_buffer, rx_poll_msg, ALL_MSG_COMMON_LEN) != 0)
+    {
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+        return;
+    }
+
+    /* Compute response message transmission time, and the response TX timestamp as the programmed time plus the antenna delay. */
+    poll_rx_ts = get_rx_timestamp_u64();
+    resp_tx_time = (poll_rx_ts + (POLL_RX_TO_RESP_TX_DLY_UUS * UUS_TO_DWT_TIME)) >> 8;
+    dwt_setdelayedtrxtime(resp_tx_time);
+    resp_tx_ts = (((uint64_t)(resp_tx_time & 0xFFFFFFFEUL)) << 8) + TX_ANT_DLY;
+
+    resp_msg_set_ts(&tx_resp_msg[RESP_MSG_POLL_RX_TS_IDX], poll_rx_ts);
+    resp_msg_set_ts(&tx_resp_msg[RESP_MSG_RESP_TX_TS_IDX], resp_tx_ts);
+
+    /* Write and send the response message, with the receiver turned on in SNIFF mode at its end. */
+    tx_resp_msg[ALL_MSG_SN_IDX] = frame_seq_nb;
+    dwt_writetxdata(sizeof(tx_resp_msg), tx_resp_msg, 0); /* Zero offset in TX buffer. */
+    dwt_writetxfctrl(sizeof(tx_resp_msg), 0, 1);          /* Zero offset in TX buffer, ranging. */
+    if (dwt_starttx(DWT_START_TX_DELAYED | DWT_RESPONSE_EXPECTED) != DWT_SUCCESS)
+    {
+        num_late++;
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+    }
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn rx_err_cb()
+ *
+ * @brief Callback to process RX error and timeout events. SFD timeouts and PHR errors are reported to the SNIFF controller as late
+ *        acquisitions of the preamble. The receiver is turned on again immediately.
+ *
+ * @param  cb_data  callback data
+ *
+ * @return  none
+ */
+static void rx_err_cb(const dwt_cb_data_t *cb_data)
+{
+    sniff_ctrl_rx_err(&sniff, (cb_data->status & (DWT_INT_RXSTO_BIT_MASK | DWT_INT_RXPHE_BIT_MASK)) != 0);
+    dwt_rxenable(DWT_START_RX_IMMEDIATE);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn tx_conf_cb()
+ *
+ * @brief Callback to process TX confirmation events. The response has been sent and the receiver is already on.
+ *
+ * @param  cb_data  callback data
+ *
+ * @return  none
+ */
+static void tx_conf_cb(const dwt_cb_data_t *cb_data)
+{
+    (void)cb_data;
+    sniff_ctrl_tx(&sniff, sizeof(tx_resp_msg));
+    num_exchanges++;
+    frame_seq_nb++;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn update_handler()
+ *
+ * @brief Runs the SNIFF controller on the observations of the last period and applies the new ON and OFF times. Runs from the system work
+ *        queue, as the callbacks, and hands the printing over to the report work queue.
+ *
+ * @param  work  update work item
+ *
+ * @return  none
+ */
+static void update_handler(struct k_work *work)
+{
+    uint32_t now = port_get_time_us();
+
+    (void)work;
+
+    if (sniff_ctrl_update(&sniff, now - last_update_us))
+    {
+        /* Takes effect at the next activation of the receiver. See NOTE 3 below. */
+        dwt_setsniffmode(sniff.enabled, sniff.on, sniff.off);
+    }
+    last_update_us = now;
+
+    report_snap = sniff;
+    report_exchanges = num_exchanges;
+    report_late = num_late;
+    k_work_submit_to_queue(&report_queue, &report_work);
+
+    k_work_schedule(&update_work, K_SECONDS(UPDATE_PERIOD_S));
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn report_handler()
+ *
+ * @brief Prints the responses and the SNIFF controller estimates of the last period.
+ *
+ * @param  work  report work item
+ *
+ * @return  none
+ */
+static void report_handler(struct k_work *work)
+{
+    static uint32_t last_exchanges, last_late;
+    char str[64];
+
+    (void)work;
+
+    snprintf(str, sizeof(str), "RESP xchg/s=%lu late=%lu", (unsigned long)((report_exchanges - last_exchanges) / UPDATE_PERIOD_S),
+        (unsigned long)(report_late - last_late));
+    test_run_info((unsigned char *)str);
+    sniff_ctrl_report(&report_snap, BATTERY_MAH);
+
+    last_exchanges = report_exchanges;
+    last_late = report_late;
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The callbacks run from the system work queue (see ss_twr_responder_evt.c), and so does the update of the controller, which keeps all the
+ *    accesses to the controller state and to the DW IC in one thread. The report copies the state of the last update and prints it from a low
+ *    priority work queue, so it never delays a response. A report may rarely mix two updates, which only affects the printout.
+ * 2. The controller assumes that the initiators use the same preamble length as this responder (128 symbols). With PAC 8 it starts with the
+ *    receiver on for 2 PACs (16 us) and off for about 73 us, which still catches every 128 symbol preamble, instead of the fixed 2/16 of
+ *    rx_sniff.c. The ON time grows when SFD timeouts and PHR errors show late detections, and SNIFF mode is left for continuous RX when the
+ *    traffic leaves too little idle time to save. See sniff_ctrl.c for the details and the limits of the current estimate.
+ * 3. dwt_setsniffmode() sets the ON and OFF times used from the next activation of the receiver, which happens after each frame, so a new
+ *    setting applies from the next poll on.
+ ****************************************************************************************************************************************************/
@@ -53,6 +53,7 @@
 #include <shared_defines.h>
 #include <shared_functions.h>
 #include <stdlib.h>
+#include <telem.h>
 
 #if defined(TEST_SS_TWR_RESPONDER_STS_NO_DATA)
 
@@ -90,9 +91,6 @@ static uint32_t status_reg = 0;
 static uint64_t poll_rx_ts;
 static uint64_t resp_tx_ts;
 
-/* Hold the amount of errors that have occurred */
-static uint32_t errors[23] = { 0 };
-
 extern dwt_config_t config_option_sp3;
 
 /* Externally declared structures for TX configuration. */
@@ -318,30 +316,35 @@ int ss_twr_responder_sts_no_data(void)
                         /* Increment frame sequence number after transmission of the report frame (modulo 256). */
                         frame_seq_nb++;
                     }
+                    else
+                    {
+                        telem_inc(TELEM_TX_LATE);
+                    }
                 }
                 else
                 {
                     // Delayed TX has failed - too "late"
+                    telem_inc(TELEM_TX_LATE);
                 }
             }
             else
             {
-                errors[PREAMBLE_COUNT_ERR_IDX] += 1;
+                telem_inc(PREAMBLE_COUNT_ERR_IDX);
                 /* Clear RX error events in the DW IC status register. */
                 dwt_writesysstatuslo(SYS_STATUS_ALL_RX_ERR);
             }
         }
         else
         {
-            check_for_status_errors(status_reg, errors);
+            check_for_status_errors(status_reg);
 
             if (goodSts < 0)
             {
-                errors[PREAMBLE_COUNT_ERR_IDX] += 1;
+                telem_inc(PREAMBLE_COUNT_ERR_IDX);
             }
             if (stsQual <= 0)
             {
-                errors[CP_QUAL_ERR_IDX] += 1;
+                telem_inc(CP_QUAL_ERR_IDX);
             }
             /* Clear RX error events in the DW IC status register. */
             dwt_writesysstatuslo(SYS_STATUS_ALL_RX_ERR);
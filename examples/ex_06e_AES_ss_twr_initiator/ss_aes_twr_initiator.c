@@ -26,6 +26,7 @@
 #include <example_selection.h>
 #include <mac_802_15_4.h>
 #include <port.h>
+#include <range_stats.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
 
@@ -138,6 +139,9 @@ static uint8_t rx_buffer[RX_BUF_LEN];
 static double tof;
 static double distance;
 
+/* Statistics of the computed distances, see range_stats.h */
+static range_stats_t range_stats;
+
 /* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
  * temperature. These values can be calibrated prior to taking reference measurements. See NOTE 2 below. */
 extern dwt_txconfig_t txconfig_options;
@@ -163,6 +167,8 @@ int ss_aes_twr_initiator(void)
     /* Display application name on LCD. */
     test_run_info((unsigned char *)APP_NAME);
 
+    range_stats_init(&range_stats);
+
     /* Configure SPI rate, DW3000 supports up to 36 MHz */
     port_set_dw_ic_spi_fastrate();
 
@@ -340,6 +346,9 @@ int ss_aes_twr_initiator(void)
 
                 tof = ((rtd_init - rtd_resp * (1 - clockOffsetRatio)) / 2.0) * DWT_TIME_UNITS;
                 distance = tof * SPEED_OF_LIGHT;
+
+                /* Accumulate computed distance, a summary is displayed periodically. */
+                range_stats_add_and_report(&range_stats, distance);
             }
         }
         else
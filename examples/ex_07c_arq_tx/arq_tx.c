@@ -0,0 +1,149 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    arq_tx.c
+ *  @brief   Bulk data transfer with selective repeat ARQ, sender example code
+ *
+ *           This example sends a blob of ARQ_BLOB_LEN bytes every second to the companion "ARQ RX" example, in 1023-byte frames with block
+ *           acknowledgements (see arq.h): the frames lost are sent again with the next window of frames rather than one frame waiting for the
+ *           acknowledgement of the previous one, as in the "ACK DATA TX" example. The transfer time, the goodput and the frames sent again are
+ *           displayed after each transfer.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <arq.h>
+#include <binlog.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+
+#if defined(TEST_ARQ_TX)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "ARQ TX v1.0"
+
+/* Default communication configuration, with the extended PHR mode for 1023-byte frames. See NOTE 1 below. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_EXT,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Addresses of the two ends, as in the ACK DATA examples */
+#define ARQ_PAN_ID  0xDECA
+#define ARQ_TX_ADDR 0x5458 /* "XT" */
+#define ARQ_RX_ADDR 0x5258 /* "XR" */
+
+/* Size of the blob and period of the transfers */
+#define ARQ_BLOB_LEN  (128 * 1024UL)
+#define ARQ_PERIOD_MS 1000
+
+static arq_t arq;
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/*
+ * The blob is generated from the offset of each byte, so that the receiver can check it without holding a copy. See NOTE 2 below.
+ */
+static void blob_read(void *ctx, uint32_t offset, uint8_t *buf, uint16_t len)
+{
+    (void)ctx;
+    while (len--)
+    {
+        *buf++ = (uint8_t)(offset ^ (offset >> 8) ^ (offset >> 16));
+        offset++;
+    }
+}
+
+/**
+ * Application entry point.
+ */
+int arq_tx(void)
+{
+    const arq_stats_t *st = &arq.stats;
+    uint32_t next_ms;
+    char str[80];
+    int ret;
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    arq_init(&arq, &arq_dw_radio, ARQ_PAN_ID, ARQ_TX_ADDR, ARQ_RX_ADDR);
+
+    next_ms = port_get_tick_ms();
+    while (1)
+    {
+        ret = arq_send(&arq, ARQ_BLOB_LEN, blob_read, NULL);
+
+        /* Transfer time and goodput in kbps (bits per ms), see NOTE 3 below. */
+        snprintf(str, sizeof(str), "ARQ %s %lu B %lu us %lu kbps fr %lu rep %lu to %lu", (ret == ARQ_OK) ? "ok" : "LOST",
+            (unsigned long)st->bytes, (unsigned long)st->time_us, (unsigned long)(st->time_us ? (uint64_t)st->bytes * 8000 / st->time_us : 0),
+            (unsigned long)st->frames, (unsigned long)st->repeats, (unsigned long)st->timeouts);
+        test_run_info((unsigned char *)str);
+        BINLOG3(BINLOG_ARQ, st->bytes, st->time_us, st->repeats);
+
+        next_ms += ARQ_PERIOD_MS;
+        while ((int32_t)(port_get_tick_ms() - next_ms) < 0) { };
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. Frames longer than 127 bytes need the extended PHR mode (DWT_PHRMODE_EXT), on both ends: a frame is then up to 1023 bytes
+ *    (FRAME_LEN_MAX_EX), of which 1007 bytes of the blob after the MAC and ARQ headers and before the FCS. The longer the frames, the
+ *    smaller the share of the preamble, PHR and headers in the air time, but the more air time a frame lost costs.
+ * 2. A real application reads its data from flash or RAM, in the callback, from the offset given. The same offset may be read several times,
+ *    for the frames sent again.
+ * 3. At 6.8 Mbps with 128 preamble symbols, a 1023-byte frame takes about 1.37 ms on air and carries 1007 bytes: back to back such frames
+ *    would give 5.9 Mbps. The gap between frames (ARQ_IFS_US, for the receiver to read each frame) and the acknowledgements give 4.8 Mbps
+ *    on a clean link, a 128 kB blob taking about 220 ms, and still 4.2 Mbps with 10% of the frames lost, as simulated by tools/arq_sim.
+ ****************************************************************************************************************************************************/
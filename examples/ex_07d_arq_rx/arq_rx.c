@@ -0,0 +1,143 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    arq_rx.c
+ *  @brief   Bulk data transfer with selective repeat ARQ, receiver example code
+ *
+ *           This example receives the blobs sent by the companion "ARQ TX" example, in 1023-byte frames (see arq.h), answering each window
+ *           of frames with a block acknowledgement, and checks the data received. The size, the transfer time, the frames received twice and
+ *           the bytes in error are displayed after each transfer.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <arq.h>
+#include <binlog.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+
+#if defined(TEST_ARQ_RX)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "ARQ RX v1.0"
+
+/* Default communication configuration, with the extended PHR mode for 1023-byte frames. See NOTE 1 of the ARQ TX example. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_EXT,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Addresses of the two ends, as in the ACK DATA examples */
+#define ARQ_PAN_ID  0xDECA
+#define ARQ_TX_ADDR 0x5458 /* "XT" */
+#define ARQ_RX_ADDR 0x5258 /* "XR" */
+
+/* Time without frames after which a transfer started is abandoned */
+#define ARQ_IDLE_MS 500
+
+static arq_t arq;
+static uint32_t errors; /* Bytes of the transfer not as sent */
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/*
+ * Check the data against the blob of the ARQ TX example, generated from the offset of each byte. See NOTE 1 below.
+ */
+static void blob_write(void *ctx, uint32_t offset, const uint8_t *buf, uint16_t len)
+{
+    (void)ctx;
+    while (len--)
+    {
+        if (*buf++ != (uint8_t)(offset ^ (offset >> 8) ^ (offset >> 16)))
+        {
+            errors++;
+        }
+        offset++;
+    }
+}
+
+/**
+ * Application entry point.
+ */
+int arq_rx(void)
+{
+    const arq_stats_t *st = &arq.stats;
+    char str[80];
+    int32_t ret;
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    arq_init(&arq, &arq_dw_radio, ARQ_PAN_ID, ARQ_RX_ADDR, ARQ_TX_ADDR);
+
+    while (1)
+    {
+        errors = 0;
+        ret = arq_receive(&arq, blob_write, NULL, ARQ_IDLE_MS);
+
+        /* The transfer time runs from the first frame to the last new one, see NOTE 2 below. */
+        snprintf(str, sizeof(str), "ARQ %s %lu B %lu us fr %lu rep %lu err %lu", (ret >= 0) ? "ok" : "LOST", (unsigned long)st->bytes,
+            (unsigned long)st->time_us, (unsigned long)st->frames, (unsigned long)st->repeats, (unsigned long)errors);
+        test_run_info((unsigned char *)str);
+        BINLOG3(BINLOG_ARQ, st->bytes, st->time_us, st->repeats);
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The data is handed over once per frame, at its offset in the blob, in the order the frames are received: a frame lost arrives later,
+ *    with a later window. A real application writes it to flash or RAM at the offset given. The callback runs before the receiver is enabled
+ *    again, so it must take less than the margin left by ARQ_IFS_US (about 50 us), or queue the data, see NOTE 2 of arq.c.
+ * 2. arq_receive() returns some time after the end of the transfer, ARQ_LINGER_MS, during which it still answers the sender in case the
+ *    last block acknowledgement was lost.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,158 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    frame_filtering_tx.c
+ *  @brief   Frame filtering TX example code
+ *
+ *           This example sends, every 50 ms, a frame of a cycle of eight to the companion "FRAME FILTERING RX" example: frames the receiver
+ *           accepts, frames its DW IC rejects (wrong destination address, wrong PAN ID, beacon) and frames its software filter rejects (denied
+ *           source, repeated frame). Each cycle is expected to count 3 accepted frames, 3 rejected by the DW IC and 2 by the software on the
+ *           receiver.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <string.h>
+
+#if defined(TEST_FRAME_FILTERING_TX)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "FRAME FILT TX v1.0"
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Frames of a cycle, see NOTE 1 below. The sequence number (byte 2) is set when sending. */
+static const uint8_t frame_ok[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'X', 'R', 'X', 'T', 'o', 'k' };
+static const uint8_t frame_dst[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 0x34, 0x12, 'X', 'T', 'd', 's', 't' };
+static const uint8_t frame_pan[] = { 0x41, 0x88, 0, 0xEF, 0xBE, 'X', 'R', 'X', 'T', 'p', 'a', 'n' };
+static const uint8_t frame_beacon[] = { 0x00, 0x80, 0, 0xCA, 0xDE, 'X', 'T', 0xFF, 0xCF, 0x00, 0x00 };
+static const uint8_t frame_bcast[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 0xFF, 0xFF, 'X', 'T', 'b', 'c', 'a', 's', 't' };
+static const uint8_t frame_src[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'X', 'R', 0xAD, 0x0B, 's', 'r', 'c' };
+static const uint8_t frame_ext[]
+    = { 0x41, 0x8C, 0, 0xCA, 0xDE, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 'X', 'T', 'e', 'x', 't' }; /* To the EUI-64 of the receiver */
+
+static const struct
+{
+    const uint8_t *frame;
+    uint8_t len;
+    uint8_t repeat; /* Sent again with the sequence number of the previous frame */
+} cycle[] = {
+    { frame_ok, sizeof(frame_ok), 0 },
+    { frame_ok, sizeof(frame_ok), 1 },
+    { frame_dst, sizeof(frame_dst), 0 },
+    { frame_pan, sizeof(frame_pan), 0 },
+    { frame_beacon, sizeof(frame_beacon), 0 },
+    { frame_bcast, sizeof(frame_bcast), 0 },
+    { frame_src, sizeof(frame_src), 0 },
+    { frame_ext, sizeof(frame_ext), 0 },
+};
+#define CYCLE_LEN    (sizeof(cycle) / sizeof(cycle[0]))
+#define FRAME_SN_IDX 2
+
+/* Inter-frame delay period, in milliseconds. */
+#define TX_DELAY_MS 50
+
+static uint8_t tx_msg[32];
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/**
+ * Application entry point.
+ */
+int frame_filtering_tx(void)
+{
+    uint8_t seq = 0;
+    unsigned int i = 0;
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    while (1)
+    {
+        memcpy(tx_msg, cycle[i].frame, cycle[i].len);
+        if (!cycle[i].repeat)
+        {
+            seq++;
+        }
+        tx_msg[FRAME_SN_IDX] = seq;
+
+        dwt_writetxdata(cycle[i].len, tx_msg, 0);        /* Zero offset in TX buffer. */
+        dwt_writetxfctrl(cycle[i].len + FCS_LEN, 0, 0); /* Zero offset in TX buffer, no ranging. */
+        dwt_starttx(DWT_START_TX_IMMEDIATE);
+        waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+        dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+
+        i = (i + 1) % CYCLE_LEN;
+        Sleep(TX_DELAY_MS);
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The frames are data frames (frame control 0x8841: 16-bit addresses, PAN ID compression) from "XT" in PAN 0xDECA, as in the other
+ *    examples, unless noted, and the receiver is "XR" (0x5258). In order:
+ *     - a frame to the receiver, accepted,
+ *     - the same frame with the same sequence number, rejected by the software as a repeated frame,
+ *     - a frame to 0x1234, rejected by the DW IC (destination address),
+ *     - a frame to the receiver in PAN 0xBEEF, rejected by the DW IC (PAN ID),
+ *     - a beacon, rejected by the DW IC (frame type, the receiver accepts data frames only),
+ *     - a broadcast frame, accepted,
+ *     - a frame from 0x0BAD, rejected by the software (source denied),
+ *     - a frame to the 64-bit address of the receiver (frame control 0x8C41), accepted.
+ *    None of them requests an acknowledgement.
+ ****************************************************************************************************************************************************/
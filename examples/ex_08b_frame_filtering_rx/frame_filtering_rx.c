@@ -0,0 +1,161 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    frame_filtering_rx.c
+ *  @brief   Frame filtering RX example code
+ *
+ *           This example receives the frames of the companion "FRAME FILTERING TX" example through a frame filter set up from a policy (see
+ *           frame_filter.h): data frames in PAN 0xDECA to the short address "XR", to its EUI-64 or broadcast, except from source 0x0BAD, and
+ *           no repeated frames. The DW IC rejects the frames of other types, PANs or destinations itself, only the first bytes of the frames it
+ *           accepts are read to check the source and the sequence number. Every 2 seconds the frames accepted and the frames rejected by the DW
+ *           IC and by the software, by reason, are displayed.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <frame_filter.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+
+#if defined(TEST_FRAME_FILTERING_RX)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "FRAME FILT RX v1.0"
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Addresses of the receiver */
+static const uint8_t eui64[8] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
+static const uint16_t src_deny[] = { 0x0BAD };
+
+/* What this receiver wants to receive. See NOTE 1 below. */
+static const frame_filter_policy_t policy = {
+    .types = FRAME_FILTER_DATA,
+    .pan_id = 0xDECA,
+    .short_addr = 0x5258, /* "XR" */
+    .eui64 = eui64,
+    .no_dup = 1,
+    .src_deny = src_deny,
+    .n_src_deny = sizeof(src_deny) / sizeof(src_deny[0]),
+};
+
+static frame_filter_t ff;
+
+/* Receive timeout, to display the statistics without frames, and display period, in milliseconds */
+#define RX_TIMEOUT_UUS 50000
+#define REPORT_MS      2000
+
+static uint8_t rx_buffer[FRAME_FILTER_HDR_MAX];
+
+/**
+ * Application entry point.
+ */
+int frame_filtering_rx(void)
+{
+    uint32_t status_reg, next_ms;
+    uint16_t frame_len;
+    const uint32_t *rej;
+    char str[96];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    frame_filter_init(&ff, &policy);
+    frame_filter_dw_apply(&ff);
+    dwt_setrxtimeout(RX_TIMEOUT_UUS);
+
+    next_ms = port_get_tick_ms() + REPORT_MS;
+    while (1)
+    {
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+
+        /* Frames rejected by the DW IC do not end the reception. See NOTE 2 below. */
+        waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+        if (status_reg & DWT_INT_RXFCG_BIT_MASK)
+        {
+            dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+            frame_len = dwt_getframelength() - FCS_LEN;
+            if (frame_len > FRAME_FILTER_HDR_MAX)
+            {
+                frame_len = FRAME_FILTER_HDR_MAX;
+            }
+            /* Only the MAC header is read, the payload of an accepted frame would be read after the check */
+            dwt_readrxdata(rx_buffer, frame_len, 0);
+            frame_filter_check(&ff, rx_buffer, frame_len);
+        }
+        else
+        {
+            dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+        }
+
+        if ((int32_t)(port_get_tick_ms() - next_ms) >= 0)
+        {
+            next_ms += REPORT_MS;
+            frame_filter_dw_update(&ff);
+            rej = ff.stats.sw_rejected;
+            snprintf(str, sizeof(str), "FF rx %lu ok %lu hw %lu sw type %lu pan %lu dst %lu src %lu dup %lu len %lu",
+                (unsigned long)ff.stats.frames, (unsigned long)ff.stats.accepted, (unsigned long)ff.stats.hw_rejected,
+                (unsigned long)rej[FRAME_FILTER_REJ_TYPE], (unsigned long)rej[FRAME_FILTER_REJ_PAN], (unsigned long)rej[FRAME_FILTER_REJ_DST],
+                (unsigned long)rej[FRAME_FILTER_REJ_SRC], (unsigned long)rej[FRAME_FILTER_REJ_DUP], (unsigned long)rej[FRAME_FILTER_REJ_LEN]);
+            test_run_info((unsigned char *)str);
+        }
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. This policy fits the DW IC: one PAN ID, one short address and the EUI-64, so the DW IC filters the types and addresses. With group
+ *    addresses (policy.groups) or more PAN IDs (policy.pans) its address filter is turned off and the software checks every frame, the
+ *    "hw" count then staying at 0 and the rejections moving to the "type", "pan" and "dst" counts.
+ * 2. The frames rejected by the DW IC leave no trace but the ARFE event counter, read every 2 seconds by frame_filter_dw_update(). With
+ *    the TX example sending a frame every 50 ms, 15 frames are rejected by the DW IC in 2 seconds, well below the 255 the counter holds.
+ ****************************************************************************************************************************************************/
@@ -19,6 +19,8 @@
 #include <example_selection.h>
 #include <port.h>
 #include <shared_defines.h>
+#include <stdio.h>
+#include <telem.h>
 
 #if defined(TEST_SPI_CRC)
 
@@ -32,6 +34,9 @@ extern void dwt_readfromdevice(uint32_t regFileID, uint16_t index, uint16_t leng
 /* Declaration of SPI read error callback, will be called if SPI read error is detected in  dwt_readfromdevice() function*/
 static void spi_rd_err_cb(void);
 
+/* Count the SPI CRC error and stop. See NOTE 4 below. */
+static void spi_crc_halt(void);
+
 /**
  * Application entry point.
  */
@@ -107,7 +112,7 @@ int spi_crc(void)
         /* if SPI error detected STOP */
         if (((status_reg = dwt_readsysstatuslo()) & (DWT_INT_SPICRCE_BIT_MASK)) || (reg_val != data))
         {
-            while (1) { };
+            spi_crc_halt();
             /* The recommended recovery from a write CRC error is to reset the DW3000 completely,
              * reinitialising and reconfiguring it into the desired operating mode for the application.
              */
@@ -125,10 +130,27 @@ int spi_crc(void)
  */
 static void spi_rd_err_cb(void)
 {
-    while (1) { };
+    spi_crc_halt();
     /* see Note 3 below */
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn spi_crc_halt()
+ *
+ * @brief Count the SPI CRC error in the telemetry, print the count and stop
+ *
+ * @return  none
+ */
+static void spi_crc_halt(void)
+{
+    char str[32];
+
+    telem_inc(TELEM_SPICRC);
+    snprintf(str, sizeof(str), "SPI CRC ERR %lu", (unsigned long)telem_get(TELEM_SPICRC));
+    test_run_info((unsigned char *)str);
+    while (1) { };
+}
+
 #endif
 /*****************************************************************************************************************************************************
  * NOTES:
@@ -141,4 +163,6 @@ static void spi_rd_err_cb(void)
  *    generate an interrupt. Please refer to DW3000 User Manual for more details on "interrupts".
  * 3. We call the spi_rd_err_cb as a result of reading the SPICRC_CFG_ID register. As long as the callback does not read SPICRC_CFG_ID register
  *    again there is no recursion issue, the host should reset device and exit this or raise some other error
+ * 4. The error is counted in the link telemetry (see telem.h), but the example then spins forever and the low priority telemetry thread never
+ *    runs again to export it, so the count is printed before stopping.
  ****************************************************************************************************************************************************/
@@ -0,0 +1,265 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    spi_bench.c
+ *  @brief   SPI bus microbenchmark
+ *
+ *           Measures the throughput of bulk TX buffer writes, RX buffer reads and small register accesses at each SPI rate of the port, and
+ *           fits the bulk transfers to a fixed cost per transaction plus a cost per byte. These are the figures which decide whether
+ *           transactions are worth batching or moving to DMA. Built with the SPI transaction profiler (cmake -DSPI_PROF=1, see spi_prof.h),
+ *           the time spent in the SPI layer is printed as well, and the breakdown per register at the end.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <prof.h>
+#include <shared_defines.h>
+#include <spi_prof.h>
+#include <stdio.h>
+
+#if defined(TEST_SPI_BENCH)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "SPI BENCH v1.0"
+
+/* Duration of the measurement of one operation, in milliseconds */
+#define SPI_BENCH_MS 200
+/* Operations done between two reads of the clock */
+#define SPI_BENCH_BATCH 8
+
+/* Transfer lengths of the bulk operations, in bytes. See NOTE 1 below. */
+static const uint16_t bench_len[] = { 4, 16, 64, 127, 256, 512, 1000 };
+#define NUM_BENCH_LEN (sizeof(bench_len) / sizeof(bench_len[0]))
+
+static uint8_t bench_buf[1024];
+static char str[128];
+
+typedef struct
+{
+    const char *name;
+    void (*op)(uint16_t len);
+    uint8_t bulk; /* 1 if run for each of bench_len, 0 for a 4 byte register access */
+} spi_bench_op_t;
+
+static void op_txbuf_write(uint16_t len)
+{
+    /* dwt_writetxdata() leaves room for the FCS, so it transfers len - 2 bytes */
+    dwt_writetxdata(len + FCS_LEN, bench_buf, 0);
+}
+
+static void op_rxbuf_read(uint16_t len)
+{
+    dwt_readrxdata(bench_buf, len, 0);
+}
+
+static void op_read_devid(uint16_t len)
+{
+    (void)len;
+    (void)dwt_readdevid();
+}
+
+static void op_read_status(uint16_t len)
+{
+    (void)len;
+    (void)dwt_readsysstatuslo();
+}
+
+static void op_write_status(uint16_t len)
+{
+    (void)len;
+    dwt_writesysstatuslo(0); /* writing 0 clears no event */
+}
+
+static void op_read_systime(uint16_t len)
+{
+    (void)len;
+    (void)dwt_readsystimestamphi32();
+}
+
+static const spi_bench_op_t bench_ops[] = {
+    { "txbuf wr", op_txbuf_write, 1 },
+    { "rxbuf rd", op_rxbuf_read, 1 },
+    { "devid rd", op_read_devid, 0 },
+    { "status rd", op_read_status, 0 },
+    { "status wr", op_write_status, 0 },
+    { "systime rd", op_read_systime, 0 },
+};
+
+#define NUM_BENCH_OPS (sizeof(bench_ops) / sizeof(bench_ops[0]))
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn spi_bench_run()
+ *
+ * @brief Run one operation for SPI_BENCH_MS and print the result.
+ *
+ * @param rate - name of the SPI rate
+ * @param op - operation
+ * @param len - transfer length in bytes
+ *
+ * @return time of one operation in nanoseconds
+ */
+static uint32_t spi_bench_run(const char *rate, const spi_bench_op_t *op, uint16_t len)
+{
+    uint32_t start, elapsed, n = 0;
+    uint32_t ns_per_op;
+    int i, ret;
+
+    SPI_PROF_RESET();
+    start = port_get_time_us();
+    do
+    {
+        for (i = 0; i < SPI_BENCH_BATCH; i++)
+        {
+            op->op(len);
+        }
+        n += SPI_BENCH_BATCH;
+        elapsed = port_get_time_us() - start;
+    } while (elapsed < SPI_BENCH_MS * 1000);
+
+    ns_per_op = (uint32_t)((uint64_t)elapsed * 1000 / n);
+    ret = snprintf(str, sizeof(str), "SPI %s %-10s len=%-4u n=%-6lu ns/op=%-7lu kB/s=%-5lu", rate, op->name, len, (unsigned long)n,
+        (unsigned long)ns_per_op, (unsigned long)(len ? (uint64_t)len * n * 1000 / elapsed : 0));
+
+#if SPI_PROF_ENABLED
+    {
+        struct spi_prof_sum sum;
+
+        /* Time spent in the SPI layer, the rest of ns/op is the driver */
+        spi_prof_total(&sum);
+        snprintf(&str[ret], sizeof(str) - ret, " spi=%lu xfer/op %lu %s/xfer", (unsigned long)(sum.count / n),
+            (unsigned long)(sum.count ? sum.cycles / sum.count : 0), PROF_UNIT);
+    }
+#else
+    (void)ret;
+#endif
+    test_run_info((unsigned char *)str);
+    return ns_per_op;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn spi_bench_fit()
+ *
+ * @brief Least squares fit of the time of the bulk operations to a cost per transaction plus a cost per byte, see NOTE 2 below.
+ *
+ * @param rate - name of the SPI rate
+ * @param op - operation
+ * @param ns - time of one operation in nanoseconds for each of bench_len
+ *
+ * @return none
+ */
+static void spi_bench_fit(const char *rate, const spi_bench_op_t *op, const uint32_t *ns)
+{
+    int64_t sx = 0, sy = 0, sxx = 0, sxy = 0, n = NUM_BENCH_LEN;
+    int64_t per_byte_ps, per_xfer_ns;
+    unsigned int i;
+
+    for (i = 0; i < NUM_BENCH_LEN; i++)
+    {
+        sx += bench_len[i];
+        sy += ns[i];
+        sxx += (int64_t)bench_len[i] * bench_len[i];
+        sxy += (int64_t)bench_len[i] * ns[i];
+    }
+
+    per_byte_ps = (n * sxy - sx * sy) * 1000 / (n * sxx - sx * sx);
+    per_xfer_ns = (sy - per_byte_ps * sx / 1000) / n;
+
+    snprintf(str, sizeof(str), "SPI %s %-10s fit: %ld ns/op + %ld ns/byte (%lu kB/s)", rate, op->name, (long)per_xfer_ns, (long)(per_byte_ps / 1000),
+        (unsigned long)(per_byte_ps > 0 ? 1000000000 / per_byte_ps : 0));
+    test_run_info((unsigned char *)str);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn spi_bench()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int spi_bench(void)
+{
+    static uint32_t ns[NUM_BENCH_LEN];
+    unsigned int r, o, l;
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_slowrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    for (l = 0; l < sizeof(bench_buf); l++)
+    {
+        bench_buf[l] = (uint8_t)l;
+    }
+
+    /* Each rate of the port, see NOTE 3 below. */
+    for (r = 0; r < 2; r++)
+    {
+        const char *rate = r ? "fast" : "slow";
+
+        if (r)
+        {
+            port_set_dw_ic_spi_fastrate();
+        }
+        else
+        {
+            port_set_dw_ic_spi_slowrate();
+        }
+
+        for (o = 0; o < NUM_BENCH_OPS; o++)
+        {
+            if (!bench_ops[o].bulk)
+            {
+                spi_bench_run(rate, &bench_ops[o], 4);
+                continue;
+            }
+            for (l = 0; l < NUM_BENCH_LEN; l++)
+            {
+                ns[l] = spi_bench_run(rate, &bench_ops[o], bench_len[l]);
+            }
+            spi_bench_fit(rate, &bench_ops[o], ns);
+        }
+    }
+
+    /* Breakdown per register of the last rate */
+    SPI_PROF_DUMP();
+
+    test_run_info((unsigned char *)"DONE");
+    while (1) { };
+}
+#endif
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The TX and RX buffers are 1024 bytes and dwt_writetxdata() refuses writes reaching the end of the buffer, so the longest transfer is
+ *    1000 bytes, close to the largest frame in extended PHR mode. 127 bytes is the largest standard frame. The register accesses are 4 byte transfers: DEV_ID with a 1 byte SPI header, SYS_STATUS and SYS_TIME with a 2 byte header.
+ * 2. The cost per transaction includes the driver and the SPI header (1 or 2 bytes), chip select and the start of the transfer of the port. It is
+ *    what is saved by batching accesses into fewer transactions, while the cost per byte is what a DMA transfer can take off the CPU. The wall
+ *    time includes the overhead of the SPI profiler when it is built in.
+ * 3. The port offers two SPI rates, the slow rate required before the DW IC PLL is locked and the fast rate, both set by the dw3000 driver
+ *    module from the devicetree. Other clocks are measured by changing the SPI frequency of the dw3000 node.
+ ****************************************************************************************************************************************************/
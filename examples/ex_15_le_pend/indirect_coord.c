@@ -0,0 +1,267 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    indirect_coord.c
+ *  @brief   Indirect transmission coordinator example code
+ *
+ *           This example is the coordinator of sleepy devices running the "INDIRECT DEVICE" example: it queues data for the devices at
+ *           random times and keeps it until each device polls with a data request. The DW IC acknowledges the data request itself, with the
+ *           frame pending bit set for the devices held in its LE address registers (see indirect.h), and the coordinator then sends the
+ *           frames of the device, each acknowledged by the device. There are more devices than LE address registers, so these are assigned
+ *           dynamically. The latency from the queuing of a frame to its delivery and the queue statistics are displayed every 10 seconds.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <binlog.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <indirect.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(TEST_INDIRECT_COORD)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "INDIRECT COORD v1.0"
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+#define PAN_ID     0xDECA
+#define COORD_ADDR 0x5258 /* "RX", as in the LE PEND RX example */
+
+/* Devices 1 to INDIRECT_DEVICES, more than the LE address registers. See NOTE 1 below. */
+#define INDIRECT_DEVICES 6
+
+/* A frame is queued for a random device every INDIRECT_GEN_MS */
+#define INDIRECT_GEN_MS 300
+
+/* Reception timeout, for the queuing of frames in between, and wait for the acknowledgement of a data frame */
+#define RX_TIMEOUT_UUS  10000
+#define ACK_TIMEOUT_UUS 1000
+
+/* Period of the statistics display, in milliseconds. */
+#define INDIRECT_REPORT_MS 10000
+
+/* Data request: MAC command frame with ACK request, 16-bit addresses and PAN ID compression, command 0x04, see the LE PEND TX example */
+#define DATA_REQ_LEN    12
+#define DATA_REQ_CMD    0x04
+#define FRAME_TYPE_MASK 0x07
+#define FRAME_TYPE_ACK  0x02
+#define FRAME_TYPE_CMD  0x03
+#define FC_PENDING      0x10
+#define FC_ACK_REQ      0x20
+#define ACK_FRAME_LEN   5
+
+/* Data frame to a device: 0x61 0x88 (data, ACK request, PAN ID compression, 16-bit addresses), sequence number, PAN ID, destination, source,
+ * payload. The frame pending bit is set if more frames follow. */
+#define DATA_HDR_LEN 9
+static uint8_t tx_msg[DATA_HDR_LEN + INDIRECT_DATA_MAX + FCS_LEN] = { 0x61, 0x88, 0, 0xCA, 0xDE, 0, 0, 'X', 'R' };
+#define FRAME_SN_IDX 2
+
+static uint8_t rx_buffer[FRAME_LEN_MAX];
+static indirect_t queue;
+static uint32_t rand_state = 0x2545F491UL;
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/*
+ * Send the frames of a device which just polled, until one is not acknowledged. See NOTE 2 below.
+ */
+static void send_pending(uint16_t addr)
+{
+    const indirect_frame_t *f;
+    uint32_t status_reg, latency_us;
+    uint16_t frame_len;
+    uint8_t more;
+
+    while ((f = indirect_head(&queue, addr, &more)) != NULL)
+    {
+        tx_msg[0] = more ? (0x61 | FC_PENDING) : 0x61;
+        tx_msg[FRAME_SN_IDX]++;
+        tx_msg[5] = (uint8_t)addr;
+        tx_msg[6] = (uint8_t)(addr >> 8);
+        memcpy(&tx_msg[DATA_HDR_LEN], f->data, f->len);
+        frame_len = DATA_HDR_LEN + f->len + FCS_LEN;
+
+        dwt_writetxdata(frame_len - FCS_LEN, tx_msg, 0); /* Zero offset in TX buffer. */
+        dwt_writetxfctrl(frame_len, 0, 0);               /* Zero offset in TX buffer, no ranging. */
+        dwt_setrxaftertxdelay(0);
+        dwt_setrxtimeout(ACK_TIMEOUT_UUS);
+        dwt_starttx(DWT_START_TX_IMMEDIATE | DWT_RESPONSE_EXPECTED);
+        waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+        dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+
+        waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+        if (!(status_reg & DWT_INT_RXFCG_BIT_MASK))
+        {
+            dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+            return;
+        }
+        dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+        if (dwt_getframelength() != ACK_FRAME_LEN)
+        {
+            return;
+        }
+        dwt_readrxdata(rx_buffer, ACK_FRAME_LEN - FCS_LEN, 0);
+        if ((rx_buffer[0] & FRAME_TYPE_MASK) != FRAME_TYPE_ACK || rx_buffer[FRAME_SN_IDX] != tx_msg[FRAME_SN_IDX])
+        {
+            return;
+        }
+
+        latency_us = indirect_delivered(&queue, addr);
+        BINLOG2(BINLOG_INDIRECT, addr, latency_us);
+    }
+}
+
+/**
+ * Application entry point.
+ */
+int indirect_coord(void)
+{
+    uint32_t status_reg, gen_ms, report_ms, count = 0;
+    uint8_t payload[8];
+    uint16_t frame_len, addr;
+    char str[100];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* PAN ID and short address for the frame filter, automatic acknowledgement of the frames requesting it. The queue sets the frame filter
+     * and the LE address registers. */
+    dwt_setpanid(PAN_ID);
+    dwt_setaddress16(COORD_ADDR);
+    dwt_enableautoack(0, 1);
+    indirect_init(&queue, &indirect_dw_radio);
+
+    gen_ms = report_ms = port_get_tick_ms();
+    while (1)
+    {
+        /* Queue a frame for a random device: its number and the number of the frame */
+        if (port_get_tick_ms() - gen_ms >= INDIRECT_GEN_MS)
+        {
+            gen_ms += INDIRECT_GEN_MS;
+            rand_state = rand_state * 1103515245UL + 12345UL;
+            addr = (uint16_t)(1 + (rand_state >> 16) % INDIRECT_DEVICES);
+            payload[0] = (uint8_t)addr;
+            payload[1] = (uint8_t)(addr >> 8);
+            payload[2] = (uint8_t)count;
+            payload[3] = (uint8_t)(count >> 8);
+            payload[4] = (uint8_t)(count >> 16);
+            payload[5] = (uint8_t)(count >> 24);
+            payload[6] = 'I';
+            payload[7] = 'D';
+            count++;
+            indirect_queue(&queue, addr, payload, sizeof(payload));
+        }
+        indirect_expire(&queue);
+
+        dwt_setrxtimeout(RX_TIMEOUT_UUS);
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+        waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+
+        if (status_reg & DWT_INT_RXFCG_BIT_MASK)
+        {
+            dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+            frame_len = dwt_getframelength();
+            if (frame_len <= FRAME_LEN_MAX)
+            {
+                dwt_readrxdata(rx_buffer, frame_len - FCS_LEN, 0); /* No need to read the FCS/CRC. */
+            }
+
+            if (frame_len == DATA_REQ_LEN && (rx_buffer[0] & FRAME_TYPE_MASK) == FRAME_TYPE_CMD && (rx_buffer[0] & FC_ACK_REQ)
+                && rx_buffer[9] == DATA_REQ_CMD)
+            {
+                /* Wait for the end of the automatic acknowledgement before anything else */
+                waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+                dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+
+                addr = (uint16_t)(rx_buffer[7] | (rx_buffer[8] << 8));
+                if (indirect_poll(&queue, addr))
+                {
+                    send_pending(addr);
+                }
+            }
+        }
+        else
+        {
+            dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+        }
+
+        if (port_get_tick_ms() - report_ms >= INDIRECT_REPORT_MS)
+        {
+            const indirect_stats_t *st = &queue.stats;
+
+            snprintf(str, sizeof(str), "IND q %lu dlv %lu exp %lu full %lu miss %lu ev %lu lat %lu ms max %lu ms", (unsigned long)st->queued,
+                (unsigned long)st->delivered, (unsigned long)st->expired, (unsigned long)st->full, (unsigned long)st->missed,
+                (unsigned long)st->evictions, (unsigned long)(st->delivered ? st->latency_sum_us / st->delivered / 1000 : 0),
+                (unsigned long)(st->latency_max_us / 1000));
+            test_run_info((unsigned char *)str);
+            report_ms += INDIRECT_REPORT_MS;
+        }
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. Run the "INDIRECT DEVICE" example on up to INDIRECT_DEVICES devices, with addresses 1 to INDIRECT_DEVICES (INDIRECT_DEV_ADDR). A device
+ *    polling every second gets its frames about half a second after they were queued on average, plus a second when its poll is missed
+ *    because it had no LE address register (the "miss" count): with one frame every 300 ms for 6 devices, 4 registers are mostly enough.
+ *    Frames for devices which never poll expire after INDIRECT_PERSISTENCE_MS.
+ * 2. The device keeps its receiver on after the acknowledgement with the frame pending bit, and after each data frame with the frame pending
+ *    bit, so the frames are sent back to back, each waiting for the automatic acknowledgement of the device. A frame not acknowledged stays
+ *    queued for the next poll. The latency of each frame delivered is written to the binary log (platform/binlog.h).
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,235 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    indirect_device.c
+ *  @brief   Sleepy device polling its data from an indirect transmission coordinator, example code
+ *
+ *           This example is a device of the "INDIRECT COORD" example: it wakes up every second and sends a data request to the coordinator,
+ *           as the LE PEND TX example does. If the acknowledgement has the frame pending bit set, it stays awake and receives the frames the
+ *           coordinator queued for it, until a frame without the frame pending bit, then it sleeps again. The device address is set at build
+ *           time, e.g. "cmake -DEXAMPLE=INDIRECT_DEVICE -DINDIRECT_DEV_ADDR=3". The time the device is awake for each poll is displayed every
+ *           10 polls.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <binlog.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+
+#if defined(TEST_INDIRECT_DEVICE)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "INDIRECT DEV v1.0"
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+#define PAN_ID 0xDECA
+
+/* Short address of the device, 1 to INDIRECT_DEVICES of the coordinator */
+#ifndef INDIRECT_DEV_ADDR
+#define INDIRECT_DEV_ADDR 1
+#endif
+
+/* Poll period, in milliseconds */
+#define POLL_PERIOD_MS 1000
+
+/* Wait for the acknowledgement of the data request, and for each data frame after a frame pending bit. See NOTE 1 below. */
+#define ACK_TIMEOUT_UUS  1000
+#define DATA_TIMEOUT_UUS 3000
+
+/* Number of polls between two displays */
+#define REPORT_POLLS 10
+
+/* Data request to the coordinator ("RX"), as in the LE PEND TX example: MAC command frame with ACK request, command 0x04 */
+static uint8_t data_req[] = { 0x63, 0x88, 0, 0xCA, 0xDE, 'X', 'R', (uint8_t)INDIRECT_DEV_ADDR, (uint8_t)(INDIRECT_DEV_ADDR >> 8), 0x04 };
+#define DATA_REQ_LEN (sizeof(data_req) + FCS_LEN)
+#define FRAME_SN_IDX 2
+
+#define FRAME_TYPE_MASK 0x07
+#define FRAME_TYPE_DATA 0x01
+#define FRAME_TYPE_ACK  0x02
+#define FC_PENDING      0x10
+#define ACK_FRAME_LEN   5
+
+static uint8_t rx_buffer[FRAME_LEN_MAX];
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+/*
+ * Wait for a frame after the receiver was enabled, return its length or 0 on timeout or error
+ */
+static uint16_t wait_frame(void)
+{
+    uint32_t status_reg;
+    uint16_t frame_len;
+
+    waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+    if (!(status_reg & DWT_INT_RXFCG_BIT_MASK))
+    {
+        dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+        return 0;
+    }
+    dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+    frame_len = dwt_getframelength();
+    if (frame_len > FRAME_LEN_MAX)
+    {
+        return 0;
+    }
+    dwt_readrxdata(rx_buffer, frame_len - FCS_LEN, 0); /* No need to read the FCS/CRC. */
+    return frame_len;
+}
+
+/**
+ * Application entry point.
+ */
+int indirect_device(void)
+{
+    uint32_t wake_us, awake_us, next_ms, polls = 0, polls_data = 0, frames_total = 0, awake_sum_us = 0, awake_max_us = 0;
+    uint16_t frame_len;
+    uint8_t pending, frames;
+    char str[80];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* Only the acknowledgements and the data frames to this device are received, the data frames being acknowledged automatically */
+    dwt_setpanid(PAN_ID);
+    dwt_setaddress16(INDIRECT_DEV_ADDR);
+    dwt_configureframefilter(DWT_FF_ENABLE_802_15_4, DWT_FF_DATA_EN | DWT_FF_ACK_EN);
+    dwt_enableautoack(0, 1);
+
+    next_ms = port_get_tick_ms();
+    while (1)
+    {
+        /* Wake up and poll. See NOTE 2 below. */
+        wake_us = port_get_time_us();
+        frames = 0;
+        pending = 0;
+
+        data_req[FRAME_SN_IDX]++;
+        dwt_writetxdata(DATA_REQ_LEN - FCS_LEN, data_req, 0); /* Zero offset in TX buffer. */
+        dwt_writetxfctrl(DATA_REQ_LEN, 0, 0);                 /* Zero offset in TX buffer, no ranging. */
+        dwt_setrxaftertxdelay(0);
+        dwt_setrxtimeout(ACK_TIMEOUT_UUS);
+        dwt_starttx(DWT_START_TX_IMMEDIATE | DWT_RESPONSE_EXPECTED);
+        waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+        dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+
+        frame_len = wait_frame();
+        if (frame_len == ACK_FRAME_LEN && (rx_buffer[0] & FRAME_TYPE_MASK) == FRAME_TYPE_ACK && rx_buffer[FRAME_SN_IDX] == data_req[FRAME_SN_IDX])
+        {
+            pending = (rx_buffer[0] & FC_PENDING) != 0;
+        }
+
+        /* Receive the frames while the frame pending bit is set, in the acknowledgement then in each frame */
+        if (pending)
+        {
+            polls_data++;
+            do
+            {
+                dwt_setrxtimeout(DATA_TIMEOUT_UUS);
+                dwt_rxenable(DWT_START_RX_IMMEDIATE);
+                frame_len = wait_frame();
+                if (frame_len == 0 || (rx_buffer[0] & FRAME_TYPE_MASK) != FRAME_TYPE_DATA)
+                {
+                    break;
+                }
+                /* Wait for the end of the automatic acknowledgement */
+                waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+                dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+                frames++;
+            } while (rx_buffer[0] & FC_PENDING);
+        }
+
+        awake_us = port_get_time_us() - wake_us;
+        BINLOG3(BINLOG_POLL, pending, frames, awake_us);
+        polls++;
+        frames_total += frames;
+        awake_sum_us += awake_us;
+        if (awake_us > awake_max_us)
+        {
+            awake_max_us = awake_us;
+        }
+
+        if (polls % REPORT_POLLS == 0)
+        {
+            snprintf(str, sizeof(str), "POLL %lu data %lu fr %lu awake %lu us max %lu us", (unsigned long)polls, (unsigned long)polls_data,
+                (unsigned long)frames_total, (unsigned long)(awake_sum_us / REPORT_POLLS), (unsigned long)awake_max_us);
+            test_run_info((unsigned char *)str);
+            awake_sum_us = 0;
+            awake_max_us = 0;
+        }
+
+        /* Sleep until the next poll */
+        next_ms += POLL_PERIOD_MS;
+        while ((int32_t)(port_get_tick_ms() - next_ms) < 0)
+        {
+            Sleep(1);
+        }
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The acknowledgement follows the data request at once, sent by the DW IC of the coordinator. The first data frame comes after the
+ *    coordinator read the request and wrote the frame, a few hundred microseconds, the next ones as soon as the previous one is acknowledged.
+ * 2. The device is awake from the data request to the last frame, or to the acknowledgement without frame pending bit: about 0.4 ms
+ *    without data and 0.5 to 1 ms more per frame. A device without data pending but whose poll ends in a timeout (no acknowledgement) stays
+ *    awake for ACK_TIMEOUT_UUS. Here only the MCU waits between polls, a real device also puts the DW IC to sleep, see the TX SLEEP
+ *    examples, adding its wake up time (about 1.5 ms to IDLE) to each poll.
+ ****************************************************************************************************************************************************/
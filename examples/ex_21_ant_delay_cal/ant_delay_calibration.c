@@ -0,0 +1,574 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    ant_delay_calibration.c
+ *  @brief   On-target antenna delay calibration
+ *
+ *           Three or more nodes placed at known distances from each other run this example, each built with its own ANT_CAL_NODE_ID. Node 0 is the
+ *           coordinator: it measures the averaged DS-TWR time-of-flight to every other node itself, and asks every other node to do the same for the
+ *           remaining pairs. Once all pairs are measured it solves for the antenna delay error of each node (see ant_delay_cal.c) and sends each node
+ *           its correction. Every node applies the corrected delay with dwt_settxantennadelay()/dwt_setrxantennadelay() and stores it in flash, so it
+ *           is picked up again at the next start.
+ *
+ *           Non-coordinator nodes simply wait for frames addressed to them: they act as DS-TWR responder when polled, run DS-TWR rounds when
+ *           instructed by the coordinator, and apply the correction they receive.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <ant_delay_cal.h>
+#include <config_options.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+
+#if defined(TEST_ANT_DELAY_CAL)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "ANT DLY CAL v1.0"
+
+/* Identity of this node, 0 is the coordinator. Can be passed from the build, e.g. add_definitions(-DANT_CAL_NODE_ID=1) */
+#ifndef ANT_CAL_NODE_ID
+#define ANT_CAL_NODE_ID 0
+#endif
+
+/* Number of nodes taking part in the calibration. Must match the distance table below. */
+#define ANT_CAL_NUM_NODES 3
+
+/* Distances between the nodes in millimetres. See NOTE 1 below. */
+static const uint32_t ant_cal_dist_mm[ANT_CAL_NUM_NODES][ANT_CAL_NUM_NODES] = {
+    { 0, 3000, 4000 },
+    { 3000, 0, 5000 },
+    { 4000, 5000, 0 },
+};
+
+/* Number of DS-TWR rounds averaged per pair, and minimum number of successful rounds for the pair to be used. */
+#define ANT_CAL_ROUNDS   100
+#define ANT_CAL_MIN_GOOD 50
+/* Delay between two rounds, in milliseconds. */
+#define ANT_CAL_ROUND_DELAY_MS 10
+/* Number of attempts to reach a node before giving up on it. */
+#define ANT_CAL_RETRIES 5
+
+/* Default communication configuration. We use default non-STS DW mode. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Default antenna delay values for 64 MHz PRF, used when nothing is stored yet. */
+#define TX_ANT_DLY 16385
+#define RX_ANT_DLY 16385
+
+/* Frame layout. See NOTE 2 below. */
+#define ALL_MSG_SN_IDX     2
+#define ALL_MSG_DST_IDX    5
+#define ALL_MSG_SRC_IDX    7
+#define ALL_MSG_FCODE_IDX  9
+#define ALL_MSG_COMMON_LEN 10
+#define ANT_CAL_ADDR_HI    'C'
+
+#define MSG_POLL      0xE0
+#define MSG_RESP      0xE1
+#define MSG_FINAL     0xE2
+#define MSG_REPORT    0xE3 /* Db (4), Rb (4) */
+#define MSG_CMD_RANGE 0xC0 /* peer (1) */
+#define MSG_RESULT    0xC1 /* peer (1), good rounds (1), ToF Q4 (4) */
+#define MSG_CMD_SET   0xC2 /* delay error Q4 (4) */
+#define MSG_SET_ACK   0xC3
+
+#define REPORT_MSG_DB_IDX      10
+#define REPORT_MSG_RB_IDX      14
+#define REPORT_MSG_LEN         18
+#define CMD_RANGE_MSG_PEER_IDX 10
+#define CMD_RANGE_MSG_LEN      11
+#define RESULT_MSG_PEER_IDX    10
+#define RESULT_MSG_GOOD_IDX    11
+#define RESULT_MSG_TOF_IDX     12
+#define RESULT_MSG_LEN         16
+#define CMD_SET_MSG_ERR_IDX    10
+#define CMD_SET_MSG_LEN        14
+
+#define RX_BUF_LEN 24
+static uint8_t rx_buffer[RX_BUF_LEN];
+static uint8_t tx_msg[RX_BUF_LEN];
+
+/* Frame sequence number, incremented after each transmission. */
+static uint8_t frame_seq_nb = 0;
+
+/* Hold copy of status register state here for reference so that it can be examined at a debug breakpoint. */
+static uint32_t status_reg = 0;
+
+/* Delays and timeouts of the DS-TWR exchange, in UWB microseconds. See NOTE 3 below. */
+#define POLL_TX_TO_RESP_RX_DLY_UUS  (300 + CPU_PROCESSING_TIME)
+#define RESP_RX_TIMEOUT_UUS         1000
+#define POLL_RX_TO_RESP_TX_DLY_UUS  (900 + CPU_PROCESSING_TIME)
+#define RESP_TX_TO_FINAL_RX_DLY_UUS 500
+#define RESP_RX_TO_FINAL_TX_DLY_UUS (900 + CPU_PROCESSING_TIME)
+#define FINAL_RX_TIMEOUT_UUS        1000
+#define REPORT_RX_TIMEOUT_UUS       2000
+/* Timeout when waiting for a reply from the coordinator or from a node. */
+#define CMD_RX_TIMEOUT_UUS 50000
+/* Number of CMD_RX_TIMEOUT_UUS periods the coordinator waits for the result of one pair. */
+#define RESULT_WAIT_PERIODS ((ANT_CAL_ROUNDS * (ANT_CAL_ROUND_DELAY_MS + 5) * 1000) / CMD_RX_TIMEOUT_UUS + 2)
+
+/* Antenna delays in use. */
+static uint16_t tx_ant_dly = TX_ANT_DLY;
+static uint16_t rx_ant_dly = RX_ANT_DLY;
+
+/* Sequence number of the last correction applied, to ignore repeated commands. */
+static int16_t last_set_sn = -1;
+
+extern dwt_txconfig_t txconfig_options;
+
+static void cal_msg_header(uint8_t dst, uint8_t fcode)
+{
+    tx_msg[0] = 0x41;
+    tx_msg[1] = 0x88;
+    tx_msg[ALL_MSG_SN_IDX] = frame_seq_nb++;
+    tx_msg[3] = 0xCA;
+    tx_msg[4] = 0xDE;
+    tx_msg[ALL_MSG_DST_IDX] = dst;
+    tx_msg[ALL_MSG_DST_IDX + 1] = ANT_CAL_ADDR_HI;
+    tx_msg[ALL_MSG_SRC_IDX] = ANT_CAL_NODE_ID;
+    tx_msg[ALL_MSG_SRC_IDX + 1] = ANT_CAL_ADDR_HI;
+    tx_msg[ALL_MSG_FCODE_IDX] = fcode;
+}
+
+/* Send the frame prepared in tx_msg. Unless a response is expected, wait for the end of the transmission. */
+static int cal_msg_send(uint16_t len, uint8_t mode)
+{
+    int ret;
+
+    dwt_writetxdata(len, tx_msg, 0);      /* Zero offset in TX buffer. */
+    dwt_writetxfctrl(len + FCS_LEN, 0, 1); /* Zero offset in TX buffer, ranging. */
+    ret = dwt_starttx(mode);
+
+    if (ret == DWT_SUCCESS && !(mode & DWT_RESPONSE_EXPECTED))
+    {
+        waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+        dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+    }
+    return ret;
+}
+
+/* Wait for a frame addressed to this node (receiver must already be enabled).
+ * Returns its function code, or 0 on timeout, error or a frame for another node. */
+static uint8_t cal_msg_receive(void)
+{
+    uint16_t frame_len;
+
+    waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+
+    if (!(status_reg & DWT_INT_RXFCG_BIT_MASK))
+    {
+        /* Clear RX error/timeout events in the DW IC status register. */
+        dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR | DWT_INT_TXFRS_BIT_MASK);
+        return 0;
+    }
+
+    /* Clear good RX frame event and TX frame sent in the DW IC status register. */
+    dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK | DWT_INT_TXFRS_BIT_MASK);
+
+    frame_len = dwt_getframelength();
+    if (frame_len > RX_BUF_LEN || frame_len < ALL_MSG_COMMON_LEN + FCS_LEN)
+    {
+        return 0;
+    }
+    dwt_readrxdata(rx_buffer, frame_len - FCS_LEN, 0); /* No need to read the FCS/CRC. */
+
+    if (rx_buffer[3] != 0xCA || rx_buffer[4] != 0xDE || rx_buffer[ALL_MSG_DST_IDX] != ANT_CAL_NODE_ID
+        || rx_buffer[ALL_MSG_DST_IDX + 1] != ANT_CAL_ADDR_HI)
+    {
+        return 0;
+    }
+    return rx_buffer[ALL_MSG_FCODE_IDX];
+}
+
+/* Enable the receiver with the given timeout and wait for a frame from a given node with a given function code. */
+static int cal_wait_for(uint8_t src, uint8_t fcode, uint32_t timeout_uus)
+{
+    dwt_setrxtimeout(timeout_uus);
+    dwt_rxenable(DWT_START_RX_IMMEDIATE);
+    return (cal_msg_receive() == fcode) && (rx_buffer[ALL_MSG_SRC_IDX] == src);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn cal_range_with_peer()
+ *
+ * @brief Run ANT_CAL_ROUNDS DS-TWR rounds as initiator towards a peer and average the time-of-flight. See NOTE 4 below.
+ *
+ * @param peer - node index of the responder
+ * @param tof_q4 - receives the averaged ToF in Q4 device time units
+ *
+ * @return number of successful rounds
+ */
+static uint8_t cal_range_with_peer(uint8_t peer, int32_t *tof_q4)
+{
+    int64_t sum = 0;
+    uint8_t good = 0;
+    uint8_t round;
+
+    for (round = 0; round < ANT_CAL_ROUNDS; round++)
+    {
+        uint32_t poll_tx_ts, resp_rx_ts, final_tx_ts, final_tx_time;
+        uint32_t db, rb;
+        int64_t ra, da, num, den;
+
+        Sleep(ANT_CAL_ROUND_DELAY_MS);
+
+        /* Poll, the response is received automatically after POLL_TX_TO_RESP_RX_DLY_UUS. */
+        dwt_setrxaftertxdelay(POLL_TX_TO_RESP_RX_DLY_UUS);
+        dwt_setrxtimeout(RESP_RX_TIMEOUT_UUS);
+        cal_msg_header(peer, MSG_POLL);
+        cal_msg_send(ALL_MSG_COMMON_LEN, DWT_START_TX_IMMEDIATE | DWT_RESPONSE_EXPECTED);
+
+        if (cal_msg_receive() != MSG_RESP || rx_buffer[ALL_MSG_SRC_IDX] != peer)
+        {
+            continue;
+        }
+
+        poll_tx_ts = dwt_readtxtimestamplo32();
+        resp_rx_ts = dwt_readrxtimestamplo32();
+
+        /* Final, sent at a known time so that the responder report can be received right after it. */
+        final_tx_time = (uint32_t)((get_rx_timestamp_u64() + ((uint64_t)RESP_RX_TO_FINAL_TX_DLY_UUS * UUS_TO_DWT_TIME)) >> 8);
+        dwt_setdelayedtrxtime(final_tx_time);
+        final_tx_ts = ((final_tx_time & 0xFFFFFFFEUL) << 8) + tx_ant_dly;
+
+        dwt_setrxaftertxdelay(0);
+        dwt_setrxtimeout(REPORT_RX_TIMEOUT_UUS);
+        cal_msg_header(peer, MSG_FINAL);
+        if (cal_msg_send(ALL_MSG_COMMON_LEN, DWT_START_TX_DELAYED | DWT_RESPONSE_EXPECTED) != DWT_SUCCESS)
+        {
+            continue;
+        }
+
+        if (cal_msg_receive() != MSG_REPORT || rx_buffer[ALL_MSG_SRC_IDX] != peer)
+        {
+            continue;
+        }
+
+        final_msg_get_ts(&rx_buffer[REPORT_MSG_DB_IDX], &db);
+        final_msg_get_ts(&rx_buffer[REPORT_MSG_RB_IDX], &rb);
+
+        /* 32-bit subtractions give correct answers even if clock has wrapped. */
+        ra = (uint32_t)(resp_rx_ts - poll_tx_ts);
+        da = (uint32_t)(final_tx_ts - resp_rx_ts);
+        num = (ra * (int64_t)rb - da * (int64_t)db) << ANT_CAL_FRAC_BITS;
+        den = ra + rb + da + db;
+
+        sum += num / den;
+        good++;
+    }
+
+    *tof_q4 = good ? (int32_t)(sum / good) : 0;
+    return good;
+}
+
+/* Responder side of one DS-TWR round, entered after a poll has been received. */
+static void cal_respond_to_poll(void)
+{
+    uint8_t peer = rx_buffer[ALL_MSG_SRC_IDX];
+    uint64_t poll_rx_ts, resp_tx_ts, final_rx_ts;
+    uint32_t resp_tx_time;
+
+    poll_rx_ts = get_rx_timestamp_u64();
+
+    resp_tx_time = (uint32_t)((poll_rx_ts + ((uint64_t)POLL_RX_TO_RESP_TX_DLY_UUS * UUS_TO_DWT_TIME)) >> 8);
+    dwt_setdelayedtrxtime(resp_tx_time);
+    resp_tx_ts = (((uint64_t)(resp_tx_time & 0xFFFFFFFEUL)) << 8) + tx_ant_dly;
+
+    dwt_setrxaftertxdelay(RESP_TX_TO_FINAL_RX_DLY_UUS);
+    dwt_setrxtimeout(FINAL_RX_TIMEOUT_UUS);
+    cal_msg_header(peer, MSG_RESP);
+    if (cal_msg_send(ALL_MSG_COMMON_LEN, DWT_START_TX_DELAYED | DWT_RESPONSE_EXPECTED) != DWT_SUCCESS)
+    {
+        return;
+    }
+
+    if (cal_msg_receive() != MSG_FINAL || rx_buffer[ALL_MSG_SRC_IDX] != peer)
+    {
+        return;
+    }
+
+    final_rx_ts = get_rx_timestamp_u64();
+
+    cal_msg_header(peer, MSG_REPORT);
+    final_msg_set_ts(&tx_msg[REPORT_MSG_DB_IDX], resp_tx_ts - poll_rx_ts);
+    final_msg_set_ts(&tx_msg[REPORT_MSG_RB_IDX], final_rx_ts - resp_tx_ts);
+    cal_msg_send(REPORT_MSG_LEN, DWT_START_TX_IMMEDIATE);
+}
+
+/* Apply a delay error computed by the coordinator and store the result. */
+static void cal_apply_and_store(int32_t err_q4)
+{
+    tx_ant_dly = ant_cal_apply(tx_ant_dly, err_q4);
+    rx_ant_dly = ant_cal_apply(rx_ant_dly, err_q4);
+    dwt_settxantennadelay(tx_ant_dly);
+    dwt_setrxantennadelay(rx_ant_dly);
+
+    if (port_ant_delay_store(tx_ant_dly, rx_ant_dly) != 0)
+    {
+        test_run_info((unsigned char *)"STORE FAILED");
+    }
+
+    snprintf(dist_str, sizeof(dist_str), "DLY %u/%u", tx_ant_dly, rx_ant_dly);
+    test_run_info((unsigned char *)dist_str);
+}
+
+/* Node role: serve polls, range on request of the coordinator and apply the correction it sends. */
+static void cal_node(void)
+{
+    while (1)
+    {
+        uint8_t fcode;
+
+        dwt_setrxtimeout(0);
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+        fcode = cal_msg_receive();
+
+        if (fcode == MSG_POLL)
+        {
+            cal_respond_to_poll();
+        }
+        else if (fcode == MSG_CMD_RANGE)
+        {
+            uint8_t peer = rx_buffer[CMD_RANGE_MSG_PEER_IDX];
+            int32_t tof_q4;
+            uint8_t good;
+
+            good = cal_range_with_peer(peer, &tof_q4);
+
+            cal_msg_header(0, MSG_RESULT);
+            tx_msg[RESULT_MSG_PEER_IDX] = peer;
+            tx_msg[RESULT_MSG_GOOD_IDX] = good;
+            final_msg_set_ts(&tx_msg[RESULT_MSG_TOF_IDX], (uint32_t)tof_q4);
+            cal_msg_send(RESULT_MSG_LEN, DWT_START_TX_IMMEDIATE);
+        }
+        else if (fcode == MSG_CMD_SET)
+        {
+            uint32_t err_q4;
+
+            final_msg_get_ts(&rx_buffer[CMD_SET_MSG_ERR_IDX], &err_q4);
+
+            cal_msg_header(0, MSG_SET_ACK);
+            cal_msg_send(ALL_MSG_COMMON_LEN, DWT_START_TX_IMMEDIATE);
+
+            /* The coordinator repeats the command if the ACK is lost, only apply it once per sequence number. */
+            if (last_set_sn != rx_buffer[ALL_MSG_SN_IDX])
+            {
+                last_set_sn = rx_buffer[ALL_MSG_SN_IDX];
+                cal_apply_and_store((int32_t)err_q4);
+            }
+        }
+    }
+}
+
+/* Have node i measure the pair (i, j) and return the result. */
+static uint8_t cal_request_pair(uint8_t i, uint8_t j, int32_t *tof_q4)
+{
+    uint8_t retry;
+    uint16_t period;
+
+    if (i == ANT_CAL_NODE_ID)
+    {
+        return cal_range_with_peer(j, tof_q4);
+    }
+
+    for (retry = 0; retry < ANT_CAL_RETRIES; retry++)
+    {
+        cal_msg_header(i, MSG_CMD_RANGE);
+        tx_msg[CMD_RANGE_MSG_PEER_IDX] = j;
+        cal_msg_send(CMD_RANGE_MSG_LEN, DWT_START_TX_IMMEDIATE);
+
+        for (period = 0; period < RESULT_WAIT_PERIODS; period++)
+        {
+            if (cal_wait_for(i, MSG_RESULT, CMD_RX_TIMEOUT_UUS) && rx_buffer[RESULT_MSG_PEER_IDX] == j)
+            {
+                uint32_t tof;
+
+                final_msg_get_ts(&rx_buffer[RESULT_MSG_TOF_IDX], &tof);
+                *tof_q4 = (int32_t)tof;
+                return rx_buffer[RESULT_MSG_GOOD_IDX];
+            }
+        }
+    }
+    return 0;
+}
+
+/* Coordinator role: collect all pairs, solve and distribute the corrections. */
+static void cal_coordinator(void)
+{
+    static ant_cal_t cal;
+    int32_t err_q4[ANT_CAL_NUM_NODES];
+    int32_t residual_q4;
+    uint8_t i, j, retry;
+    int iter;
+
+    ant_cal_init(&cal, ANT_CAL_NUM_NODES);
+
+    for (i = 0; i < ANT_CAL_NUM_NODES; i++)
+    {
+        for (j = i + 1; j < ANT_CAL_NUM_NODES; j++)
+        {
+            int32_t tof_q4;
+            uint8_t good = cal_request_pair(i, j, &tof_q4);
+
+            snprintf(dist_str, sizeof(dist_str), "%u-%u: %u ok", i, j, good);
+            test_run_info((unsigned char *)dist_str);
+
+            if (good >= ANT_CAL_MIN_GOOD)
+            {
+                ant_cal_add_pair(&cal, i, j, tof_q4, ant_cal_dist_mm[i][j]);
+            }
+        }
+    }
+
+    iter = ant_cal_solve(&cal, err_q4, &residual_q4);
+    if (iter < 0)
+    {
+        test_run_info((unsigned char *)"CAL UNDERDETERMINED");
+        return;
+    }
+
+    snprintf(dist_str, sizeof(dist_str), "RES %ld ps", (long)residual_q4 * 1565 / 1600);
+    test_run_info((unsigned char *)dist_str);
+
+    for (i = 0; i < ANT_CAL_NUM_NODES; i++)
+    {
+        uint8_t set_sn = frame_seq_nb;
+
+        if (i == ANT_CAL_NODE_ID)
+        {
+            continue;
+        }
+
+        for (retry = 0; retry < ANT_CAL_RETRIES; retry++)
+        {
+            cal_msg_header(i, MSG_CMD_SET);
+            tx_msg[ALL_MSG_SN_IDX] = set_sn; /* Same sequence number on retries so the node applies it only once. */
+            final_msg_set_ts(&tx_msg[CMD_SET_MSG_ERR_IDX], (uint32_t)err_q4[i]);
+            cal_msg_send(CMD_SET_MSG_LEN, DWT_START_TX_IMMEDIATE);
+
+            if (cal_wait_for(i, MSG_SET_ACK, CMD_RX_TIMEOUT_UUS))
+            {
+                break;
+            }
+        }
+
+        if (retry == ANT_CAL_RETRIES)
+        {
+            snprintf(dist_str, sizeof(dist_str), "NODE %u NO ACK", i);
+            test_run_info((unsigned char *)dist_str);
+        }
+    }
+
+    cal_apply_and_store(err_q4[ANT_CAL_NODE_ID]);
+    test_run_info((unsigned char *)"CAL DONE");
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn ant_delay_calibration()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int ant_delay_calibration(void)
+{
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* Start from the previously calibrated antenna delays, if any. */
+    if (port_ant_delay_load(&tx_ant_dly, &rx_ant_dly) != 0)
+    {
+        tx_ant_dly = TX_ANT_DLY;
+        rx_ant_dly = RX_ANT_DLY;
+    }
+    dwt_setrxantennadelay(rx_ant_dly);
+    dwt_settxantennadelay(tx_ant_dly);
+
+    /* Next can enable TX/RX states output on GPIOs 5 and 6 to help debug, and also TX/RX LEDs
+     * Note, in real low power applications the LEDs should not be used. */
+    dwt_setlnapamode(DWT_LNA_ENABLE | DWT_PA_ENABLE);
+
+    if (ANT_CAL_NODE_ID == 0)
+    {
+        /* Give the other nodes time to start up. */
+        Sleep(1000);
+        cal_coordinator();
+    }
+
+    /* After calibration the coordinator keeps serving polls, e.g. for verification with another node. */
+    cal_node();
+
+    return DWT_SUCCESS;
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The accuracy of the calibration is directly bound by the accuracy of these distances. The nodes should be placed in line of sight of each
+ *    other, at the height and orientation they will be used in, and far enough apart (a few metres) that near field effects do not matter.
+ * 2. All frames are IEEE 802.15.4 data frames with 16-bit addressing:
+ *     - byte 0/1: frame control (0x8841 to indicate a data frame using 16-bit addressing).
+ *     - byte 2: sequence number, incremented for each new frame.
+ *     - byte 3/4: PAN ID (0xDECA).
+ *     - byte 5/6: destination address, node index and ANT_CAL_ADDR_HI.
+ *     - byte 7/8: source address, node index and ANT_CAL_ADDR_HI.
+ *     - byte 9: function code, see MSG_xxx above.
+ *    All multi-byte fields are little endian.
+ * 3. The delays used here are generous compared to the DS-TWR examples as the calibration is not time critical. What matters is that the
+ *    reply delays are the same for all pairs and that both sides use the same antenna delay for TX and RX.
+ * 4. The DS-TWR exchange is the one of the DS-TWR examples with an extra "report" frame, in which the responder returns its reply time (Db) and
+ *    round time (Rb) so that the initiator can compute the time-of-flight itself:
+ *        ToF = (Ra * Rb - Da * Db) / (Ra + Rb + Da + Db)
+ *    Integer arithmetic is used: all reply and round times stay well below 2^32 device time units, and their products below 2^59.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,70 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    twr_bench_initiator.c
+ *  @brief   Ranging benchmark, initiator
+ *
+ *           Runs SS-TWR, DS-TWR, SS-TWR with STS, DS-TWR with STS-SDC and AES secured SS-TWR exchanges one after the other against the
+ *           benchmark responder, for each configuration preset of twr_bench.c, and prints one JSON line of results per run (exchanges per
+ *           second, success ratio, turnaround percentiles, CPU utilisation). See twr_bench.h.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <twr_bench.h>
+
+#if defined(TEST_TWR_BENCH_INITIATOR)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "TWR BENCH INIT v1.0"
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn twr_bench_initiator()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int twr_bench_initiator(void)
+{
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Next can enable TX/RX states output on GPIOs 5 and 6 to help debug, and also TX/RX LEDs
+     * Note, in real low power applications the LEDs should not be used. */
+    dwt_setlnapamode(DWT_LNA_ENABLE | DWT_PA_ENABLE);
+
+    /* The benchmark configures the DW IC for each run, see twr_bench_dw.c. */
+    twr_bench_run_initiator(&twr_bench_dw_radio, TWR_BENCH_RUN_MS);
+
+    while (1) { };
+}
+#endif
@@ -0,0 +1,70 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    twr_bench_responder.c
+ *  @brief   Ranging benchmark, responder
+ *
+ *           Answers the exchanges of the benchmark initiator and measures its poll to response turnaround, which is sent back to the
+ *           initiator and printed with its results. See twr_bench.h.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <twr_bench.h>
+
+#if defined(TEST_TWR_BENCH_RESPONDER)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "TWR BENCH RESP v1.0"
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn twr_bench_responder()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int twr_bench_responder(void)
+{
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED     ");
+        while (1) { };
+    }
+
+    /* Next can enable TX/RX states output on GPIOs 5 and 6 to help debug, and also TX/RX LEDs
+     * Note, in real low power applications the LEDs should not be used. */
+    dwt_setlnapamode(DWT_LNA_ENABLE | DWT_PA_ENABLE);
+
+    /* The benchmark configures the DW IC for each run, see twr_bench_dw.c. */
+    twr_bench_run_responder(&twr_bench_dw_radio);
+
+    test_run_info((unsigned char *)"DONE");
+    while (1) { };
+}
+#endif
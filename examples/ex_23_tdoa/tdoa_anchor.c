@@ -0,0 +1,370 @@
+/*! ----------------------------------------------------------------------------
+ *  @file    tdoa_anchor.c
+ *  @brief   TDoA anchor example code
+ *
+ *           This application is an anchor of a time difference of arrival (TDoA) system: it timestamps the blinks of the tags (as sent by the
+ *           "simple TX" example) and streams the timestamps to the host, which compares the timestamps of a blink from all anchors to locate the
+ *           tag. For the timestamps of different anchors to be comparable, they are all expressed in the clock of one of them, the reference
+ *           anchor (TDOA_ANCHOR_ID 0), which transmits sync beacons carrying their own TX timestamp. The other anchors receive the beacons, fit
+ *           their clock to the reference clock (offset and drift, see tdoa_sync.h) and convert the timestamps of the blinks accordingly.
+ *           The anchor ID and the distance to the reference anchor are set at build time, e.g.
+ *           "cmake -DEXAMPLE=TDOA_ANCHOR -DTDOA_ANCHOR_ID=2 -DTDOA_REF_DIST_MM=12500".
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deca_probe_interface.h"
+#include <binlog.h>
+#include <deca_device_api.h>
+#include <deca_spi.h>
+#include <example_selection.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <stdio.h>
+#include <string.h>
+#include <tdoa_sync.h>
+
+#if defined(TEST_TDOA_ANCHOR)
+
+extern void test_run_info(unsigned char *data);
+
+/* Example application name */
+#define APP_NAME "TDOA ANCHOR v1.0"
+
+/* ID of this anchor, 0 for the reference anchor, and its distance to the reference anchor. See NOTE 1 below. */
+#ifndef TDOA_ANCHOR_ID
+#define TDOA_ANCHOR_ID 0
+#endif
+#ifndef TDOA_REF_DIST_MM
+#define TDOA_REF_DIST_MM 0
+#endif
+#define TDOA_IS_REF (TDOA_ANCHOR_ID == 0)
+
+/* Default communication configuration, as the "simple TX" example sending the blinks. */
+static dwt_config_t config = {
+    5,                /* Channel number. */
+    DWT_PLEN_128,     /* Preamble length. Used in TX only. */
+    DWT_PAC8,         /* Preamble acquisition chunk size. Used in RX only. */
+    9,                /* TX preamble code. Used in TX only. */
+    9,                /* RX preamble code. Used in RX only. */
+    1,                /* 0 to use standard 8 symbol SFD, 1 to use non-standard 8 symbol, 2 for non-standard 16 symbol SFD and 3 for 4z 8 symbol SDF type */
+    DWT_BR_6M8,       /* Data rate. */
+    DWT_PHRMODE_STD,  /* PHY header mode. */
+    DWT_PHRRATE_STD,  /* PHY header rate. */
+    (129 + 8 - 8),    /* SFD timeout (preamble length + 1 + SFD length - PAC size). Used in RX only. */
+    DWT_STS_MODE_OFF, /* STS disabled */
+    DWT_STS_LEN_64,   /* STS length see allowed values in Enum dwt_sts_lengths_e */
+    DWT_PDOA_M0       /* PDOA mode off */
+};
+
+/* Default antenna delay values for 64 MHz PRF. See NOTE 2 below. */
+#define TX_ANT_DLY 16385
+#define RX_ANT_DLY 16385
+
+/* Frames. See NOTE 3 below. */
+static uint8_t sync_msg[] = { 0x41, 0x88, 0, 0xCA, 0xDE, 0xFF, 0xFF, 'R', 'F', 0xE8, 0, 0, 0, 0, 0, 0, 0 };
+#define ALL_MSG_SN_IDX      2
+#define SYNC_MSG_COMMON_LEN 10
+#define SYNC_MSG_TX_TS_IDX  10
+#define BLINK_MSG_LEN       12
+#define BLINK_MSG_SN_IDX    1
+#define BLINK_MSG_ID_IDX    2
+#define BLINK_MSG_ID_LEN    8
+
+/* Sync beacons of the reference anchor: period, and delay from the programming of the transmission to the transmission. */
+#define SYNC_PERIOD_MS   100
+#define SYNC_TX_DLY_UUS  2000
+
+/* Receiver timeout, so that the reference anchor transmits its beacons on time and the statistics are displayed. */
+#define RX_TIMEOUT_UUS 10000
+
+/* Blink record streamed to the host. See NOTE 4 below. */
+#define TDOA_REC_SYNC        0xAD0A
+#define TDOA_REC_LEN         20
+#define TDOA_REC_FLAG_SYNCED 0x01
+#define TDOA_REC_FLAG_REF    0x02
+
+/* Period of the statistics display, in milliseconds. */
+#define TDOA_REPORT_MS 1000
+
+/* Buffer to store received frames, as long as the longest frame handled. */
+#define RX_BUF_LEN sizeof(sync_msg)
+static uint8_t rx_buffer[RX_BUF_LEN];
+
+/* Hold copy of status register state here for reference so that it can be examined at a debug breakpoint. */
+static uint32_t status_reg = 0;
+
+/* Synchronisation to the reference clock, unused by the reference anchor itself. */
+static tdoa_sync_t tdoa_sync;
+
+/* Counters, cumulative since start, so that they can be examined at a debug breakpoint. */
+static uint32_t blinks;
+static uint32_t unsynced; /* Blinks received while not synchronised */
+static uint32_t dropped;  /* Records the host did not take */
+
+/* Values for the PG_DELAY and TX_POWER registers reflect the bandwidth and power of the spectrum at the current
+ * temperature. These values can be calibrated prior to taking reference measurements. */
+extern dwt_txconfig_t txconfig_options;
+
+static void ts_set40(uint8_t *field, uint64_t ts)
+{
+    int i;
+
+    for (i = 0; i < 5; i++)
+    {
+        field[i] = (uint8_t)(ts >> (8 * i));
+    }
+}
+
+static uint64_t ts_get40(const uint8_t *field)
+{
+    uint64_t ts = 0;
+    int i;
+
+    for (i = 4; i >= 0; i--)
+    {
+        ts = (ts << 8) | field[i];
+    }
+    return ts;
+}
+
+/*
+ * Transmit a sync beacon carrying its own TX timestamp. See NOTE 5 below.
+ */
+static void tdoa_send_sync(uint8_t seq)
+{
+    uint32_t tx_time;
+    uint64_t tx_ts;
+
+    tx_time = dwt_readsystimestamphi32() + ((SYNC_TX_DLY_UUS * UUS_TO_DWT_TIME) >> 8);
+    tx_ts = ((((uint64_t)(tx_time & 0xFFFFFFFEUL)) << 8) + TX_ANT_DLY) & TDOA_TS_MASK;
+
+    sync_msg[ALL_MSG_SN_IDX] = seq;
+    ts_set40(&sync_msg[SYNC_MSG_TX_TS_IDX], tx_ts);
+    dwt_setdelayedtrxtime(tx_time);
+    dwt_writetxdata(sizeof(sync_msg), sync_msg, 0); /* Zero offset in TX buffer. */
+    dwt_writetxfctrl(sizeof(sync_msg), 0, 1);       /* Zero offset in TX buffer, ranging. */
+    if (dwt_starttx(DWT_START_TX_DELAYED) == DWT_SUCCESS)
+    {
+        waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+        dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+    }
+}
+
+/*
+ * Stream the record of a blink, or count it as dropped if the host does not keep up.
+ */
+static void tdoa_stream_blink(const uint8_t *blink, uint64_t ts, uint8_t flags)
+{
+    uint8_t rec[TDOA_REC_LEN];
+    uint32_t err = tdoa_sync.rms_dtu;
+
+    if (port_stream_space(PORT_STREAM_DATA) < TDOA_REC_LEN)
+    {
+        dropped++;
+        return;
+    }
+    rec[0] = (uint8_t)TDOA_REC_SYNC;
+    rec[1] = (uint8_t)(TDOA_REC_SYNC >> 8);
+    rec[2] = TDOA_ANCHOR_ID;
+    rec[3] = blink[BLINK_MSG_SN_IDX];
+    memcpy(&rec[4], &blink[BLINK_MSG_ID_IDX], BLINK_MSG_ID_LEN);
+    ts_set40(&rec[12], ts);
+    rec[17] = flags;
+    if (err > 0xFFFF)
+    {
+        err = 0xFFFF;
+    }
+    rec[18] = (uint8_t)err;
+    rec[19] = (uint8_t)(err >> 8);
+    port_stream_write(PORT_STREAM_DATA, rec, TDOA_REC_LEN);
+}
+
+/*
+ * Handle a frame received: a blink to timestamp, or a sync beacon.
+ */
+static void tdoa_rx_frame(void)
+{
+    uint16_t frame_len = dwt_getframelength();
+    uint64_t rx_ts = get_rx_timestamp_u64();
+    uint64_t ts;
+
+    if (frame_len > sizeof(rx_buffer))
+    {
+        return;
+    }
+    dwt_readrxdata(rx_buffer, frame_len, 0);
+
+    if (frame_len == BLINK_MSG_LEN && rx_buffer[0] == 0xC5)
+    {
+        blinks++;
+        if (TDOA_IS_REF)
+        {
+            tdoa_stream_blink(rx_buffer, rx_ts, TDOA_REC_FLAG_SYNCED | TDOA_REC_FLAG_REF);
+        }
+        else if (tdoa_sync_convert(&tdoa_sync, rx_ts, &ts) == 0)
+        {
+            tdoa_stream_blink(rx_buffer, ts, TDOA_REC_FLAG_SYNCED);
+        }
+        else
+        {
+            /* Streamed all the same, with the local timestamp, so that the host sees the blink. */
+            unsynced++;
+            tdoa_stream_blink(rx_buffer, rx_ts, 0);
+        }
+    }
+    else if (!TDOA_IS_REF && frame_len == sizeof(sync_msg) && memcmp(&rx_buffer[3], &sync_msg[3], SYNC_MSG_COMMON_LEN - 3) == 0)
+    {
+        int ret = tdoa_sync_beacon(&tdoa_sync, rx_buffer[ALL_MSG_SN_IDX], ts_get40(&rx_buffer[SYNC_MSG_TX_TS_IDX]),
+            TDOA_MM_TO_DTU(TDOA_REF_DIST_MM), rx_ts);
+
+        BINLOG3(BINLOG_TDOA_SYNC, (int32_t)(((int64_t)tdoa_sync.drift_q32 * 1000000000) >> 32), tdoa_sync.rms_dtu, ret);
+    }
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn tdoa_anchor()
+ *
+ * @brief Application entry point.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+int tdoa_anchor(void)
+{
+    uint32_t report_ms, sync_ms, now_ms;
+    uint32_t last_blinks = 0;
+    uint8_t sync_seq = 0;
+    char str[80];
+
+    /* Display application name on LCD. */
+    test_run_info((unsigned char *)APP_NAME);
+
+    if (port_stream_init(PORT_STREAM_DATA) < 0)
+    {
+        test_run_info((unsigned char *)"STREAM INIT FAILED");
+        while (1) { };
+    }
+
+    /* Configure SPI rate, DW3000 supports up to 36 MHz */
+    port_set_dw_ic_spi_fastrate();
+
+    /* Reset DW IC */
+    reset_DWIC(); /* Target specific drive of RSTn line into DW IC low for a period. */
+
+    Sleep(2); // Time needed for DW3000 to start up (transition from INIT_RC to IDLE_RC, or could wait for SPIRDY event)
+
+    /* Probe for the correct device driver. */
+    dwt_probe((struct dwt_probe_s *)&dw3000_probe_interf);
+
+    while (!dwt_checkidlerc()) /* Need to make sure DW IC is in IDLE_RC before proceeding */ { };
+
+    if (dwt_initialise(DWT_DW_INIT) == DWT_ERROR)
+    {
+        test_run_info((unsigned char *)"INIT FAILED");
+        while (1) { };
+    }
+
+    /* Configure DW IC. */
+    /* if the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed the host should reset the device */
+    if (dwt_configure(&config))
+    {
+        test_run_info((unsigned char *)"CONFIG FAILED     ");
+        while (1) { };
+    }
+
+    /* Configure the TX spectrum parameters (power, PG delay and PG count) */
+    dwt_configuretxrf(&txconfig_options);
+
+    /* Apply default antenna delay value. See NOTE 2 below. */
+    dwt_setrxantennadelay(RX_ANT_DLY);
+    dwt_settxantennadelay(TX_ANT_DLY);
+
+    dwt_setrxtimeout(RX_TIMEOUT_UUS);
+    tdoa_sync_init(&tdoa_sync);
+
+    report_ms = sync_ms = port_get_tick_ms();
+
+    /* Loop forever receiving blinks, and beacons or sending them. */
+    while (1)
+    {
+        now_ms = port_get_tick_ms();
+        if (TDOA_IS_REF && now_ms - sync_ms >= SYNC_PERIOD_MS)
+        {
+            tdoa_send_sync(sync_seq++);
+            sync_ms += SYNC_PERIOD_MS;
+        }
+
+        if (now_ms - report_ms >= TDOA_REPORT_MS)
+        {
+            snprintf(str, sizeof(str), "A%u %lu blink/s unsync %lu drop %lu bcn %lu lost %lu drift %ld ppb rms %lu", TDOA_ANCHOR_ID,
+                (unsigned long)((blinks - last_blinks) * 1000 / (now_ms - report_ms)), (unsigned long)unsynced, (unsigned long)dropped,
+                (unsigned long)tdoa_sync.beacons, (unsigned long)tdoa_sync.lost, (long)(((int64_t)tdoa_sync.drift_q32 * 1000000000) >> 32),
+                (unsigned long)tdoa_sync.rms_dtu);
+            test_run_info((unsigned char *)str);
+            last_blinks = blinks;
+            report_ms = now_ms;
+        }
+
+        /* Activate reception immediately. */
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+
+        /* Poll for reception of a frame or error/timeout. */
+        waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+
+        if (status_reg & DWT_INT_RXFCG_BIT_MASK)
+        {
+            /* Clear good RX frame event in the DW IC status register. */
+            dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+
+            tdoa_rx_frame();
+        }
+        else
+        {
+            /* Clear RX error/timeout events in the DW IC status register. */
+            dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+        }
+    }
+}
+#endif
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. Every anchor is built with its own TDOA_ANCHOR_ID, 0 being the reference anchor. The other anchors must receive the beacons of the
+ *    reference anchor, and know their distance to it (TDOA_REF_DIST_MM, from the surveyed positions of the anchors): the beacons are received
+ *    one time of flight after their transmission, which is added to their TX timestamp. An error of this distance shifts all the timestamps
+ *    of the anchor, i.e. biases the positions computed by the host.
+ * 2. The sum of the values is the TX to RX antenna delay, experimentally determined by a calibration process. Here we use a hard coded typical value
+ *    but, in a real application, each device should have its own antenna delay properly calibrated (see the ant_delay_cal example). With TDoA
+ *    the RX antenna delay of each anchor, and the TX antenna delay of the reference anchor, directly shift the timestamps.
+ * 3. The blinks are the 12-byte frames of the "simple TX" example, 0xC5, a sequence number and the 8-byte ID of the tag, plus the FCS. The
+ *    sync beacon is a broadcast data frame:
+ *     - byte 0/1: frame control (0x8841 to indicate a data frame using 16-bit addressing).
+ *     - byte 2: sequence number, incremented for each beacon, so that the anchors count the beacons they miss.
+ *     - byte 3/4: PAN ID (0xDECA).
+ *     - byte 5/6: destination address, broadcast (0xFFFF).
+ *     - byte 7/8: source address, "RF".
+ *     - byte 9: function code 0xE8.
+ *     - byte 10 -> 14: TX timestamp of the beacon, the 40 bits, least significant byte first.
+ *    All frames end with a 2-byte checksum automatically set by DW IC.
+ * 4. The stream (RTT channel 2, or the console UART when RTT is not used) is a sequence of 20-byte little endian records, one per blink:
+ *     - sync 0xAD0A (2 bytes)
+ *     - anchor ID (1 byte)
+ *     - sequence number of the blink (1 byte)
+ *     - tag ID (8 bytes)
+ *     - RX timestamp of the blink, 40 bits in the clock of the reference anchor (5 bytes)
+ *     - flags (1 byte): bit 0 set if the timestamp is in the reference clock, bit 1 set for the reference anchor itself. Without bit 0 the
+ *       anchor is not synchronised yet, and the timestamp is in its own clock.
+ *     - RMS of the residuals of the synchronisation, in device time units (2 bytes), 0 for the reference anchor.
+ *    The host collects the records of all anchors, groups them by tag ID and sequence number, and computes the differences of the timestamps,
+ *    e.g. tools/tdoa_decode.py with the streams of all anchors, which prints them in metres.
+ *    A record the host does not take is dropped and counted, nothing is queued: the record is only valid while the beacons around it are.
+ * 5. The TX timestamp is computed in advance, as in the ss_twr_responder example: the transmission time is the current time plus
+ *    SYNC_TX_DLY_UUS, its 9 lower bits ignored by the DW IC, plus the TX antenna delay. If the transmission is late the beacon is not sent, and
+ *    the anchors see one beacon lost. While the reference anchor sends a beacon it does not receive, so a blink may be missed by it.
+ * 6. With beacons every 100 ms and anchor clocks within 20 ppm, the synchronisation error at a blink is about the noise of the beacon
+ *    timestamps divided by the square root of the window, i.e. within 100 ps (3 cm), see tdoa_sync.c. The drift estimated by each anchor,
+ *    in ppb, is also written to the binary log (platform/binlog.h) for each beacon, e.g. "TDOA drift=-4316 ppb rms=5 dtu rc=0".
+ ****************************************************************************************************************************************************/
@@ -392,6 +392,126 @@ void build_examples(void)
 
     example_pointer = simple_aes;
     test_cnt++;
+#endif
+#ifdef TEST_ANT_DELAY_CAL
+    extern int ant_delay_calibration(void);
+
+    example_pointer = ant_delay_calibration;
+    test_cnt++;
+#endif
+#ifdef TEST_CIR_CAPTURE
+    extern int cir_capture(void);
+
+    example_pointer = cir_capture;
+    test_cnt++;
+#endif
+#ifdef TEST_TWR_BENCH_INITIATOR
+    extern int twr_bench_initiator(void);
+
+    example_pointer = twr_bench_initiator;
+    test_cnt++;
+#endif
+#ifdef TEST_TWR_BENCH_RESPONDER
+    extern int twr_bench_responder(void);
+
+    example_pointer = twr_bench_responder;
+    test_cnt++;
+#endif
+#ifdef TEST_SPI_BENCH
+    extern int spi_bench(void);
+
+    example_pointer = spi_bench;
+    test_cnt++;
+#endif
+#ifdef TEST_SS_TWR_RESPONDER_EVT
+    extern int ss_twr_responder_evt(void);
+
+    example_pointer = ss_twr_responder_evt;
+    test_cnt++;
+#endif
+#ifdef TEST_SS_TWR_RESPONDER_SNIFF
+    extern int ss_twr_responder_sniff(void);
+
+    example_pointer = ss_twr_responder_sniff;
+    test_cnt++;
+#endif
+#ifdef TEST_SS_TWR_INITIATOR_SCHED
+    extern int ss_twr_initiator_sched(void);
+
+    example_pointer = ss_twr_initiator_sched;
+    test_cnt++;
+#endif
+#ifdef TEST_SIMPLE_RX_MULTI
+    extern int simple_rx_multi(void);
+
+    example_pointer = simple_rx_multi;
+    test_cnt++;
+#endif
+#ifdef TEST_SS_TWR_INITIATOR_AOA
+    extern int ss_twr_initiator_aoa(void);
+
+    example_pointer = ss_twr_initiator_aoa;
+    test_cnt++;
+#endif
+#ifdef TEST_SS_TWR_RESPONDER_AOA
+    extern int ss_twr_responder_aoa(void);
+
+    example_pointer = ss_twr_responder_aoa;
+    test_cnt++;
+#endif
+#ifdef TEST_SS_TWR_INITIATOR_MULTILAT
+    extern int ss_twr_initiator_multilat(void);
+
+    example_pointer = ss_twr_initiator_multilat;
+    test_cnt++;
+#endif
+#ifdef TEST_TDOA_ANCHOR
+    extern int tdoa_anchor(void);
+
+    example_pointer = tdoa_anchor;
+    test_cnt++;
+#endif
+#ifdef TEST_TX_CSMA
+    extern int tx_csma(void);
+
+    example_pointer = tx_csma;
+    test_cnt++;
+#endif
+#ifdef TEST_ARQ_TX
+    extern int arq_tx(void);
+
+    example_pointer = arq_tx;
+    test_cnt++;
+#endif
+#ifdef TEST_ARQ_RX
+    extern int arq_rx(void);
+
+    example_pointer = arq_rx;
+    test_cnt++;
+#endif
+#ifdef TEST_INDIRECT_COORD
+    extern int indirect_coord(void);
+
+    example_pointer = indirect_coord;
+    test_cnt++;
+#endif
+#ifdef TEST_INDIRECT_DEVICE
+    extern int indirect_device(void);
+
+    example_pointer = indirect_device;
+    test_cnt++;
+#endif
+#ifdef TEST_RX_DBL_BUFF_PIPE
+    extern int rx_dbl_buff_pipe(void);
+
+    example_pointer = rx_dbl_buff_pipe;
+    test_cnt++;
+#endif
+#ifdef TEST_SNIFFER
+    extern int sniffer(void);
+
+    example_pointer = sniffer;
+    test_cnt++;
 #endif
     // Check that only 1 test was enabled in test_selection.h file
     assert(test_cnt == 1);
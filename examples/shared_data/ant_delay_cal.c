@@ -0,0 +1,239 @@
+/*! ----------------------------------------------------------------------------
+ * @file    ant_delay_cal.c
+ * @brief   Antenna delay calibration solver
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ant_delay_cal.h>
+#include <shared_defines.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Device time units per second (499.2 MHz * 128), divided by 1000 to take distances in millimetres. */
+#define DTU_PER_MM_NUM 63897600ULL
+
+/* Extra fractional bits of the solver state, so that the rounding of each iteration does not stop it away from the solution,
+ * see NOTE 1 below. */
+#define SOLVE_EXTRA_BITS 4
+
+/* Division rounding to the nearest integer, also for negative numerators. */
+static int32_t div_round(int32_t num, int32_t den)
+{
+    return (num >= 0) ? ((num + den / 2) / den) : -((-num + den / 2) / den);
+}
+
+int ant_cal_init(ant_cal_t *cal, uint8_t num_nodes)
+{
+    if (num_nodes < 3 || num_nodes > ANT_CAL_MAX_NODES)
+    {
+        return -1;
+    }
+
+    memset(cal, 0, sizeof(*cal));
+    cal->num_nodes = num_nodes;
+    return 0;
+}
+
+int32_t ant_cal_dist_to_tof_q4(uint32_t dist_mm)
+{
+    return (int32_t)((((uint64_t)dist_mm << ANT_CAL_FRAC_BITS) * DTU_PER_MM_NUM + SPEED_OF_LIGHT / 2) / SPEED_OF_LIGHT);
+}
+
+int ant_cal_add_pair(ant_cal_t *cal, uint8_t i, uint8_t j, int32_t tof_q4, uint32_t dist_mm)
+{
+    int32_t err;
+
+    if (i == j || i >= cal->num_nodes || j >= cal->num_nodes)
+    {
+        return -1;
+    }
+
+    err = tof_q4 - ant_cal_dist_to_tof_q4(dist_mm);
+    cal->err_q4[i][j] = err;
+    cal->err_q4[j][i] = err;
+    cal->valid[i][j] = 1;
+    cal->valid[j][i] = 1;
+    return 0;
+}
+
+/* The system has a unique solution only if every group of nodes connected by measurements contains an odd cycle (i.e. it is not
+ * bipartite), see NOTE 2 below. */
+static int ant_cal_is_determined(const ant_cal_t *cal)
+{
+    int8_t colour[ANT_CAL_MAX_NODES];
+    uint8_t queue[ANT_CAL_MAX_NODES];
+    uint8_t head = 0, tail = 0;
+    uint8_t start, i, j;
+
+    for (i = 0; i < cal->num_nodes; i++)
+    {
+        colour[i] = -1;
+    }
+
+    for (start = 0; start < cal->num_nodes; start++)
+    {
+        int odd_cycle = 0;
+
+        if (colour[start] >= 0)
+        {
+            continue;
+        }
+
+        colour[start] = 0;
+        queue[tail++] = start;
+        while (head < tail)
+        {
+            i = queue[head++];
+            for (j = 0; j < cal->num_nodes; j++)
+            {
+                if (!cal->valid[i][j])
+                {
+                    continue;
+                }
+                if (colour[j] < 0)
+                {
+                    colour[j] = !colour[i];
+                    queue[tail++] = j;
+                }
+                else if (colour[j] == colour[i])
+                {
+                    odd_cycle = 1;
+                }
+            }
+        }
+
+        if (!odd_cycle)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int ant_cal_solve(const ant_cal_t *cal, int32_t *delay_err_q4, int32_t *residual_q4)
+{
+    int32_t est[ANT_CAL_MAX_NODES];
+    uint8_t i, j;
+    int iter;
+
+    if (!ant_cal_is_determined(cal))
+    {
+        return -1;
+    }
+
+    for (i = 0; i < cal->num_nodes; i++)
+    {
+        est[i] = 0;
+    }
+
+    for (iter = 1; iter <= ANT_CAL_MAX_ITER; iter++)
+    {
+        int32_t max_step = 0;
+
+        for (i = 0; i < cal->num_nodes; i++)
+        {
+            int32_t sum = 0;
+            int32_t cnt = 0;
+            int32_t next, step;
+
+            for (j = 0; j < cal->num_nodes; j++)
+            {
+                if (cal->valid[i][j])
+                {
+                    sum += (cal->err_q4[i][j] << SOLVE_EXTRA_BITS) - est[j];
+                    cnt++;
+                }
+            }
+
+            next = div_round(sum, cnt);
+            step = next - est[i];
+            if (step < 0)
+            {
+                step = -step;
+            }
+            if (step > max_step)
+            {
+                max_step = step;
+            }
+            est[i] = next;
+        }
+
+        if (max_step == 0)
+        {
+            break;
+        }
+    }
+
+    if (iter > ANT_CAL_MAX_ITER)
+    {
+        iter = ANT_CAL_MAX_ITER;
+    }
+
+    for (i = 0; i < cal->num_nodes; i++)
+    {
+        delay_err_q4[i] = div_round(est[i], 1 << SOLVE_EXTRA_BITS);
+    }
+
+    if (residual_q4 != NULL)
+    {
+        *residual_q4 = 0;
+        for (i = 0; i < cal->num_nodes; i++)
+        {
+            for (j = i + 1; j < cal->num_nodes; j++)
+            {
+                int32_t r;
+
+                if (!cal->valid[i][j])
+                {
+                    continue;
+                }
+                r = cal->err_q4[i][j] - delay_err_q4[i] - delay_err_q4[j];
+                if (r < 0)
+                {
+                    r = -r;
+                }
+                if (r > *residual_q4)
+                {
+                    *residual_q4 = r;
+                }
+            }
+        }
+    }
+
+    return iter;
+}
+
+uint16_t ant_cal_apply(uint16_t ant_dly, int32_t delay_err_q4)
+{
+    int32_t dly = (int32_t)ant_dly + div_round(delay_err_q4, 1 << ANT_CAL_FRAC_BITS);
+
+    if (dly < 0)
+    {
+        dly = 0;
+    }
+    else if (dly > UINT16_MAX)
+    {
+        dly = UINT16_MAX;
+    }
+    return (uint16_t)dly;
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. With TX and RX antenna delays programmed to the same value on each node, a DS-TWR exchange between nodes i and j measures
+ *        tof_meas = tof_true + (e_i + e_j)
+ *    where e_k is the difference between the actual and the programmed antenna delay of node k (the TX and RX halves of both nodes are
+ *    averaged by the two-way exchange). Every measured pair therefore gives one equation e_i + e_j = tof_meas - tof_true. The normal equations
+ *    of the least-squares problem are symmetric positive definite once the system is determined, so Gauss-Seidel iterations of
+ *        e_i = mean over measured j of (err_ij - e_j)
+ *    converge. Each iteration rounds its result, and the iterations stop when they no longer change: on sparse measurement graphs, which converge
+ *    slowly, this can happen several Q4 units away from the least-squares solution, so the iterations use SOLVE_EXTRA_BITS more fractional bits
+ *    than the Q4 device time units (~1 ps resolution) of the inputs and outputs. This keeps all sums inside 32 bits for pair errors up to about
+ *    1 us. tools/ant_delay_cal_sim compares the solver with the floating point least-squares solution on a host.
+ * 2. With only two nodes, or with measurements forming an even cycle only, only sums of errors are observable and the individual delays cannot
+ *    be separated. Three nodes measuring each other is the minimum configuration. Groups of nodes without a measurement between them are
+ *    solved independently, each needs its own odd cycle.
+ ****************************************************************************************************************************************************/
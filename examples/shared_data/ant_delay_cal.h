@@ -0,0 +1,101 @@
+/*! ----------------------------------------------------------------------------
+ * @file    ant_delay_cal.h
+ * @brief   Antenna delay calibration solver
+ *
+ *          Estimates the antenna delay error of every node in a group of three or more nodes placed at known distances from
+ *          each other, given the time-of-flight measured by DS-TWR between each pair. The solver uses integer arithmetic only and
+ *          does not depend on the DW IC driver, so it can be built and exercised on a host as well as on the target.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _ANT_DELAY_CAL_
+#define _ANT_DELAY_CAL_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define ANT_CAL_MAX_NODES 8   /* Maximum number of nodes taking part in one calibration */
+#define ANT_CAL_FRAC_BITS 4   /* Fractional bits of all time values handled by the solver (Q4 device time units) */
+#define ANT_CAL_MAX_ITER  256 /* Upper bound on the number of solver iterations */
+
+    typedef struct
+    {
+        uint8_t num_nodes;
+        uint8_t valid[ANT_CAL_MAX_NODES][ANT_CAL_MAX_NODES];  /* Non-zero when a pair has been measured */
+        int32_t err_q4[ANT_CAL_MAX_NODES][ANT_CAL_MAX_NODES]; /* Measured minus true ToF, Q4 device time units */
+    } ant_cal_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn ant_cal_init()
+     *
+     * @brief Reset the calibration state for the given number of nodes.
+     *
+     * @param cal - calibration state
+     * @param num_nodes - number of nodes, between 3 and ANT_CAL_MAX_NODES
+     *
+     * @return 0 on success, -1 if num_nodes is out of range
+     */
+    int ant_cal_init(ant_cal_t *cal, uint8_t num_nodes);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn ant_cal_dist_to_tof_q4()
+     *
+     * @brief Convert a distance in millimetres into the expected time-of-flight in Q4 device time units.
+     *
+     * @param dist_mm - distance in millimetres
+     *
+     * @return time-of-flight in Q4 device time units
+     */
+    int32_t ant_cal_dist_to_tof_q4(uint32_t dist_mm);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn ant_cal_add_pair()
+     *
+     * @brief Record the averaged time-of-flight measured between nodes i and j which are dist_mm apart.
+     *
+     * @param cal - calibration state
+     * @param i, j - node indexes (order is not relevant)
+     * @param tof_q4 - measured time-of-flight, Q4 device time units
+     * @param dist_mm - true distance between the two nodes in millimetres
+     *
+     * @return 0 on success, -1 on invalid indexes
+     */
+    int ant_cal_add_pair(ant_cal_t *cal, uint8_t i, uint8_t j, int32_t tof_q4, uint32_t dist_mm);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn ant_cal_solve()
+     *
+     * @brief Estimate the antenna delay error of every node. The measured ToF error of a pair is modelled as the sum of the two
+     *        node errors, and the least-squares solution of this system is found with Gauss-Seidel iterations on the normal
+     *        equations. See NOTE 1 in ant_delay_cal.c.
+     *
+     * @param cal - calibration state with at least as many measured pairs as nodes
+     * @param delay_err_q4 - output array of num_nodes entries receiving the per-node delay error, Q4 device time units
+     * @param residual_q4 - if not NULL, receives the largest absolute pair residual, Q4 device time units
+     *
+     * @return number of iterations used, or -1 if the system is under-determined
+     */
+    int ant_cal_solve(const ant_cal_t *cal, int32_t *delay_err_q4, int32_t *residual_q4);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn ant_cal_apply()
+     *
+     * @brief Correct an antenna delay value with the error returned by ant_cal_solve().
+     *
+     * @param ant_dly - antenna delay currently programmed, device time units
+     * @param delay_err_q4 - estimated error of this node, Q4 device time units
+     *
+     * @return corrected antenna delay, device time units
+     */
+    uint16_t ant_cal_apply(uint16_t ant_dly, int32_t delay_err_q4);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
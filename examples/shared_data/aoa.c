@@ -0,0 +1,237 @@
+/*! ----------------------------------------------------------------------------
+ * @file    aoa.c
+ * @brief   Angle of arrival from the phase difference of arrival (PDoA), and position relative to the anchor
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <aoa.h>
+#include <stddef.h>
+
+#define PI_Q11          6434  /* pi in radians Q11, the format of dwt_readpdoa() */
+#define TWO_PI_Q11      12868
+#define AOA_MARGIN_Q11  (PI_Q11 / 8) /* Noise allowed beyond the largest physical PDoA when unwrapping */
+#define AOA_OUTLIER_Q11 (PI_Q11 / 2) /* Distance from the average of an outlier */
+
+/* Carrier wavelengths of channels 5 (6489.6 MHz) and 9 (7987.2 MHz), in um */
+#define LAMBDA_CH5_UM 46196
+#define LAMBDA_CH9_UM 37534
+
+/* atan(i / 64) for i = 0 to 64, in 0.01 degree */
+static const int16_t atan_lut[65] = {
+    0, 90, 179, 268, 358, 447, 536, 624, 713, 800, 888,
+    975, 1062, 1148, 1234, 1319, 1404, 1488, 1571, 1653, 1735, 1817,
+    1897, 1977, 2056, 2134, 2211, 2287, 2363, 2438, 2511, 2584, 2657,
+    2728, 2798, 2867, 2936, 3003, 3070, 3136, 3201, 3264, 3327, 3390,
+    3451, 3511, 3571, 3629, 3687, 3744, 3800, 3855, 3909, 3963, 4016,
+    4067, 4119, 4169, 4218, 4267, 4315, 4363, 4409, 4455, 4500,
+};
+
+static int32_t wrap_q11(int32_t phi)
+{
+    while (phi > PI_Q11)
+    {
+        phi -= TWO_PI_Q11;
+    }
+    while (phi <= -PI_Q11)
+    {
+        phi += TWO_PI_Q11;
+    }
+    return phi;
+}
+
+static int32_t abs32(int32_t v)
+{
+    return (v < 0) ? -v : v;
+}
+
+static uint32_t isqrt32(uint32_t v)
+{
+    uint32_t res = 0, bit = 1UL << 30;
+
+    while (bit > v)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (v >= res + bit)
+        {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+/* atan(n / d) for 0 <= n <= d, d > 0 */
+static int32_t atan_octant(uint32_t n, uint32_t d)
+{
+    uint32_t pos = (uint32_t)(((uint64_t)n << 22) / d); /* 64 * n / d, Q16 */
+    uint32_t i = pos >> 16, f = pos & 0xFFFF;
+
+    if (i >= 64)
+    {
+        return atan_lut[64];
+    }
+    return atan_lut[i] + (((atan_lut[i + 1] - atan_lut[i]) * (int32_t)f) >> 16);
+}
+
+int16_t aoa_atan2_cdeg(int32_t y, int32_t x)
+{
+    uint32_t ax = (uint32_t)abs32(x), ay = (uint32_t)abs32(y);
+    int32_t a;
+
+    if (ax == 0 && ay == 0)
+    {
+        return 0;
+    }
+    a = (ax >= ay) ? atan_octant(ay, ax) : 9000 - atan_octant(ax, ay);
+    if (x < 0)
+    {
+        a = 18000 - a;
+    }
+    return (int16_t)((y < 0) ? -a : a);
+}
+
+void aoa_init(aoa_t *aoa, const aoa_config_t *cfg)
+{
+    int32_t max;
+
+    aoa->cfg = *cfg;
+    if (aoa->cfg.window == 0 || aoa->cfg.window > AOA_WINDOW_MAX)
+    {
+        aoa->cfg.window = AOA_WINDOW_MAX;
+    }
+    aoa->lambda_um = (cfg->channel == 9) ? LAMBDA_CH9_UM : LAMBDA_CH5_UM;
+    max = (int32_t)((uint64_t)TWO_PI_Q11 * cfg->spacing_um / aoa->lambda_um);
+    aoa->max_q11 = (int16_t)((max > TWO_PI_Q11) ? TWO_PI_Q11 : max);
+    aoa->sum = 0;
+    aoa->count = 0;
+    aoa->next = 0;
+    aoa->outliers = 0;
+    aoa->added = 0;
+    aoa->unwrapped = 0;
+    aoa->rejected = 0;
+}
+
+int aoa_add(aoa_t *aoa, int16_t pdoa_q11, int sts_good, int16_t sts_qual)
+{
+    int32_t phi, mean, cand, best;
+    int k;
+
+    if (!sts_good || sts_qual < aoa->cfg.min_qual)
+    {
+        aoa->rejected++;
+        return AOA_LOW_QUAL;
+    }
+    phi = wrap_q11((int32_t)pdoa_q11 - aoa->cfg.offset_q11);
+
+    if (aoa->count > 0)
+    {
+        /* Unwrap against the average: the closest of the possible phases. See NOTE 2 below. */
+        mean = aoa->sum / aoa->count;
+        best = phi;
+        for (k = -1; k <= 1; k += 2)
+        {
+            cand = phi + k * TWO_PI_Q11;
+            if (abs32(cand) <= aoa->max_q11 + AOA_MARGIN_Q11 && abs32(cand - mean) < abs32(best - mean))
+            {
+                best = cand;
+            }
+        }
+        if (best != phi)
+        {
+            if (sts_qual < aoa->cfg.unwrap_qual)
+            {
+                aoa->rejected++;
+                return AOA_AMBIGUOUS;
+            }
+            aoa->unwrapped++;
+            phi = best;
+        }
+
+        if (abs32(phi - mean) > AOA_OUTLIER_Q11)
+        {
+            /* A single outlier is dropped, a series of them means the tag has moved: start again from this PDoA. */
+            if (++aoa->outliers < ((aoa->cfg.window > 4) ? aoa->cfg.window / 2 : 2))
+            {
+                aoa->rejected++;
+                return AOA_OUTLIER;
+            }
+            aoa->sum = 0;
+            aoa->count = 0;
+            aoa->next = 0;
+        }
+    }
+    aoa->outliers = 0;
+
+    if (aoa->count == aoa->cfg.window)
+    {
+        aoa->sum -= aoa->pdoa[aoa->next];
+    }
+    else
+    {
+        aoa->count++;
+    }
+    aoa->pdoa[aoa->next] = (int16_t)phi;
+    aoa->sum += phi;
+    aoa->next = (aoa->next + 1) % aoa->cfg.window;
+    aoa->added++;
+    return AOA_OK;
+}
+
+int aoa_get(const aoa_t *aoa, aoa_result_t *res)
+{
+    int32_t mean;
+    int64_t s;
+
+    if (aoa->count == 0)
+    {
+        return -1;
+    }
+    mean = aoa->sum / aoa->count;
+
+    /* sin(A) = PDoA * L / (2 * pi * d), in Q15 */
+    s = (int64_t)mean * aoa->lambda_um * 16384 / ((int64_t)PI_Q11 * aoa->cfg.spacing_um);
+    if (s > 32767)
+    {
+        s = 32767;
+    }
+    if (s < -32767)
+    {
+        s = -32767;
+    }
+    res->sin_q15 = (int16_t)s;
+    res->cos_q15 = (int16_t)isqrt32((uint32_t)(32767 * 32767 - s * s));
+    res->angle_cdeg = aoa_atan2_cdeg(res->sin_q15, res->cos_q15);
+    res->pdoa_q11 = (int16_t)mean;
+    res->count = aoa->count;
+    return 0;
+}
+
+void aoa_position(const aoa_result_t *res, int32_t range_mm, int32_t *x_mm, int32_t *y_mm)
+{
+    *x_mm = (int32_t)(((int64_t)range_mm * res->cos_q15) >> 15);
+    *y_mm = (int32_t)(((int64_t)range_mm * res->sin_q15) >> 15);
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The spacing is the distance between the phase centres of the two antennas, close to half the wavelength of the channel on PDoA boards,
+ *    so that the PDoA covers +/- pi over +/- 90 degrees without ambiguity. The PDoA also includes a phase offset of the board (RF paths,
+ *    cables), measured with the tag on the boresight (see NOTE 3 of simple_rx_pdoa.c), which is subtracted from each PDoA. The sign of the
+ *    angle follows the sign of the PDoA, which depends on which antenna is connected to which RF port.
+ * 2. When the spacing is more than half the wavelength, or with noise near +/- 90 degrees, a PDoA may have wrapped around +/- pi. Of the
+ *    phases PDoA and PDoA +/- 2 pi that are physically possible, the one closest to the current average is used, but only if the STS quality
+ *    of the frame is high enough for the phase to be trusted, as a poor first path gives phases anywhere. A PDoA more than pi/2 away from the
+ *    average is dropped, unless half a window of them follow each other, which restarts the average from them.
+ * 3. The position is in the plane containing the boresight and the antenna baseline, the TWR range being the distance to the anchor. If the
+ *    tag is much higher or lower than the anchor, the range should first be projected on this plane.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,140 @@
+/*! ----------------------------------------------------------------------------
+ * @file    aoa.h
+ * @brief   Angle of arrival from the phase difference of arrival (PDoA), and position relative to the anchor
+ *
+ *          A PDoA device (DW3120, PDoA mode 3) measures the phase difference of the STS between its two antennas, read with dwt_readpdoa().
+ *          With the carrier wavelength L of the channel and the distance d between the antennas, the angle of arrival A from the boresight
+ *          is given by sin(A) = PDoA * L / (2 * pi * d). The calibration offset of the board is removed from each PDoA, phases which may have
+ *          wrapped are unwrapped against the current average, using the STS quality to reject ambiguous ones, and the angle is computed from
+ *          the average of a window of PDoAs. With a TWR range to the tag, this gives the position of the tag relative to the anchor. All
+ *          computations are done in fixed point, the angle with an arctangent lookup table. No DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _AOA_
+#define _AOA_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define AOA_WINDOW_MAX 16 /* Largest averaging window */
+
+/* Results of aoa_add() */
+#define AOA_OK        0  /* PDoA added */
+#define AOA_LOW_QUAL  -1 /* STS quality too low */
+#define AOA_AMBIGUOUS -2 /* Wrapped phase with an STS quality too low to unwrap it */
+#define AOA_OUTLIER   -3 /* Too far from the average, see NOTE 2 in aoa.c */
+
+/* STS quality index of pct percent of the ideal one, which is the STS length in symbols, (1 << (stsLength + 2)) * 8. dwt_readstsquality()
+ * reports a good STS from 60 %. */
+#define AOA_STS_QUAL(pct, sts_len) ((int16_t)((int32_t)(sts_len) * (pct) / 100))
+
+    typedef struct
+    {
+        uint8_t channel;     /* 5 or 9 */
+        uint32_t spacing_um; /* Distance between the antenna phase centres, see NOTE 1 in aoa.c */
+        int16_t offset_q11;  /* PDoA measured with the tag on the boresight, radians Q11 as dwt_readpdoa() */
+        uint8_t window;      /* Number of PDoAs averaged, up to AOA_WINDOW_MAX */
+        int16_t min_qual;    /* STS quality index of a PDoA to be used, as returned by dwt_readstsquality() */
+        int16_t unwrap_qual; /* STS quality index of a PDoA to be unwrapped */
+    } aoa_config_t;
+
+    typedef struct
+    {
+        aoa_config_t cfg;
+        uint32_t lambda_um;  /* Carrier wavelength */
+        int16_t max_q11;     /* Largest physical PDoA, at +/- 90 degrees */
+        int16_t pdoa[AOA_WINDOW_MAX]; /* Unwrapped and corrected PDoAs, radians Q11 */
+        int32_t sum;
+        uint8_t count;
+        uint8_t next;
+        uint8_t outliers;    /* Consecutive outliers */
+
+        /* Counters */
+        uint32_t added;
+        uint32_t unwrapped;
+        uint32_t rejected;
+    } aoa_t;
+
+    typedef struct
+    {
+        int16_t angle_cdeg; /* Angle from the boresight, 0.01 degree, with the sign of the PDoA, see NOTE 1 in aoa.c */
+        int16_t sin_q15;
+        int16_t cos_q15;
+        int16_t pdoa_q11;   /* Average PDoA, corrected */
+        uint8_t count;      /* PDoAs averaged */
+    } aoa_result_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn aoa_init()
+     *
+     * @brief Initialise the estimation of an angle.
+     *
+     * @param aoa - estimation state
+     * @param cfg - configuration, copied
+     *
+     * @return none
+     */
+    void aoa_init(aoa_t *aoa, const aoa_config_t *cfg);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn aoa_add()
+     *
+     * @brief Add the PDoA of a received frame.
+     *
+     * @param aoa - estimation state
+     * @param pdoa_q11 - PDoA read with dwt_readpdoa()
+     * @param sts_good - return value of dwt_readstsquality() is not negative
+     * @param sts_qual - STS quality index from dwt_readstsquality()
+     *
+     * @return AOA_OK or the reason why the PDoA was not used
+     */
+    int aoa_add(aoa_t *aoa, int16_t pdoa_q11, int sts_good, int16_t sts_qual);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn aoa_get()
+     *
+     * @brief Angle of the average PDoA of the window.
+     *
+     * @param aoa - estimation state
+     * @param res - receives the result
+     *
+     * @return 0, or -1 if no PDoA has been added yet
+     */
+    int aoa_get(const aoa_t *aoa, aoa_result_t *res);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn aoa_atan2_cdeg()
+     *
+     * @brief Fixed point arctangent of y / x, from a lookup table with linear interpolation.
+     *
+     * @param y, x - coordinates, any scale
+     *
+     * @return angle in 0.01 degree, -18000 to 18000
+     */
+    int16_t aoa_atan2_cdeg(int32_t y, int32_t x);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn aoa_position()
+     *
+     * @brief Position of the tag relative to the anchor in the plane of the antennas, from an angle and a range. See NOTE 3 in aoa.c.
+     *
+     * @param res - angle, from aoa_get()
+     * @param range_mm - range to the tag
+     * @param x_mm - receives the distance along the boresight
+     * @param y_mm - receives the distance along the antenna baseline
+     *
+     * @return none
+     */
+    void aoa_position(const aoa_result_t *res, int32_t range_mm, int32_t *x_mm, int32_t *y_mm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+/*! ----------------------------------------------------------------------------
+ * @file    arq.h
+ * @brief   Selective repeat ARQ with block acknowledgements, for bulk data transfers over 1023-byte frames
+ *
+ *          The sender cuts a blob (e.g. a firmware or configuration image) into 1023-byte frames numbered from 0 and sends them back to
+ *          back, a window of up to ARQ_WINDOW frames at a time, the last frame of each window requesting a block acknowledgement. The
+ *          receiver answers with the first frame it misses and a bitmap of the frames it received after it; the sender slides its window
+ *          and sends the missing frames again with the next window. The receiver hands each frame over at its offset in the blob as it
+ *          arrives, so neither side buffers the window. The engine only talks to the radio through arq_radio_t, so it runs on the DW3000
+ *          (arq_dw_radio) as well as against a simulated link on a host (tools/arq_sim). No DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _ARQ_
+#define _ARQ_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define ARQ_FRAME_LEN_MAX 1023 /* Extended frames, FRAME_LEN_MAX_EX, FCS included */
+#define ARQ_FCS_LEN       2
+#define ARQ_MAC_HDR_LEN   9 /* 802.15.4 data frame, 16-bit addresses and PAN ID compression */
+#define ARQ_HDR_LEN       (ARQ_MAC_HDR_LEN + 5)
+#define ARQ_PAYLOAD_MAX   (ARQ_FRAME_LEN_MAX - ARQ_HDR_LEN - ARQ_FCS_LEN) /* 1007 bytes of the blob per frame */
+#define ARQ_BACK_LEN      (ARQ_HDR_LEN + 4 + ARQ_FCS_LEN)
+
+#define ARQ_WINDOW        16   /* Frames sent before an acknowledgement is requested, up to 32 (bitmap) */
+#define ARQ_IFS_US        300  /* Gap between the end of a frame and the next one, see NOTE 2 in arq.c */
+#define ARQ_ACK_TIMEOUT_UUS 1000 /* Wait for the block acknowledgement after the end of the frame requesting it */
+#define ARQ_MAX_RETRIES   20   /* Consecutive requests without acknowledgement before the transfer is abandoned */
+#define ARQ_RX_TIMEOUT_UUS 20000 /* Receiver timeout, for the idle time checks of arq_receive() */
+#define ARQ_LINGER_MS     300  /* Time the receiver keeps acknowledging a complete transfer, in case its last acknowledgement was lost */
+
+/* Return values */
+#define ARQ_OK      0
+#define ARQ_TIMEOUT (-1) /* RX timeout */
+#define ARQ_ERROR   (-2) /* RX error, or frame too long */
+#define ARQ_LOST    (-3) /* Peer not answering, transfer abandoned */
+
+    /* Radio used by the engine, all frame lengths including the FCS */
+    typedef struct
+    {
+        /* Write a frame to send into the TX buffer */
+        void (*load)(const uint8_t *frame, uint16_t len);
+        /* Send the frame loaded and wait for the end of its transmission. If rx_timeout_uus is not 0 the receiver is enabled after the
+         * frame, for the next receive(). Returns ARQ_OK or ARQ_ERROR. */
+        int (*send)(uint32_t rx_timeout_uus);
+        /* Receive a frame, enabling the receiver first unless send() did, and read its first size bytes into buf. timeout_uus 0 waits
+         * forever. Returns the frame length, ARQ_TIMEOUT or ARQ_ERROR. */
+        int (*receive)(uint8_t *buf, uint16_t size, uint32_t timeout_uus);
+        /* Read more of the frame received last, from offset */
+        void (*read)(uint8_t *buf, uint16_t offset, uint16_t len);
+        /* Free running microsecond clock */
+        uint32_t (*time_us)(void);
+    } arq_radio_t;
+
+    /* DW3000 radio, see arq_dw.c. The DW IC must be configured for extended frames (DWT_PHRMODE_EXT). */
+    extern const arq_radio_t arq_dw_radio;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief Source of the blob sent: copy len bytes from offset into buf.
+     */
+    typedef void (*arq_read_cb_t)(void *ctx, uint32_t offset, uint8_t *buf, uint16_t len);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief Destination of the blob received: len bytes at offset. Frames arrive out of order when some are sent again, each only once.
+     */
+    typedef void (*arq_write_cb_t)(void *ctx, uint32_t offset, const uint8_t *buf, uint16_t len);
+
+    /* Statistics of the last transfer */
+    typedef struct
+    {
+        uint32_t bytes;     /* Blob size */
+        uint32_t frames;    /* Data frames sent or received, repeats included */
+        uint32_t repeats;   /* Data frames sent again, or received twice */
+        uint32_t requests;  /* Acknowledgement requests sent, or acknowledgements sent */
+        uint32_t polls;     /* Acknowledgement requests without data, after a timeout */
+        uint32_t timeouts;  /* Acknowledgement requests not answered */
+        uint32_t time_us;   /* Duration of the transfer */
+    } arq_stats_t;
+
+    typedef struct
+    {
+        const arq_radio_t *radio;
+        uint16_t pan_id;
+        uint16_t addr;
+        uint16_t peer;
+        uint8_t xfer; /* Transfer number, in each frame so that the receiver tells transfers apart */
+        uint8_t frame[ARQ_FRAME_LEN_MAX];
+        arq_stats_t stats;
+    } arq_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn arq_init()
+     *
+     * @brief Initialise one end of a link.
+     *
+     * @param a - link
+     * @param radio - radio to use
+     * @param pan_id - PAN ID of the frames
+     * @param addr - own short address
+     * @param peer - short address of the other end
+     *
+     * @return none
+     */
+    void arq_init(arq_t *a, const arq_radio_t *radio, uint16_t pan_id, uint16_t addr, uint16_t peer);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn arq_send()
+     *
+     * @brief Send a blob to the peer, running arq_receive(), and return when all of it is acknowledged.
+     *
+     * @param a - link
+     * @param len - blob size, up to 65535 frames
+     * @param read - source of the blob
+     * @param ctx - context given to read
+     *
+     * @return ARQ_OK, or ARQ_LOST if the peer stopped answering
+     */
+    int arq_send(arq_t *a, uint32_t len, arq_read_cb_t read, void *ctx);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn arq_receive()
+     *
+     * @brief Receive a blob from the peer, running arq_send(), and return when all of it is received.
+     *
+     * @param a - link
+     * @param write - destination of the blob
+     * @param ctx - context given to write
+     * @param idle_ms - time without frame from the peer, once the transfer started, after which it is abandoned, 0 never to abandon it
+     *
+     * @return blob size, or ARQ_LOST if the transfer stopped
+     */
+    int32_t arq_receive(arq_t *a, arq_write_cb_t write, void *ctx, uint32_t idle_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
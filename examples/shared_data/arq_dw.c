@@ -0,0 +1,91 @@
+/*! ----------------------------------------------------------------------------
+ * @file    arq_dw.c
+ * @brief   DW3000 radio of the ARQ engine, see arq.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arq.h>
+#include <deca_device_api.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+
+static uint8_t rx_armed;
+
+static void dw_load(const uint8_t *frame, uint16_t len)
+{
+    dwt_writetxdata(len - FCS_LEN, (uint8_t *)frame, 0); /* Zero offset in TX buffer. */
+    dwt_writetxfctrl(len, 0, 0);                         /* Zero offset in TX buffer, no ranging. */
+}
+
+static int dw_send(uint32_t rx_timeout_uus)
+{
+    uint8_t mode = DWT_START_TX_IMMEDIATE;
+
+    if (rx_timeout_uus)
+    {
+        dwt_setrxaftertxdelay(0);
+        dwt_setrxtimeout(rx_timeout_uus);
+        mode |= DWT_RESPONSE_EXPECTED;
+    }
+
+    rx_armed = 0;
+    if (dwt_starttx(mode) != DWT_SUCCESS)
+    {
+        return ARQ_ERROR;
+    }
+    rx_armed = (rx_timeout_uus != 0);
+
+    waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+    dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+    return ARQ_OK;
+}
+
+static int dw_receive(uint8_t *buf, uint16_t size, uint32_t timeout_uus)
+{
+    uint32_t status_reg;
+    uint16_t frame_len;
+
+    if (!rx_armed)
+    {
+        dwt_setrxtimeout(timeout_uus);
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+    }
+    rx_armed = 0;
+
+    waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+    if (!(status_reg & DWT_INT_RXFCG_BIT_MASK))
+    {
+        dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+        return (status_reg & SYS_STATUS_ALL_RX_TO) ? ARQ_TIMEOUT : ARQ_ERROR;
+    }
+    dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+
+    /* The length of an extended frame has 10 bits, see NOTE 1 below. */
+    frame_len = dwt_getframelength() & RXFL_MASK_1023;
+    dwt_readrxdata(buf, (frame_len < size) ? frame_len : size, 0);
+    return frame_len;
+}
+
+static void dw_read(uint8_t *buf, uint16_t offset, uint16_t len)
+{
+    dwt_readrxdata(buf, len, offset);
+}
+
+const arq_radio_t arq_dw_radio = {
+    .load = dw_load,
+    .send = dw_send,
+    .receive = dw_receive,
+    .read = dw_read,
+    .time_us = port_get_time_us,
+};
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The frames are up to 1023 bytes (FRAME_LEN_MAX_EX), which needs the extended PHR mode (DWT_PHRMODE_EXT) on both ends: the standard PHR
+ *    only codes 127 bytes. The length of the received frame then has 10 bits, RXFL_MASK_1023, rather than 7.
+ * 2. The RX buffer of the DW IC is kept after the transmission of a frame, so the receiver sends the block acknowledgement first and reads the
+ *    data of the frame from the RX buffer afterwards (dw_read()), as long as the receiver is not enabled again in between.
+ ****************************************************************************************************************************************************/
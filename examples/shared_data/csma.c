@@ -0,0 +1,203 @@
+/*! ----------------------------------------------------------------------------
+ * @file    csma.c
+ * @brief   Unslotted CSMA-CA channel access over the preamble detection CCA of the DW IC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <csma.h>
+#include <stddef.h>
+
+#define CSMA_STATE_IDLE    0 /* Queue empty */
+#define CSMA_STATE_BACKOFF 1 /* Waiting for wake_us */
+#define CSMA_STATE_TX      2 /* CCA or transmission in progress */
+
+static const csma_params_t csma_default_params = { CSMA_MIN_BE, CSMA_MAX_BE, CSMA_MAX_BACKOFFS, CSMA_UNIT_BACKOFF_US };
+
+/* xorshift32, a few cycles per number. See NOTE 2 below. */
+static uint32_t csma_rand(csma_t *c)
+{
+    uint32_t x = c->rand;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    c->rand = x;
+    return x;
+}
+
+static void csma_backoff(csma_t *c, uint32_t now_us)
+{
+    uint32_t units = (csma_rand(c) >> 16) & ((1UL << c->be) - 1);
+
+    c->wake_us = now_us + units * c->params.unit_us;
+    c->state = CSMA_STATE_BACKOFF;
+}
+
+/* Remove the head of the queue and report its outcome */
+static void csma_complete(csma_t *c, int result)
+{
+    csma_frame_t f = c->queue[c->head];
+    uint32_t delay_us = c->cca_us - c->start_us;
+
+    c->stats.backoffs[(c->nb <= CSMA_MAX_BACKOFFS) ? c->nb : CSMA_MAX_BACKOFFS + 1]++;
+    if (result == CSMA_TX_DONE)
+    {
+        c->stats.sent++;
+        c->stats.delay_sum_us += delay_us;
+        if (delay_us > c->stats.delay_max_us)
+        {
+            c->stats.delay_max_us = delay_us;
+        }
+    }
+    else if (result == CSMA_TX_FAIL)
+    {
+        c->stats.failed++;
+    }
+    else
+    {
+        c->stats.errors++;
+    }
+
+    /* Dequeue before the callback, which may queue the next frame */
+    c->head = (c->head + 1) & (CSMA_QUEUE_LEN - 1);
+    c->count--;
+    c->state = CSMA_STATE_IDLE;
+    if (f.done)
+    {
+        f.done(f.ctx, result, c->nb, delay_us);
+    }
+}
+
+void csma_init(csma_t *c, const csma_radio_t *radio, const csma_params_t *params, uint32_t seed)
+{
+    unsigned int i;
+
+    c->radio = radio;
+    c->params = params ? *params : csma_default_params;
+    c->rand = seed ? seed : 0x2545F491UL; /* xorshift must not start from 0 */
+    c->head = 0;
+    c->count = 0;
+    c->state = CSMA_STATE_IDLE;
+    c->stats.queued = 0;
+    c->stats.sent = 0;
+    c->stats.failed = 0;
+    c->stats.errors = 0;
+    c->stats.cca_busy = 0;
+    c->stats.delay_max_us = 0;
+    c->stats.delay_sum_us = 0;
+    for (i = 0; i < sizeof(c->stats.backoffs) / sizeof(c->stats.backoffs[0]); i++)
+    {
+        c->stats.backoffs[i] = 0;
+    }
+}
+
+int csma_queue(csma_t *c, const uint8_t *frame, uint16_t len, csma_done_cb_t done, void *ctx)
+{
+    csma_frame_t *f;
+
+    if (c->count == CSMA_QUEUE_LEN)
+    {
+        return CSMA_ERR_FULL;
+    }
+    f = &c->queue[(c->head + c->count) & (CSMA_QUEUE_LEN - 1)];
+    f->frame = frame;
+    f->len = len;
+    f->done = done;
+    f->ctx = ctx;
+    c->count++;
+    c->stats.queued++;
+    return CSMA_OK;
+}
+
+uint32_t csma_process(csma_t *c)
+{
+    uint32_t now_us = c->radio->time_us();
+    int32_t wait_us;
+    int result;
+
+    /* Loop as long as an action is due now: a frame completed immediately starts the backoff of the next one */
+    while (1)
+    {
+        switch (c->state)
+        {
+            case CSMA_STATE_IDLE:
+                if (c->count == 0)
+                {
+                    return CSMA_IDLE;
+                }
+                c->nb = 0;
+                c->be = c->params.min_be;
+                c->start_us = now_us;
+                csma_backoff(c, now_us);
+                break;
+
+            case CSMA_STATE_BACKOFF:
+                wait_us = (int32_t)(c->wake_us - now_us);
+                if (wait_us > 0)
+                {
+                    return (uint32_t)wait_us;
+                }
+                c->cca_us = now_us;
+                if (c->radio->cca_tx(c->queue[c->head].frame, c->queue[c->head].len) != CSMA_TX_PENDING)
+                {
+                    csma_complete(c, CSMA_TX_ERROR);
+                    break;
+                }
+                c->state = CSMA_STATE_TX;
+                return 0;
+
+            case CSMA_STATE_TX:
+                result = c->radio->tx_status();
+                if (result == CSMA_TX_PENDING)
+                {
+                    return 0;
+                }
+                now_us = c->radio->time_us();
+                switch (result)
+                {
+                    case CSMA_TX_DONE:
+                        csma_complete(c, CSMA_TX_DONE);
+                        break;
+
+                    default:
+                        /* CCA failure. See NOTE 3 below. */
+                        c->stats.cca_busy++;
+                        if (c->nb++ >= c->params.max_backoffs)
+                        {
+                            csma_complete(c, CSMA_TX_FAIL);
+                            break;
+                        }
+                        if (c->be < c->params.max_be)
+                        {
+                            c->be++;
+                        }
+                        csma_backoff(c, now_us);
+                        break;
+                }
+                break;
+
+            default:
+                c->state = CSMA_STATE_IDLE;
+                break;
+        }
+    }
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. IEEE 802.15.4 defaults to macMinBE 3, macMaxBE 5 and macMaxCSMABackoffs 4: a frame waits 0 to 7 backoff periods before its first CCA,
+ *    0 to 15 after the first failure, and 0 to 31 after the next ones, and is abandoned after 5 CCA failures. The backoff period of the
+ *    standard, aUnitBackoffPeriod, is the CCA time plus the RX to TX turnaround. The CCA of the DW IC is the preamble detection timeout, 3
+ *    PACs (24 symbols, about 25 us with PAC 8), the turnaround is a few us, hence 40 us by default. With longer PACs or preambles the backoff
+ *    period should grow accordingly, see tools/csma_sim for the throughput obtained.
+ * 2. The backoffs of the devices sharing the channel must not be correlated, so each device seeds the generator differently. xorshift32 has a
+ *    period of 2^32 - 1 and its upper bits are used; its statistical weaknesses do not matter for drawing backoffs.
+ * 3. The DW IC only detects the preamble of a frame, not its PHR and data, so a CCA during the data of another frame succeeds and the frame
+ *    sent then overlaps that data. This costs little only if a receiver demodulating data is not disturbed by a preamble, see NOTE 1 of
+ *    tx_with_cca.c: tools/csma_sim then finds a saturation throughput of about 63% of the channel time, against about 45 to 50% if any
+ *    overlap loses the frame (csma_sim -s), see NOTE 1 of tx_csma.c. After a CCA failure the DW IC returns to IDLE by itself, so the next
+ *    backoff starts at once; the frame is still in its TX buffer but written again at the next attempt, as the application may have used the
+ *    TX buffer in between.
+ ****************************************************************************************************************************************************/
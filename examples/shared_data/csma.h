@@ -0,0 +1,168 @@
+/*! ----------------------------------------------------------------------------
+ * @file    csma.h
+ * @brief   Unslotted CSMA-CA channel access (IEEE 802.15.4) over the preamble detection CCA of the DW IC
+ *
+ *          Frames are queued with a completion callback. The frame at the head of the queue waits a random number of backoff periods,
+ *          drawn from 0 to 2^BE - 1, then is sent with CCA: the DW IC listens for a preamble and only transmits if none is detected. On a
+ *          CCA failure the backoff exponent BE is increased, up to max_be, and the frame waits again, until it is sent or max_backoffs
+ *          retries failed. The engine never waits itself: csma_process() returns when its next action is due, so the caller sleeps in
+ *          between, and it only talks to the radio through csma_radio_t, so it runs on the DW3000 (csma_dw_radio) as well as against a
+ *          simulated channel on a host (tools/csma_sim). No DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _CSMA_
+#define _CSMA_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define CSMA_QUEUE_LEN 8 /* Frames queued, power of 2 */
+
+/* Default parameters, macMinBE, macMaxBE and macMaxCSMABackoffs of IEEE 802.15.4, see NOTE 1 in csma.c */
+#define CSMA_MIN_BE          3
+#define CSMA_MAX_BE          5
+#define CSMA_MAX_BACKOFFS    4
+#define CSMA_UNIT_BACKOFF_US 40
+
+#define CSMA_CCA_PACS 3 /* Preamble detection timeout of the CCA, in PACs */
+
+/* Results of the radio, and of the frames given to the callbacks */
+#define CSMA_TX_PENDING 0  /* CCA or transmission in progress */
+#define CSMA_TX_DONE    1  /* Frame sent */
+#define CSMA_TX_BUSY    2  /* CCA failed, preamble detected */
+#define CSMA_TX_FAIL    3  /* Channel access failure: max_backoffs + 1 CCA failed */
+#define CSMA_TX_ERROR   4  /* The radio refused the transmission */
+
+/* Return values of csma_queue() */
+#define CSMA_OK       0
+#define CSMA_ERR_FULL (-1)
+
+/* Value of csma_process() when it has nothing to do */
+#define CSMA_IDLE 0xFFFFFFFFUL
+
+    /* Radio used by the engine */
+    typedef struct
+    {
+        /* Write a frame (length including the FCS) and start its transmission with CCA. Returns CSMA_TX_PENDING, or CSMA_TX_ERROR. */
+        int (*cca_tx)(const uint8_t *frame, uint16_t len);
+        /* Outcome of the last cca_tx(), without waiting: CSMA_TX_PENDING, CSMA_TX_DONE or CSMA_TX_BUSY */
+        int (*tx_status)(void);
+        /* Free running microsecond clock */
+        uint32_t (*time_us)(void);
+    } csma_radio_t;
+
+    /* DW3000 radio, see csma_dw.c */
+    extern const csma_radio_t csma_dw_radio;
+
+    typedef struct
+    {
+        uint8_t min_be;
+        uint8_t max_be;
+        uint8_t max_backoffs;
+        uint16_t unit_us; /* Backoff period */
+    } csma_params_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief Completion of a frame, called from csma_process().
+     *
+     * @param ctx - context given to csma_queue()
+     * @param result - CSMA_TX_DONE, CSMA_TX_FAIL or CSMA_TX_ERROR
+     * @param backoffs - CCA failures of the frame
+     * @param delay_us - channel access delay: from the frame reaching the head of the queue to the start of its last CCA
+     */
+    typedef void (*csma_done_cb_t)(void *ctx, int result, uint8_t backoffs, uint32_t delay_us);
+
+    typedef struct
+    {
+        const uint8_t *frame; /* Must stay valid until the callback */
+        uint16_t len;
+        csma_done_cb_t done;
+        void *ctx;
+    } csma_frame_t;
+
+    /* Statistics, cumulative since csma_init() */
+    typedef struct
+    {
+        uint32_t queued;
+        uint32_t sent;
+        uint32_t failed;    /* Channel access failures */
+        uint32_t errors;    /* Transmissions refused by the radio */
+        uint32_t cca_busy;  /* CCA failures */
+        uint32_t delay_max_us;
+        uint64_t delay_sum_us; /* Of the frames sent */
+        uint32_t backoffs[CSMA_MAX_BACKOFFS + 2]; /* Frames sent or failed by number of CCA failures, the last one counting all higher numbers */
+    } csma_stats_t;
+
+    typedef struct
+    {
+        const csma_radio_t *radio;
+        csma_params_t params;
+        uint32_t rand; /* xorshift32 state */
+
+        csma_frame_t queue[CSMA_QUEUE_LEN];
+        uint8_t head;
+        uint8_t count;
+
+        /* Frame at the head of the queue */
+        uint8_t state;
+        uint8_t nb; /* CCA failures */
+        uint8_t be; /* Backoff exponent */
+        uint32_t start_us; /* Reached the head of the queue */
+        uint32_t cca_us;   /* Last CCA started */
+        uint32_t wake_us;  /* End of the backoff */
+
+        csma_stats_t stats;
+    } csma_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn csma_init()
+     *
+     * @brief Initialise the engine, with an empty queue.
+     *
+     * @param c - engine
+     * @param radio - radio to use
+     * @param params - backoff parameters, NULL for the defaults
+     * @param seed - seed of the backoff random numbers, different for each device (e.g. from its part and lot IDs)
+     *
+     * @return none
+     */
+    void csma_init(csma_t *c, const csma_radio_t *radio, const csma_params_t *params, uint32_t seed);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn csma_queue()
+     *
+     * @brief Queue a frame. It is sent by the following calls of csma_process().
+     *
+     * @param c - engine
+     * @param frame - frame, which must stay valid until the callback
+     * @param len - length of the frame including the FCS
+     * @param done - completion callback, or NULL
+     * @param ctx - context given to the callback
+     *
+     * @return CSMA_OK, or CSMA_ERR_FULL
+     */
+    int csma_queue(csma_t *c, const uint8_t *frame, uint16_t len, csma_done_cb_t done, void *ctx);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn csma_process()
+     *
+     * @brief Run the engine: start the backoff of the next frame, its CCA when the backoff is over, and handle the outcome of the CCA and
+     *        transmission. Call it again within the time returned, or as soon as the DW IC signals the end of the CCA or transmission.
+     *
+     * @param c - engine
+     *
+     * @return time to the next action in microseconds: 0 while the radio is busy, CSMA_IDLE if the queue is empty
+     */
+    uint32_t csma_process(csma_t *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+/*! ----------------------------------------------------------------------------
+ * @file    csma_dw.c
+ * @brief   DW3000 radio of the CSMA-CA engine, see csma.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <csma.h>
+#include <deca_device_api.h>
+#include <port.h>
+#include <shared_defines.h>
+
+static int dw_cca_tx(const uint8_t *frame, uint16_t len)
+{
+    dwt_writetxdata(len - FCS_LEN, (uint8_t *)frame, 0); /* Zero offset in TX buffer. */
+    dwt_writetxfctrl(len, 0, 0);                         /* Zero offset in TX buffer, no ranging. */
+
+    /* The transmission only starts if no preamble is detected within the preamble detection timeout, see NOTE 1 below. */
+    if (dwt_starttx(DWT_START_TX_CCA) != DWT_SUCCESS)
+    {
+        return CSMA_TX_ERROR;
+    }
+    return CSMA_TX_PENDING;
+}
+
+static int dw_tx_status(void)
+{
+    if (dwt_readsysstatuslo() & DWT_INT_TXFRS_BIT_MASK)
+    {
+        dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+        return CSMA_TX_DONE;
+    }
+    if (dwt_readsysstatushi() & DWT_INT_HI_CCA_FAIL_BIT_MASK)
+    {
+        /* The DW IC is back in IDLE */
+        dwt_writesysstatushi(DWT_INT_HI_CCA_FAIL_BIT_MASK);
+        return CSMA_TX_BUSY;
+    }
+    return CSMA_TX_PENDING;
+}
+
+const csma_radio_t csma_dw_radio = {
+    .cca_tx = dw_cca_tx,
+    .tx_status = dw_tx_status,
+    .time_us = port_get_time_us,
+};
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The preamble detection timeout is set by the application with dwt_setpreambledetecttimeout(CSMA_CCA_PACS), it is the CCA time. The
+ *    transmission starts at the end of the CCA, the CCA failure and the end of the frame are both status events which can also raise
+ *    the interrupt of the DW IC, e.g. to wake the MCU up and call csma_process().
+ ****************************************************************************************************************************************************/
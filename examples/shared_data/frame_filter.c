@@ -0,0 +1,265 @@
+/*! ----------------------------------------------------------------------------
+ * @file    frame_filter.c
+ * @brief   IEEE 802.15.4 frame filter of the DW IC set up from a policy, with a software second stage
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <frame_filter.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Frame control, see mac_802_15_4.h */
+#define FC_TYPE_MASK   0x0007
+#define FC_PANID_COMP  0x0040
+#define FC_SEQ_SUPP    0x0100
+#define FC_DST_SHIFT   10
+#define FC_VER_SHIFT   12
+#define FC_SRC_SHIFT   14
+#define FC_VERSION_2015 2
+#define ADDR_MODE_SHORT 2
+#define ADDR_MODE_EXT   3
+
+static int frame_filter_in(const uint16_t *table, uint8_t n, uint16_t v)
+{
+    while (n--)
+    {
+        if (*table++ == v)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static uint16_t frame_filter_get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void frame_filter_init(frame_filter_t *ff, const frame_filter_policy_t *policy)
+{
+    memset(ff, 0, sizeof(*ff));
+    ff->policy = *policy;
+
+    /* The DW IC matches one PAN ID and one short address only. See NOTE 1 below. */
+    ff->hw_addr = (policy->n_groups == 0 && policy->n_pans == 0);
+}
+
+int frame_filter_parse(const uint8_t *hdr, uint16_t len, frame_filter_hdr_t *h)
+{
+    uint16_t fc;
+    uint8_t i, comp, dst_pan, src_pan, n;
+
+    if (len < 2)
+    {
+        return -1;
+    }
+    fc = frame_filter_get16(hdr);
+    h->type = fc & FC_TYPE_MASK;
+    h->dst_mode = (fc >> FC_DST_SHIFT) & 3;
+    h->src_mode = (fc >> FC_SRC_SHIFT) & 3;
+    comp = (fc & FC_PANID_COMP) != 0;
+    i = 2;
+    h->seq = 0;
+    if (((fc >> FC_VER_SHIFT) & 3) != FC_VERSION_2015 || !(fc & FC_SEQ_SUPP))
+    {
+        if (len < 3)
+        {
+            return -1;
+        }
+        h->seq = hdr[i++];
+    }
+
+    /* PAN IDs present, see NOTE 2 below */
+    if (((fc >> FC_VER_SHIFT) & 3) != FC_VERSION_2015)
+    {
+        dst_pan = (h->dst_mode != 0);
+        src_pan = (h->src_mode != 0) && !(comp && h->dst_mode);
+    }
+    else if (!h->dst_mode || !h->src_mode)
+    {
+        dst_pan = h->dst_mode ? !comp : (!h->src_mode && comp);
+        src_pan = h->src_mode && !h->dst_mode && !comp;
+    }
+    else
+    {
+        dst_pan = (h->dst_mode == ADDR_MODE_EXT && h->src_mode == ADDR_MODE_EXT) ? !comp : 1;
+        src_pan = dst_pan && !comp && !(h->dst_mode == ADDR_MODE_EXT && h->src_mode == ADDR_MODE_EXT);
+    }
+
+    h->dst_pan = h->src_pan = FRAME_FILTER_BROADCAST;
+    memset(h->dst, 0, sizeof(h->dst));
+    memset(h->src, 0, sizeof(h->src));
+    if (dst_pan)
+    {
+        if (len < i + 2)
+        {
+            return -1;
+        }
+        h->dst_pan = frame_filter_get16(&hdr[i]);
+        i += 2;
+    }
+    n = (h->dst_mode == ADDR_MODE_EXT) ? 8 : (h->dst_mode == ADDR_MODE_SHORT) ? 2 : 0;
+    if (len < i + n)
+    {
+        return -1;
+    }
+    memcpy(h->dst, &hdr[i], n);
+    i += n;
+    if (src_pan)
+    {
+        if (len < i + 2)
+        {
+            return -1;
+        }
+        h->src_pan = frame_filter_get16(&hdr[i]);
+        i += 2;
+    }
+    else if (h->src_mode)
+    {
+        h->src_pan = h->dst_pan; /* Compressed, same PAN */
+    }
+    n = (h->src_mode == ADDR_MODE_EXT) ? 8 : (h->src_mode == ADDR_MODE_SHORT) ? 2 : 0;
+    if (len < i + n)
+    {
+        return -1;
+    }
+    memcpy(h->src, &hdr[i], n);
+    i += n;
+    h->hdr_len = i;
+    return 0;
+}
+
+/* Address filtering of the DW IC, in software when it is off */
+static int frame_filter_addr(const frame_filter_t *ff, const frame_filter_hdr_t *h)
+{
+    const frame_filter_policy_t *p = &ff->policy;
+    uint16_t pan = (h->dst_mode || h->dst_pan != FRAME_FILTER_BROADCAST) ? h->dst_pan : h->src_pan;
+    uint16_t dst;
+
+    if (pan != FRAME_FILTER_BROADCAST && pan != p->pan_id && !frame_filter_in(p->pans, p->n_pans, pan))
+    {
+        return FRAME_FILTER_REJ_PAN;
+    }
+    switch (h->dst_mode)
+    {
+        case ADDR_MODE_SHORT:
+            dst = frame_filter_get16(h->dst);
+            if (dst != FRAME_FILTER_BROADCAST && dst != p->short_addr && !frame_filter_in(p->groups, p->n_groups, dst))
+            {
+                return FRAME_FILTER_REJ_DST;
+            }
+            break;
+
+        case ADDR_MODE_EXT:
+            if (!p->eui64 || memcmp(h->dst, p->eui64, 8))
+            {
+                return FRAME_FILTER_REJ_DST;
+            }
+            break;
+
+        default:
+            /* Beacons and acknowledgements have no destination */
+            if (!p->no_dst && h->type != 0 && h->type != 2)
+            {
+                return FRAME_FILTER_REJ_DST;
+            }
+            break;
+    }
+    return FRAME_FILTER_ACCEPT;
+}
+
+/* Source tables, see NOTE 3 below */
+static int frame_filter_src(const frame_filter_t *ff, const frame_filter_hdr_t *h)
+{
+    const frame_filter_policy_t *p = &ff->policy;
+    uint16_t src;
+
+    if (h->src_mode == ADDR_MODE_SHORT)
+    {
+        src = frame_filter_get16(h->src);
+        if (frame_filter_in(p->src_deny, p->n_src_deny, src) || (p->n_src_allow && !frame_filter_in(p->src_allow, p->n_src_allow, src)))
+        {
+            return FRAME_FILTER_REJ_SRC;
+        }
+    }
+    else if (h->src_mode == ADDR_MODE_EXT && p->n_src_allow)
+    {
+        return FRAME_FILTER_REJ_SRC;
+    }
+    return FRAME_FILTER_ACCEPT;
+}
+
+/* Repeated frame: same source and sequence number as the previous frame of this source, e.g. sent again after a lost acknowledgement */
+static int frame_filter_dup(frame_filter_t *ff, const frame_filter_hdr_t *h)
+{
+    int i;
+
+    if (!ff->policy.no_dup || !h->src_mode)
+    {
+        return FRAME_FILTER_ACCEPT;
+    }
+    for (i = 0; i < FRAME_FILTER_DUP_LEN; i++)
+    {
+        if (ff->dup[i].used && !memcmp(ff->dup[i].src, h->src, 8))
+        {
+            if (ff->dup[i].seq == h->seq)
+            {
+                return FRAME_FILTER_REJ_DUP;
+            }
+            ff->dup[i].seq = h->seq;
+            return FRAME_FILTER_ACCEPT;
+        }
+    }
+    i = ff->dup_next;
+    ff->dup_next = (uint8_t)((ff->dup_next + 1) % FRAME_FILTER_DUP_LEN);
+    memcpy(ff->dup[i].src, h->src, 8);
+    ff->dup[i].seq = h->seq;
+    ff->dup[i].used = 1;
+    return FRAME_FILTER_ACCEPT;
+}
+
+int frame_filter_check(frame_filter_t *ff, const uint8_t *hdr, uint16_t len)
+{
+    frame_filter_hdr_t h;
+    int ret;
+
+    ff->stats.frames++;
+    if (frame_filter_parse(hdr, len, &h) < 0)
+    {
+        ret = FRAME_FILTER_REJ_LEN;
+    }
+    else if (!ff->hw_addr && !(ff->policy.types & (1 << h.type)))
+    {
+        ret = FRAME_FILTER_REJ_TYPE;
+    }
+    else if ((ret = ff->hw_addr ? FRAME_FILTER_ACCEPT : frame_filter_addr(ff, &h)) == FRAME_FILTER_ACCEPT
+             && (ret = frame_filter_src(ff, &h)) == FRAME_FILTER_ACCEPT)
+    {
+        ret = frame_filter_dup(ff, &h);
+    }
+
+    if (ret == FRAME_FILTER_ACCEPT)
+    {
+        ff->stats.accepted++;
+    }
+    else
+    {
+        ff->stats.sw_rejected[ret]++;
+    }
+    return ret;
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The DW IC rejects a frame whose type is not enabled, whose destination PAN ID is not its own or broadcast, or whose destination
+ *    address is not its short address, its extended address or broadcast, before the MCU is interrupted or reads anything. Group
+ *    addresses or other PANs cannot be added to it, so with such a policy its filter is turned off and the software filters the types
+ *    and addresses as well: every frame then costs an SPI read of its header and the check.
+ * 2. The PAN IDs present depend on the addressing modes and on the PAN ID compression bit, with different rules for 802.15.4-2006
+ *    (frame versions 0 and 1) and 802.15.4-2015 (frame version 2, table 7-2). A compressed source PAN ID is the destination PAN ID.
+ * 3. The DW IC does not filter on the source address. The source tables hold short addresses: with an allow table the frames with an
+ *    extended source address are rejected, and the deny table only applies to short addresses.
+ ****************************************************************************************************************************************************/
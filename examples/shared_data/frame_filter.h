@@ -0,0 +1,169 @@
+/*! ----------------------------------------------------------------------------
+ * @file    frame_filter.h
+ * @brief   IEEE 802.15.4 frame filter of the DW IC set up from a policy, with a software second stage
+ *
+ *          The application describes what it wants to receive (frame types, PAN ID, short and extended address, frames without destination
+ *          address) and the filter derives the frame filter configuration of the DW IC from it, so that the DW IC rejects the other frames
+ *          without the MCU reading them. What the DW IC cannot filter is done in software, on the MAC header only: sources allowed or denied,
+ *          group addresses and more PANs (which need the address filter of the DW IC to be off), and repeated frames (same source and
+ *          sequence number). The frames rejected by the DW IC and by the software are counted separately.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _FRAME_FILTER_
+#define _FRAME_FILTER_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+/* Frame types, bit n for the 802.15.4 frame type n (mac_frame_type_802_15_4_e) */
+#define FRAME_FILTER_BEACON 0x01
+#define FRAME_FILTER_DATA   0x02
+#define FRAME_FILTER_ACK    0x04
+#define FRAME_FILTER_CMD    0x08
+#define FRAME_FILTER_MULTI  0x20
+#define FRAME_FILTER_FRAG   0x40
+#define FRAME_FILTER_EXT    0x80
+
+#define FRAME_FILTER_NO_SHORT  0xFFFE /* No short address, as the 802.15.4 macShortAddress */
+#define FRAME_FILTER_BROADCAST 0xFFFF
+#define FRAME_FILTER_HDR_MAX   23 /* Longest MAC header filtered: frame control, sequence number, 2 PAN IDs and 2 extended addresses */
+#define FRAME_FILTER_DUP_LEN   8  /* Sources whose last sequence number is kept for the repeated frames */
+#define FRAME_FILTER_TABLE_MAX 16 /* Entries of each table of the policy */
+
+/* Results of frame_filter_check(), also indices of the rejection counters */
+#define FRAME_FILTER_ACCEPT    0
+#define FRAME_FILTER_REJ_LEN   1 /* Frame too short for its header */
+#define FRAME_FILTER_REJ_TYPE  2
+#define FRAME_FILTER_REJ_PAN   3
+#define FRAME_FILTER_REJ_DST   4
+#define FRAME_FILTER_REJ_SRC   5
+#define FRAME_FILTER_REJ_DUP   6
+#define FRAME_FILTER_REJ_COUNT 7
+
+    typedef struct
+    {
+        uint8_t types;         /* Frame types accepted, FRAME_FILTER_DATA etc. */
+        uint16_t pan_id;       /* Own PAN ID */
+        uint16_t short_addr;   /* Own short address, FRAME_FILTER_NO_SHORT if none */
+        const uint8_t *eui64;  /* Own extended address, least significant byte first, NULL if none */
+        uint8_t no_dst;        /* Accept the frames without destination address, e.g. to a PAN coordinator */
+        uint8_t no_dup;        /* Reject the frames repeating the sequence number of the previous frame of the same source */
+        /* Second stage tables, in software */
+        const uint16_t *groups; /* More destination short addresses, e.g. group addresses */
+        uint8_t n_groups;
+        const uint16_t *pans; /* More PAN IDs */
+        uint8_t n_pans;
+        const uint16_t *src_allow; /* Short source addresses accepted, all if none */
+        uint8_t n_src_allow;
+        const uint16_t *src_deny; /* Short source addresses rejected */
+        uint8_t n_src_deny;
+    } frame_filter_policy_t;
+
+    /* Parsed MAC header */
+    typedef struct
+    {
+        uint8_t type;
+        uint8_t seq;
+        uint8_t hdr_len;
+        uint8_t dst_mode; /* 0 none, 2 short, 3 extended */
+        uint8_t src_mode;
+        uint16_t dst_pan;
+        uint16_t src_pan;
+        uint8_t dst[8]; /* Short addresses in the first 2 bytes */
+        uint8_t src[8];
+    } frame_filter_hdr_t;
+
+    typedef struct
+    {
+        uint32_t frames;     /* Frames seen by the software, accepted or not */
+        uint32_t accepted;
+        uint32_t hw_rejected; /* Frames rejected by the DW IC, see frame_filter_dw_update() */
+        uint32_t sw_rejected[FRAME_FILTER_REJ_COUNT]; /* By reason, FRAME_FILTER_REJ_xxx */
+    } frame_filter_stats_t;
+
+    typedef struct
+    {
+        frame_filter_policy_t policy;
+        uint8_t hw_addr; /* The DW IC filters, else the software filters the types and addresses as well */
+        struct
+        {
+            uint8_t src[8];
+            uint8_t seq;
+            uint8_t used;
+        } dup[FRAME_FILTER_DUP_LEN];
+        uint8_t dup_next;
+        frame_filter_stats_t stats;
+    } frame_filter_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn frame_filter_init()
+     *
+     * @brief Derive the configuration of the DW IC and of the software stage from a policy. The tables of the policy are not copied.
+     *
+     * @param ff - filter
+     * @param policy - frames to receive
+     *
+     * @return none
+     */
+    void frame_filter_init(frame_filter_t *ff, const frame_filter_policy_t *policy);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn frame_filter_parse()
+     *
+     * @brief Parse the MAC header of a frame.
+     *
+     * @param hdr - start of the frame
+     * @param len - bytes available, FCS excluded
+     * @param h - parsed header
+     *
+     * @return 0, or -1 if the header is longer than len
+     */
+    int frame_filter_parse(const uint8_t *hdr, uint16_t len, frame_filter_hdr_t *h);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn frame_filter_check()
+     *
+     * @brief Second stage filter of a frame accepted by the DW IC, from its first bytes. Counts the frame.
+     *
+     * @param ff - filter
+     * @param hdr - first bytes of the frame, FRAME_FILTER_HDR_MAX are enough
+     * @param len - bytes in hdr, FCS excluded
+     *
+     * @return FRAME_FILTER_ACCEPT or the reason of the rejection, FRAME_FILTER_REJ_xxx
+     */
+    int frame_filter_check(frame_filter_t *ff, const uint8_t *hdr, uint16_t len);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn frame_filter_dw_apply()
+     *
+     * @brief Configure the DW IC: PAN ID, addresses and frame filter, and enable its event counters for the rejections. See frame_filter_dw.c.
+     *
+     * @param ff - filter, initialised
+     *
+     * @return none
+     */
+    void frame_filter_dw_apply(frame_filter_t *ff);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn frame_filter_dw_update()
+     *
+     * @brief Add the frames rejected by the DW IC since the last call to the statistics and clear the event counters of the DW IC. To
+     *        call before 255 rejections, the counter saturates.
+     *
+     * @param ff - filter
+     *
+     * @return none
+     */
+    void frame_filter_dw_update(frame_filter_t *ff);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,85 @@
+/*! ----------------------------------------------------------------------------
+ * @file    frame_filter_dw.c
+ * @brief   DW3000 frame filter and rejection counter of the frame filter, see frame_filter.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <deca_device_api.h>
+#include <frame_filter.h>
+#include <string.h>
+#include <telem.h>
+
+/* Frame filter configuration bit of each frame type of the policy */
+static const struct
+{
+    uint8_t type;
+    uint16_t ff;
+} ff_types[] = {
+    { FRAME_FILTER_BEACON, DWT_FF_BEACON_EN },
+    { FRAME_FILTER_DATA, DWT_FF_DATA_EN },
+    { FRAME_FILTER_ACK, DWT_FF_ACK_EN },
+    { FRAME_FILTER_CMD, DWT_FF_MAC_EN },
+    { FRAME_FILTER_MULTI, DWT_FF_MULTI_EN },
+    { FRAME_FILTER_FRAG, DWT_FF_FRAG_EN },
+    { FRAME_FILTER_EXT, DWT_FF_EXTEND_EN },
+};
+
+void frame_filter_dw_apply(frame_filter_t *ff)
+{
+    const frame_filter_policy_t *p = &ff->policy;
+    uint8_t eui64[8];
+    uint16_t mask = 0;
+    unsigned int i;
+
+    dwt_setpanid(p->pan_id);
+    dwt_setaddress16(p->short_addr);
+    if (p->eui64)
+    {
+        memcpy(eui64, p->eui64, sizeof(eui64));
+        dwt_seteui(eui64);
+    }
+
+    if (ff->hw_addr)
+    {
+        for (i = 0; i < sizeof(ff_types) / sizeof(ff_types[0]); i++)
+        {
+            if (p->types & ff_types[i].type)
+            {
+                mask |= ff_types[i].ff;
+            }
+        }
+        if (p->no_dst)
+        {
+            /* See NOTE 1 below */
+            mask |= DWT_FF_COORD_EN | DWT_FF_IMPBRCAST_EN;
+        }
+        dwt_configureframefilter(DWT_FF_ENABLE_802_15_4, mask);
+    }
+    else
+    {
+        dwt_configureframefilter(DWT_FF_DISABLE, 0);
+    }
+
+    /* Enabling the event counters clears them. See NOTE 2 below. */
+    telem_hw_enable();
+}
+
+void frame_filter_dw_update(frame_filter_t *ff)
+{
+    dwt_deviceentcnts_t cnt;
+
+    telem_hw_update(&cnt);
+    ff->stats.hw_rejected += cnt.ARFE;
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. DWT_FF_COORD_EN accepts the frames without destination address whose source PAN ID is the own one, as a PAN coordinator does, and
+ *    DWT_FF_IMPBRCAST_EN the frames without destination address at all (implicit broadcast).
+ * 2. A frame rejected by the frame filter does not end the reception: the DW IC goes on receiving and the host sees nothing, no event is
+ *    raised. The ARFE event counter is the only trace of these frames. It is 8 bits wide and saturates, so frame_filter_dw_update()
+ *    reads and clears it, to be called before 255 rejections. The other event counters are cleared with it, all of them being added to the
+ *    telemetry of telem.h.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,241 @@
+/*! ----------------------------------------------------------------------------
+ * @file    indirect.c
+ * @brief   Indirect transmission queue of a coordinator, for sleepy devices polling their data
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <indirect.h>
+#include <stddef.h>
+#include <string.h>
+
+static int indirect_find_slot(const indirect_t *q, uint16_t addr)
+{
+    int i;
+
+    for (i = 0; i < INDIRECT_SLOTS; i++)
+    {
+        if (q->slots[i].used && q->slots[i].addr == addr)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Oldest frame of a device, or of any device without a slot if addr is 0xFFFF */
+static indirect_frame_t *indirect_oldest(const indirect_t *q, uint16_t addr, uint8_t *count)
+{
+    const indirect_frame_t *best = NULL;
+    int i;
+
+    *count = 0;
+    for (i = 0; i < INDIRECT_QUEUE_LEN; i++)
+    {
+        const indirect_frame_t *f = &q->frames[i];
+
+        if (!f->used || (addr == 0xFFFF ? indirect_find_slot(q, f->addr) >= 0 : f->addr != addr))
+        {
+            continue;
+        }
+        (*count)++;
+        if (!best || (int32_t)(f->order - best->order) < 0)
+        {
+            best = f;
+        }
+    }
+    return (indirect_frame_t *)best;
+}
+
+/* Give a device a slot: a free one, else the least recently used. See NOTE 1 below. */
+static void indirect_assign(indirect_t *q, uint16_t addr, uint32_t now_us)
+{
+    int i, lru = 0;
+
+    for (i = 0; i < INDIRECT_SLOTS; i++)
+    {
+        if (!q->slots[i].used)
+        {
+            lru = i;
+            break;
+        }
+        if ((int32_t)(q->slots[i].use_us - q->slots[lru].use_us) < 0)
+        {
+            lru = i;
+        }
+    }
+    if (q->slots[lru].used)
+    {
+        q->stats.evictions++;
+    }
+    q->slots[lru].addr = addr;
+    q->slots[lru].used = 1;
+    q->slots[lru].use_us = now_us;
+    q->enabled |= (uint8_t)(1 << lru);
+    q->radio->set_slot((uint8_t)lru, addr, q->enabled);
+}
+
+/* Release the slot of a device without data, and give it to a device with data but no slot, if any */
+static void indirect_release(indirect_t *q, int slot, uint32_t now_us)
+{
+    indirect_frame_t *f;
+    uint8_t count;
+
+    q->slots[slot].used = 0;
+    q->enabled &= (uint8_t)~(1 << slot);
+    f = indirect_oldest(q, 0xFFFF, &count);
+    if (f)
+    {
+        indirect_assign(q, f->addr, now_us);
+    }
+    else
+    {
+        q->radio->set_slot((uint8_t)slot, q->slots[slot].addr, q->enabled);
+    }
+}
+
+void indirect_init(indirect_t *q, const indirect_radio_t *radio)
+{
+    int i;
+
+    memset(q, 0, sizeof(*q));
+    q->radio = radio;
+    for (i = 0; i < INDIRECT_SLOTS; i++)
+    {
+        q->slots[i].addr = 0xFFFF;
+        radio->set_slot((uint8_t)i, 0xFFFF, 0);
+    }
+}
+
+int indirect_queue(indirect_t *q, uint16_t addr, const uint8_t *data, uint8_t len)
+{
+    uint32_t now_us = q->radio->time_us();
+    int i;
+
+    if (len > INDIRECT_DATA_MAX)
+    {
+        return INDIRECT_ERR_LEN;
+    }
+    for (i = 0; i < INDIRECT_QUEUE_LEN && q->frames[i].used; i++) { };
+    if (i == INDIRECT_QUEUE_LEN)
+    {
+        q->stats.full++;
+        return INDIRECT_ERR_FULL;
+    }
+
+    q->frames[i].addr = addr;
+    q->frames[i].len = len;
+    q->frames[i].queued_us = now_us;
+    q->frames[i].order = q->order++;
+    memcpy(q->frames[i].data, data, len);
+    q->frames[i].used = 1;
+    q->stats.queued++;
+
+    if (indirect_find_slot(q, addr) < 0)
+    {
+        indirect_assign(q, addr, now_us);
+    }
+    return INDIRECT_OK;
+}
+
+int indirect_poll(indirect_t *q, uint16_t addr)
+{
+    uint32_t now_us = q->radio->time_us();
+    int slot = indirect_find_slot(q, addr);
+    uint8_t count;
+
+    q->stats.polls++;
+    indirect_oldest(q, addr, &count);
+    if (slot >= 0)
+    {
+        q->slots[slot].use_us = now_us;
+        if (count)
+        {
+            q->stats.polls_data++;
+            return 1;
+        }
+        indirect_release(q, slot, now_us);
+    }
+    else if (count)
+    {
+        /* Too late for this poll, the acknowledgement is already sent. See NOTE 2 below. */
+        q->stats.missed++;
+        indirect_assign(q, addr, now_us);
+    }
+    return 0;
+}
+
+const indirect_frame_t *indirect_head(const indirect_t *q, uint16_t addr, uint8_t *more)
+{
+    indirect_frame_t *f;
+    uint8_t count;
+
+    f = indirect_oldest(q, addr, &count);
+    *more = (count > 1);
+    return f;
+}
+
+uint32_t indirect_delivered(indirect_t *q, uint16_t addr)
+{
+    uint32_t now_us = q->radio->time_us(), latency_us;
+    indirect_frame_t *f;
+    uint8_t count;
+    int slot;
+
+    f = indirect_oldest(q, addr, &count);
+    if (!f)
+    {
+        return 0;
+    }
+    f->used = 0;
+    latency_us = now_us - f->queued_us;
+    q->stats.delivered++;
+    q->stats.latency_sum_us += latency_us;
+    if (latency_us > q->stats.latency_max_us)
+    {
+        q->stats.latency_max_us = latency_us;
+    }
+
+    slot = indirect_find_slot(q, addr);
+    if (count == 1 && slot >= 0)
+    {
+        indirect_release(q, slot, now_us);
+    }
+    return latency_us;
+}
+
+void indirect_expire(indirect_t *q)
+{
+    uint32_t now_us = q->radio->time_us();
+    uint8_t count;
+    int i;
+
+    for (i = 0; i < INDIRECT_QUEUE_LEN; i++)
+    {
+        if (q->frames[i].used && now_us - q->frames[i].queued_us >= INDIRECT_PERSISTENCE_MS * 1000UL)
+        {
+            q->frames[i].used = 0;
+            q->stats.expired++;
+        }
+    }
+    for (i = 0; i < INDIRECT_SLOTS; i++)
+    {
+        if (q->slots[i].used && !indirect_oldest(q, q->slots[i].addr, &count))
+        {
+            indirect_release(q, i, now_us);
+        }
+    }
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. Only the devices with data pending hold a slot. A device gets one when a frame is queued for it, and when all four are taken the slot
+ *    of the device which was given its slot or polled the longest time ago goes to it: that device polls the least often, so it is the
+ *    least likely to poll before the others, and it gets a slot back when another one is released or at its next poll. With up to four
+ *    devices with data at a time no poll is missed.
+ * 2. The DW IC sends the acknowledgement of the data request before the MCU reads the request, with the frame pending bit if the address
+ *    of the device is in an enabled slot at that time. A device polling with data pending but without slot therefore sleeps again and
+ *    gets its data at its next poll, its slot being assigned now. Conversely the queue assumes that the slot state did not change between
+ *    the reception of the request and indirect_poll(): the application should not queue frames in between, e.g. from an interrupt.
+ ****************************************************************************************************************************************************/
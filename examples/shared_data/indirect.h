@@ -0,0 +1,167 @@
+/*! ----------------------------------------------------------------------------
+ * @file    indirect.h
+ * @brief   Indirect transmission queue of a coordinator, for sleepy devices polling their data
+ *
+ *          A coordinator cannot send to a device which sleeps, so it keeps the frames for each device until the device wakes up and polls
+ *          with a data request (IEEE 802.15.4 MAC command 0x04). The acknowledgement of the data request, sent by the DW IC itself, has
+ *          its frame pending bit set if the device has data waiting: the device then stays awake for the data, otherwise it sleeps again at
+ *          once. The DW IC sets the frame pending bit for the addresses held in its four LE address registers (LE0 to LE3), so the queue
+ *          assigns these slots to the devices with data pending, the least recently used slot going to a new device when all four are
+ *          taken. The queue talks to the DW IC through indirect_radio_t (indirect_dw_radio). No DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _INDIRECT_
+#define _INDIRECT_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define INDIRECT_SLOTS          4     /* LE address registers of the DW IC */
+#define INDIRECT_QUEUE_LEN      16    /* Frames held, all devices together */
+#define INDIRECT_DATA_MAX       64    /* Payload of a frame */
+#define INDIRECT_PERSISTENCE_MS 10000 /* A frame not polled within this time is dropped, macTransactionPersistenceTime */
+
+/* Return values */
+#define INDIRECT_OK      0
+#define INDIRECT_ERR_FULL (-1)
+#define INDIRECT_ERR_LEN  (-2)
+
+    /* Frame pending bit setting of the DW IC */
+    typedef struct
+    {
+        /* Set the address of a slot and the slots whose addresses get the frame pending bit, bit i for slot i */
+        void (*set_slot)(uint8_t slot, uint16_t addr, uint8_t enabled);
+        /* Free running microsecond clock */
+        uint32_t (*time_us)(void);
+    } indirect_radio_t;
+
+    /* DW3000 LE address registers, see indirect_dw.c */
+    extern const indirect_radio_t indirect_dw_radio;
+
+    typedef struct
+    {
+        uint16_t addr; /* Destination device */
+        uint8_t len;
+        uint8_t used;
+        uint32_t queued_us; /* Time queued, for the expiry and the latency */
+        uint32_t order;     /* Order queued, frames of a device are sent in this order */
+        uint8_t data[INDIRECT_DATA_MAX];
+    } indirect_frame_t;
+
+    typedef struct
+    {
+        uint16_t addr;
+        uint8_t used;
+        uint32_t use_us; /* Last assignment or poll, for the LRU */
+    } indirect_slot_t;
+
+    typedef struct
+    {
+        uint32_t queued;     /* Frames queued */
+        uint32_t delivered;  /* Frames acknowledged by their device */
+        uint32_t expired;    /* Frames dropped after INDIRECT_PERSISTENCE_MS */
+        uint32_t full;       /* Frames not queued, the queue being full */
+        uint32_t polls;      /* Data requests received */
+        uint32_t polls_data; /* Data requests answered with the frame pending bit */
+        uint32_t missed;     /* Data requests of a device with data pending but no slot, answered without the frame pending bit */
+        uint32_t evictions;  /* Slots taken from a device with data pending */
+        uint32_t latency_max_us; /* Time from the queuing of a frame to its delivery */
+        uint64_t latency_sum_us;
+    } indirect_stats_t;
+
+    typedef struct
+    {
+        const indirect_radio_t *radio;
+        indirect_frame_t frames[INDIRECT_QUEUE_LEN];
+        indirect_slot_t slots[INDIRECT_SLOTS];
+        uint8_t enabled; /* Slots with the frame pending bit, bit i for slot i */
+        uint32_t order;
+        indirect_stats_t stats;
+    } indirect_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn indirect_init()
+     *
+     * @brief Initialise an empty queue, all the slots disabled.
+     *
+     * @param q - queue
+     * @param radio - DW IC programming
+     *
+     * @return none
+     */
+    void indirect_init(indirect_t *q, const indirect_radio_t *radio);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn indirect_queue()
+     *
+     * @brief Queue a frame for a device, and give the device a slot if it has none.
+     *
+     * @param q - queue
+     * @param addr - short address of the device
+     * @param data - payload, copied
+     * @param len - payload length, up to INDIRECT_DATA_MAX
+     *
+     * @return INDIRECT_OK, INDIRECT_ERR_FULL or INDIRECT_ERR_LEN
+     */
+    int indirect_queue(indirect_t *q, uint16_t addr, const uint8_t *data, uint8_t len);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn indirect_poll()
+     *
+     * @brief Data request received from a device. If the device has data pending but no slot, it gets one for its next poll.
+     *
+     * @param q - queue
+     * @param addr - short address of the device
+     *
+     * @return 1 if the acknowledgement had the frame pending bit, and the frames of the device (indirect_head()) are to be sent now,
+     *         0 otherwise
+     */
+    int indirect_poll(indirect_t *q, uint16_t addr);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn indirect_head()
+     *
+     * @brief Oldest frame of a device.
+     *
+     * @param q - queue
+     * @param addr - short address of the device
+     * @param more - set to 1 if the device has more frames after this one, for the frame pending bit of the data frame
+     *
+     * @return the frame, NULL if none
+     */
+    const indirect_frame_t *indirect_head(const indirect_t *q, uint16_t addr, uint8_t *more);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn indirect_delivered()
+     *
+     * @brief Remove the oldest frame of a device, acknowledged by it. The slot of the device is released when it has no more frames.
+     *
+     * @param q - queue
+     * @param addr - short address of the device
+     *
+     * @return latency of the frame in microseconds
+     */
+    uint32_t indirect_delivered(indirect_t *q, uint16_t addr);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn indirect_expire()
+     *
+     * @brief Drop the frames older than INDIRECT_PERSISTENCE_MS. To call regularly, e.g. at each reception timeout.
+     *
+     * @param q - queue
+     *
+     * @return none
+     */
+    void indirect_expire(indirect_t *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
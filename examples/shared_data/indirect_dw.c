@@ -0,0 +1,44 @@
+/*! ----------------------------------------------------------------------------
+ * @file    indirect_dw.c
+ * @brief   DW3000 LE address registers of the indirect transmission queue, see indirect.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <deca_device_api.h>
+#include <indirect.h>
+#include <port.h>
+
+/* Frames received by the coordinator besides the data requests: data frames and acknowledgements. See NOTE 1 below. */
+#define INDIRECT_DW_FF (DWT_FF_DATA_EN | DWT_FF_ACK_EN | DWT_FF_MAC_EN)
+
+static const uint16_t le_en[INDIRECT_SLOTS] = { DWT_FF_MAC_LE0_EN, DWT_FF_MAC_LE1_EN, DWT_FF_MAC_LE2_EN, DWT_FF_MAC_LE3_EN };
+
+static void dw_set_slot(uint8_t slot, uint16_t addr, uint8_t enabled)
+{
+    uint16_t ff = INDIRECT_DW_FF;
+    int i;
+
+    dwt_configure_le_address(addr, slot);
+    for (i = 0; i < INDIRECT_SLOTS; i++)
+    {
+        if (enabled & (1 << i))
+        {
+            ff |= le_en[i];
+        }
+    }
+    dwt_configureframefilter(DWT_FF_ENABLE_802_15_4, ff);
+}
+
+const indirect_radio_t indirect_dw_radio = {
+    .set_slot = dw_set_slot,
+    .time_us = port_get_time_us,
+};
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The frame pending bit is set in the automatic acknowledgement of a MAC command frame (the data request) from a 16-bit source address
+ *    held in an LE address register whose LEx_PEND bit is set in the frame filter configuration, see the LE PEND RX example. The frame
+ *    filter is therefore written as a whole with each slot change, the MAC command, data and acknowledgement frames staying enabled.
+ ****************************************************************************************************************************************************/
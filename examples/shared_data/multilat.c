@@ -0,0 +1,267 @@
+/*! ----------------------------------------------------------------------------
+ * @file    multilat.c
+ * @brief   Position of a tag from its ranges to anchors at known positions (multilateration)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <multilat.h>
+
+#define MULTILAT_EPS        1e-5f /* Smallest pivot of a linear system, relative to its diagonal */
+#define MULTILAT_PLANAR_MM  500   /* 3D: anchors whose heights are all within this are taken as coplanar */
+#define MULTILAT_MIN_DIST_M 0.001f
+
+/* Solve a x = b, a being symmetric of order dim, by Gaussian elimination with partial pivoting. a and b are overwritten. */
+static int solve(float a[3][3], float b[3], int dim, float x[3])
+{
+    float scale = 0, f;
+    int i, j, k, p;
+
+    for (i = 0; i < dim; i++)
+    {
+        if (fabsf(a[i][i]) > scale)
+        {
+            scale = fabsf(a[i][i]);
+        }
+    }
+    for (k = 0; k < dim; k++)
+    {
+        p = k;
+        for (i = k + 1; i < dim; i++)
+        {
+            if (fabsf(a[i][k]) > fabsf(a[p][k]))
+            {
+                p = i;
+            }
+        }
+        if (fabsf(a[p][k]) <= scale * MULTILAT_EPS)
+        {
+            return -1;
+        }
+        if (p != k)
+        {
+            for (j = 0; j < dim; j++)
+            {
+                f = a[k][j];
+                a[k][j] = a[p][j];
+                a[p][j] = f;
+            }
+            f = b[k];
+            b[k] = b[p];
+            b[p] = f;
+        }
+        for (i = k + 1; i < dim; i++)
+        {
+            f = a[i][k] / a[k][k];
+            for (j = k; j < dim; j++)
+            {
+                a[i][j] -= f * a[k][j];
+            }
+            b[i] -= f * b[k];
+        }
+    }
+    for (k = dim - 1; k >= 0; k--)
+    {
+        f = b[k];
+        for (j = k + 1; j < dim; j++)
+        {
+            f -= a[k][j] * x[j];
+        }
+        x[k] = f / a[k][k];
+    }
+    return 0;
+}
+
+/* Closed form least squares position, the anchors being centred on their centroid. See NOTE 2 below. */
+static int closed_form(float pos[][3], const float *r, unsigned int m, int dim, float p[3])
+{
+    float a[3][3] = { { 0 } }, b[3] = { 0 }, k[MULTILAT_MAX_ANCHORS], k_mean = 0;
+    unsigned int i;
+    int u, v;
+
+    for (i = 0; i < m; i++)
+    {
+        k[i] = pos[i][0] * pos[i][0] + pos[i][1] * pos[i][1] + pos[i][2] * pos[i][2] - r[i] * r[i];
+        k_mean += k[i];
+    }
+    k_mean /= m;
+    for (i = 0; i < m; i++)
+    {
+        for (u = 0; u < dim; u++)
+        {
+            for (v = 0; v < dim; v++)
+            {
+                a[u][v] += pos[i][u] * pos[i][v];
+            }
+            b[u] += pos[i][u] * (k[i] - k_mean) / 2;
+        }
+    }
+    return solve(a, b, dim, p);
+}
+
+int multilat_find(const multilat_anchor_t *anchors, unsigned int n, uint16_t addr)
+{
+    unsigned int i;
+
+    for (i = 0; i < n; i++)
+    {
+        if (anchors[i].addr == addr)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int multilat_solve(const multilat_anchor_t *anchors, const int32_t *range_mm, unsigned int n, int dim, multilat_result_t *res)
+{
+    float pos[MULTILAT_MAX_ANCHORS][3], r[MULTILAT_MAX_ANCHORS];
+    float c[3] = { 0 }, p[3] = { 0 }, z_min = 0, z_max = 0, sq = 0;
+    unsigned int i, m = 0;
+    int u, iter;
+
+    /* Anchors with a range, in m */
+    for (i = 0; i < n && m < MULTILAT_MAX_ANCHORS; i++)
+    {
+        if (range_mm[i] == MULTILAT_NO_RANGE)
+        {
+            continue;
+        }
+        pos[m][0] = anchors[i].x_cm / 100.0f;
+        pos[m][1] = anchors[i].y_cm / 100.0f;
+        pos[m][2] = (dim == 3) ? anchors[i].z_cm / 100.0f : 0;
+        r[m] = range_mm[i] / 1000.0f;
+        if (m == 0 || pos[m][2] < z_min)
+        {
+            z_min = pos[m][2];
+        }
+        if (m == 0 || pos[m][2] > z_max)
+        {
+            z_max = pos[m][2];
+        }
+        m++;
+    }
+    if (m < (unsigned int)dim + 1)
+    {
+        return MULTILAT_ERR_ANCHORS;
+    }
+
+    /* Work relative to the centroid of the anchors, which keeps the squares small. See NOTE 1 below. */
+    for (i = 0; i < m; i++)
+    {
+        for (u = 0; u < 3; u++)
+        {
+            c[u] += pos[i][u] / m;
+        }
+    }
+    for (i = 0; i < m; i++)
+    {
+        for (u = 0; u < 3; u++)
+        {
+            pos[i][u] -= c[u];
+        }
+    }
+
+    /* Initial guess. With coplanar anchors, the horizontal position only and the tag below them. See NOTE 3 below. */
+    if (dim == 3 && z_max - z_min < MULTILAT_PLANAR_MM / 1000.0f)
+    {
+        if (closed_form(pos, r, m, 2, p) != 0)
+        {
+            return MULTILAT_ERR_GEOMETRY;
+        }
+        p[2] = -MULTILAT_BELOW_MM / 1000.0f;
+    }
+    else if (closed_form(pos, r, m, dim, p) != 0)
+    {
+        return MULTILAT_ERR_GEOMETRY;
+    }
+
+    /* Gauss-Newton iterations on the range residuals */
+    for (iter = 0; iter < MULTILAT_MAX_ITER;)
+    {
+        float jtj[3][3] = { { 0 } }, jtf[3] = { 0 }, d[3], step[3] = { 0 }, dist, f, norm = 0;
+        int v;
+
+        for (i = 0; i < m; i++)
+        {
+            dist = 0;
+            for (u = 0; u < dim; u++)
+            {
+                d[u] = p[u] - pos[i][u];
+                dist += d[u] * d[u];
+            }
+            dist = sqrtf(dist);
+            if (dist < MULTILAT_MIN_DIST_M)
+            {
+                dist = MULTILAT_MIN_DIST_M;
+            }
+            f = dist - r[i];
+            for (u = 0; u < dim; u++)
+            {
+                d[u] /= dist;
+            }
+            for (u = 0; u < dim; u++)
+            {
+                for (v = 0; v < dim; v++)
+                {
+                    jtj[u][v] += d[u] * d[v];
+                }
+                jtf[u] -= d[u] * f;
+            }
+        }
+        if (solve(jtj, jtf, dim, step) != 0)
+        {
+            break; /* Keep the last position */
+        }
+        iter++;
+        for (u = 0; u < dim; u++)
+        {
+            p[u] += step[u];
+            norm += step[u] * step[u];
+        }
+        if (norm < (MULTILAT_STEP_MM / 1000.0f) * (MULTILAT_STEP_MM / 1000.0f))
+        {
+            break;
+        }
+    }
+
+    /* Quality: RMS of the residuals at the solution */
+    for (i = 0; i < m; i++)
+    {
+        float dist = 0, d;
+
+        for (u = 0; u < dim; u++)
+        {
+            d = p[u] - pos[i][u];
+            dist += d * d;
+        }
+        d = sqrtf(dist) - r[i];
+        sq += d * d;
+    }
+
+    res->x_mm = (int32_t)lrintf((p[0] + c[0]) * 1000);
+    res->y_mm = (int32_t)lrintf((p[1] + c[1]) * 1000);
+    res->z_mm = (dim == 3) ? (int32_t)lrintf((p[2] + c[2]) * 1000) : 0;
+    res->rms_mm = (uint32_t)lrintf(sqrtf(sq / m) * 1000);
+    res->anchors = (uint8_t)m;
+    res->iter = (uint8_t)iter;
+    return 0;
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The Cortex-M4F of the nRF52 computes in single precision in hardware, about 7 significant digits. Relative to the centroid of the
+ *    anchors and in metres, the squares of the closed form stay within a few thousand for a site of a hundred metres, which keeps the
+ *    position at the mm. A solution with 4 anchors takes a few thousand cycles (tools/multilat_bench measures the time on a host).
+ * 2. Subtracting the mean of the range equations |p - a_i|^2 = r_i^2 leaves 2 a_i.p = |a_i|^2 - r_i^2 - mean(|a|^2 - r^2), linear in p with the
+ *    anchors centred, solved by least squares. It is exact with exact ranges, biased by noisy ones, hence the Gauss-Newton iterations which
+ *    minimise the squared range residuals. Their RMS is close to the range noise when the ranges agree, and grows with a range biased by NLOS
+ *    or a wrong anchor position: it is the quality of the position, to be compared with the noise of the ranges. It is always 0 with only
+ *    dim ranges, which an intersection of their spheres fits exactly; each range beyond them adds redundancy to check the position with.
+ * 3. With all anchors at about the same height, common on a ceiling, the ranges give the height of the tag up to its mirror image across the
+ *    plane of the anchors, and the closed form cannot. The horizontal position is then found in 2D, and the iterations start
+ *    MULTILAT_BELOW_MM below the plane, which converges to the solution on that side. In 2D, the tag is taken in the plane of the anchors:
+ *    a difference of height between them adds to the range residuals.
+ ****************************************************************************************************************************************************/
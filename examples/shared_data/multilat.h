@@ -0,0 +1,85 @@
+/*! ----------------------------------------------------------------------------
+ * @file    multilat.h
+ * @brief   Position of a tag from its ranges to anchors at known positions (multilateration)
+ *
+ *          The anchors are given in a compact table, 8 bytes each. The position is first found in closed form, by least squares on the
+ *          linear equations left by subtracting the range equation of one anchor from the others, then refined by a bounded number of
+ *          Gauss-Newton iterations on the ranges themselves. The RMS of the range residuals at the solution tells how consistent the ranges
+ *          are. 2D (tag in the plane of the anchor coordinates) or 3D. Fixed memory, single precision floating point for the FPU of the
+ *          nRF52 (see NOTE 1 in multilat.c), no DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _MULTILAT_
+#define _MULTILAT_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define MULTILAT_MAX_ANCHORS 8  /* Largest number of ranges used in a solution */
+#define MULTILAT_MAX_ITER    10 /* Gauss-Newton iterations, at most */
+#define MULTILAT_STEP_MM     1  /* Iterations stop once the position moves by less than this */
+#define MULTILAT_BELOW_MM    1000 /* 3D with coplanar anchors: the tag is searched this far below their plane, see NOTE 3 in multilat.c */
+
+#define MULTILAT_NO_RANGE INT32_MIN /* Range of an anchor not measured in this round */
+
+/* Errors of multilat_solve() */
+#define MULTILAT_ERR_ANCHORS  -1 /* Fewer ranges than needed, 3 in 2D, 4 in 3D */
+#define MULTILAT_ERR_GEOMETRY -2 /* The anchors do not define a position, e.g. all on a line */
+
+    typedef struct
+    {
+        uint16_t addr; /* Short address of the anchor */
+        int16_t x_cm;  /* Position, in cm, +/- 327 m */
+        int16_t y_cm;
+        int16_t z_cm;  /* Ignored in 2D */
+    } multilat_anchor_t;
+
+    typedef struct
+    {
+        int32_t x_mm;
+        int32_t y_mm;
+        int32_t z_mm;    /* 0 in 2D */
+        uint32_t rms_mm; /* RMS of the range residuals, see NOTE 2 in multilat.c */
+        uint8_t anchors; /* Ranges used */
+        uint8_t iter;    /* Gauss-Newton iterations done */
+    } multilat_result_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn multilat_find()
+     *
+     * @brief Index of an anchor in the table from its address.
+     *
+     * @param anchors - anchor table
+     * @param n - number of anchors in the table
+     * @param addr - short address
+     *
+     * @return index, or -1 if the address is not in the table
+     */
+    int multilat_find(const multilat_anchor_t *anchors, unsigned int n, uint16_t addr);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn multilat_solve()
+     *
+     * @brief Position of the tag from its ranges to the anchors of the table.
+     *
+     * @param anchors - anchor table
+     * @param range_mm - range to each anchor of the table, MULTILAT_NO_RANGE if not measured
+     * @param n - number of anchors in the table, up to MULTILAT_MAX_ANCHORS are used
+     * @param dim - 2 or 3
+     * @param res - receives the position
+     *
+     * @return 0, or MULTILAT_ERR_ANCHORS or MULTILAT_ERR_GEOMETRY
+     */
+    int multilat_solve(const multilat_anchor_t *anchors, const int32_t *range_mm, unsigned int n, int dim, multilat_result_t *res);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,197 @@
+/*! ----------------------------------------------------------------------------
+ * @file    nlos.c
+ * @brief   Line-of-sight / non-line-of-sight estimation of a received frame
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <nlos.h>
+
+/* All levels are handled in dB with 8 fractional bits (Q8). */
+#define SIG_LVL_THRESHOLD_Q8 (12 * 256) // Threshold is 12 dB; default from experiments and simulations.
+#define SIG_LVL_FACTOR_NUM   2          // Factor between 0 and 1, as a fraction; default 0.4 (2/5) from experiments and simulations.
+#define SIG_LVL_FACTOR_DEN   5
+#define ALPHA_PRF_16_Q8      29133 // Constant A for PRF of 16 MHz (113.8). See User Manual for more information.
+#define ALPHA_PRF_64_Q8      31155 // Constant A for PRF of 64 MHz, plus 1 (120.7 + 1). See User Manual for more information.
+#define LOG_CONSTANT_C0_Q8   16179 // 10log10(2^21) = 63.2    // See User Manual for more information.
+#define LOG_CONSTANT_D0_E0_Q8 13101 // 10log10(2^17) = 51.175  // See User Manual for more information.
+#define DGC_STEP_Q8          (6 * 256) // Each DGC decision step is 6 dB.
+#define IP_MIN_THRESHOLD_X10 (33 * 32) // Minimum index difference (3.3), times 10, index has 5 fractional bits. Please see App Notes "APS006 PART 3"
+#define IP_MAX_THRESHOLD     (6 * 32)  // Maximum index difference (6.0), index has 5 fractional bits. Please see App Notes "APS006 PART 3"
+#define CONSTANT_PR_IP_A     39178 // 0.39178 * 100000, constant from simulations on DW device accumulator, please see App Notes "APS006 PART 3"
+#define CONSTANT_PR_IP_B     131719 // 1.31719 * 100000, constant from simulations on DW device accumulator, please see App Notes "APS006 PART 3"
+
+/* 10 * log10(2) in Q22, to convert a Q16 base 2 logarithm into dB in Q8 */
+#define TEN_LOG10_2_Q22 49321
+
+/* Diagnostics read for each CIR */
+static const dwt_diag_type_e diag_type[NLOS_NUM_CIR] = { IPATOV, STS1, STS2 };
+
+/* log2(1 + i / 32) in Q16, see NOTE 1 below. */
+static const uint16_t log2_lut[33] = { 0, 2909, 5732, 8473, 11136, 13727, 16248, 18704, 21098, 23433, 25711, 27936, 30109, 32234, 34312, 36346,
+    38336, 40286, 42196, 44068, 45904, 47705, 49472, 51207, 52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047, 65535 };
+
+int32_t nlos_10log10_q8(uint64_t x)
+{
+    uint32_t n, idx, rem;
+    int32_t log2_q16;
+
+    n = 63 - __builtin_clzll(x);
+    x <<= 63 - n;
+    idx = (uint32_t)(x >> 58) & 31;
+    rem = (uint32_t)(x >> 42) & 0xFFFF;
+    log2_q16 = (int32_t)(n << 16) + log2_lut[idx] + (int32_t)(((log2_lut[idx + 1] - log2_lut[idx]) * rem) >> 16);
+
+    return (int32_t)(((int64_t)log2_q16 * TEN_LOG10_2_Q22 + (1 << 21)) >> 22);
+}
+
+/* Signal levels of one CIR, returns RSL - FSL in dB Q8 or 0 if the diagnostics are empty. See NOTE 2 below. */
+static int32_t nlos_cir_levels(const nlos_cir_diag_t *cir, int32_t alpha_q8, int32_t log_constant_q8, int16_t *rsl_q8, int16_t *fsl_q8)
+{
+    uint64_t f1 = cir->f1 >> 2, f2 = cir->f2 >> 2, f3 = cir->f3 >> 2;
+    uint64_t fp_power = f1 * f1 + f2 * f2 + f3 * f3;
+    int32_t n_db, cp_db, fp_db, offset;
+
+    if (cir->accum_count == 0 || cir->cir_power == 0 || fp_power == 0)
+    {
+        *rsl_q8 = INT16_MIN;
+        *fsl_q8 = INT16_MIN;
+        return 0;
+    }
+
+    n_db = nlos_10log10_q8((uint64_t)cir->accum_count * cir->accum_count);
+    cp_db = nlos_10log10_q8(cir->cir_power);
+    fp_db = nlos_10log10_q8(fp_power);
+    offset = cir->d * DGC_STEP_Q8 - alpha_q8 - n_db;
+
+    *rsl_q8 = (int16_t)(cp_db + offset + log_constant_q8);
+    *fsl_q8 = (int16_t)(fp_db + offset);
+
+    return cp_db + log_constant_q8 - fp_db;
+}
+
+void nlos_read_input(const dwt_config_t *config, uint32_t dev_id, nlos_input_t *in)
+{
+    dwt_nlos_alldiag_t all_diag;
+    dwt_nlos_ipdiag_t index;
+    uint8_t i;
+
+    /* STS1 only reports when STS is on, STS2 only when PDoA mode 3 is used as well. */
+    if (config->stsMode == DWT_STS_MODE_OFF)
+    {
+        in->num_cir = 1;
+    }
+    else
+    {
+        in->num_cir = (config->pdoaMode == DWT_PDOA_M3) ? 3 : 2;
+    }
+
+    for (i = 0; i < in->num_cir; i++)
+    {
+        all_diag.diag_type = diag_type[i];
+        dwt_nlos_alldiag(&all_diag);
+        in->cir[i].accum_count = all_diag.accumCount;
+        in->cir[i].f1 = all_diag.F1;
+        in->cir[i].f2 = all_diag.F2;
+        in->cir[i].f3 = all_diag.F3;
+        in->cir[i].cir_power = all_diag.cir_power;
+        in->cir[i].d = all_diag.D;
+    }
+
+    dwt_nlos_ipdiag(&index);
+    in->index_fp = index.index_fp_u32;
+    in->index_pp = index.index_pp_u32;
+
+    in->prf64 = (config->rxCode > 8); // For 64 MHz PRF the RX code is 9 and above.
+    in->dw3000 = (dev_id == (uint32_t)DWT_DW3000_DEV_ID) || (dev_id == (uint32_t)DWT_DW3000_PDOA_DEV_ID);
+}
+
+void nlos_evaluate(const nlos_input_t *in, nlos_result_t *res)
+{
+    int32_t log_constant_q8 = in->dw3000 ? LOG_CONSTANT_C0_Q8 : LOG_CONSTANT_D0_E0_Q8;
+    int32_t sl_diff[NLOS_NUM_CIR] = { 0 };
+    int32_t pr, index_diff;
+    uint8_t i;
+
+    for (i = 0; i < NLOS_NUM_CIR; i++)
+    {
+        if (i < in->num_cir)
+        {
+            int32_t alpha_q8 = (i == 0 && !in->prf64) ? ALPHA_PRF_16_Q8 : ALPHA_PRF_64_Q8;
+
+            sl_diff[i] = nlos_cir_levels(&in->cir[i], alpha_q8, log_constant_q8, &res->rsl_q8[i], &res->fsl_q8[i]);
+        }
+        else
+        {
+            res->rsl_q8[i] = INT16_MIN;
+            res->fsl_q8[i] = INT16_MIN;
+        }
+    }
+
+    /* A signal level difference above the threshold in any CIR means NLOS. */
+    for (i = 0; i < NLOS_NUM_CIR; i++)
+    {
+        if (sl_diff[i] > SIG_LVL_THRESHOLD_Q8)
+        {
+            res->prob_pct = 100;
+            return;
+        }
+    }
+
+    /* Above threshold * factor, the probability grows linearly with the difference of the first CIR over it. See NOTE 3 below. */
+    for (i = 0; i < NLOS_NUM_CIR; i++)
+    {
+        if (sl_diff[i] * SIG_LVL_FACTOR_DEN > SIG_LVL_THRESHOLD_Q8 * SIG_LVL_FACTOR_NUM)
+        {
+            pr = (100 * SIG_LVL_FACTOR_DEN * sl_diff[i] - 100 * SIG_LVL_FACTOR_NUM * SIG_LVL_THRESHOLD_Q8
+                     + (SIG_LVL_FACTOR_DEN - SIG_LVL_FACTOR_NUM) * SIG_LVL_THRESHOLD_Q8 / 2)
+                 / ((SIG_LVL_FACTOR_DEN - SIG_LVL_FACTOR_NUM) * SIG_LVL_THRESHOLD_Q8);
+            res->prob_pct = (uint8_t)pr;
+            return;
+        }
+    }
+
+    /* Signal levels are inconclusive, use the Ipatov first path and peak path indexes. See NOTE 4 below. */
+    index_diff = (int32_t)(in->index_pp - in->index_fp);
+    if (index_diff * 10 <= IP_MIN_THRESHOLD_X10)
+    {
+        res->prob_pct = 0;
+    }
+    else if (index_diff >= IP_MAX_THRESHOLD)
+    {
+        res->prob_pct = 100;
+    }
+    else
+    {
+        pr = (CONSTANT_PR_IP_A * index_diff - CONSTANT_PR_IP_B * 32 + 32 * 1000 / 2) / (32 * 1000);
+        res->prob_pct = (pr < 0) ? 0 : (uint8_t)pr;
+    }
+}
+
+uint8_t nlos_probability(const dwt_config_t *config, uint32_t dev_id)
+{
+    nlos_input_t in;
+    nlos_result_t res;
+
+    nlos_read_input(config, dev_id, &in);
+    nlos_evaluate(&in, &res);
+    return res.prob_pct;
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The base 2 logarithm is the position of the most significant bit plus the logarithm of the normalised mantissa, which is interpolated
+ *    linearly between the 33 entries of the table. The error of the interpolation is below 0.0015 in log2, i.e. below 0.005 dB. On a Cortex-M4
+ *    the count leading zeros builtin is a single CLZ instruction, and the complete estimation takes a few hundred cycles (a few microseconds
+ *    at 64 MHz), compared to several calls to the floating point log10() before.
+ * 2. The calculation of First Path Power Level (FSL) and Receive Signal Power Level (RSL) is taken from DW3000 User Manual section 4.7.1 & 4.7.2:
+ *        RSL = 10 * log10(C / N^2) + K - A + 6 * D        FSL = 10 * log10((F1^2 + F2^2 + F3^2) / N^2) - A + 6 * D
+ *    where C is the CIR power, K is 10 * log10(2^21) on DW3000 (10 * log10(2^17) otherwise) and the first path amplitudes F1 to F3 have
+ *    2 fractional bits which are dropped. The number of accumulated symbols N, A and D cancel out in the difference RSL - FSL used to estimate NLOS.
+ * 3. The signal level threshold is 12 dB and the signal level factor 0.4. Between 12 * 0.4 = 4.8 dB and 12 dB the probability is
+ *        100 * (diff / 12 - 0.4) / (1 - 0.4)
+ *    computed with the first of the Ipatov, STS1 and STS2 CIRs above 4.8 dB.
+ * 4. The indexes have 5 fractional bits. An index difference below 3.3 is line of sight, above 6 it is non line of sight and in between the
+ *    probability is 100 * (0.39178 * diff - 1.31719). See App Notes "APS006 PART 3".
+ ****************************************************************************************************************************************************/
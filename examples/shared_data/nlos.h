@@ -0,0 +1,110 @@
+/*! ----------------------------------------------------------------------------
+ * @file    nlos.h
+ * @brief   Line-of-sight / non-line-of-sight estimation of a received frame
+ *
+ *          The first path signal level (FSL), receive signal level (RSL) and the probability of a frame having been received through a
+ *          non-line-of-sight path are derived from the CIR diagnostics as described in the App Notes "APS006 PART 3", see simple_rx_nlos.c
+ *          for a detailed explanation of the method. All computations are done in fixed point, the logarithms with a lookup table, so that
+ *          the estimation can run for every frame, e.g. from an RX callback.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _NLOS_
+#define _NLOS_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <deca_device_api.h>
+#include <stdint.h>
+
+/* Number of CIRs the estimation can use: Ipatov, STS1 and STS2 */
+#define NLOS_NUM_CIR 3
+
+    /* Diagnostics of one CIR, as read with dwt_nlos_alldiag() */
+    typedef struct
+    {
+        uint32_t accum_count; /* Number of preamble/STS symbols accumulated */
+        uint32_t f1;          /* First path amplitudes, 2 fractional bits */
+        uint32_t f2;
+        uint32_t f3;
+        uint32_t cir_power;
+        uint8_t d;            /* DGC decision */
+    } nlos_cir_diag_t;
+
+    /* Integer inputs of the estimation */
+    typedef struct
+    {
+        nlos_cir_diag_t cir[NLOS_NUM_CIR]; /* Ipatov, STS1, STS2 */
+        uint8_t num_cir;                   /* 1 for Ipatov only, 2 when STS is on, 3 with STS in PDoA mode 3 */
+        uint8_t prf64;                     /* Non-zero if the Ipatov preamble uses 64 MHz PRF */
+        uint8_t dw3000;                    /* Non-zero for DW3000 devices, see LOG_CONSTANT_C0 in nlos.c */
+        uint32_t index_fp;                 /* Ipatov first path index, from dwt_nlos_ipdiag() */
+        uint32_t index_pp;                 /* Ipatov peak path index */
+    } nlos_input_t;
+
+    typedef struct
+    {
+        int16_t rsl_q8[NLOS_NUM_CIR]; /* Receive signal level, dBm, Q8 */
+        int16_t fsl_q8[NLOS_NUM_CIR]; /* First path signal level, dBm, Q8 */
+        uint8_t prob_pct;             /* Probability of NLOS, 0 to 100 % */
+    } nlos_result_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn nlos_read_input()
+     *
+     * @brief Read the diagnostics of the last received frame needed by nlos_evaluate(). The CIA diagnostics must have been enabled with
+     *        dwt_configciadiag(DW_CIA_DIAG_LOG_ALL) before the reception.
+     *
+     * @param config - configuration the frame was received with (RX code, STS and PDoA modes are used)
+     * @param dev_id - device ID as returned by dwt_readdevid()
+     * @param in - receives the diagnostics
+     *
+     * @return none
+     */
+    void nlos_read_input(const dwt_config_t *config, uint32_t dev_id, nlos_input_t *in);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn nlos_evaluate()
+     *
+     * @brief Compute the signal levels of every CIR and the probability of NLOS. This function does not access the DW IC.
+     *
+     * @param in - diagnostics of the frame
+     * @param res - receives the signal levels and the probability
+     *
+     * @return none
+     */
+    void nlos_evaluate(const nlos_input_t *in, nlos_result_t *res);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn nlos_probability()
+     *
+     * @brief Estimate the probability that the last received frame came through a non-line-of-sight path, i.e. nlos_read_input()
+     *        followed by nlos_evaluate().
+     *
+     * @param config - configuration the frame was received with
+     * @param dev_id - device ID as returned by dwt_readdevid()
+     *
+     * @return probability of NLOS in percent, between 0 and 100
+     */
+    uint8_t nlos_probability(const dwt_config_t *config, uint32_t dev_id);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn nlos_10log10_q8()
+     *
+     * @brief Fixed-point 10 * log10(x), accurate to better than 0.01 dB.
+     *
+     * @param x - value, must not be 0
+     *
+     * @return 10 * log10(x) in dB, Q8
+     */
+    int32_t nlos_10log10_q8(uint64_t x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,179 @@
+/*! ----------------------------------------------------------------------------
+ * @file    range_filter.c
+ * @brief   Per-peer fixed-point alpha-beta filter of ranging results
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <range_filter.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+extern void test_run_info(unsigned char *data);
+
+void range_filter_init(range_filter_t *rf)
+{
+    memset(rf, 0, sizeof(*rf));
+}
+
+uint8_t range_filter_sts_pct(int16_t sts_qual, uint16_t sts_len)
+{
+    int32_t pct;
+
+    if (sts_qual <= 0 || sts_len == 0)
+    {
+        return 0;
+    }
+
+    pct = (int32_t)sts_qual * 100 / sts_len;
+    return (pct > 100) ? 100 : (uint8_t)pct;
+}
+
+static range_track_t *range_filter_find(range_filter_t *rf, uint16_t peer, uint32_t time_ms)
+{
+    range_track_t *free_trk = NULL;
+    range_track_t *oldest = NULL;
+    int i;
+
+    for (i = 0; i < RANGE_FILTER_MAX_PEERS; i++)
+    {
+        range_track_t *trk = &rf->track[i];
+
+        if (!trk->used)
+        {
+            if (free_trk == NULL)
+            {
+                free_trk = trk;
+            }
+        }
+        else if (trk->peer == peer)
+        {
+            return trk;
+        }
+        else if (oldest == NULL || (time_ms - trk->last_ms) > (time_ms - oldest->last_ms))
+        {
+            oldest = trk;
+        }
+    }
+
+    return (free_trk != NULL) ? free_trk : oldest;
+}
+
+static void range_filter_restart(range_track_t *trk, int32_t range_mm)
+{
+    trk->range_q8 = range_mm * 256;
+    trk->vel_q8 = 0;
+    trk->innov_var = (uint32_t)RANGE_FILTER_MIN_SIGMA_MM * RANGE_FILTER_MIN_SIGMA_MM;
+    trk->rejects = 0;
+}
+
+int range_filter_update(range_filter_t *rf, uint16_t peer, int32_t range_mm, uint32_t time_ms, uint8_t nlos_pct, uint8_t sts_pct,
+    range_filter_out_t *out)
+{
+    range_track_t *trk = range_filter_find(rf, peer, time_ms);
+    uint32_t dt_ms = time_ms - trk->last_ms;
+    uint32_t conf;
+    int32_t pred_q8, innov_q8;
+    uint64_t innov_sq, var;
+    int ret = RANGE_FILTER_ACCEPTED;
+
+    /* Confidence in the measurement, Q8. See NOTE 1 below. */
+    if (nlos_pct > 100)
+    {
+        nlos_pct = 100;
+    }
+    if (sts_pct > 100)
+    {
+        sts_pct = 100;
+    }
+    conf = (uint32_t)(100 - nlos_pct) * sts_pct * 256 / (100 * 100);
+    if (conf < RANGE_FILTER_MIN_CONF)
+    {
+        conf = RANGE_FILTER_MIN_CONF;
+    }
+
+    if (!trk->used || trk->peer != peer || dt_ms > RANGE_FILTER_MAX_DT_MS)
+    {
+        trk->used = 1;
+        trk->peer = peer;
+        range_filter_restart(trk, range_mm);
+        ret = RANGE_FILTER_RESTART;
+    }
+    else
+    {
+        /* Predict with the constant velocity model. */
+        pred_q8 = trk->range_q8 + (int32_t)((int64_t)trk->vel_q8 * dt_ms / 1000);
+        innov_q8 = range_mm * 256 - pred_q8;
+        innov_sq = ((uint64_t)((int64_t)innov_q8 * innov_q8)) >> 16;
+
+        var = trk->innov_var;
+        if (var < (uint64_t)RANGE_FILTER_MIN_SIGMA_MM * RANGE_FILTER_MIN_SIGMA_MM)
+        {
+            var = (uint64_t)RANGE_FILTER_MIN_SIGMA_MM * RANGE_FILTER_MIN_SIGMA_MM;
+        }
+
+        /* Innovation gate, tighter for measurements with a low confidence. See NOTE 2 below. */
+        if (innov_sq * 256 > (uint64_t)(RANGE_FILTER_GATE_SIGMA * RANGE_FILTER_GATE_SIGMA) * var * conf)
+        {
+            trk->range_q8 = pred_q8;
+            if (++trk->rejects >= RANGE_FILTER_MAX_REJECTS)
+            {
+                range_filter_restart(trk, range_mm);
+                ret = RANGE_FILTER_RESTART;
+            }
+            else
+            {
+                ret = RANGE_FILTER_REJECTED;
+            }
+        }
+        else
+        {
+            int32_t alpha = (int32_t)(RANGE_FILTER_ALPHA * conf) >> 8;
+            int32_t beta = (int32_t)(RANGE_FILTER_BETA * conf) >> 8;
+
+            trk->range_q8 = pred_q8 + (int32_t)(((int64_t)alpha * innov_q8) >> 8);
+            if (dt_ms != 0)
+            {
+                trk->vel_q8 += (int32_t)(((int64_t)beta * innov_q8 * 1000 / dt_ms) >> 8);
+            }
+
+            /* Exponential average of the squared innovation with a weight of 1/8. */
+            var = trk->innov_var + ((int64_t)innov_sq - (int64_t)trk->innov_var) / 8;
+            trk->innov_var = (var > UINT32_MAX) ? UINT32_MAX : (uint32_t)var;
+            trk->rejects = 0;
+        }
+    }
+
+    trk->last_ms = time_ms;
+
+    if (out != NULL)
+    {
+        out->range_mm = (trk->range_q8 + 128) >> 8;
+        out->velocity_mm_s = (trk->vel_q8 + 128) >> 8;
+        out->conf = (uint16_t)conf;
+    }
+
+    return ret;
+}
+
+void range_filter_report(uint16_t peer, const range_filter_out_t *out)
+{
+    char str[64];
+
+    snprintf(str, sizeof(str), "FLT %04X r=%ld mm v=%ld mm/s conf=%u", peer, (long)out->range_mm, (long)out->velocity_mm_s,
+        (unsigned)out->conf);
+    test_run_info((unsigned char *)str);
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The confidence scales the alpha and beta gains, so that a measurement likely to be NLOS or received with a poor STS quality moves the
+ *    track less. It is the product of the line-of-sight probability and the STS quality, bounded below by RANGE_FILTER_MIN_CONF so that a peer
+ *    which stays in NLOS is still tracked, only more slowly.
+ * 2. The gate compares the squared innovation with RANGE_FILTER_GATE_SIGMA^2 times the smoothed squared innovation of the accepted measurements,
+ *    scaled by the confidence: the NLOS bias is positive and can be large, so a low confidence measurement is only accepted if it is consistent
+ *    with the track. A rejected measurement does not update the track, which coasts on its prediction. After RANGE_FILTER_MAX_REJECTS rejections
+ *    in a row the track is assumed to be lost (e.g. after a real jump) and is restarted on the measurement.
+ ****************************************************************************************************************************************************/
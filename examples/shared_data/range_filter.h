@@ -0,0 +1,118 @@
+/*! ----------------------------------------------------------------------------
+ * @file    range_filter.h
+ * @brief   Per-peer fixed-point alpha-beta filter of ranging results
+ *
+ *          Tracks range and range rate (velocity) of up to RANGE_FILTER_MAX_PEERS peers with a constant velocity alpha-beta filter.
+ *          Every measurement is weighted by a confidence derived from its NLOS probability and STS quality, and measurements whose
+ *          innovation falls outside a confidence dependent gate are rejected. Integer arithmetic only, no DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _RANGE_FILTER_
+#define _RANGE_FILTER_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define RANGE_FILTER_MAX_PEERS 8 /* Number of peers tracked at the same time, the least recently updated one is replaced when full */
+
+#define RANGE_FILTER_ALPHA 102 /* Range gain, Q8 (0.4) */
+#define RANGE_FILTER_BETA  26  /* Velocity gain, Q8 (0.1) */
+
+#define RANGE_FILTER_GATE_SIGMA    3    /* Innovations beyond this many standard deviations are rejected, see NOTE 2 in range_filter.c */
+#define RANGE_FILTER_MIN_SIGMA_MM  100  /* Lower bound of the innovation standard deviation used for gating */
+#define RANGE_FILTER_MAX_REJECTS   5    /* Consecutive rejections after which the track is restarted on the new measurement */
+#define RANGE_FILTER_MAX_DT_MS     5000 /* Tracks not updated for longer than this are restarted */
+#define RANGE_FILTER_MIN_CONF      32   /* Lower bound of the measurement confidence, Q8 */
+
+/* Return values of range_filter_update() */
+#define RANGE_FILTER_ACCEPTED 0 /* Measurement used to update the track */
+#define RANGE_FILTER_REJECTED 1 /* Measurement gated out, the output is the prediction */
+#define RANGE_FILTER_RESTART  2 /* Track (re)started on the measurement */
+
+    typedef struct
+    {
+        uint16_t peer;      /* Peer address */
+        uint8_t used;
+        uint8_t rejects;    /* Consecutive rejected measurements */
+        uint32_t last_ms;   /* Time of the last update */
+        int32_t range_q8;   /* mm, Q8 */
+        int32_t vel_q8;     /* mm/s, Q8 */
+        uint32_t innov_var; /* Smoothed squared innovation, mm^2 */
+    } range_track_t;
+
+    typedef struct
+    {
+        range_track_t track[RANGE_FILTER_MAX_PEERS];
+    } range_filter_t;
+
+    typedef struct
+    {
+        int32_t range_mm;      /* Filtered range */
+        int32_t velocity_mm_s; /* Filtered range rate, positive when the peer moves away */
+        uint16_t conf;         /* Confidence given to the measurement, Q8 (256 = full) */
+    } range_filter_out_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_filter_init()
+     *
+     * @brief Forget all tracks.
+     *
+     * @param rf - filter state
+     *
+     * @return none
+     */
+    void range_filter_init(range_filter_t *rf);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_filter_sts_pct()
+     *
+     * @brief Convert the STS quality index read with dwt_readstsquality() into a percentage of the ideal value, which is the STS length.
+     *
+     * @param sts_qual - STS quality index
+     * @param sts_len - STS length in symbols, i.e. (1 << (stsLength + 2)) * 8
+     *
+     * @return STS quality between 0 and 100 %
+     */
+    uint8_t range_filter_sts_pct(int16_t sts_qual, uint16_t sts_len);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_filter_update()
+     *
+     * @brief Run one filter step for a peer with a new range measurement. Call it at the ranging rate, once per computed distance.
+     *
+     * @param rf - filter state
+     * @param peer - address of the peer the range was measured to
+     * @param range_mm - measured range in millimetres
+     * @param time_ms - time of the measurement in milliseconds, e.g. port_get_tick_ms()
+     * @param nlos_pct - probability of NLOS of the measurement, 0 to 100 (0 if unknown)
+     * @param sts_pct - STS quality of the measurement, 0 to 100 (100 if STS is not used)
+     * @param out - receives the filtered range and velocity
+     *
+     * @return RANGE_FILTER_ACCEPTED, RANGE_FILTER_REJECTED or RANGE_FILTER_RESTART
+     */
+    int range_filter_update(range_filter_t *rf, uint16_t peer, int32_t range_mm, uint32_t time_ms, uint8_t nlos_pct, uint8_t sts_pct,
+        range_filter_out_t *out);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_filter_report()
+     *
+     * @brief Print the output of the filter for a peer with test_run_info().
+     *
+     * @param peer - address of the peer
+     * @param out - output of range_filter_update()
+     *
+     * @return none
+     */
+    void range_filter_report(uint16_t peer, const range_filter_out_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+/*! ----------------------------------------------------------------------------
+ * @file    range_stats.c
+ * @brief   Constant memory online statistics of ranging results
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <binlog.h>
+#include <math.h>
+#include <range_stats.h>
+#include <stdio.h>
+
+extern void test_run_info(unsigned char *data);
+
+void range_stats_p2_init(p2_quantile_t *p2, float q)
+{
+    p2->q = q;
+    p2->count = 0;
+}
+
+void range_stats_p2_add(p2_quantile_t *p2, float x)
+{
+    int i, k;
+
+    /* The first five samples are kept sorted in the marker heights. */
+    if (p2->count < 5)
+    {
+        for (i = p2->count; i > 0 && p2->h[i - 1] > x; i--)
+        {
+            p2->h[i] = p2->h[i - 1];
+        }
+        p2->h[i] = x;
+
+        if (++p2->count == 5)
+        {
+            for (i = 0; i < 5; i++)
+            {
+                p2->n[i] = i;
+            }
+            p2->np[0] = 0;
+            p2->np[1] = 2 * p2->q;
+            p2->np[2] = 4 * p2->q;
+            p2->np[3] = 2 + 2 * p2->q;
+            p2->np[4] = 4;
+            p2->dn[0] = 0;
+            p2->dn[1] = p2->q / 2;
+            p2->dn[2] = p2->q;
+            p2->dn[3] = (1 + p2->q) / 2;
+            p2->dn[4] = 1;
+        }
+        return;
+    }
+
+    /* Find the cell k the sample falls in, extending the extreme markers if needed. */
+    if (x < p2->h[0])
+    {
+        p2->h[0] = x;
+        k = 0;
+    }
+    else if (x >= p2->h[4])
+    {
+        p2->h[4] = x;
+        k = 3;
+    }
+    else
+    {
+        for (k = 0; k < 3 && x >= p2->h[k + 1]; k++) { };
+    }
+
+    for (i = k + 1; i < 5; i++)
+    {
+        p2->n[i]++;
+    }
+    for (i = 0; i < 5; i++)
+    {
+        p2->np[i] += p2->dn[i];
+    }
+
+    /* Adjust the heights of the three middle markers if they are off their desired position. */
+    for (i = 1; i < 4; i++)
+    {
+        float d = p2->np[i] - p2->n[i];
+
+        if ((d >= 1 && p2->n[i + 1] - p2->n[i] > 1) || (d <= -1 && p2->n[i - 1] - p2->n[i] < -1))
+        {
+            int s = (d >= 0) ? 1 : -1;
+            float hp;
+
+            /* Piecewise parabolic prediction, falling back to linear if it would break the marker ordering. */
+            hp = p2->h[i]
+                 + (float)s / (p2->n[i + 1] - p2->n[i - 1])
+                       * ((p2->n[i] - p2->n[i - 1] + s) * (p2->h[i + 1] - p2->h[i]) / (p2->n[i + 1] - p2->n[i])
+                           + (p2->n[i + 1] - p2->n[i] - s) * (p2->h[i] - p2->h[i - 1]) / (p2->n[i] - p2->n[i - 1]));
+
+            if (p2->h[i - 1] < hp && hp < p2->h[i + 1])
+            {
+                p2->h[i] = hp;
+            }
+            else
+            {
+                p2->h[i] += s * (p2->h[i + s] - p2->h[i]) / (p2->n[i + s] - p2->n[i]);
+            }
+            p2->n[i] += s;
+        }
+    }
+}
+
+int32_t range_stats_quantile_mm(const p2_quantile_t *p2)
+{
+    if (p2->count == 0)
+    {
+        return 0;
+    }
+    if (p2->count < 5)
+    {
+        /* Not initialised yet, pick the nearest of the sorted samples. */
+        return (int32_t)p2->h[(int)(p2->q * (p2->count - 1) + 0.5f)];
+    }
+    return (int32_t)p2->h[2];
+}
+
+void range_stats_init(range_stats_t *stats)
+{
+    stats->count = 0;
+    stats->outliers = 0;
+    stats->mean = 0;
+    stats->m2 = 0;
+    stats->min_mm = INT32_MAX;
+    stats->max_mm = INT32_MIN;
+    range_stats_p2_init(&stats->p50, 0.5f);
+    range_stats_p2_init(&stats->p95, 0.95f);
+}
+
+int range_stats_add(range_stats_t *stats, int32_t dist_mm)
+{
+    float x = (float)dist_mm;
+    float delta = x - stats->mean;
+    int outlier = 0;
+
+    /* Check against the statistics before this sample is included. See NOTE 1 below. */
+    if (stats->count >= RANGE_STATS_OUTLIER_MIN_COUNT
+        && delta * delta > (RANGE_STATS_OUTLIER_SIGMA * RANGE_STATS_OUTLIER_SIGMA) * stats->m2 / (stats->count - 1))
+    {
+        stats->outliers++;
+        outlier = 1;
+    }
+
+    stats->count++;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (x - stats->mean);
+
+    if (dist_mm < stats->min_mm)
+    {
+        stats->min_mm = dist_mm;
+    }
+    if (dist_mm > stats->max_mm)
+    {
+        stats->max_mm = dist_mm;
+    }
+
+    range_stats_p2_add(&stats->p50, x);
+    range_stats_p2_add(&stats->p95, x);
+
+    return outlier;
+}
+
+int32_t range_stats_stddev_mm(const range_stats_t *stats)
+{
+    if (stats->count < 2)
+    {
+        return 0;
+    }
+    return (int32_t)sqrtf(stats->m2 / (stats->count - 1));
+}
+
+void range_stats_report(const range_stats_t *stats)
+{
+    char str[160];
+
+    if (stats->count == 0)
+    {
+        return;
+    }
+
+    snprintf(str, sizeof(str), "RNG n=%lu mean=%ld sd=%ld min=%ld p50=%ld p95=%ld max=%ld out=%lu mm", (unsigned long)stats->count,
+        (long)stats->mean, (long)range_stats_stddev_mm(stats), (long)stats->min_mm, (long)range_stats_quantile_mm(&stats->p50),
+        (long)range_stats_quantile_mm(&stats->p95), (long)stats->max_mm, (unsigned long)stats->outliers);
+    test_run_info((unsigned char *)str);
+}
+
+void range_stats_add_and_report(range_stats_t *stats, double distance)
+{
+    int32_t dist_mm = (int32_t)(distance * 1000);
+
+    BINLOG1(BINLOG_RANGE, dist_mm);
+    range_stats_add(stats, dist_mm);
+
+    if (stats->count % RANGE_STATS_REPORT_PERIOD == 0)
+    {
+        range_stats_report(stats);
+    }
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. Mean and variance are updated with Welford's algorithm which is numerically stable in single precision, so the hardware FPU can be used.
+ *    Outliers are only counted, they are still included in all statistics; median and 95th percentile are not affected much by them anyway.
+ * 2. The P-square algorithm (Jain and Chlamtac, 1985) estimates a quantile with five markers whose heights are adjusted with a piecewise
+ *    parabolic formula as samples arrive. Memory use is constant and the estimate converges without storing any sample.
+ ****************************************************************************************************************************************************/
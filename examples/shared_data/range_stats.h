@@ -0,0 +1,149 @@
+/*! ----------------------------------------------------------------------------
+ * @file    range_stats.h
+ * @brief   Constant memory online statistics of ranging results
+ *
+ *          Keeps count, mean and variance (Welford), min/max, median and 95th percentile (P-square estimators) and an outlier count of a
+ *          stream of distances, without storing the samples. A summary is printed with integer formatting only.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _RANGE_STATS_
+#define _RANGE_STATS_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+/* Number of samples between two summaries printed by range_stats_add_and_report() */
+#define RANGE_STATS_REPORT_PERIOD 50
+
+/* A sample further than this many standard deviations from the running mean is counted as an outlier */
+#define RANGE_STATS_OUTLIER_SIGMA 3
+/* Number of samples needed before outliers are detected */
+#define RANGE_STATS_OUTLIER_MIN_COUNT 10
+
+    /* P-square quantile estimator state, see NOTE 2 in range_stats.c */
+    typedef struct
+    {
+        float q;        /* Quantile to estimate, between 0 and 1 */
+        float h[5];     /* Marker heights */
+        int32_t n[5];   /* Marker positions */
+        float np[5];    /* Desired marker positions */
+        float dn[5];    /* Increments of the desired positions */
+        uint8_t count;  /* Number of samples while initialising (up to 5) */
+    } p2_quantile_t;
+
+    typedef struct
+    {
+        uint32_t count;
+        uint32_t outliers;
+        float mean;     /* mm */
+        float m2;       /* Sum of squared differences from the mean, mm^2 */
+        int32_t min_mm;
+        int32_t max_mm;
+        p2_quantile_t p50;
+        p2_quantile_t p95;
+    } range_stats_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_stats_init()
+     *
+     * @brief Reset the statistics.
+     *
+     * @param stats - statistics state
+     *
+     * @return none
+     */
+    void range_stats_init(range_stats_t *stats);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_stats_add()
+     *
+     * @brief Add one distance sample.
+     *
+     * @param stats - statistics state
+     * @param dist_mm - distance in millimetres
+     *
+     * @return 1 if the sample was counted as an outlier, 0 otherwise
+     */
+    int range_stats_add(range_stats_t *stats, int32_t dist_mm);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_stats_stddev_mm()
+     *
+     * @brief Sample standard deviation of the distances seen so far.
+     *
+     * @param stats - statistics state
+     *
+     * @return standard deviation in millimetres
+     */
+    int32_t range_stats_stddev_mm(const range_stats_t *stats);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_stats_p2_init()
+     *
+     * @brief Reset a P-square quantile estimator. The estimators can also be used on their own, for other quantities than distances.
+     *
+     * @param p2 - estimator
+     * @param q - quantile to estimate, between 0 and 1
+     *
+     * @return none
+     */
+    void range_stats_p2_init(p2_quantile_t *p2, float q);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_stats_p2_add()
+     *
+     * @brief Add one sample to a P-square quantile estimator.
+     *
+     * @param p2 - estimator
+     * @param x - sample
+     *
+     * @return none
+     */
+    void range_stats_p2_add(p2_quantile_t *p2, float x);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_stats_quantile_mm()
+     *
+     * @brief Current estimate of a quantile tracked by a P-square estimator.
+     *
+     * @param p2 - estimator, e.g. &stats->p50
+     *
+     * @return estimate in millimetres
+     */
+    int32_t range_stats_quantile_mm(const p2_quantile_t *p2);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_stats_report()
+     *
+     * @brief Print a one line summary of the statistics with test_run_info().
+     *
+     * @param stats - statistics state
+     *
+     * @return none
+     */
+    void range_stats_report(const range_stats_t *stats);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn range_stats_add_and_report()
+     *
+     * @brief Add a distance sample and print a summary every RANGE_STATS_REPORT_PERIOD samples. This is what the ranging examples call
+     *        for every computed distance instead of printing it.
+     *
+     * @param stats - statistics state
+     * @param distance - distance in metres
+     *
+     * @return none
+     */
+    void range_stats_add_and_report(range_stats_t *stats, double distance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,246 @@
+/*! ----------------------------------------------------------------------------
+ * @file    resp_timing.c
+ * @brief   Response timing service for the delayed TX of ranging responders
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <resp_timing.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+extern void test_run_info(unsigned char *data);
+
+#define DTU_PER_UUS 63898 /* UUS_TO_DWT_TIME */
+
+static uint32_t us_to_uus(uint32_t us)
+{
+    return us * 39 / 40;
+}
+
+static uint16_t round_up_step(uint32_t uus)
+{
+    uus = (uus + RESP_TIMING_STEP_UUS - 1) / RESP_TIMING_STEP_UUS * RESP_TIMING_STEP_UUS;
+    return (uus > 0xFFFF) ? 0xFFFF : (uint16_t)uus;
+}
+
+/* Time from the end of the poll to the opening of the RX window of the initiator for a response delay of 0, see resp_timing_rx_window() */
+static uint32_t rx_window_lead_uus(const struct uwb_phy *phy, uint16_t poll_len)
+{
+    uint32_t poll_air, poll_pre, resp_pre;
+
+    poll_air = us_to_uus(uwb_phy_airtime_us(phy, 0, poll_len, &poll_pre));
+    uwb_phy_airtime_us(phy, 0, 0, &resp_pre);
+    return poll_air - us_to_uus(poll_pre) + us_to_uus(resp_pre) + RESP_TIMING_RX_EARLY_UUS;
+}
+
+/* Latency from the poll RMARKER to a system time read */
+static uint32_t latency_uus(uint32_t poll_rx_ts, uint32_t sys_time_hi32)
+{
+    return ((sys_time_hi32 << 8) - poll_rx_ts) / DTU_PER_UUS;
+}
+
+void resp_timing_init(resp_timing_t *rt, const struct uwb_phy *phy, uint16_t poll_len)
+{
+    uint32_t preamble_us;
+
+    memset(rt, 0, sizeof(*rt));
+    uwb_phy_airtime_us(phy, 0, 0, &preamble_us);
+    rt->lead_uus = (uint16_t)(us_to_uus(preamble_us) + RESP_TIMING_SETUP_UUS);
+
+    /* Never below the opening of the fixed RX window of the initiators. See NOTE 3 below. */
+    rt->min_uus = round_up_step(RESP_TIMING_RX_DLY_UUS + rx_window_lead_uus(phy, poll_len));
+    if (rt->min_uus < RESP_TIMING_MIN_UUS)
+    {
+        rt->min_uus = RESP_TIMING_MIN_UUS;
+    }
+    rt->delay_uus = (RESP_TIMING_INIT_UUS > rt->min_uus) ? RESP_TIMING_INIT_UUS : rt->min_uus;
+}
+
+uint32_t resp_timing_tx_time(uint64_t poll_rx_ts, uint16_t delay_uus)
+{
+    return (uint32_t)((poll_rx_ts + (uint64_t)delay_uus * DTU_PER_UUS) >> 8);
+}
+
+void resp_timing_started(resp_timing_t *rt, uint32_t poll_rx_ts, uint32_t sys_time_hi32, int late)
+{
+    uint32_t lat = latency_uus(poll_rx_ts, sys_time_hi32);
+    uint32_t lat_q4 = lat << 4, need;
+    int32_t dev_q4;
+    uint16_t target, prev = rt->delay_uus;
+
+    /* Average and average deviation of the latency, and largest latency of the window. See NOTE 1 below. */
+    if (rt->responses == 0 && rt->late == 0)
+    {
+        rt->lat_q4 = lat_q4;
+        rt->lat_dev_q4 = lat_q4 / 4;
+    }
+    else
+    {
+        dev_q4 = (int32_t)(lat_q4 - rt->lat_q4);
+        rt->lat_q4 = (uint32_t)((int32_t)rt->lat_q4 + dev_q4 / 8);
+        if (dev_q4 < 0)
+        {
+            dev_q4 = -dev_q4;
+        }
+        rt->lat_dev_q4 = (uint32_t)((int32_t)rt->lat_dev_q4 + (dev_q4 - (int32_t)rt->lat_dev_q4) / 8);
+    }
+    if (lat > rt->win_max_uus)
+    {
+        rt->win_max_uus = (lat > 0xFFFF) ? 0xFFFF : (uint16_t)lat;
+    }
+    if (rt->win_max_uus > rt->lat_max_uus)
+    {
+        rt->lat_max_uus = rt->win_max_uus;
+    }
+
+    if (late)
+    {
+        /* Late anyway: raise the delay at once and start a new window. */
+        rt->late++;
+        rt->delay_uus += RESP_TIMING_LATE_UUS;
+        rt->win_late = 1;
+    }
+    else
+    {
+        rt->responses++;
+    }
+
+    /* Delay needed by the latency seen recently */
+    need = (rt->lat_q4 + RESP_TIMING_DEV_MULT * rt->lat_dev_q4) >> 4;
+    if (rt->win_prev_uus > need)
+    {
+        need = rt->win_prev_uus;
+    }
+    if (rt->win_max_uus > need)
+    {
+        need = rt->win_max_uus;
+    }
+    target = round_up_step(need + rt->lead_uus + RESP_TIMING_MARGIN_UUS);
+
+    /* Raise at once, lower only after a full window without late TX */
+    if (target > rt->delay_uus)
+    {
+        rt->delay_uus = target;
+    }
+    if (++rt->win_count >= RESP_TIMING_WINDOW)
+    {
+        if (!rt->win_late && target < rt->delay_uus)
+        {
+            rt->delay_uus = target;
+        }
+        rt->win_prev_uus = rt->win_max_uus;
+        rt->win_max_uus = 0;
+        rt->win_count = 0;
+        rt->win_late = 0;
+    }
+
+    /* Each change stays within the RX window the initiator placed from the previous delay. See NOTE 3 below. */
+    if (rt->delay_uus > prev + RESP_TIMING_SPAN_UUS)
+    {
+        rt->delay_uus = prev + RESP_TIMING_SPAN_UUS;
+    }
+    else if (rt->delay_uus + RESP_TIMING_DOWN_UUS < prev)
+    {
+        rt->delay_uus = prev - RESP_TIMING_DOWN_UUS;
+    }
+
+    if (rt->delay_uus < rt->min_uus)
+    {
+        rt->delay_uus = rt->min_uus;
+    }
+    if (rt->delay_uus > RESP_TIMING_MAX_UUS)
+    {
+        rt->delay_uus = RESP_TIMING_MAX_UUS;
+    }
+}
+
+uint16_t resp_timing_retry(resp_timing_t *rt, uint32_t poll_rx_ts, uint32_t sys_time_hi32, uint16_t last_uus)
+{
+    uint16_t next;
+
+    /* The next point of the grid which can still be reached. See NOTE 2 below. */
+    next = round_up_step(latency_uus(poll_rx_ts, sys_time_hi32) + RESP_TIMING_RETRY_UUS + rt->lead_uus);
+    if (next <= last_uus)
+    {
+        next = last_uus + RESP_TIMING_STEP_UUS;
+    }
+    if (next > last_uus + RESP_TIMING_SPAN_UUS)
+    {
+        rt->dropped++;
+        return 0;
+    }
+    rt->retried++;
+    return next;
+}
+
+void resp_timing_set_field(uint8_t *field, uint16_t delay_uus)
+{
+    field[0] = (uint8_t)delay_uus;
+    field[1] = (uint8_t)(delay_uus >> 8);
+}
+
+uint16_t resp_timing_get_field(const uint8_t *field)
+{
+    return (uint16_t)(field[0] | ((uint16_t)field[1] << 8));
+}
+
+void resp_timing_rx_window(uint16_t delay_uus, const struct uwb_phy *phy, uint16_t poll_len, uint16_t resp_len, uint32_t *rx_after_tx_uus,
+    uint32_t *rx_timeout_uus)
+{
+    uint32_t resp_air, after;
+
+    resp_air = us_to_uus(uwb_phy_airtime_us(phy, 0, resp_len, NULL));
+
+    /* The RX after TX delay runs from the end of the poll, the delay of the responder from the poll RMARKER to the response RMARKER. */
+    after = rx_window_lead_uus(phy, poll_len);
+    *rx_after_tx_uus = (delay_uus > after) ? delay_uus - after : 0;
+    *rx_timeout_uus = RESP_TIMING_RX_EARLY_UUS + resp_air + RESP_TIMING_SPAN_UUS + RESP_TIMING_RX_MARGIN_UUS;
+}
+
+void resp_timing_rx_fallback(const struct uwb_phy *phy, uint16_t poll_len, uint16_t resp_len, uint32_t *rx_after_tx_uus,
+    uint32_t *rx_timeout_uus)
+{
+    uint32_t max_after_tx;
+
+    /* From the opening of the fixed window to the end of the window of the largest delay */
+    resp_timing_rx_window(RESP_TIMING_MAX_UUS, phy, poll_len, resp_len, &max_after_tx, rx_timeout_uus);
+    *rx_after_tx_uus = RESP_TIMING_RX_DLY_UUS;
+    if (max_after_tx > RESP_TIMING_RX_DLY_UUS)
+    {
+        *rx_timeout_uus += max_after_tx - RESP_TIMING_RX_DLY_UUS;
+    }
+}
+
+void resp_timing_report(const resp_timing_t *rt)
+{
+    char str[144];
+
+    snprintf(str, sizeof(str), "RESP dly=%u uus lat avg=%lu dev=%lu max=%u uus n=%lu late=%lu retried=%lu dropped=%lu", rt->delay_uus,
+        (unsigned long)(rt->lat_q4 >> 4), (unsigned long)(rt->lat_dev_q4 >> 4), rt->lat_max_uus, (unsigned long)rt->responses,
+        (unsigned long)rt->late, (unsigned long)rt->retried, (unsigned long)rt->dropped);
+    test_run_info((unsigned char *)str);
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The latency runs from the poll RMARKER to the call of dwt_starttx(): the end of the poll, the status polling or the interrupt, the reading
+ *    and checking of the poll and the writing of the response. It is measured with the system time of the DW IC read just before
+ *    dwt_starttx(), so in the same time base as the TX time. The delayed TX time is the RMARKER of the response, which follows the start of the
+ *    TX by its preamble, hence the lead. The delay allows for the average latency plus RESP_TIMING_DEV_MULT average deviations, or for the
+ *    largest latency of the current and previous windows if larger, plus a margin. It is raised as soon as a latency needs it and lowered
+ *    only at the end of a window without late TX, so that a single fast exchange does not shorten it.
+ * 2. A late TX (HPDWARN) means that the latency was longer than ever seen, e.g. a higher priority interrupt. The delay is raised, and the
+ *    response is programmed again for the next point of the delay grid that can still be reached, with the new TX timestamp. The initiator
+ *    keeps its receiver on for RESP_TIMING_SPAN_UUS more than the chosen delay (see resp_timing_rx_window()), so the retries stay within
+ *    this span, beyond it the response is dropped as before.
+ * 3. The initiator learns the delay only from the responses it receives, so a change of the delay must not take the next response out of the
+ *    RX window placed from the previous delay: a raise is limited to RESP_TIMING_SPAN_UUS, which the window covers after the delay, and a
+ *    lowering to RESP_TIMING_DOWN_UUS, within the RESP_TIMING_RX_EARLY_UUS the window opens before it. A long delay after a latency outlier
+ *    thus comes down over a few windows. The delay never goes below min_uus, the opening of the fixed window (RESP_TIMING_RX_DLY_UUS after
+ *    the poll) with which the initiators start. An initiator which misses RESP_TIMING_FALLBACK_MISSES responses in a row anyway (lost
+ *    frames, responder restarted) goes back to the wide window of resp_timing_rx_fallback(), from this opening to the largest delay, and
+ *    places its window again from the next response it receives.
+ ****************************************************************************************************************************************************/
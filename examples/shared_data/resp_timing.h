@@ -0,0 +1,194 @@
+/*! ----------------------------------------------------------------------------
+ * @file    resp_timing.h
+ * @brief   Response timing service for the delayed TX of ranging responders
+ *
+ *          Chooses the delay between the reception of a poll and the transmission of the response of a responder. The software latency from
+ *          the poll RMARKER to the call of dwt_starttx() is measured on each exchange with the system time of the DW IC, and the delay is the
+ *          smallest one which leaves room for the latency seen recently, the preamble of the response and a margin. When the delayed TX is
+ *          late anyway (HPDWARN), the response is sent again at the next feasible time on the grid of RESP_TIMING_STEP_UUS instead of being
+ *          dropped, as long as it stays in the RX window of the initiator. The delay is sent in the response so that the initiator can place
+ *          its RX window, see resp_timing_rx_window(). Each change of the delay stays within the RX window placed from the previous one, and
+ *          the delay never goes below the opening of the fixed RX window the initiators start with, so an initiator which misses responses
+ *          can find the responder again with resp_timing_rx_fallback(). No DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _RESP_TIMING_
+#define _RESP_TIMING_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <uwb_phy.h>
+
+#define RESP_TIMING_INIT_UUS     650 /* Delay used until the latency is known, the fixed delay of the SS TWR examples */
+#define RESP_TIMING_MIN_UUS      200 /* Bounds of the delay */
+#define RESP_TIMING_MAX_UUS      2000
+#define RESP_TIMING_STEP_UUS     10  /* Grid of the delays, and of the retries */
+#define RESP_TIMING_SETUP_UUS    10  /* Time from dwt_starttx() to the start of the preamble */
+#define RESP_TIMING_MARGIN_UUS   20  /* Margin on the latency */
+#define RESP_TIMING_RETRY_UUS    30  /* Time to program the response again after a late TX */
+#define RESP_TIMING_SPAN_UUS     100 /* Retries are possible up to this much after the chosen delay, see NOTE 2 in resp_timing.c */
+#define RESP_TIMING_DEV_MULT     4   /* The latency allowed for is the average plus this many average deviations... */
+#define RESP_TIMING_WINDOW       32  /* ...or the largest latency of the last window of this many exchanges */
+#define RESP_TIMING_LATE_UUS     40  /* Raise of the delay after a late TX */
+#define RESP_TIMING_RX_EARLY_UUS 50  /* The initiator enables its receiver this much before the expected preamble */
+#define RESP_TIMING_RX_MARGIN_UUS 50 /* RX timeout margin after the end of the response */
+#define RESP_TIMING_DOWN_UUS     30  /* Largest lowering of the delay at a time, less than RESP_TIMING_RX_EARLY_UUS */
+#define RESP_TIMING_RX_DLY_UUS   240 /* RX after TX delay of the initiators before they know the delay (POLL_TX_TO_RESP_RX_DLY_UUS) */
+#define RESP_TIMING_FALLBACK_MISSES 3 /* Exchanges without response after which the initiator falls back to its wide RX window */
+
+#define RESP_TIMING_FIELD_LEN 2 /* Length of the delay field of the response */
+
+    typedef struct
+    {
+        uint16_t lead_uus;  /* Preamble of the response and TX setup, from dwt_starttx() to the RMARKER */
+        uint16_t delay_uus; /* Chosen delay, poll RMARKER to response RMARKER */
+        uint16_t min_uus;   /* Smallest delay, the opening of the RX window of an initiator with RESP_TIMING_RX_DLY_UUS */
+
+        /* Latency from the poll RMARKER to dwt_starttx(), in UUS Q4 */
+        uint32_t lat_q4;
+        uint32_t lat_dev_q4;
+        uint16_t win_max_uus; /* Largest latency of the current window */
+        uint16_t win_prev_uus; /* Largest latency of the previous window */
+        uint8_t win_count;
+        uint8_t win_late;
+
+        /* Counters */
+        uint32_t responses;
+        uint32_t late;    /* Late delayed TX, retried or not */
+        uint32_t retried; /* Responses sent by a retry */
+        uint32_t dropped; /* Responses given up, the retry being out of the RX window of the initiator */
+        uint16_t lat_max_uus;
+    } resp_timing_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn resp_timing_init()
+     *
+     * @brief Start with RESP_TIMING_INIT_UUS until latencies are measured.
+     *
+     * @param rt - service state
+     * @param phy - air interface of the poll and response
+     * @param poll_len - length of the poll, including the FCS
+     *
+     * @return none
+     */
+    void resp_timing_init(resp_timing_t *rt, const struct uwb_phy *phy, uint16_t poll_len);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn resp_timing_tx_time()
+     *
+     * @brief Delayed TX time of a response.
+     *
+     * @param poll_rx_ts - poll RX timestamp (40 bits)
+     * @param delay_uus - delay of the response
+     *
+     * @return time for dwt_setdelayedtrxtime()
+     */
+    uint32_t resp_timing_tx_time(uint64_t poll_rx_ts, uint16_t delay_uus);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn resp_timing_started()
+     *
+     * @brief Account the start of a delayed TX: measure the latency and adapt the delay, see NOTE 1 in resp_timing.c.
+     *
+     * @param rt - service state
+     * @param poll_rx_ts - low 32 bits of the poll RX timestamp
+     * @param sys_time_hi32 - system time read just before dwt_starttx(), dwt_readsystimestamphi32()
+     * @param late - 1 if dwt_starttx() failed, the TX time having passed
+     *
+     * @return none
+     */
+    void resp_timing_started(resp_timing_t *rt, uint32_t poll_rx_ts, uint32_t sys_time_hi32, int late);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn resp_timing_retry()
+     *
+     * @brief Next feasible delay after a late TX, see NOTE 2 in resp_timing.c.
+     *
+     * @param rt - service state
+     * @param poll_rx_ts - low 32 bits of the poll RX timestamp
+     * @param sys_time_hi32 - system time of the DW IC, dwt_readsystimestamphi32()
+     * @param last_uus - delay of the late attempt
+     *
+     * @return the delay to try, 0 if the response has to be dropped
+     */
+    uint16_t resp_timing_retry(resp_timing_t *rt, uint32_t poll_rx_ts, uint32_t sys_time_hi32, uint16_t last_uus);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn resp_timing_set_field()
+     *
+     * @brief Write a delay into the delay field of a response (little endian).
+     *
+     * @param field - delay field of the response, RESP_TIMING_FIELD_LEN bytes
+     * @param delay_uus - delay
+     *
+     * @return none
+     */
+    void resp_timing_set_field(uint8_t *field, uint16_t delay_uus);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn resp_timing_get_field()
+     *
+     * @brief Read the delay field of a response.
+     *
+     * @param field - delay field of the response, RESP_TIMING_FIELD_LEN bytes
+     *
+     * @return delay in UUS
+     */
+    uint16_t resp_timing_get_field(const uint8_t *field);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn resp_timing_rx_window()
+     *
+     * @brief RX window of the initiator for the response to its poll, covering the retries of the responder.
+     *
+     * @param delay_uus - delay of the responder, from the delay field of its last response
+     * @param phy - air interface of the poll and response
+     * @param poll_len - length of the poll, including the FCS
+     * @param resp_len - length of the response, including the FCS
+     * @param rx_after_tx_uus - receives the delay for dwt_setrxaftertxdelay()
+     * @param rx_timeout_uus - receives the timeout for dwt_setrxtimeout()
+     *
+     * @return none
+     */
+    void resp_timing_rx_window(uint16_t delay_uus, const struct uwb_phy *phy, uint16_t poll_len, uint16_t resp_len, uint32_t *rx_after_tx_uus,
+        uint32_t *rx_timeout_uus);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn resp_timing_rx_fallback()
+     *
+     * @brief Wide RX window of the initiator, covering every delay a responder can use, from its smallest one to RESP_TIMING_MAX_UUS and the
+     *        retries after it. For an initiator which missed RESP_TIMING_FALLBACK_MISSES responses in a row, see NOTE 3 in resp_timing.c.
+     *
+     * @param phy - air interface of the poll and response
+     * @param poll_len - length of the poll, including the FCS
+     * @param resp_len - length of the response, including the FCS
+     * @param rx_after_tx_uus - receives the delay for dwt_setrxaftertxdelay(), RESP_TIMING_RX_DLY_UUS
+     * @param rx_timeout_uus - receives the timeout for dwt_setrxtimeout()
+     *
+     * @return none
+     */
+    void resp_timing_rx_fallback(const struct uwb_phy *phy, uint16_t poll_len, uint16_t resp_len, uint32_t *rx_after_tx_uus,
+        uint32_t *rx_timeout_uus);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn resp_timing_report()
+     *
+     * @brief Print the delay, the latency statistics and the counters with test_run_info().
+     *
+     * @param rt - service state
+     *
+     * @return none
+     */
+    void resp_timing_report(const resp_timing_t *rt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
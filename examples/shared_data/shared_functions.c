@@ -13,10 +13,13 @@
 #include <config_options.h>
 #include <deca_device_api.h>
 #include <deca_types.h>
+#include <dw_dev.h>
 #include <port.h>
+#include <prof.h>
 #include <shared_defines.h>
 #include <shared_functions.h>
 #include <stdlib.h>
+#include <telem.h>
 
 extern dwt_config_t config_options;
 
@@ -146,108 +149,113 @@ uint8_t calculate_power_boost(uint16_t frame_duration_us)
 /*! ------------------------------------------------------------------------------------------------------------------
  * @fn check_for_status_errors()
  *
- * @brief This function is used to get a value to increase the delay timer by dependent on the current TX preamble length set.
+ * @brief This function counts the errors flagged in a status register value, in the error counters of the telemetry (see telem.h).
+ *        The counters are exported periodically and can be read with telem_get().
  *
  * @param reg: uint32_t value representing the current status register value.
- * @param errors: pointer to a uint32_t buffer that contains the sum of different errors logged during program operation.
  *
  * @return none
  */
-void check_for_status_errors(uint32_t reg, uint32_t *errors)
+void check_for_status_errors(uint32_t reg)
 {
     uint16_t stsStatus = 0;
 
     if (!(reg & DWT_INT_RXFCG_BIT_MASK))
     {
-        errors[BAD_FRAME_ERR_IDX] += 1;
+        telem_inc(BAD_FRAME_ERR_IDX);
     }
 
     if (reg & DWT_INT_RXFSL_BIT_MASK)
     {
-        errors[RSE_ERR_IDX] += 1;
+        telem_inc(RSE_ERR_IDX);
     }
 
     if (reg & DWT_INT_RXPHE_BIT_MASK)
     {
-        errors[PHE_ERR_IDX] += 1;
+        telem_inc(PHE_ERR_IDX);
     }
 
     if (reg & DWT_INT_RXPTO_BIT_MASK)
     {
-        errors[PTO_ERR_IDX] += 1;
+        telem_inc(PTO_ERR_IDX);
     }
 
     if (reg & DWT_INT_ARFE_BIT_MASK)
     {
-        errors[ARFE_ERR_IDX] += 1;
+        telem_inc(ARFE_ERR_IDX);
     }
 
     if ((reg & DWT_INT_RXFR_BIT_MASK) && !(reg & DWT_INT_RXFCG_BIT_MASK))
     {
-        errors[CRC_ERR_IDX] += 1;
+        telem_inc(CRC_ERR_IDX);
     }
 
     if ((reg & DWT_INT_RXFTO_BIT_MASK) || (reg & SYS_STATUS_ALL_RX_TO))
     {
-        errors[RTO_ERR_IDX] += 1;
+        telem_inc(RTO_ERR_IDX);
     }
 
     if (reg & DWT_INT_RXSTO_BIT_MASK)
     {
-        errors[SFDTO_ERR_IDX] += 1;
+        telem_inc(SFDTO_ERR_IDX);
+    }
+
+    if (reg & DWT_INT_SPICRCE_BIT_MASK)
+    {
+        telem_inc(SPICRC_ERR_IDX);
     }
 
     if (reg & DWT_INT_CPERR_BIT_MASK)
     {
         // There is a general STS error
-        errors[STS_PREAMBLE_ERR] += 1;
+        telem_inc(STS_PREAMBLE_ERR);
 
         // Get the status for a more detailed error reading of what went wrong with the STS
         dwt_readstsstatus(&stsStatus, 0);
         if (stsStatus & 0x100)
         {
             // Peak growth rate warning
-            errors[STS_PEAK_GROWTH_RATE_ERR] += 1;
+            telem_inc(STS_PEAK_GROWTH_RATE_ERR);
         }
         if (stsStatus & 0x080)
         {
             // ADC count warning
-            errors[STS_ADC_COUNT_ERR] += 1;
+            telem_inc(STS_ADC_COUNT_ERR);
         }
         if (stsStatus & 0x040)
         {
             // SFD count warning
-            errors[STS_SFD_COUNT_ERR] += 1;
+            telem_inc(STS_SFD_COUNT_ERR);
         }
         if (stsStatus & 0x020)
         {
             // Late first path estimation
-            errors[STS_LATE_FIRST_PATH_ERR] += 1;
+            telem_inc(STS_LATE_FIRST_PATH_ERR);
         }
         if (stsStatus & 0x010)
         {
             // Late coarse estimation
-            errors[STS_LATE_COARSE_EST_ERR] += 1;
+            telem_inc(STS_LATE_COARSE_EST_ERR);
         }
         if (stsStatus & 0x008)
         {
             // Coarse estimation empty
-            errors[STS_COARSE_EST_EMPTY_ERR] += 1;
+            telem_inc(STS_COARSE_EST_EMPTY_ERR);
         }
         if (stsStatus & 0x004)
         {
             // High noise threshold
-            errors[STS_HIGH_NOISE_THREASH_ERR] += 1;
+            telem_inc(STS_HIGH_NOISE_THREASH_ERR);
         }
         if (stsStatus & 0x002)
         {
             // Non-triangle
-            errors[STS_NON_TRIANGLE_ERR] += 1;
+            telem_inc(STS_NON_TRIANGLE_ERR);
         }
         if (stsStatus & 0x001)
         {
             // Logistic regression failed
-            errors[STS_LOG_REG_FAILED_ERR] += 1;
+            telem_inc(STS_LOG_REG_FAILED_ERR);
         }
     }
 }
@@ -457,12 +465,14 @@ uint64_t get_tx_timestamp_u64(void)
     uint8_t ts_tab[5];
     uint64_t ts = 0;
     int8_t i;
+    PROF_START(PROF_READ_TS);
     dwt_readtxtimestamp(ts_tab);
     for (i = 4; i >= 0; i--)
     {
         ts <<= 8;
         ts |= ts_tab[i];
     }
+    PROF_STOP(PROF_READ_TS);
     return ts;
 }
 
@@ -481,12 +491,14 @@ uint64_t get_rx_timestamp_u64(void)
     uint8_t ts_tab[5];
     uint64_t ts = 0;
     int8_t i;
+    PROF_START(PROF_READ_TS);
     dwt_readrxtimestamp(ts_tab);
     for (i = 4; i >= 0; i--)
     {
         ts <<= 8;
         ts |= ts_tab[i];
     }
+    PROF_STOP(PROF_READ_TS);
     return ts;
 }
 
@@ -590,6 +602,7 @@ void waitforsysstatus(uint32_t *lo_result, uint32_t *hi_result, uint32_t lo_mask
 {
     uint32_t lo_result_tmp = 0;
     uint32_t hi_result_tmp = 0;
+    PROF_START(PROF_WAIT_STATUS);
 
     // If a mask has been passed into the function for the system status register (lower 32-bits)
     if (lo_mask)
@@ -622,4 +635,93 @@ void waitforsysstatus(uint32_t *lo_result, uint32_t *hi_result, uint32_t lo_mask
     {
         *hi_result = hi_result_tmp;
     }
+
+    PROF_STOP(PROF_WAIT_STATUS);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn get_tx_timestamp_u64_dev()
+ *
+ * @brief As get_tx_timestamp_u64(), for one of several DW ICs.
+ *
+ * @param  dev  device to read
+ *
+ * @return  64-bit value of the read time-stamp.
+ */
+uint64_t get_tx_timestamp_u64_dev(struct dw_dev *dev)
+{
+    uint64_t ts;
+
+    dw_dev_lock(dev);
+    ts = get_tx_timestamp_u64();
+    dw_dev_unlock(dev);
+    return ts;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn get_rx_timestamp_u64_dev()
+ *
+ * @brief As get_rx_timestamp_u64(), for one of several DW ICs.
+ *
+ * @param  dev  device to read
+ *
+ * @return  64-bit value of the read time-stamp.
+ */
+uint64_t get_rx_timestamp_u64_dev(struct dw_dev *dev)
+{
+    uint64_t ts;
+
+    dw_dev_lock(dev);
+    ts = get_rx_timestamp_u64();
+    dw_dev_unlock(dev);
+    return ts;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn waitforsysstatus_dev()
+ *
+ * @brief As waitforsysstatus(), for one of several DW ICs, yielding between the reads of the status register.
+ *
+ * @param  dev        device to wait for
+ * @param  lo_result  receives the low 32 bits of the status register, may be NULL
+ * @param  hi_result  receives the high 32 bits of the status register, may be NULL
+ * @param  lo_mask    events of the low 32 bits to wait for
+ * @param  hi_mask    events of the high 32 bits to wait for
+ *
+ * @return  none
+ */
+void waitforsysstatus_dev(struct dw_dev *dev, uint32_t *lo_result, uint32_t *hi_result, uint32_t lo_mask, uint32_t hi_mask)
+{
+    uint32_t lo_result_tmp = 0;
+    uint32_t hi_result_tmp = 0;
+
+    while (1)
+    {
+        dw_dev_lock(dev);
+        if (lo_mask)
+        {
+            lo_result_tmp = dwt_readsysstatuslo();
+        }
+        if (hi_mask)
+        {
+            hi_result_tmp = dwt_readsysstatushi();
+        }
+        dw_dev_unlock(dev);
+
+        if ((lo_result_tmp & lo_mask) || (hi_result_tmp & hi_mask) || (!lo_mask && !hi_mask))
+        {
+            break;
+        }
+        port_yield();
+    }
+
+    if (lo_result != NULL)
+    {
+        *lo_result = lo_result_tmp;
+    }
+
+    if (hi_result != NULL)
+    {
+        *hi_result = hi_result_tmp;
+    }
 }
@@ -35,14 +35,14 @@ extern "C"
     /*! ------------------------------------------------------------------------------------------------------------------
      * @fn check_for_status_errors()
      *
-     * @brief This function is used to get a value to increase the delay timer by dependent on the current TX preamble length set.
+     * @brief This function counts the errors flagged in a status register value, in the error counters of the telemetry (see telem.h).
+     *        The counters are exported periodically and can be read with telem_get().
      *
      * @param reg: uint32_t value representing the current status register value.
-     * @param errors: pointer to a uint32_t buffer that contains the sum of different errors logged during program operation.
      *
      * @return none
      */
-    void check_for_status_errors(uint32_t reg, uint32_t *errors);
+    void check_for_status_errors(uint32_t reg);
 
     /*! ------------------------------------------------------------------------------------------------------------------
      * @fn get_rx_delay_time_txpreamble()
@@ -204,6 +204,44 @@ extern "C"
      */
     void waitforsysstatus(uint32_t *lo_result, uint32_t *hi_result, uint32_t lo_mask, uint32_t hi_mask);
 
+    /* Device of the platform when the MCU drives several DW ICs, see dw_dev.h */
+    struct dw_dev;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn get_tx_timestamp_u64_dev()
+     *
+     * @brief As get_tx_timestamp_u64(), for one of several DW ICs.
+     *
+     * @param  dev  device to read
+     *
+     * @return  64-bit value of the read time-stamp.
+     */
+    uint64_t get_tx_timestamp_u64_dev(struct dw_dev *dev);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn get_rx_timestamp_u64_dev()
+     *
+     * @brief As get_rx_timestamp_u64(), for one of several DW ICs.
+     *
+     * @param  dev  device to read
+     *
+     * @return  64-bit value of the read time-stamp.
+     */
+    uint64_t get_rx_timestamp_u64_dev(struct dw_dev *dev);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn waitforsysstatus_dev()
+     *
+     * @brief As waitforsysstatus(), for one of several DW ICs. The device is locked for each read of the status register only, and the thread
+     *        yields between the reads, so that the other devices are served while it waits.
+     *
+     * @param dev - device to wait for
+     * @param lo_result, hi_result, lo_mask, hi_mask - see waitforsysstatus()
+     *
+     * return None
+     */
+    void waitforsysstatus_dev(struct dw_dev *dev, uint32_t *lo_result, uint32_t *hi_result, uint32_t lo_mask, uint32_t hi_mask);
+
 #ifdef __cplusplus
 }
 #endif
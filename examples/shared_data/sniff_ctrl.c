@@ -0,0 +1,188 @@
+/*! ----------------------------------------------------------------------------
+ * @file    sniff_ctrl.c
+ * @brief   Adaptive SNIFF mode controller for responders and anchors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <sniff_ctrl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+extern void test_run_info(unsigned char *data);
+
+void sniff_ctrl_init(sniff_ctrl_t *sc, const struct uwb_phy *phy)
+{
+    memset(sc, 0, sizeof(*sc));
+    sc->phy = *phy;
+    sc->on = 1;
+    sc->off = sniff_ctrl_max_off(phy, sc->on);
+    sc->enabled = (sc->off != 0);
+    sc->duty_permille = 1000;
+}
+
+uint8_t sniff_ctrl_max_off(const struct uwb_phy *phy, uint8_t on)
+{
+    uint32_t on_sym = (uint32_t)(on + 1) * phy->pac;
+    uint32_t need = 2 * on_sym + SNIFF_CTRL_ACQ_SYMBOLS + SNIFF_CTRL_MARGIN_SYMBOLS;
+    uint32_t off;
+
+    /* See NOTE 1 below. */
+    if (phy->plen <= need)
+    {
+        return 0;
+    }
+    off = (phy->plen - need) * uwb_phy_symbol_ns(phy) / UWB_PHY_SNIFF_OFF_NS;
+    return (off > SNIFF_CTRL_MAX_OFF) ? SNIFF_CTRL_MAX_OFF : (uint8_t)off;
+}
+
+void sniff_ctrl_rx_ok(sniff_ctrl_t *sc, uint16_t len)
+{
+    sc->rx_frames++;
+    sc->acq_frames++;
+    sc->rx_us += uwb_phy_airtime_us(&sc->phy, 0, len, NULL);
+}
+
+void sniff_ctrl_rx_err(sniff_ctrl_t *sc, int acq)
+{
+    sc->rx_errors++;
+    if (acq)
+    {
+        sc->acq_errors++;
+    }
+    /* The receiver stays on for about a preamble before the error, see NOTE 2 below. */
+    sc->rx_us += uwb_phy_airtime_us(&sc->phy, 0, 0, NULL);
+}
+
+void sniff_ctrl_tx(sniff_ctrl_t *sc, uint16_t len)
+{
+    sc->tx_us += uwb_phy_airtime_us(&sc->phy, 0, len, NULL);
+}
+
+/* Adapt the ON time to the share of late acquisitions, with more evidence needed to lower it than to raise it. */
+static void sniff_ctrl_adapt_on(sniff_ctrl_t *sc)
+{
+    uint32_t total = sc->acq_frames + sc->acq_errors;
+    uint32_t pct;
+
+    if (total < SNIFF_CTRL_MIN_FRAMES)
+    {
+        return;
+    }
+    pct = sc->acq_errors * 100 / total;
+
+    if (pct > SNIFF_CTRL_ERR_HI_PCT)
+    {
+        if (sc->on < SNIFF_CTRL_MAX_ON && sniff_ctrl_max_off(&sc->phy, sc->on + 1) != 0)
+        {
+            sc->on++;
+        }
+    }
+    else if (total < 4 * SNIFF_CTRL_MIN_FRAMES)
+    {
+        return;
+    }
+    else if (pct < SNIFF_CTRL_ERR_LO_PCT && sc->on > 1)
+    {
+        sc->on--;
+    }
+    sc->acq_frames = 0;
+    sc->acq_errors = 0;
+}
+
+int sniff_ctrl_update(sniff_ctrl_t *sc, uint32_t elapsed_us)
+{
+    uint8_t old_enabled = sc->enabled, old_on = sc->on, old_off = sc->off;
+    uint32_t rx_pm, tx_pm, idle_pm, sniff_pm, saving_pm, on_pm, on_ns, off_ns;
+
+    if (elapsed_us == 0)
+    {
+        return 0;
+    }
+
+    /* Traffic of the period */
+    if (sc->rx_us > elapsed_us)
+    {
+        sc->rx_us = elapsed_us;
+    }
+    if (sc->tx_us > elapsed_us - sc->rx_us)
+    {
+        sc->tx_us = elapsed_us - sc->rx_us;
+    }
+    rx_pm = (uint32_t)((uint64_t)sc->rx_us * 1000 / elapsed_us);
+    tx_pm = (uint32_t)((uint64_t)sc->tx_us * 1000 / elapsed_us);
+    idle_pm = 1000 - rx_pm - tx_pm;
+    sc->frames_per_s = (uint32_t)((uint64_t)sc->rx_frames * 1000000 / elapsed_us);
+    sc->busy_permille = (uint16_t)(rx_pm + tx_pm);
+
+    /* ON and OFF times */
+    sniff_ctrl_adapt_on(sc);
+    sc->off = sniff_ctrl_max_off(&sc->phy, sc->on);
+
+    /* Share of the idle time the receiver is on in SNIFF mode, and the RX time saved. See NOTE 3 below. */
+    on_ns = (uint32_t)(sc->on + 1) * sc->phy.pac * uwb_phy_symbol_ns(&sc->phy);
+    off_ns = (uint32_t)sc->off * UWB_PHY_SNIFF_OFF_NS;
+    sniff_pm = on_ns * 1000 / (on_ns + off_ns);
+    saving_pm = idle_pm * (1000 - sniff_pm) / 1000;
+
+    if (sc->off == 0 || (sc->enabled && saving_pm < SNIFF_CTRL_MIN_SAVING * 10))
+    {
+        sc->enabled = 0;
+    }
+    else if (!sc->enabled && saving_pm >= (SNIFF_CTRL_MIN_SAVING + SNIFF_CTRL_HYST_SAVING) * 10)
+    {
+        sc->enabled = 1;
+    }
+
+    /* Estimates */
+    on_pm = rx_pm + (sc->enabled ? idle_pm * sniff_pm / 1000 : idle_pm);
+    sc->duty_permille = (uint16_t)on_pm;
+    sc->current_ua = (uint32_t)(((uint64_t)on_pm * uwb_phy_current_na(&sc->phy, UWB_PHY_RX)
+                                    + (uint64_t)tx_pm * uwb_phy_current_na(&sc->phy, UWB_PHY_TX)
+                                    + (uint64_t)(1000 - on_pm - tx_pm) * uwb_phy_current_na(&sc->phy, UWB_PHY_IDLE_PLL))
+                                / 1000000);
+
+    sc->rx_frames = 0;
+    sc->rx_errors = 0;
+    sc->rx_us = 0;
+    sc->tx_us = 0;
+
+    return (sc->enabled != old_enabled) || (sc->enabled && (sc->on != old_on || sc->off != old_off));
+}
+
+void sniff_ctrl_report(const sniff_ctrl_t *sc, uint32_t battery_mah)
+{
+    char str[112];
+    int ret;
+
+    ret = snprintf(str, sizeof(str), "SNIFF %s on=%u off=%u fps=%lu busy=%u.%u%% duty=%u.%u%% I=%lu.%02lu mA", sc->enabled ? "on " : "off", sc->on, sc->off,
+        (unsigned long)sc->frames_per_s, sc->busy_permille / 10, sc->busy_permille % 10, sc->duty_permille / 10, sc->duty_permille % 10,
+        (unsigned long)(sc->current_ua / 1000), (unsigned long)(sc->current_ua % 1000 / 10));
+    if (battery_mah && sc->current_ua && ret > 0 && ret < (int)sizeof(str))
+    {
+        snprintf(&str[ret], sizeof(str) - ret, " life=%lu d", (unsigned long)((uint64_t)battery_mah * 1000 / sc->current_ua / 24));
+    }
+    test_run_info((unsigned char *)str);
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. In SNIFF mode the receiver is on for (ON + 1) PACs and off for OFF x 128/125 us, over and over. A preamble is caught when an ON phase falls
+ *    entirely inside it and enough preamble is left after the detection to acquire it and find the SFD. In the worst case the preamble starts
+ *    just after the start of an ON phase, so the next full ON phase ends ON + OFF + ON after the start of the preamble. The guarantee is thus
+ *    2 x ON + OFF + SNIFF_CTRL_ACQ_SYMBOLS + SNIFF_CTRL_MARGIN_SYMBOLS <= preamble length, and the OFF time is set to the largest value meeting
+ *    it. With a 128 symbol preamble and PAC 8 this gives ON = 1 and OFF = 71, i.e. the receiver on 18 % of the idle time. Short preambles leave
+ *    no room for SNIFF mode, the controller then keeps continuous RX. The initiators may use longer preambles to let the responder sleep more.
+ * 2. A preamble detected too late runs into the SFD timeout, or is acquired badly and fails the PHR check, while the frames which are not
+ *    detected at all are not seen. The share of SFD timeouts and PHR errors is therefore used as the measure of late detections: above
+ *    SNIFF_CTRL_ERR_HI_PCT the ON time is raised, which gives the detector more symbols, at the cost of a shorter OFF time. Noise also causes
+ *    false detections ending in an SFD timeout, so the decisions need SNIFF_CTRL_MIN_FRAMES observations, and four times more to lower the ON
+ *    time again. Low traffic spreads a decision over several updates.
+ * 3. SNIFF mode only saves power while the receiver is idle. When the traffic keeps it receiving most of the time the saving drops below
+ *    SNIFF_CTRL_MIN_SAVING % and the controller returns to continuous RX, which also avoids the late detections. The current is estimated from
+ *    the time shares of RX, TX and the OFF phase with the typical figures of uwb_phy_current_na() for the channel and data rate: measure the
+ *    board to get real figures. The OFF phase keeps the PLL running, so SNIFF mode alone divides the RX current by a few; lasting months on a
+ *    battery also needs the DW IC to sleep between scheduled ranging slots.
+ ****************************************************************************************************************************************************/
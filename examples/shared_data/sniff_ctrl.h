@@ -0,0 +1,151 @@
+/*! ----------------------------------------------------------------------------
+ * @file    sniff_ctrl.h
+ * @brief   Adaptive SNIFF mode controller for responders and anchors
+ *
+ *          Chooses the SNIFF mode ON and OFF times of a receiver which listens most of the time, such as a ranging responder or an anchor.
+ *          The OFF time is the longest which still guarantees that a preamble of the configured length is detected and acquired, and the ON
+ *          time is raised when late acquisitions show up in the RX errors and lowered again when they are gone. When the observed traffic
+ *          keeps the receiver busy so much that SNIFF mode would save little, the controller falls back to continuous RX. The RX duty cycle
+ *          and the average current are estimated from the same observations. No DW IC driver dependency, the caller applies the times with
+ *          dwt_setsniffmode().
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _SNIFF_CTRL_
+#define _SNIFF_CTRL_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <uwb_phy.h>
+
+#define SNIFF_CTRL_ACQ_SYMBOLS    16 /* Preamble symbols needed after the detection to acquire the preamble, see NOTE 1 in sniff_ctrl.c */
+#define SNIFF_CTRL_MARGIN_SYMBOLS 8  /* Preamble symbols kept as a safety margin */
+#define SNIFF_CTRL_MAX_ON         15 /* Largest ON time, in PACs (4 bit field) */
+#define SNIFF_CTRL_MAX_OFF        255 /* Largest OFF time, in 128/125 us (8 bit field) */
+
+#define SNIFF_CTRL_MIN_FRAMES   20 /* Frames and acquisition errors observed before the ON time is adapted */
+#define SNIFF_CTRL_ERR_HI_PCT   5  /* The ON time is raised above this share of acquisition errors */
+#define SNIFF_CTRL_ERR_LO_PCT   1  /* and lowered below this one */
+#define SNIFF_CTRL_MIN_SAVING   10 /* SNIFF mode is left when it saves less than this percentage of the RX time... */
+#define SNIFF_CTRL_HYST_SAVING  5  /* ...and entered again when it saves this much more */
+
+    typedef struct
+    {
+        struct uwb_phy phy; /* Air interface of the received frames, with the PAC size of the receiver */
+
+        /* Current setting */
+        uint8_t enabled; /* 0 for continuous RX */
+        uint8_t on;      /* ON time in PACs, the DW IC adds one PAC */
+        uint8_t off;     /* OFF time in 128/125 us */
+
+        /* Observations since the last update */
+        uint32_t rx_frames;
+        uint32_t rx_errors;
+        uint32_t rx_us; /* Air time of the frames received, and of the RX errors */
+        uint32_t tx_us; /* Air time of the frames sent */
+
+        /* Observations since the last change of the ON time */
+        uint32_t acq_frames;
+        uint32_t acq_errors;
+
+        /* Estimates of the last update */
+        uint32_t frames_per_s;
+        uint16_t busy_permille; /* Share of the time spent receiving and sending frames */
+        uint16_t duty_permille; /* Share of the time the receiver is on */
+        uint32_t current_ua;    /* Average current of the DW IC */
+    } sniff_ctrl_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn sniff_ctrl_init()
+     *
+     * @brief Start with the shortest ON time and the longest OFF time allowed by the preamble length.
+     *
+     * @param sc - controller state
+     * @param phy - air interface of the received frames, with the PAC size (8, 16 or 32)
+     *
+     * @return none
+     */
+    void sniff_ctrl_init(sniff_ctrl_t *sc, const struct uwb_phy *phy);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn sniff_ctrl_max_off()
+     *
+     * @brief Longest OFF time which guarantees the acquisition of a preamble with a given ON time, see NOTE 1 in sniff_ctrl.c.
+     *
+     * @param phy - air interface, only the preamble length, PRF and PAC size are used
+     * @param on - ON time in PACs
+     *
+     * @return OFF time in 128/125 us, 0 if SNIFF mode cannot guarantee the acquisition
+     */
+    uint8_t sniff_ctrl_max_off(const struct uwb_phy *phy, uint8_t on);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn sniff_ctrl_rx_ok()
+     *
+     * @brief Account a good frame received.
+     *
+     * @param sc - controller state
+     * @param len - frame length, including the FCS
+     *
+     * @return none
+     */
+    void sniff_ctrl_rx_ok(sniff_ctrl_t *sc, uint16_t len);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn sniff_ctrl_rx_err()
+     *
+     * @brief Account an RX error.
+     *
+     * @param sc - controller state
+     * @param acq - 1 if the error shows a late acquisition of the preamble (SFD timeout or PHR error), see NOTE 2 in sniff_ctrl.c
+     *
+     * @return none
+     */
+    void sniff_ctrl_rx_err(sniff_ctrl_t *sc, int acq);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn sniff_ctrl_tx()
+     *
+     * @brief Account a frame sent.
+     *
+     * @param sc - controller state
+     * @param len - frame length, including the FCS
+     *
+     * @return none
+     */
+    void sniff_ctrl_tx(sniff_ctrl_t *sc, uint16_t len);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn sniff_ctrl_update()
+     *
+     * @brief Update the estimates with the observations of a period and choose the next setting. Call it periodically, e.g. every second.
+     *
+     * @param sc - controller state
+     * @param elapsed_us - time since the last update
+     *
+     * @return 1 if the setting changed and has to be applied with dwt_setsniffmode(enabled, on, off), 0 otherwise
+     */
+    int sniff_ctrl_update(sniff_ctrl_t *sc, uint32_t elapsed_us);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn sniff_ctrl_report()
+     *
+     * @brief Print the setting and the estimates of the last update with test_run_info().
+     *
+     * @param sc - controller state
+     * @param battery_mah - battery capacity for the estimate of the battery life, 0 to leave it out
+     *
+     * @return none
+     */
+    void sniff_ctrl_report(const sniff_ctrl_t *sc, uint32_t battery_mah);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
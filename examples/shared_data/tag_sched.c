@@ -0,0 +1,248 @@
+/*! ----------------------------------------------------------------------------
+ * @file    tag_sched.c
+ * @brief   Wake-on-schedule planner of a tag ranging in a slot of the anchor superframe
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <tag_sched.h>
+
+extern void test_run_info(unsigned char *data);
+
+void tag_sched_init(tag_sched_t *ts, const struct uwb_phy *phy, uint16_t slot, uint32_t slot_us, uint16_t period_sf)
+{
+    memset(ts, 0, sizeof(*ts));
+    ts->phy = *phy;
+    ts->slot = slot;
+    ts->slot_dtu = (uint32_t)((uint64_t)slot * slot_us * TAG_SCHED_DTU_PER_US_X10 / 10);
+    ts->cycle_us = (uint32_t)(((uint64_t)period_sf << TAG_SCHED_SF_DTU_LOG2) * 10 / TAG_SCHED_DTU_PER_US_X10);
+    ts->wake_q4 = TAG_SCHED_WAKE_INIT_US << 4;
+}
+
+static uint32_t tag_sched_lead_us(const tag_sched_t *ts)
+{
+    return ((ts->wake_q4 + TAG_SCHED_WAKE_DEV_MULT * ts->wake_dev_q4) >> 4) + TAG_SCHED_GUARD_US;
+}
+
+static uint32_t tag_sched_period_us(const tag_sched_t *ts)
+{
+    return (uint32_t)((int32_t)ts->cycle_us + (ts->drift_q8 >> 8));
+}
+
+void tag_sched_plan(tag_sched_t *ts, uint32_t now_us, tag_sched_plan_t *plan)
+{
+    uint32_t lead = tag_sched_lead_us(ts);
+
+    if (!ts->synced)
+    {
+        /* Acquisition, poll as soon as possible and learn the position in the superframe from the response. */
+        ts->next_tx_us = now_us + lead;
+    }
+    else
+    {
+        /* Skip the slots which cannot be reached anymore, e.g. after a long report. */
+        while ((int32_t)(ts->next_tx_us - now_us) < (int32_t)lead)
+        {
+            ts->next_tx_us += tag_sched_period_us(ts);
+        }
+    }
+    plan->tx_us = ts->next_tx_us;
+    plan->wake_us = plan->tx_us - lead;
+}
+
+int tag_sched_woke(tag_sched_t *ts, const tag_sched_plan_t *plan, uint32_t woke_us, uint32_t ready_us)
+{
+    uint32_t lat_q4;
+    int32_t dev_q4;
+
+    ts->wake_lat_us = ready_us - woke_us;
+    ts->late_us = (int32_t)(woke_us - plan->wake_us);
+
+    /* Average and average deviation of the wake-up latency. See NOTE 1 below. */
+    lat_q4 = ts->wake_lat_us << 4;
+    if (ts->rounds == 0)
+    {
+        ts->wake_q4 = lat_q4;
+        ts->wake_dev_q4 = lat_q4 / 4;
+    }
+    else
+    {
+        dev_q4 = (int32_t)(lat_q4 - ts->wake_q4);
+        ts->wake_q4 = (uint32_t)((int32_t)ts->wake_q4 + dev_q4 / 8);
+        if (dev_q4 < 0)
+        {
+            dev_q4 = -dev_q4;
+        }
+        ts->wake_dev_q4 = (uint32_t)((int32_t)ts->wake_dev_q4 + (dev_q4 - (int32_t)ts->wake_dev_q4) / 8);
+    }
+
+    if (ts->wake_lat_us > ts->wake_max_us)
+    {
+        ts->wake_max_us = ts->wake_lat_us;
+    }
+    if (ts->late_us > ts->late_max_us)
+    {
+        ts->late_max_us = ts->late_us;
+    }
+    return (int32_t)(plan->tx_us - ready_us) > 0;
+}
+
+uint32_t tag_sched_tx_time(const tag_sched_plan_t *plan, uint32_t now_us, uint32_t sys_time_hi32)
+{
+    int32_t dt = (int32_t)(plan->tx_us - now_us);
+
+    if (dt < 0)
+    {
+        dt = 0;
+    }
+    return sys_time_hi32 + (uint32_t)((uint64_t)dt * TAG_SCHED_HI32_PER_US_X10 / 10);
+}
+
+int32_t tag_sched_sync(tag_sched_t *ts, uint32_t poll_rx_ts)
+{
+    /* The difference wraps with the superframe, so the error is within half a superframe. */
+    int32_t err_dtu = (int32_t)(poll_rx_ts - ts->slot_dtu);
+    uint32_t abs_err;
+
+    ts->err_us = (int32_t)((int64_t)err_dtu * 10 / TAG_SCHED_DTU_PER_US_X10);
+
+    /* Phase and frequency tracking. See NOTE 2 below. */
+    if (ts->synced)
+    {
+        ts->drift_q8 -= ts->err_us * TAG_SCHED_FREQ_GAIN_Q8;
+
+        abs_err = (ts->err_us < 0) ? (uint32_t)-ts->err_us : (uint32_t)ts->err_us;
+        ts->synced_rounds++;
+        ts->err_sum += ts->err_us;
+        ts->err_sq_sum += (uint64_t)abs_err * abs_err;
+        if (abs_err > ts->err_max)
+        {
+            ts->err_max = abs_err;
+        }
+    }
+    ts->result = ts->synced ? TAG_SCHED_OK : TAG_SCHED_ACQ;
+    ts->synced = 1;
+    ts->misses = 0;
+    ts->next_tx_us += tag_sched_period_us(ts) - ts->err_us;
+    return ts->err_us;
+}
+
+void tag_sched_miss(tag_sched_t *ts)
+{
+    ts->result = TAG_SCHED_MISS;
+    ts->err_us = 0;
+    ts->missed++;
+    if (++ts->misses >= TAG_SCHED_MAX_MISSES)
+    {
+        ts->synced = 0;
+        ts->drift_q8 = 0;
+    }
+    ts->next_tx_us += tag_sched_period_us(ts);
+}
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0, b = (uint64_t)1 << 62;
+
+    while (b > v)
+    {
+        b >>= 2;
+    }
+    while (b)
+    {
+        if (v >= r + b)
+        {
+            v -= r + b;
+            r = (r >> 1) + b;
+        }
+        else
+        {
+            r >>= 1;
+        }
+        b >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+static void tag_sched_summary(tag_sched_t *ts)
+{
+    char str[176];
+    int32_t mean = 0;
+    uint32_t sd = 0, avg_ua = 0;
+    uint64_t var;
+
+    if (ts->synced_rounds)
+    {
+        mean = (int32_t)(ts->err_sum / ts->synced_rounds);
+        var = ts->err_sq_sum / ts->synced_rounds;
+        var = (var > (uint64_t)((int64_t)mean * mean)) ? var - (uint64_t)((int64_t)mean * mean) : 0;
+        sd = isqrt64(var);
+    }
+    if (ts->time_sum_us)
+    {
+        /* nJ / us / V = mA, scaled to uA */
+        avg_ua = (uint32_t)(ts->energy_sum_nj * 1000000 / ts->time_sum_us / UWB_PHY_SUPPLY_MV);
+    }
+
+    snprintf(str, sizeof(str), "TAG n=%lu ok=%lu miss=%lu err mean=%ld sd=%lu max=%lu us wake max=%lu us late max=%ld us I=%lu uA",
+        (unsigned long)ts->rounds, (unsigned long)ts->synced_rounds, (unsigned long)ts->missed, (long)mean, (unsigned long)sd,
+        (unsigned long)ts->err_max, (unsigned long)ts->wake_max_us, (long)ts->late_max_us, (unsigned long)avg_ua);
+    test_run_info((unsigned char *)str);
+
+    ts->synced_rounds = 0;
+    ts->missed = 0;
+    ts->err_sum = 0;
+    ts->err_sq_sum = 0;
+    ts->err_max = 0;
+    ts->wake_max_us = 0;
+    ts->late_max_us = 0;
+    ts->energy_sum_nj = 0;
+    ts->time_sum_us = 0;
+}
+
+void tag_sched_end(tag_sched_t *ts, const tag_sched_times_t *times)
+{
+    static const char *const result_str[] = { "acq ", "ok  ", "miss" };
+    char str[96];
+    uint64_t charge;
+
+    /* Energy of the DW IC in the round. See NOTE 3 below. */
+    charge = (uint64_t)times->sleep_us * uwb_phy_current_na(&ts->phy, UWB_PHY_DEEPSLEEP)
+             + (uint64_t)times->wake_us * uwb_phy_current_na(&ts->phy, UWB_PHY_IDLE_RC)
+             + (uint64_t)times->idle_us * uwb_phy_current_na(&ts->phy, UWB_PHY_IDLE_PLL)
+             + (uint64_t)times->tx_us * uwb_phy_current_na(&ts->phy, UWB_PHY_TX)
+             + (uint64_t)times->rx_us * uwb_phy_current_na(&ts->phy, UWB_PHY_RX); /* fC */
+    ts->energy_nj = (uint32_t)(charge * UWB_PHY_SUPPLY_MV / 1000000000);
+    ts->energy_sum_nj += ts->energy_nj;
+    ts->time_sum_us += (uint64_t)times->sleep_us + times->wake_us + times->idle_us + times->tx_us + times->rx_us;
+    ts->rounds++;
+
+    snprintf(str, sizeof(str), "TAG #%lu %s err=%ld us wake=%lu us late=%ld us E=%lu.%03lu uJ", (unsigned long)ts->rounds, result_str[ts->result],
+        (long)ts->err_us, (unsigned long)ts->wake_lat_us, (long)ts->late_us, (unsigned long)(ts->energy_nj / 1000), (unsigned long)(ts->energy_nj % 1000));
+    test_run_info((unsigned char *)str);
+
+    if (ts->rounds % TAG_SCHED_REPORT_PERIOD == 0)
+    {
+        tag_sched_summary(ts);
+    }
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The wake-up latency is the time from the start of the wake-up of the DW IC to the end of dwt_restoreconfig(), mostly the start of the
+ *    crystal and the restore of the configuration. Its average and average deviation are tracked with a gain of 1/8, and the DW IC is woken
+ *    up TAG_SCHED_WAKE_DEV_MULT deviations earlier than the average plus TAG_SCHED_GUARD_US before the poll. Waking up too early only costs
+ *    IDLE_PLL current until the poll, waking up too late misses the slot. The lateness of the MCU itself (the kernel timer and the wake-up
+ *    from its low power state) is reported separately and is absorbed by the guard time: the poll is sent with a delayed TX, so the timing
+ *    of the MCU does not move it.
+ * 2. The anchor reports the low 32 bits of the reception time of the poll, i.e. its position in the superframe. The error to the start of the
+ *    slot moves the next poll (phase) and a quarter of it accumulates into a correction of the period (frequency), which compensates the
+ *    offset between the crystal of the anchor and the clock of the MCU, the only clock running while the tag sleeps. The error includes a
+ *    constant offset, the preamble of the poll up to its RMARKER and the time of flight, which the loop removes with the rest: the poll is
+ *    sent so that its RMARKER reaches the anchor at the start of the slot. The jitter is the standard deviation of the error.
+ * 3. The energy only covers the DW IC, with the typical figures of uwb_phy_current_na() for each state: measure the board to get real figures
+ *    and to add the MCU. The RX time runs from the end of the poll to the response or the RX timeout.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,190 @@
+/*! ----------------------------------------------------------------------------
+ * @file    tag_sched.h
+ * @brief   Wake-on-schedule planner of a tag ranging in a slot of the anchor superframe
+ *
+ *          Plans the ranging rounds of a tag which sleeps, MCU and DW IC, between rounds. The superframe is the wrap period of the 32 bit
+ *          timestamps of the anchor (2^32 device time units, about 67.2 ms), divided into slots, so that any anchor running the SS TWR
+ *          responder defines it and reports in each response where in the superframe the poll arrived. From these reports the planner keeps
+ *          the polls of the tag in its slot with a phase and frequency tracking loop, and wakes the tag ahead of each poll by a wake-up latency
+ *          calibrated on the previous rounds. The energy of the DW IC per round is estimated from the time spent in each state, and the
+ *          alignment error and wake-up timing of each round are reported. No DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _TAG_SCHED_
+#define _TAG_SCHED_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <uwb_phy.h>
+
+#define TAG_SCHED_SF_DTU_LOG2     32      /* Superframe length, 2^32 device time units */
+#define TAG_SCHED_DTU_PER_US_X10  638976  /* Device time units per 10 us (63.8976 GHz) */
+#define TAG_SCHED_HI32_PER_US_X10 2496    /* Units of the delayed TX time (256 device time units) per 10 us */
+
+#define TAG_SCHED_GUARD_US      150 /* Time kept between the end of the wake-up and the poll, for writing the frame and programming the TX */
+#define TAG_SCHED_WAKE_INIT_US  3000 /* Wake-up latency assumed before the first measurement */
+#define TAG_SCHED_WAKE_DEV_MULT 4   /* Wake-up latency planned as the average plus this many average deviations */
+#define TAG_SCHED_FREQ_GAIN_Q8  64  /* Share of the alignment error added to the cycle length, Q8 (0.25), see NOTE 2 in tag_sched.c */
+#define TAG_SCHED_MAX_MISSES    8   /* Rounds without response after which the tag acquires the superframe again */
+
+#define TAG_SCHED_REPORT_PERIOD 16 /* Rounds between two summaries */
+
+/* Outcome of a round */
+#define TAG_SCHED_ACQ  0 /* Superframe acquired */
+#define TAG_SCHED_OK   1 /* Poll answered, alignment updated */
+#define TAG_SCHED_MISS 2 /* No response, or slot missed */
+
+    /* Plan of one round, in local microseconds (port_get_time_us()) */
+    typedef struct
+    {
+        uint32_t wake_us; /* Time to wake the DW IC up */
+        uint32_t tx_us;   /* Time of the poll transmission */
+    } tag_sched_plan_t;
+
+    /* Time spent by the DW IC in each state during one round, in microseconds */
+    typedef struct
+    {
+        uint32_t sleep_us; /* DEEPSLEEP */
+        uint32_t wake_us;  /* Wake-up, IDLE_RC */
+        uint32_t idle_us;  /* IDLE_PLL, waiting for the delayed TX */
+        uint32_t tx_us;
+        uint32_t rx_us;
+    } tag_sched_times_t;
+
+    typedef struct
+    {
+        /* Configuration */
+        struct uwb_phy phy;  /* Air interface, for the supply currents of the energy estimate */
+        uint32_t slot_dtu;   /* Start of the slot in the superframe, in device time units */
+        uint32_t cycle_us;   /* Nominal round period, a whole number of superframes */
+        uint16_t slot;
+
+        /* Tracking */
+        uint8_t synced;
+        uint8_t misses;      /* Consecutive rounds without response */
+        uint32_t next_tx_us; /* Planned time of the next poll */
+        int32_t drift_q8;    /* Correction of the round period, us Q8 */
+        uint32_t wake_q4;    /* Average wake-up latency, us Q4 */
+        uint32_t wake_dev_q4; /* Average deviation of the wake-up latency, us Q4 */
+
+        /* Last round */
+        uint8_t result;       /* TAG_SCHED_ACQ, TAG_SCHED_OK or TAG_SCHED_MISS */
+        int32_t err_us;       /* Alignment error measured by the anchor */
+        int32_t late_us;      /* Wake-up of the MCU after the planned time */
+        uint32_t wake_lat_us; /* Wake-up latency of the DW IC */
+        uint32_t energy_nj;   /* Energy of the DW IC */
+
+        /* Summary */
+        uint32_t rounds;
+        uint32_t synced_rounds;
+        uint32_t missed;
+        int64_t err_sum;
+        uint64_t err_sq_sum;
+        uint32_t err_max;
+        uint32_t wake_max_us;
+        int32_t late_max_us;
+        uint64_t energy_sum_nj;
+        uint64_t time_sum_us;
+    } tag_sched_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tag_sched_init()
+     *
+     * @brief Configure the slot and period of the tag. The first round is planned as soon as possible to acquire the superframe.
+     *
+     * @param ts - planner state
+     * @param phy - air interface of the tag
+     * @param slot - slot of the tag
+     * @param slot_us - slot length, the superframe holds about 67200 / slot_us slots
+     * @param period_sf - round period in superframes
+     *
+     * @return none
+     */
+    void tag_sched_init(tag_sched_t *ts, const struct uwb_phy *phy, uint16_t slot, uint32_t slot_us, uint16_t period_sf);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tag_sched_plan()
+     *
+     * @brief Plan the next round.
+     *
+     * @param ts - planner state
+     * @param now_us - current time
+     * @param plan - receives the wake-up and poll times
+     *
+     * @return none
+     */
+    void tag_sched_plan(tag_sched_t *ts, uint32_t now_us, tag_sched_plan_t *plan);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tag_sched_woke()
+     *
+     * @brief Account the wake-up of a round and update the calibration of the wake-up latency, see NOTE 1 in tag_sched.c.
+     *
+     * @param ts - planner state
+     * @param plan - plan of the round
+     * @param woke_us - time the MCU woke up and started the wake-up of the DW IC
+     * @param ready_us - time the DW IC was ready
+     *
+     * @return 1 if there is still time to program the poll, 0 if the round is missed
+     */
+    int tag_sched_woke(tag_sched_t *ts, const tag_sched_plan_t *plan, uint32_t woke_us, uint32_t ready_us);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tag_sched_tx_time()
+     *
+     * @brief Convert the planned poll time into a delayed TX time of the DW IC.
+     *
+     * @param plan - plan of the round
+     * @param now_us - current time
+     * @param sys_time_hi32 - system time of the DW IC read at now_us, dwt_readsystimestamphi32()
+     *
+     * @return time for dwt_setdelayedtrxtime()
+     */
+    uint32_t tag_sched_tx_time(const tag_sched_plan_t *plan, uint32_t now_us, uint32_t sys_time_hi32);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tag_sched_sync()
+     *
+     * @brief Align the next rounds with the reception time of the poll reported by the anchor, see NOTE 2 in tag_sched.c.
+     *
+     * @param ts - planner state
+     * @param poll_rx_ts - poll reception timestamp of the anchor (lower 32 bits)
+     *
+     * @return alignment error of the round in microseconds
+     */
+    int32_t tag_sched_sync(tag_sched_t *ts, uint32_t poll_rx_ts);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tag_sched_miss()
+     *
+     * @brief Account a round without response. The next rounds follow the local clock until TAG_SCHED_MAX_MISSES rounds are missed.
+     *
+     * @param ts - planner state
+     *
+     * @return none
+     */
+    void tag_sched_miss(tag_sched_t *ts);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tag_sched_end()
+     *
+     * @brief End a round: estimate its energy, print it and print the summary every TAG_SCHED_REPORT_PERIOD rounds.
+     *
+     * @param ts - planner state
+     * @param times - time spent by the DW IC in each state since the end of the previous round
+     *
+     * @return none
+     */
+    void tag_sched_end(tag_sched_t *ts, const tag_sched_times_t *times);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
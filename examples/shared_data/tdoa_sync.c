@@ -0,0 +1,243 @@
+/*! ----------------------------------------------------------------------------
+ * @file    tdoa_sync.c
+ * @brief   Synchronisation of a TDoA anchor to the clock of the reference anchor
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <tdoa_sync.h>
+
+#define TDOA_SYNC_SHIFT 12 /* Scaling of the reference times in the regression sums, see NOTE 1 below */
+
+/* Signed difference of two 40 bit timestamps */
+static int64_t ts_diff(uint64_t a, uint64_t b)
+{
+    int64_t d = (int64_t)((a - b) & TDOA_TS_MASK);
+
+    return (d & 0x8000000000LL) ? d - 0x10000000000LL : d;
+}
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t res = 0, bit = 1ULL << 62;
+
+    while (bit > v)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (v >= res + bit)
+        {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)res;
+}
+
+/* (v * drift_q32) >> 32, v up to 2^40 */
+static int64_t mul_drift(int64_t v, int32_t drift_q32)
+{
+    return (v * drift_q32) >> 32;
+}
+
+/* Local time predicted by the fitted line for a reference time */
+static uint64_t predict(const tdoa_sync_t *ts, uint64_t ref)
+{
+    int64_t dx = ts_diff(ref, ts->ref0);
+
+    return (ts->local0 + dx + mul_drift(dx, ts->drift_q32)) & TDOA_TS_MASK;
+}
+
+/* Least squares line through the beacons of the window. See NOTE 1 below. */
+static void fit(tdoa_sync_t *ts)
+{
+    unsigned int last = (ts->next + TDOA_SYNC_WINDOW - 1) % TDOA_SYNC_WINDOW, i, k;
+    int64_t x[TDOA_SYNC_WINDOW], y[TDOA_SYNC_WINDOW], x_mean = 0, y_mean = 0, sxx = 0, sxy = 0, y0;
+    uint64_t sq = 0;
+    int shift = 32 - TDOA_SYNC_SHIFT;
+
+    for (k = 0; k < ts->count; k++)
+    {
+        int64_t dx;
+
+        i = (last + TDOA_SYNC_WINDOW - k) % TDOA_SYNC_WINDOW;
+        dx = ts_diff(ts->ref_ts[i], ts->ref_ts[last]);
+        x[k] = dx / (1 << TDOA_SYNC_SHIFT);
+        y[k] = ts_diff(ts->local_ts[i], ts->local_ts[last]) - dx;
+        x_mean += x[k];
+        y_mean += y[k];
+    }
+    x_mean /= ts->count;
+    y_mean /= ts->count;
+    for (k = 0; k < ts->count; k++)
+    {
+        sxx += (x[k] - x_mean) * (x[k] - x_mean);
+        sxy += (x[k] - x_mean) * (y[k] - y_mean);
+    }
+
+    /* drift = sxy / sxx / 2^SHIFT, in Q32: scale sxy up as far as it goes, sxx down for the rest */
+    if (ts->count >= 2 && sxx > 0)
+    {
+        int64_t drift;
+
+        while (shift > 0 && sxy < (1LL << 52) && sxy > -(1LL << 52))
+        {
+            sxy *= 2;
+            shift--;
+        }
+        sxx >>= shift;
+        drift = (sxx > 0) ? sxy / sxx : 0;
+        if (drift > TDOA_SYNC_MAX_DRIFT_Q32)
+        {
+            drift = TDOA_SYNC_MAX_DRIFT_Q32;
+        }
+        if (drift < -TDOA_SYNC_MAX_DRIFT_Q32)
+        {
+            drift = -TDOA_SYNC_MAX_DRIFT_Q32;
+        }
+        ts->drift_q32 = (int32_t)drift;
+    }
+
+    /* The line at the last beacon */
+    y0 = y_mean - mul_drift(x_mean * (1 << TDOA_SYNC_SHIFT), ts->drift_q32);
+    ts->ref0 = ts->ref_ts[last];
+    ts->local0 = (ts->local_ts[last] + y0) & TDOA_TS_MASK;
+
+    for (k = 0; k < ts->count; k++)
+    {
+        int64_t r = y[k] - y0 - mul_drift(x[k] * (1 << TDOA_SYNC_SHIFT), ts->drift_q32);
+
+        sq += (uint64_t)(r * r);
+    }
+    ts->rms_dtu = isqrt64(sq / ts->count);
+}
+
+void tdoa_sync_init(tdoa_sync_t *ts)
+{
+    ts->count = 0;
+    ts->next = 0;
+    ts->outliers = 0;
+    ts->drift_q32 = 0;
+    ts->rms_dtu = 0;
+    ts->beacons = 0;
+    ts->lost = 0;
+    ts->rejected = 0;
+    ts->restarts = 0;
+}
+
+int tdoa_sync_beacon(tdoa_sync_t *ts, uint8_t seq, uint64_t ref_tx_ts, uint32_t tof_dtu, uint64_t local_rx_ts)
+{
+    uint64_t ref = (ref_tx_ts + tof_dtu) & TDOA_TS_MASK;
+    int ret = TDOA_SYNC_OK;
+
+    if (ts->count > 0 && ref == ts->ref0)
+    {
+        /* Same beacon again */
+        ts->rejected++;
+        return TDOA_SYNC_OUTLIER;
+    }
+    if (ts->beacons > 0)
+    {
+        ts->lost += (uint8_t)(seq - ts->seq - 1);
+    }
+    ts->beacons++;
+    ts->seq = seq;
+
+    if (ts->count > 0)
+    {
+        int64_t age = ts_diff(ref, ts->ref0);
+
+        if (age < 0 || age > TDOA_SYNC_MAX_AGE_DTU)
+        {
+            /* Beacons lost for too long, or the reference restarted */
+            ts->count = 0;
+            ts->next = 0;
+            ts->drift_q32 = 0;
+            ts->restarts++;
+            ret = TDOA_SYNC_RESTART;
+        }
+        else
+        {
+            /* Forget the beacons too old for the regression, see NOTE 1 below. */
+            while (ts->count > 0 &&
+                   ts_diff(ref, ts->ref_ts[(ts->next + TDOA_SYNC_WINDOW - ts->count) % TDOA_SYNC_WINDOW]) > TDOA_SYNC_MAX_AGE_DTU)
+            {
+                ts->count--;
+            }
+        }
+
+        if (ret == TDOA_SYNC_OK && ts->count >= TDOA_SYNC_MIN_BEACONS)
+        {
+            int64_t err = ts_diff(local_rx_ts, predict(ts, ref));
+
+            /* See NOTE 2 below. */
+            if (err > TDOA_SYNC_GATE_DTU || err < -TDOA_SYNC_GATE_DTU)
+            {
+                if (++ts->outliers < TDOA_SYNC_MAX_OUTLIERS)
+                {
+                    ts->rejected++;
+                    return TDOA_SYNC_OUTLIER;
+                }
+                ts->count = 0;
+                ts->next = 0;
+                ts->drift_q32 = 0;
+                ts->restarts++;
+                ret = TDOA_SYNC_RESTART;
+            }
+        }
+    }
+    ts->outliers = 0;
+
+    ts->ref_ts[ts->next] = ref;
+    ts->local_ts[ts->next] = local_rx_ts & TDOA_TS_MASK;
+    ts->next = (ts->next + 1) % TDOA_SYNC_WINDOW;
+    if (ts->count < TDOA_SYNC_WINDOW)
+    {
+        ts->count++;
+    }
+    fit(ts);
+    return ret;
+}
+
+int tdoa_sync_convert(const tdoa_sync_t *ts, uint64_t local_ts, uint64_t *ref_ts)
+{
+    int64_t dy, d1;
+
+    if (ts->count < TDOA_SYNC_MIN_BEACONS)
+    {
+        return -1;
+    }
+    dy = ts_diff(local_ts, ts->local0);
+    if (dy > TDOA_SYNC_MAX_AGE_DTU || dy < -TDOA_SYNC_MAX_AGE_DTU)
+    {
+        return -1;
+    }
+
+    /* ref = ref0 + dy / (1 + drift), to the second order of the drift */
+    d1 = mul_drift(dy, ts->drift_q32);
+    *ref_ts = (ts->ref0 + dy - d1 + mul_drift(d1, ts->drift_q32)) & TDOA_TS_MASK;
+    return 0;
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The regression is done relative to the last beacon: x is the reference time of each beacon minus the one of the last beacon, and y the
+ *    local time minus the one of the last beacon, minus x, i.e. what the local clock gained on the reference. The slope of y against x is the
+ *    drift, a few ppm, and the line at x = 0 gives the offset. Beacons older than TDOA_SYNC_MAX_AGE_DTU (2^37) are dropped from the window
+ *    before each fit, so that x spans at most 2^37, far from the wrap of the 40 bit differences, and with fewer than TDOA_SYNC_MIN_BEACONS
+ *    left (e.g. beacons more than about 1 s apart) timestamps are not converted. x is scaled down by 2^12 in the sums, y stays within the
+ *    drift times the window (a few 10^6 device time units), so that the sums fit in 64 bits. Over a window of 8 beacons 100 ms apart, with 6
+ *    DTU (about 100 ps) of timestamp noise on each beacon, tools/tdoa_sim gives an error of 5 DTU RMS and about 20 DTU at most on a blink
+ *    received halfway between two beacons, to which the noise of the blink timestamp adds.
+ * 2. A beacon which does not fall on the line within TDOA_SYNC_GATE_DTU, once enough beacons are known, is dropped: e.g. a reflected path, or
+ *    a beacon of another reference. After TDOA_SYNC_MAX_OUTLIERS consecutive ones the clock is assumed to have jumped (e.g. the reference was
+ *    reset) and the regression restarts from the new beacon.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,107 @@
+/*! ----------------------------------------------------------------------------
+ * @file    tdoa_sync.h
+ * @brief   Synchronisation of a TDoA anchor to the clock of the reference anchor
+ *
+ *          The reference anchor transmits sync beacons carrying their own TX timestamp. Each anchor timestamps the beacons it receives and,
+ *          the time of flight from the reference being known from the anchor positions, fits its clock against the reference clock by linear
+ *          regression over a window of beacons: offset and drift. Any local timestamp, e.g. of a blink, is then converted to the timeline of
+ *          the reference, so that the timestamps of a blink from all anchors can be compared (time difference of arrival). The timestamps are
+ *          40 bit device times, their wrap (about 17.2 s) being handled. Integer arithmetic only, no DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _TDOA_SYNC_
+#define _TDOA_SYNC_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define TDOA_SYNC_WINDOW       8             /* Beacons of the regression */
+#define TDOA_SYNC_MIN_BEACONS  3             /* Beacons needed before timestamps are converted */
+#define TDOA_SYNC_MAX_AGE_DTU  0x2000000000LL /* About 2.2 s: older beacons are forgotten, and timestamps that far from the last beacon are not converted */
+#define TDOA_SYNC_GATE_DTU     6390          /* 100 ns: a beacon further than this from the prediction is an outlier, see NOTE 2 in tdoa_sync.c */
+#define TDOA_SYNC_MAX_OUTLIERS 3             /* Consecutive outliers after which the regression restarts */
+#define TDOA_SYNC_MAX_DRIFT_Q32 429497       /* 100 ppm, bound of the drift */
+
+#define TDOA_TS_MASK 0xFFFFFFFFFFULL /* 40 bit device time */
+
+/* Time of flight, in device time units, of a distance in mm */
+#define TDOA_MM_TO_DTU(mm) ((uint32_t)(((uint64_t)(mm) * 21313) / 100000))
+
+/* Results of tdoa_sync_beacon() */
+#define TDOA_SYNC_OK      0 /* Beacon used */
+#define TDOA_SYNC_OUTLIER 1 /* Beacon dropped */
+#define TDOA_SYNC_RESTART 2 /* Regression restarted from this beacon */
+
+    typedef struct
+    {
+        /* Window of beacons, reference TX time plus time of flight and local RX time */
+        uint64_t ref_ts[TDOA_SYNC_WINDOW];
+        uint64_t local_ts[TDOA_SYNC_WINDOW];
+        uint8_t count;
+        uint8_t next;
+        uint8_t outliers; /* Consecutive outliers */
+        uint8_t seq;      /* Sequence number of the last beacon */
+
+        /* Fitted line: local = local0 + (ref - ref0) * (1 + drift), see NOTE 1 in tdoa_sync.c */
+        uint64_t ref0;
+        uint64_t local0;
+        int32_t drift_q32; /* Drift of the local clock, Q32 (1 ppm = 4295) */
+        uint32_t rms_dtu;  /* RMS of the residuals of the beacons */
+
+        /* Counters */
+        uint32_t beacons;
+        uint32_t lost;     /* Beacons missed, from the sequence numbers */
+        uint32_t rejected; /* Outliers */
+        uint32_t restarts;
+    } tdoa_sync_t;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tdoa_sync_init()
+     *
+     * @brief Forget all beacons.
+     *
+     * @param ts - synchronisation state
+     *
+     * @return none
+     */
+    void tdoa_sync_init(tdoa_sync_t *ts);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tdoa_sync_beacon()
+     *
+     * @brief Add a sync beacon of the reference anchor and fit the clock again.
+     *
+     * @param ts - synchronisation state
+     * @param seq - sequence number of the beacon
+     * @param ref_tx_ts - TX timestamp of the beacon in the reference clock, from the beacon (40 bits)
+     * @param tof_dtu - time of flight from the reference anchor
+     * @param local_rx_ts - RX timestamp of the beacon, get_rx_timestamp_u64() (40 bits)
+     *
+     * @return TDOA_SYNC_OK, TDOA_SYNC_OUTLIER or TDOA_SYNC_RESTART
+     */
+    int tdoa_sync_beacon(tdoa_sync_t *ts, uint8_t seq, uint64_t ref_tx_ts, uint32_t tof_dtu, uint64_t local_rx_ts);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn tdoa_sync_convert()
+     *
+     * @brief Convert a local timestamp to the clock of the reference anchor.
+     *
+     * @param ts - synchronisation state
+     * @param local_ts - local timestamp (40 bits)
+     * @param ref_ts - receives the timestamp in the reference clock (40 bits)
+     *
+     * @return 0, or -1 if not synchronised or too far from the last beacon
+     */
+    int tdoa_sync_convert(const tdoa_sync_t *ts, uint64_t local_ts, uint64_t *ref_ts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,581 @@
+/*! ----------------------------------------------------------------------------
+ * @file    twr_bench.c
+ * @brief   Ranging throughput and latency benchmark
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <range_stats.h>
+#include <stdio.h>
+#include <string.h>
+#include <twr_bench.h>
+
+extern void test_run_info(unsigned char *data);
+
+/* Presets swept by the benchmark, see NOTE 1 below. */
+static const twr_bench_preset_t presets[] = {
+    /* option, { channel, preamble length, code, 6.8 Mbps, STS length, PAC } */
+    { 1, { 5, 64, 9, 0, 64, 8 } },
+    { 3, { 5, 128, 9, 0, 64, 8 } },
+    { 17, { 5, 64, 9, 1, 64, 8 } },
+    { 18, { 9, 64, 9, 1, 64, 8 } },
+    { 19, { 5, 128, 9, 1, 64, 8 } },
+    { 23, { 5, 1024, 9, 1, 64, 8 } },
+    { 33, { 5, 128, 9, 1, 128, 8 } },
+};
+
+#define NUM_PRESETS (sizeof(presets) / sizeof(presets[0]))
+
+/* Preset used to set up the runs, the default configuration of the examples */
+static const twr_bench_preset_t setup_preset = { 0, { 5, 128, 9, 1, 64, 8 } };
+
+static const char *const variant_name[TWR_BENCH_NUM_VARIANTS] = { "ss_twr", "ds_twr", "ss_twr_sts", "ds_twr_sts_sdc", "ss_twr_aes" };
+
+/* Frames, see NOTE 2 below. */
+#define FRAME_SN_IDX   2
+#define FRAME_FN_IDX   9
+#define FRAME_DATA_IDX 10
+#define FRAME_FCS_LEN  2
+
+#define FN_SETUP 0xB0
+#define FN_ACK   0xB1
+#define FN_POLL  0xE0
+#define FN_RESP  0xE1
+#define FN_FINAL 0xE2
+
+#define SETUP_LEN (FRAME_DATA_IDX + 4 + FRAME_FCS_LEN)
+#define ACK_LEN   (FRAME_DATA_IDX + 1 + 8 * 4 + FRAME_FCS_LEN)
+#define POLL_LEN  (FRAME_DATA_IDX + FRAME_FCS_LEN)
+#define RESP_LEN  (FRAME_DATA_IDX + 8 + FRAME_FCS_LEN)
+#define FINAL_LEN (FRAME_DATA_IDX + 12 + FRAME_FCS_LEN)
+
+static const uint8_t frame_hdr[FRAME_FN_IDX] = { 0x41, 0x88, 0, 0xCA, 0xDE, 'W', 'A', 'V', 'E' };
+
+#define UUS_TO_DTU     63898
+#define DTU_S          (1.0 / 499.2e6 / 128.0)
+#define LIGHT_SPEED    299702547
+#define RX_EARLY_UUS   100 /* The receiver is enabled this much before the expected preamble */
+#define RX_MARGIN_UUS  100 /* RX timeout margin after the expected end of a frame */
+
+#define NUM_TA_QUANTILES 3
+
+static const float ta_quantile[NUM_TA_QUANTILES] = { 0.5f, 0.95f, 0.99f };
+
+/* Timing of the exchanges of a run, derived from the preset and variant */
+typedef struct
+{
+    uint32_t resp_dly_uus;      /* Poll RX timestamp to response TX time */
+    uint32_t final_dly_uus;     /* Response RX timestamp to final TX time */
+    uint32_t rx_after_tx_uus;   /* End of a frame to the receiver being enabled for the answer */
+    uint32_t resp_timeout_uus;  /* Response RX timeout */
+    uint32_t final_timeout_uus; /* Final RX timeout */
+    uint32_t poll_tail_ns;      /* Part of the poll after its RMARKER */
+    uint32_t resp_tail_ns;      /* Part of the response after its RMARKER */
+} bench_timing_t;
+
+/* Turnaround statistics, see NOTE 4 below */
+typedef struct
+{
+    p2_quantile_t q[NUM_TA_QUANTILES];
+    uint32_t max_ns;
+} bench_ta_t;
+
+/* Results of the initiator for one run */
+typedef struct
+{
+    uint8_t variant;
+    uint8_t preset;
+    uint32_t exchanges;
+    uint32_t ok;
+    uint32_t timeouts;
+    uint32_t errors;
+    uint32_t late;
+    uint32_t elapsed_us;
+    uint32_t wait_us;
+    uint32_t guard_us;
+    p2_quantile_t dist; /* mm, SS-TWR variants */
+    bench_ta_t final_ta; /* DS-TWR variants */
+} bench_run_t;
+
+/* Results of the responder for one run, sent back in the setup acknowledgement of the next run */
+typedef struct
+{
+    uint32_t polls;
+    uint32_t late;
+    uint32_t ranges;
+    p2_quantile_t dist; /* mm, DS-TWR variants */
+    bench_ta_t resp_ta;
+} bench_resp_t;
+
+static uint8_t tx_buffer[TWR_BENCH_FRAME_LEN];
+static uint8_t rx_buffer[TWR_BENCH_FRAME_LEN];
+static uint8_t frame_seq_nb;
+static char json[512];
+
+static uint32_t us_to_uus(uint32_t us)
+{
+    return us * 39 / 40;
+}
+
+static void bench_timing(const twr_bench_preset_t *preset, twr_bench_variant_e variant, bench_timing_t *t)
+{
+    int sts = TWR_BENCH_VARIANT_STS(variant);
+    uint16_t extra = (variant == TWR_BENCH_SS_TWR_AES) ? TWR_BENCH_AES_OVERHEAD : 0;
+    uint32_t margin = TWR_BENCH_PROC_MARGIN_UUS + ((variant == TWR_BENCH_SS_TWR_AES) ? TWR_BENCH_AES_MARGIN_UUS : 0);
+    uint32_t poll_air, poll_pre, resp_air, resp_pre, final_air, final_pre;
+
+    poll_air = uwb_phy_airtime_us(&preset->phy, sts, POLL_LEN + extra, &poll_pre);
+    resp_air = uwb_phy_airtime_us(&preset->phy, sts, RESP_LEN + extra, &resp_pre);
+    final_air = uwb_phy_airtime_us(&preset->phy, sts, FINAL_LEN + extra, &final_pre);
+
+    /* The delayed TX time is the RMARKER of the answer: the end of the received frame, the processing margin and the preamble of the answer. */
+    t->resp_dly_uus = us_to_uus(poll_air - poll_pre + resp_pre) + margin;
+    t->final_dly_uus = us_to_uus(resp_air - resp_pre + final_pre) + margin;
+    t->rx_after_tx_uus = margin - RX_EARLY_UUS;
+    t->resp_timeout_uus = RX_EARLY_UUS + us_to_uus(resp_air) + RX_MARGIN_UUS;
+    t->final_timeout_uus = RX_EARLY_UUS + us_to_uus(final_air) + RX_MARGIN_UUS;
+    t->poll_tail_ns = (poll_air - poll_pre) * 1000;
+    t->resp_tail_ns = (resp_air - resp_pre) * 1000;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void frame_init(uint8_t fn, uint8_t seq)
+{
+    memcpy(tx_buffer, frame_hdr, FRAME_FN_IDX);
+    tx_buffer[FRAME_SN_IDX] = seq;
+    tx_buffer[FRAME_FN_IDX] = fn;
+}
+
+static int frame_is(int len, uint8_t fn, int expected_len)
+{
+    return len == expected_len && rx_buffer[FRAME_FN_IDX] == fn && memcmp(&rx_buffer[3], &frame_hdr[3], FRAME_FN_IDX - 3) == 0;
+}
+
+static void bench_ta_init(bench_ta_t *ta)
+{
+    int i;
+
+    for (i = 0; i < NUM_TA_QUANTILES; i++)
+    {
+        range_stats_p2_init(&ta->q[i], ta_quantile[i]);
+    }
+    ta->max_ns = 0;
+}
+
+/* Add a turnaround, measured in units of 256 DTU from an RMARKER, to the statistics. tail_ns is the part of the received frame after it. */
+static void bench_ta_add(bench_ta_t *ta, uint32_t ta_sys, uint32_t tail_ns)
+{
+    uint32_t ns = (uint32_t)((uint64_t)ta_sys * 40064 / 10000);
+    int i;
+
+    ns = (ns > tail_ns) ? ns - tail_ns : 0;
+    for (i = 0; i < NUM_TA_QUANTILES; i++)
+    {
+        range_stats_p2_add(&ta->q[i], (float)ns);
+    }
+    if (ns > ta->max_ns)
+    {
+        ta->max_ns = ns;
+    }
+}
+
+static void bench_ss_exchange(const twr_bench_radio_t *radio, const bench_timing_t *t, bench_run_t *r)
+{
+    uint32_t poll_tx_ts, resp_rx_ts, poll_rx_ts, resp_tx_ts;
+    int32_t rtd_init, rtd_resp;
+    float clock_offset_ratio;
+    double tof;
+    int len;
+
+    frame_init(FN_POLL, frame_seq_nb++);
+    radio->send(tx_buffer, POLL_LEN, 0, t->rx_after_tx_uus, t->resp_timeout_uus);
+
+    len = radio->receive(rx_buffer, sizeof(rx_buffer), t->resp_timeout_uus);
+    if (len == TWR_BENCH_TIMEOUT)
+    {
+        r->timeouts++;
+        return;
+    }
+    if (!frame_is(len, FN_RESP, RESP_LEN))
+    {
+        r->errors++;
+        return;
+    }
+
+    /* Same computation as the SS-TWR initiator example. */
+    poll_tx_ts = (uint32_t)radio->tx_timestamp();
+    resp_rx_ts = (uint32_t)radio->rx_timestamp();
+    clock_offset_ratio = ((float)radio->clock_offset()) / (uint32_t)(1 << 26);
+    poll_rx_ts = get_u32(&rx_buffer[FRAME_DATA_IDX]);
+    resp_tx_ts = get_u32(&rx_buffer[FRAME_DATA_IDX + 4]);
+
+    rtd_init = resp_rx_ts - poll_tx_ts;
+    rtd_resp = resp_tx_ts - poll_rx_ts;
+    tof = ((rtd_init - rtd_resp * (1 - clock_offset_ratio)) / 2.0) * DTU_S;
+
+    range_stats_p2_add(&r->dist, (float)(tof * LIGHT_SPEED * 1000));
+    r->ok++;
+}
+
+static void bench_ds_exchange(const twr_bench_radio_t *radio, const bench_timing_t *t, bench_run_t *r)
+{
+    uint64_t poll_tx_ts, resp_rx_ts, final_tx_ts;
+    uint32_t final_tx_time, ta;
+    int len, ret;
+
+    frame_init(FN_POLL, frame_seq_nb++);
+    radio->send(tx_buffer, POLL_LEN, 0, t->rx_after_tx_uus, t->resp_timeout_uus);
+
+    len = radio->receive(rx_buffer, sizeof(rx_buffer), t->resp_timeout_uus);
+    if (len == TWR_BENCH_TIMEOUT)
+    {
+        r->timeouts++;
+        return;
+    }
+    if (!frame_is(len, FN_RESP, RESP_LEN))
+    {
+        r->errors++;
+        return;
+    }
+
+    /* Same computation as the DS-TWR initiator example. */
+    poll_tx_ts = radio->tx_timestamp();
+    resp_rx_ts = radio->rx_timestamp();
+    final_tx_time = (uint32_t)((resp_rx_ts + (uint64_t)t->final_dly_uus * UUS_TO_DTU) >> 8);
+    final_tx_ts = (((uint64_t)(final_tx_time & 0xFFFFFFFEUL)) << 8) + TWR_BENCH_ANT_DLY;
+
+    frame_init(FN_FINAL, frame_seq_nb++);
+    put_u32(&tx_buffer[FRAME_DATA_IDX], (uint32_t)poll_tx_ts);
+    put_u32(&tx_buffer[FRAME_DATA_IDX + 4], (uint32_t)resp_rx_ts);
+    put_u32(&tx_buffer[FRAME_DATA_IDX + 8], (uint32_t)final_tx_ts);
+    ret = radio->send(tx_buffer, FINAL_LEN, final_tx_time, 0, 0);
+    ta = radio->sys_time() - (uint32_t)(resp_rx_ts >> 8);
+    if (ret == TWR_BENCH_LATE)
+    {
+        r->late++;
+        return;
+    }
+    radio->wait_tx_done();
+
+    /* The exchange succeeds if the responder receives the final, counted by it. See NOTE 3 below. */
+    bench_ta_add(&r->final_ta, ta, t->resp_tail_ns);
+}
+
+/* Leave the responder time to re-enable its receiver before the next poll. See NOTE 4 below. */
+static void bench_guard(const twr_bench_radio_t *radio, bench_run_t *r)
+{
+    uint32_t start = radio->time_us();
+
+    radio->sleep_until_us(start + TWR_BENCH_GUARD_UUS * 40 / 39);
+    r->guard_us += radio->time_us() - start;
+}
+
+static void bench_initiator_run(const twr_bench_radio_t *radio, uint8_t variant, uint8_t preset, uint32_t run_ms, bench_run_t *r)
+{
+    bench_timing_t t;
+    uint32_t start;
+
+    memset(r, 0, sizeof(*r));
+    r->variant = variant;
+    r->preset = preset;
+    range_stats_p2_init(&r->dist, 0.5f);
+    bench_ta_init(&r->final_ta);
+
+    bench_timing(&presets[preset], variant, &t);
+    radio->configure(&presets[preset], variant);
+    radio->sleep_ms(TWR_BENCH_SETTLE_MS);
+
+    /* Exchanges separated by the guard time, see NOTE 4 below. */
+    radio->take_wait_us();
+    start = radio->time_us();
+    while (radio->time_us() - start < run_ms * 1000)
+    {
+        r->exchanges++;
+        if (TWR_BENCH_VARIANT_DS(variant))
+        {
+            bench_ds_exchange(radio, &t, r);
+        }
+        else
+        {
+            bench_ss_exchange(radio, &t, r);
+        }
+        bench_guard(radio, r);
+    }
+    r->elapsed_us = radio->time_us() - start;
+    r->wait_us = radio->take_wait_us();
+}
+
+/* Send the setup of a run with the setup preset until it is acknowledged. Returns 0 and the acknowledgement in rx_buffer, or -1. */
+static int bench_setup(const twr_bench_radio_t *radio, uint8_t run, uint8_t variant, uint8_t preset, uint8_t last)
+{
+    int i, len;
+
+    radio->configure(&setup_preset, TWR_BENCH_SS_TWR);
+
+    for (i = 0; i < TWR_BENCH_SETUP_RETRIES; i++)
+    {
+        frame_init(FN_SETUP, frame_seq_nb++);
+        tx_buffer[FRAME_DATA_IDX] = run;
+        tx_buffer[FRAME_DATA_IDX + 1] = variant;
+        tx_buffer[FRAME_DATA_IDX + 2] = preset;
+        tx_buffer[FRAME_DATA_IDX + 3] = last;
+        radio->send(tx_buffer, SETUP_LEN, 0, 0, TWR_BENCH_SETUP_TIMEOUT_UUS);
+
+        len = radio->receive(rx_buffer, sizeof(rx_buffer), TWR_BENCH_SETUP_TIMEOUT_UUS);
+        if (frame_is(len, FN_ACK, ACK_LEN) && rx_buffer[FRAME_DATA_IDX] == run)
+        {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Print the results of a run, with the responder results from the acknowledgement in rx_buffer. See NOTE 3 below. */
+static void bench_report(uint8_t run, const bench_run_t *r)
+{
+    const twr_bench_preset_t *p = &presets[r->preset];
+    const uint8_t *ack = &rx_buffer[FRAME_DATA_IDX + 1];
+    uint32_t elapsed = r->elapsed_us ? r->elapsed_us : 1;
+    uint32_t idle = r->wait_us + r->guard_us;
+    uint32_t busy = (elapsed > idle) ? elapsed - idle : 0;
+    int32_t dist = TWR_BENCH_VARIANT_DS(r->variant) ? (int32_t)get_u32(&ack[12]) : range_stats_quantile_mm(&r->dist);
+    uint32_t ok = TWR_BENCH_VARIANT_DS(r->variant) ? get_u32(&ack[8]) : r->ok;
+    int n;
+
+    n = snprintf(json, sizeof(json),
+        "{\"run\":%u,\"variant\":\"%s\",\"option\":%u,\"channel\":%u,\"plen\":%u,\"rate\":\"%s\",\"sts_len\":%u,\"elapsed_ms\":%lu,"
+        "\"exchanges\":%lu,\"ok\":%lu,\"timeouts\":%lu,\"errors\":%lu,\"late\":%lu,\"exch_per_s\":%lu,\"success_permille\":%lu,"
+        "\"cpu_pct\":%lu,\"dist_mm\":%ld,",
+        run, variant_name[r->variant], p->option, p->phy.channel, p->phy.plen, p->phy.rate_6m8 ? "6M8" : "850K", p->phy.sts_len,
+        (unsigned long)(elapsed / 1000), (unsigned long)r->exchanges, (unsigned long)ok, (unsigned long)r->timeouts,
+        (unsigned long)r->errors, (unsigned long)r->late, (unsigned long)((uint64_t)ok * 1000000 / elapsed),
+        (unsigned long)(r->exchanges ? (uint64_t)ok * 1000 / r->exchanges : 0), (unsigned long)((uint64_t)busy * 100 / elapsed), (long)dist);
+
+    snprintf(&json[n], sizeof(json) - n,
+        "\"resp_polls\":%lu,\"resp_late\":%lu,\"resp_ranges\":%lu,\"resp_ta_ns\":[%lu,%lu,%lu,%lu],\"final_ta_ns\":[%ld,%ld,%ld,%lu]}",
+        (unsigned long)get_u32(&ack[0]), (unsigned long)get_u32(&ack[4]), (unsigned long)get_u32(&ack[8]), (unsigned long)get_u32(&ack[16]),
+        (unsigned long)get_u32(&ack[20]), (unsigned long)get_u32(&ack[24]), (unsigned long)get_u32(&ack[28]),
+        (long)range_stats_quantile_mm(&r->final_ta.q[0]), (long)range_stats_quantile_mm(&r->final_ta.q[1]),
+        (long)range_stats_quantile_mm(&r->final_ta.q[2]), (unsigned long)r->final_ta.max_ns);
+
+    test_run_info((unsigned char *)json);
+}
+
+int twr_bench_run_initiator(const twr_bench_radio_t *radio, uint32_t run_ms)
+{
+    static bench_run_t result;
+    uint8_t run = 0;
+    uint8_t variant, preset;
+
+    for (variant = 0; variant < TWR_BENCH_NUM_VARIANTS; variant++)
+    {
+        for (preset = 0; preset < NUM_PRESETS; preset++)
+        {
+            /* The acknowledgement of each setup carries the responder results of the previous run. */
+            if (bench_setup(radio, run, variant, preset, 0))
+            {
+                test_run_info((unsigned char *)"{\"error\":\"no answer from the responder\"}");
+                return -1;
+            }
+            if (run > 0)
+            {
+                bench_report(run - 1, &result);
+            }
+
+            bench_initiator_run(radio, variant, preset, run_ms, &result);
+            run++;
+        }
+    }
+
+    if (bench_setup(radio, run, 0, 0, 1))
+    {
+        test_run_info((unsigned char *)"{\"error\":\"no answer from the responder\"}");
+        return -1;
+    }
+    bench_report(run - 1, &result);
+
+    snprintf(json, sizeof(json), "{\"done\":%u}", run);
+    test_run_info((unsigned char *)json);
+    return 0;
+}
+
+static void bench_responder_run(const twr_bench_radio_t *radio, uint8_t variant, uint8_t preset, bench_resp_t *s)
+{
+    bench_timing_t t;
+    uint64_t poll_rx_ts, resp_tx_ts, final_rx_ts;
+    uint32_t resp_tx_time, last_poll, ta;
+    int len, ret;
+
+    bench_timing(&presets[preset], variant, &t);
+    radio->configure(&presets[preset], variant);
+
+    /* Answer polls until the initiator moves on to the next run. */
+    last_poll = radio->time_us();
+    while (radio->time_us() - last_poll < TWR_BENCH_IDLE_MS * 1000)
+    {
+        len = radio->receive(rx_buffer, sizeof(rx_buffer), TWR_BENCH_IDLE_TIMEOUT_UUS);
+        if (!frame_is(len, FN_POLL, POLL_LEN))
+        {
+            continue;
+        }
+        last_poll = radio->time_us();
+        s->polls++;
+
+        /* Same computation as the TWR responder examples. */
+        poll_rx_ts = radio->rx_timestamp();
+        resp_tx_time = (uint32_t)((poll_rx_ts + (uint64_t)t.resp_dly_uus * UUS_TO_DTU) >> 8);
+        resp_tx_ts = (((uint64_t)(resp_tx_time & 0xFFFFFFFEUL)) << 8) + TWR_BENCH_ANT_DLY;
+
+        frame_init(FN_RESP, rx_buffer[FRAME_SN_IDX]);
+        put_u32(&tx_buffer[FRAME_DATA_IDX], (uint32_t)poll_rx_ts);
+        put_u32(&tx_buffer[FRAME_DATA_IDX + 4], (uint32_t)resp_tx_ts);
+        if (TWR_BENCH_VARIANT_DS(variant))
+        {
+            ret = radio->send(tx_buffer, RESP_LEN, resp_tx_time, t.rx_after_tx_uus, t.final_timeout_uus);
+        }
+        else
+        {
+            ret = radio->send(tx_buffer, RESP_LEN, resp_tx_time, 0, 0);
+        }
+        ta = radio->sys_time() - (uint32_t)(poll_rx_ts >> 8);
+        if (ret == TWR_BENCH_LATE)
+        {
+            s->late++;
+            continue;
+        }
+        bench_ta_add(&s->resp_ta, ta, t.poll_tail_ns);
+
+        if (!TWR_BENCH_VARIANT_DS(variant))
+        {
+            radio->wait_tx_done();
+            s->ranges++;
+            continue;
+        }
+
+        len = radio->receive(rx_buffer, sizeof(rx_buffer), t.final_timeout_uus);
+        if (frame_is(len, FN_FINAL, FINAL_LEN))
+        {
+            uint32_t poll_tx_ts, resp_rx_ts, final_tx_ts;
+            double ra, rb, da, db;
+            int64_t tof_dtu;
+
+            resp_tx_ts = radio->tx_timestamp();
+            final_rx_ts = radio->rx_timestamp();
+            poll_tx_ts = get_u32(&rx_buffer[FRAME_DATA_IDX]);
+            resp_rx_ts = get_u32(&rx_buffer[FRAME_DATA_IDX + 4]);
+            final_tx_ts = get_u32(&rx_buffer[FRAME_DATA_IDX + 8]);
+
+            ra = (double)(resp_rx_ts - poll_tx_ts);
+            rb = (double)((uint32_t)final_rx_ts - (uint32_t)resp_tx_ts);
+            da = (double)(final_tx_ts - resp_rx_ts);
+            db = (double)((uint32_t)resp_tx_ts - (uint32_t)poll_rx_ts);
+            tof_dtu = (int64_t)((ra * rb - da * db) / (ra + rb + da + db));
+
+            range_stats_p2_add(&s->dist, (float)(tof_dtu * DTU_S * LIGHT_SPEED * 1000));
+            s->ranges++;
+        }
+    }
+}
+
+int twr_bench_run_responder(const twr_bench_radio_t *radio)
+{
+    static bench_resp_t cur, prev;
+    int cur_run = -1;
+    uint8_t variant, preset;
+    int len, i;
+
+    memset(&cur, 0, sizeof(cur));
+
+    while (1)
+    {
+        /* Wait for the setup of the next run. */
+        radio->configure(&setup_preset, TWR_BENCH_SS_TWR);
+        do
+        {
+            len = radio->receive(rx_buffer, sizeof(rx_buffer), 0);
+        } while (!frame_is(len, FN_SETUP, SETUP_LEN));
+
+        /* A repeated setup means the acknowledgement was lost, send the same results again. */
+        if (rx_buffer[FRAME_DATA_IDX] != cur_run)
+        {
+            prev = cur;
+            cur_run = rx_buffer[FRAME_DATA_IDX];
+        }
+        variant = rx_buffer[FRAME_DATA_IDX + 1];
+        preset = rx_buffer[FRAME_DATA_IDX + 2];
+
+        frame_init(FN_ACK, rx_buffer[FRAME_SN_IDX]);
+        tx_buffer[FRAME_DATA_IDX] = (uint8_t)cur_run;
+        put_u32(&tx_buffer[FRAME_DATA_IDX + 1], prev.polls);
+        put_u32(&tx_buffer[FRAME_DATA_IDX + 5], prev.late);
+        put_u32(&tx_buffer[FRAME_DATA_IDX + 9], prev.ranges);
+        put_u32(&tx_buffer[FRAME_DATA_IDX + 13], (uint32_t)range_stats_quantile_mm(&prev.dist));
+        for (i = 0; i < NUM_TA_QUANTILES; i++)
+        {
+            put_u32(&tx_buffer[FRAME_DATA_IDX + 17 + 4 * i], (uint32_t)range_stats_quantile_mm(&prev.resp_ta.q[i]));
+        }
+        put_u32(&tx_buffer[FRAME_DATA_IDX + 29], prev.resp_ta.max_ns);
+        radio->send(tx_buffer, ACK_LEN, 0, 0, 0);
+        radio->wait_tx_done();
+
+        if (rx_buffer[FRAME_DATA_IDX + 3])
+        {
+            return 0;
+        }
+        if (variant >= TWR_BENCH_NUM_VARIANTS || preset >= NUM_PRESETS)
+        {
+            continue;
+        }
+
+        memset(&cur, 0, sizeof(cur));
+        range_stats_p2_init(&cur.dist, 0.5f);
+        bench_ta_init(&cur.resp_ta);
+        bench_responder_run(radio, variant, preset, &cur);
+    }
+}
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. The presets are a subset of the configuration options of config_options.h (64 MHz PRF, PAC 8, 4z 8 symbol SFD), with the number of the
+ *    option reported in the results. Add entries to the table to sweep other options. The air time of the frames, which sets the response
+ *    delays and RX timeouts, is the one modelled by uwb_phy_airtime_us(), see platform/uwb_phy.c.
+ * 2. The frames follow the format of the TWR examples: IEEE 802.15.4 data frame header (frame control 0x8841, sequence number, PAN ID 0xDECA,
+ *    destination "WA" and source "VE"), a function code and little endian data:
+ *      - setup 0xB0: run number, variant, preset index, last run flag. Always sent with the setup preset.
+ *      - setup acknowledgement 0xB1: run number, then the responder results of the previous run: polls received, responses too late, ranges
+ *        completed, median distance in mm (DS-TWR), median, 95th and 99th percentile and maximum of the response turnaround in ns.
+ *      - poll 0xE0, response 0xE1 (poll RX and response TX timestamps) and final 0xE2 (poll TX, response RX and final TX timestamps).
+ *    The AES variant carries the same frames as payload of an encrypted 802.15.8 frame, TWR_BENCH_AES_OVERHEAD bytes longer.
+ * 3. One JSON object per line is printed with test_run_info() for each run, so the console output can be filtered on lines starting with '{':
+ *      - run, variant, option, channel, plen, rate, sts_len: what was run
+ *      - elapsed_ms, exchanges: duration of the run and number of exchanges started by the initiator
+ *      - ok: exchanges which gave a range, the responses received by the initiator for SS-TWR and the finals received by the responder
+ *        (resp_ranges) for DS-TWR
+ *      - timeouts, errors, late: exchanges lost by the initiator to an RX timeout, an RX/STS/AES error or a bad frame, a missed delayed final
+ *        TX time. For DS-TWR the rest of the exchanges which are not ok lost the final.
+ *      - exch_per_s, success_permille: completed exchanges per second and per thousand exchanges started
+ *      - cpu_pct: share of the run the initiator CPU was not waiting for the radio or in the guard time between exchanges
+ *      - dist_mm: median distance, from the initiator for SS-TWR and from the responder for DS-TWR
+ *      - resp_polls, resp_late, resp_ranges: responder counts, see NOTE 2
+ *      - resp_ta_ns, final_ta_ns: median, 95th and 99th percentile and maximum turnaround of the responder (poll to response) and of the
+ *        initiator (response to final, DS-TWR only), see NOTE 4
+ *    The last line is {"done":<number of runs>}.
+ * 4. The turnaround is the time from the end of a received frame to the return of the call programming the delayed answer, measured with the
+ *    device time of the radio. It is the CPU time the delayed answers need, compare it to TWR_BENCH_PROC_MARGIN_UUS: answers are only sent
+ *    in time while it is below. Each run lasts run_ms, the initiator waiting TWR_BENCH_GUARD_UUS after each exchange before its next poll:
+ *    the responder only enables its receiver again after handling the last frame of an exchange, and a poll sent right away races it and is
+ *    lost. The guard covers this CPU time, in the same way as TWR_BENCH_PROC_MARGIN_UUS covers the delayed answers.
+ ****************************************************************************************************************************************************/
@@ -0,0 +1,127 @@
+/*! ----------------------------------------------------------------------------
+ * @file    twr_bench.h
+ * @brief   Ranging throughput and latency benchmark
+ *
+ *          Runs SS-TWR, DS-TWR, SS-TWR with STS, DS-TWR with STS-SDC and AES secured SS-TWR exchanges one after the other, separated by
+ *          a short guard time, for each of a list of configuration presets, and prints one JSON line of results per run. The benchmark only talks
+ *          to the radio through twr_bench_radio_t, so it runs on the DW3000 (twr_bench_dw_radio) as well as against a simulated radio
+ *          on a host (tools/twr_bench_sim). No DW IC driver dependency.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _TWR_BENCH_
+#define _TWR_BENCH_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <uwb_phy.h>
+
+#define TWR_BENCH_RUN_MS 2000 /* Default duration of the exchanges of one variant and preset */
+
+#define TWR_BENCH_PROC_MARGIN_UUS 400 /* CPU time allowed to the responder between the end of a frame and its delayed response */
+#define TWR_BENCH_AES_MARGIN_UUS  300 /* Additional time allowed to decrypt and encrypt the frames of the AES variant */
+#define TWR_BENCH_GUARD_UUS       300 /* Time left to the responder between the end of an exchange and the next poll, see NOTE 4 in twr_bench.c */
+
+#define TWR_BENCH_SETUP_TIMEOUT_UUS 5000 /* Time to wait for the answer to a setup frame */
+#define TWR_BENCH_SETUP_RETRIES     400  /* Setup frames sent before the responder is considered lost */
+#define TWR_BENCH_IDLE_TIMEOUT_UUS  50000 /* RX timeout of the responder while waiting for polls */
+#define TWR_BENCH_IDLE_MS           300  /* Time without polls after which the responder returns to the setup preset */
+#define TWR_BENCH_SETTLE_MS         10   /* Time given to the responder to switch to the preset of a run */
+
+#define TWR_BENCH_FRAME_LEN 48 /* Size of the frame buffers, including the FCS */
+#define TWR_BENCH_AES_OVERHEAD 37 /* 802.15.8 header (21 bytes) and MIC (16 bytes) added to the frames of the AES variant */
+#define TWR_BENCH_ANT_DLY 16385 /* Antenna delay applied to TX and RX, in DTU */
+
+/* Return values of the radio functions */
+#define TWR_BENCH_OK      0
+#define TWR_BENCH_TIMEOUT (-1) /* RX timeout */
+#define TWR_BENCH_ERROR   (-2) /* RX error, bad STS quality or decryption error */
+#define TWR_BENCH_LATE    (-3) /* Delayed transmission requested too late */
+
+    typedef enum
+    {
+        TWR_BENCH_SS_TWR = 0,
+        TWR_BENCH_DS_TWR,
+        TWR_BENCH_SS_TWR_STS,
+        TWR_BENCH_DS_TWR_STS_SDC,
+        TWR_BENCH_SS_TWR_AES,
+        TWR_BENCH_NUM_VARIANTS
+    } twr_bench_variant_e;
+
+#define TWR_BENCH_VARIANT_STS(v) ((v) == TWR_BENCH_SS_TWR_STS || (v) == TWR_BENCH_DS_TWR_STS_SDC)
+#define TWR_BENCH_VARIANT_DS(v)  ((v) == TWR_BENCH_DS_TWR || (v) == TWR_BENCH_DS_TWR_STS_SDC)
+
+    /* Configuration preset, see NOTE 1 in twr_bench.c */
+    typedef struct
+    {
+        uint8_t option;     /* Number of the configuration option in config_options.h, 0 for the setup preset */
+        struct uwb_phy phy; /* Air interface, the STS length is used by the STS variants */
+    } twr_bench_preset_t;
+
+    /* Radio used by the benchmark, all times in UWB microseconds (UUS, 1.0256 us) or device time units (DTU, 15.65 ps) */
+    typedef struct
+    {
+        /* Configure the radio for a preset and variant. Returns TWR_BENCH_OK or TWR_BENCH_ERROR. */
+        int (*configure)(const twr_bench_preset_t *preset, twr_bench_variant_e variant);
+        /* Send a frame (length including the FCS) immediately or, if tx_time is not 0, at tx_time (upper 32 bits of the 40-bit device time).
+         * If rx_timeout_uus is not 0 the receiver is enabled rx_after_tx_uus after the frame. Returns TWR_BENCH_OK or TWR_BENCH_LATE. */
+        int (*send)(uint8_t *frame, uint16_t len, uint32_t tx_time, uint32_t rx_after_tx_uus, uint32_t rx_timeout_uus);
+        /* Wait for the end of the frame being sent. */
+        void (*wait_tx_done)(void);
+        /* Receive a frame, enabling the receiver first unless send() did. timeout_uus 0 waits forever. Returns the frame length (including the
+         * FCS), TWR_BENCH_TIMEOUT or TWR_BENCH_ERROR. */
+        int (*receive)(uint8_t *buf, uint16_t size, uint32_t timeout_uus);
+        /* Timestamps of the last frame sent and received, 40-bit DTU */
+        uint64_t (*tx_timestamp)(void);
+        uint64_t (*rx_timestamp)(void);
+        /* Clock offset of the remote device, in parts per 2^26 */
+        int16_t (*clock_offset)(void);
+        /* Current device time, upper 32 bits of the 40-bit DTU counter */
+        uint32_t (*sys_time)(void);
+        /* Free running microsecond clock of the host */
+        uint32_t (*time_us)(void);
+        /* Time spent waiting for the radio since the previous call, in microseconds */
+        uint32_t (*take_wait_us)(void);
+        /* Sleep, used while the peer switches configuration */
+        void (*sleep_ms)(uint32_t ms);
+        /* Sleep until time_us() reaches t_us, used for the guard time between exchanges */
+        void (*sleep_until_us)(uint32_t t_us);
+    } twr_bench_radio_t;
+
+    /* DW3000 radio, see twr_bench_dw.c */
+    extern const twr_bench_radio_t twr_bench_dw_radio;
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn twr_bench_run_initiator()
+     *
+     * @brief Run every variant with every preset against a device running twr_bench_run_responder() and print one JSON line of results per run,
+     *        see NOTE 3 in twr_bench.c.
+     *
+     * @param radio - radio to use
+     * @param run_ms - duration of each run in milliseconds
+     *
+     * @return 0 when all runs are done, -1 if the responder stopped answering
+     */
+    int twr_bench_run_initiator(const twr_bench_radio_t *radio, uint32_t run_ms);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @fn twr_bench_run_responder()
+     *
+     * @brief Answer the exchanges of twr_bench_run_initiator() and measure the poll to response turnaround.
+     *
+     * @param radio - radio to use
+     *
+     * @return 0 when the initiator signals the end of the benchmark
+     */
+    int twr_bench_run_responder(const twr_bench_radio_t *radio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,297 @@
+/*! ----------------------------------------------------------------------------
+ * @file    twr_bench_dw.c
+ * @brief   DW3000 radio of the ranging benchmark, see twr_bench.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <deca_device_api.h>
+#include <mac_802_15_8.h>
+#include <port.h>
+#include <shared_defines.h>
+#include <shared_functions.h>
+#include <string.h>
+#include <telem.h>
+#include <twr_bench.h>
+
+extern dwt_txconfig_t txconfig_options;
+extern dwt_txconfig_t txconfig_options_ch9;
+
+/* Same STS key and IV as the STS examples */
+static dwt_sts_cp_key_t cp_key = { 0x14EB220F, 0xF86050A8, 0xD1D336AA, 0x14148674 };
+static dwt_sts_cp_iv_t cp_iv = { 0x1F9A3DE4, 0xD37EC3CA, 0xC44FA8FB, 0x362EEB34 };
+
+/* Same AES key as the AES examples, see NOTE 2 below */
+static const dwt_aes_key_t aes_key = { 0x41424344, 0x45464748, 0x49505152, 0x53545556, 0x00000000, 0x00000000, 0x00000000, 0x00000000 };
+
+static dwt_aes_config_t aes_config = { .key_load = AES_KEY_Load,
+    .key_size = AES_KEY_128bit,
+    .key_src = AES_KEY_Src_Register,
+    .mic = MIC_16,
+    .mode = AES_Encrypt,
+    .aes_core_type = AES_core_type_GCM,
+    .aes_key_otp_type = AES_key_RAM,
+    .key_addr = 0 };
+
+#define AES_MIC_LEN 16
+
+static dwt_config_t config;
+static twr_bench_variant_e cur_variant;
+static uint8_t rx_armed;
+static uint32_t wait_us;
+static uint64_t aes_pn;
+
+static mac_frame_802_15_8_format_t aes_header = { .fc = { 0x50, 0xCC }, /* DATA, 48 bit source and destination addresses */
+    .seq = 0,
+    .dst_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 },
+    .src_addr = { 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 },
+    .nonce = { 0 } };
+
+static int dw_configure(const twr_bench_preset_t *preset, twr_bench_variant_e variant)
+{
+    const struct uwb_phy *phy = &preset->phy;
+
+    config.chan = phy->channel;
+    config.txPreambLength = (phy->plen == 64) ? DWT_PLEN_64 : (phy->plen == 128) ? DWT_PLEN_128 : (phy->plen == 256) ? DWT_PLEN_256 : (phy->plen == 512) ? DWT_PLEN_512 : DWT_PLEN_1024;
+    config.rxPAC = DWT_PAC8;
+    config.txCode = phy->code;
+    config.rxCode = phy->code;
+    config.sfdType = 3; /* 4z 8 symbol SFD */
+    config.dataRate = phy->rate_6m8 ? DWT_BR_6M8 : DWT_BR_850K;
+    config.phrMode = DWT_PHRMODE_STD;
+    config.phrRate = DWT_PHRRATE_STD;
+    config.sfdTO = phy->plen + 1 + 8 - 8; /* Preamble length + 1 + SFD length - PAC size */
+    config.stsMode = (variant == TWR_BENCH_SS_TWR_STS) ? DWT_STS_MODE_1 : (variant == TWR_BENCH_DS_TWR_STS_SDC) ? (DWT_STS_MODE_1 | DWT_STS_MODE_SDC) : DWT_STS_MODE_OFF;
+    config.stsLength = (phy->sts_len == 128) ? DWT_STS_LEN_128 : DWT_STS_LEN_64;
+    config.pdoaMode = DWT_PDOA_M0;
+
+    dwt_forcetrxoff();
+    rx_armed = 0;
+    cur_variant = variant;
+
+    /* If the dwt_configure returns DWT_ERROR either the PLL or RX calibration has failed, the benchmark continues and reports the errors. */
+    if (dwt_configure(&config))
+    {
+        return TWR_BENCH_ERROR;
+    }
+    dwt_configuretxrf((phy->channel == 9) ? &txconfig_options_ch9 : &txconfig_options);
+    dwt_setrxantennadelay(TWR_BENCH_ANT_DLY);
+    dwt_settxantennadelay(TWR_BENCH_ANT_DLY);
+
+    if (variant == TWR_BENCH_SS_TWR_STS)
+    {
+        dwt_configurestskey(&cp_key);
+    }
+    else if (variant == TWR_BENCH_SS_TWR_AES)
+    {
+        dwt_set_keyreg_128(&aes_key);
+    }
+    return TWR_BENCH_OK;
+}
+
+/* Reload the STS IV at the start of an exchange so both ends use the same STS, see NOTE 1 below. */
+static void dw_sts_reload(void)
+{
+    if (cur_variant == TWR_BENCH_SS_TWR_STS)
+    {
+        dwt_configurestsiv(&cp_iv);
+        dwt_configurestsloadiv();
+    }
+}
+
+static int dw_write_aes(uint8_t *frame, uint16_t len)
+{
+    dwt_aes_job_t aes_job;
+    uint8_t nonce[12];
+    int8_t status;
+    int i;
+
+    aes_pn++;
+    for (i = 0; i < 6; i++)
+    {
+        nonce[i] = aes_header.nonce[i] = (uint8_t)(aes_pn >> (8 * i));
+    }
+    memcpy(&nonce[6], &aes_header.src_addr[0], 6);
+    aes_header.seq = frame[2];
+
+    aes_config.mode = AES_Encrypt;
+    dwt_configure_aes(&aes_config);
+
+    aes_job.nonce = nonce;
+    aes_job.header = (uint8_t *)&aes_header;
+    aes_job.header_len = sizeof(aes_header);
+    aes_job.payload = frame;
+    aes_job.payload_len = len - FCS_LEN;
+    aes_job.src_port = AES_Src_Tx_buf;
+    aes_job.dst_port = AES_Dst_Tx_buf;
+    aes_job.mode = AES_Encrypt;
+    aes_job.mic_size = AES_MIC_LEN;
+
+    status = dwt_do_aes(&aes_job, aes_config.aes_core_type);
+    if (status < 0 || (status & DWT_AES_ERRORS))
+    {
+        return TWR_BENCH_ERROR;
+    }
+    dwt_writetxfctrl(sizeof(aes_header) + len + AES_MIC_LEN, 0, 1);
+    return TWR_BENCH_OK;
+}
+
+static int dw_send(uint8_t *frame, uint16_t len, uint32_t tx_time, uint32_t rx_after_tx_uus, uint32_t rx_timeout_uus)
+{
+    uint8_t mode = tx_time ? DWT_START_TX_DELAYED : DWT_START_TX_IMMEDIATE;
+
+    if (cur_variant == TWR_BENCH_SS_TWR_AES)
+    {
+        dw_write_aes(frame, len);
+    }
+    else
+    {
+        dwt_writetxdata(len, frame, 0);
+        dwt_writetxfctrl(len, 0, 1);
+    }
+
+    if (rx_timeout_uus)
+    {
+        dwt_setrxaftertxdelay(rx_after_tx_uus);
+        dwt_setrxtimeout(rx_timeout_uus);
+        mode |= DWT_RESPONSE_EXPECTED;
+    }
+    if (tx_time)
+    {
+        dwt_setdelayedtrxtime(tx_time);
+    }
+    else
+    {
+        dw_sts_reload();
+    }
+
+    rx_armed = 0;
+    if (dwt_starttx(mode) != DWT_SUCCESS)
+    {
+        telem_inc(TELEM_TX_LATE);
+        return TWR_BENCH_LATE;
+    }
+    rx_armed = (rx_timeout_uus != 0);
+    return TWR_BENCH_OK;
+}
+
+static void dw_wait_tx_done(void)
+{
+    uint32_t start = port_get_time_us();
+
+    waitforsysstatus(NULL, NULL, DWT_INT_TXFRS_BIT_MASK, 0);
+    dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+    wait_us += port_get_time_us() - start;
+}
+
+static int dw_receive(uint8_t *buf, uint16_t size, uint32_t timeout_uus)
+{
+    uint32_t status_reg, start;
+    uint16_t frame_len;
+    int16_t sts_qual;
+
+    if (!rx_armed)
+    {
+        dw_sts_reload();
+        dwt_setrxtimeout(timeout_uus);
+        dwt_rxenable(DWT_START_RX_IMMEDIATE);
+    }
+    rx_armed = 0;
+
+    start = port_get_time_us();
+    waitforsysstatus(&status_reg, NULL, (DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR), 0);
+    wait_us += port_get_time_us() - start;
+
+    /* The frame sent before the reception is done as well. */
+    dwt_writesysstatuslo(DWT_INT_TXFRS_BIT_MASK);
+
+    if (!(status_reg & DWT_INT_RXFCG_BIT_MASK))
+    {
+        dwt_writesysstatuslo(SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+        return (status_reg & SYS_STATUS_ALL_RX_TO) ? TWR_BENCH_TIMEOUT : TWR_BENCH_ERROR;
+    }
+    dwt_writesysstatuslo(DWT_INT_RXFCG_BIT_MASK);
+
+    if (TWR_BENCH_VARIANT_STS(cur_variant) && dwt_readstsquality(&sts_qual) < 0)
+    {
+        return TWR_BENCH_ERROR;
+    }
+
+    frame_len = dwt_getframelength();
+    if (cur_variant == TWR_BENCH_SS_TWR_AES)
+    {
+        dwt_aes_job_t aes_job;
+
+        aes_config.mode = AES_Decrypt;
+        dwt_configure_aes(&aes_config);
+        aes_job.src_port = AES_Src_Rx_buf_0;
+        aes_job.dst_port = AES_Dst_Rx_buf_0;
+        aes_job.mode = AES_Decrypt;
+        aes_job.mic_size = AES_MIC_LEN;
+        if (rx_aes_802_15_8(frame_len, &aes_job, buf, size, aes_config.aes_core_type) != AES_RES_OK)
+        {
+            return TWR_BENCH_ERROR;
+        }
+        return frame_len - (sizeof(aes_header) + AES_MIC_LEN);
+    }
+
+    if (frame_len > size)
+    {
+        return TWR_BENCH_ERROR;
+    }
+    dwt_readrxdata(buf, frame_len, 0);
+    return frame_len;
+}
+
+static uint64_t dw_tx_timestamp(void)
+{
+    return get_tx_timestamp_u64();
+}
+
+static uint64_t dw_rx_timestamp(void)
+{
+    return get_rx_timestamp_u64();
+}
+
+static int16_t dw_clock_offset(void)
+{
+    return dwt_readclockoffset();
+}
+
+static uint32_t dw_sys_time(void)
+{
+    return dwt_readsystimestamphi32();
+}
+
+static uint32_t dw_take_wait_us(void)
+{
+    uint32_t w = wait_us;
+
+    wait_us = 0;
+    return w;
+}
+
+const twr_bench_radio_t twr_bench_dw_radio = {
+    .configure = dw_configure,
+    .send = dw_send,
+    .wait_tx_done = dw_wait_tx_done,
+    .receive = dw_receive,
+    .tx_timestamp = dw_tx_timestamp,
+    .rx_timestamp = dw_rx_timestamp,
+    .clock_offset = dw_clock_offset,
+    .sys_time = dw_sys_time,
+    .time_us = port_get_time_us,
+    .take_wait_us = dw_take_wait_us,
+    .sleep_ms = Sleep,
+    .sleep_until_us = port_sleep_until_us,
+};
+
+/*****************************************************************************************************************************************************
+ * NOTES:
+ *
+ * 1. In STS mode 1 the STS counter is incremented with each frame. Both devices reload the IV at the start of an exchange, the initiator before
+ *    its poll and the responder before enabling the receiver for it, and then stay in step for the rest of the exchange. The DS-TWR variant uses
+ *    the deterministic STS (SDC) and needs no key.
+ * 2. The AES variant sends the frames of the benchmark as encrypted payload of an 802.15.8 frame with a 16 byte GCM MIC, as the simple AES TX
+ *    and RX examples. Encryption is done in the DW IC TX buffer before the delayed TX time is programmed, decryption in the RX buffer.
+ ****************************************************************************************************************************************************/
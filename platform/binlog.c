@@ -0,0 +1,141 @@
+/*
+ * Binary deferred logging, see binlog.h
+ *
+ * Stream format, little endian, one record after the other:
+ *   sync (0xB7), timestamp (u32, hardware cycles), event ID (u16),
+ *   number of arguments (u8), sequence number (u8), arguments (i32 each)
+ * The sequence number increments with every record written to the ring, so
+ * the host can detect lost bytes. Records lost because the ring was full are
+ * reported with a BINLOG_DROPPED record.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <zephyr.h>
+
+#include <binlog.h>
+#include <port.h>
+
+#if BINLOG_ENABLED
+
+#define BINLOG_SYNC 0xB7
+#define BINLOG_HDR_LEN 9
+
+#define BINLOG_THREAD_STACK_SIZE 512
+#define BINLOG_DRAIN_PERIOD_MS 10
+
+struct binlog_rec {
+	uint32_t ts;
+	uint16_t id;
+	uint8_t nargs;
+	uint8_t seq;
+	int32_t arg[BINLOG_MAX_ARGS];
+};
+
+static struct binlog_rec ring[BINLOG_NUM_RECS];
+static uint32_t head; /* written by the producers, under irq_lock */
+static uint32_t tail; /* written by the drain thread only */
+static uint32_t dropped;
+static uint8_t seq;
+static bool active; /* set once the log stream is open */
+
+K_THREAD_STACK_DEFINE(binlog_stack, BINLOG_THREAD_STACK_SIZE);
+static struct k_thread binlog_thread;
+
+void binlog_write(uint16_t id, uint8_t nargs, int32_t a0, int32_t a1, int32_t a2)
+{
+	struct binlog_rec *rec;
+	unsigned int key;
+
+	if (!active) {
+		return;
+	}
+
+	key = irq_lock();
+
+	if (head - tail >= BINLOG_NUM_RECS) {
+		dropped++;
+		irq_unlock(key);
+		return;
+	}
+
+	rec = &ring[head & (BINLOG_NUM_RECS - 1)];
+	rec->ts = k_cycle_get_32();
+	rec->id = id;
+	rec->nargs = nargs;
+	rec->seq = seq++;
+	rec->arg[0] = a0;
+	rec->arg[1] = a1;
+	rec->arg[2] = a2;
+	head++;
+
+	irq_unlock(key);
+}
+
+/* Records between tail and head are complete and not touched by producers */
+static int binlog_send(const struct binlog_rec *rec)
+{
+	uint8_t buf[BINLOG_HDR_LEN + sizeof(rec->arg)];
+	uint32_t len = BINLOG_HDR_LEN + rec->nargs * sizeof(int32_t);
+
+	if (port_stream_space(PORT_STREAM_LOG) < len) {
+		return -EAGAIN;
+	}
+
+	buf[0] = BINLOG_SYNC;
+	memcpy(&buf[1], &rec->ts, 4);
+	memcpy(&buf[5], &rec->id, 2);
+	buf[7] = rec->nargs;
+	buf[8] = rec->seq;
+	memcpy(&buf[BINLOG_HDR_LEN], rec->arg, rec->nargs * sizeof(int32_t));
+
+	port_stream_write(PORT_STREAM_LOG, buf, len);
+	return 0;
+}
+
+static void binlog_drain(void *p1, void *p2, void *p3)
+{
+	uint32_t lost;
+	unsigned int key;
+
+	while (1) {
+		while (tail != head) {
+			if (binlog_send(&ring[tail & (BINLOG_NUM_RECS - 1)])) {
+				break;
+			}
+			tail++;
+		}
+
+		key = irq_lock();
+		lost = dropped;
+		dropped = 0;
+		irq_unlock(key);
+
+		if (lost) {
+			BINLOG1(BINLOG_DROPPED, lost);
+		}
+
+		k_msleep(BINLOG_DRAIN_PERIOD_MS);
+	}
+}
+
+int binlog_init(void)
+{
+	int ret;
+
+	ret = port_stream_init(PORT_STREAM_LOG);
+	if (ret < 0) {
+		return ret;
+	}
+	active = true;
+
+	k_thread_create(&binlog_thread, binlog_stack, K_THREAD_STACK_SIZEOF(binlog_stack),
+			binlog_drain, NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0,
+			K_NO_WAIT);
+
+	BINLOG1(BINLOG_START, sys_clock_hw_cycles_per_sec());
+	return 0;
+}
+
+#endif
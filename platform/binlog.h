@@ -0,0 +1,61 @@
+/*
+ * Binary deferred logging
+ *
+ * A log call stores a timestamp, an event ID and up to three integer
+ * arguments into a ring buffer, without any formatting. A low priority thread
+ * drains the ring into the PORT_STREAM_LOG binary stream, and the host renders
+ * the records with tools/binlog_decode.py using the formats of
+ * binlog_events.h. Logging is safe from threads and interrupts (e.g. DW IC
+ * callbacks) and costs a few tens of cycles, so it can stay enabled in
+ * ranging loops. Records are dropped and counted when the ring is full.
+ *
+ * The stream is an RTT channel: without RTT, binlog_init() fails rather than
+ * mixing records with the console text, and log calls return at once.
+ *
+ * Fractional values are logged as fixed point integers, e.g. millimetres or
+ * hundredths, and printed with the %q conversion on the host.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BINLOG_H_
+#define BINLOG_H_
+
+#include <stdint.h>
+
+/* Set to 0 to compile out all log calls */
+#ifndef BINLOG_ENABLED
+#define BINLOG_ENABLED 1
+#endif
+
+#define BINLOG_MAX_ARGS 3
+#define BINLOG_NUM_RECS 128 /* ring size in records, must be a power of 2 */
+
+#define BINLOG_EVENT(name, fmt) name,
+enum binlog_event {
+#include <binlog_events.h>
+	BINLOG_NUM_EVENTS
+};
+#undef BINLOG_EVENT
+
+#if BINLOG_ENABLED
+
+int binlog_init(void);
+void binlog_write(uint16_t id, uint8_t nargs, int32_t a0, int32_t a1, int32_t a2);
+
+#define BINLOG0(id)             binlog_write(id, 0, 0, 0, 0)
+#define BINLOG1(id, a0)         binlog_write(id, 1, (int32_t)(a0), 0, 0)
+#define BINLOG2(id, a0, a1)     binlog_write(id, 2, (int32_t)(a0), (int32_t)(a1), 0)
+#define BINLOG3(id, a0, a1, a2) binlog_write(id, 3, (int32_t)(a0), (int32_t)(a1), (int32_t)(a2))
+
+#else
+
+#define binlog_init()           0
+#define BINLOG0(id)             ((void)0)
+#define BINLOG1(id, a0)         ((void)0)
+#define BINLOG2(id, a0, a1)     ((void)0)
+#define BINLOG3(id, a0, a1, a2) ((void)0)
+
+#endif
+
+#endif /* BINLOG_H_ */
@@ -0,0 +1,29 @@
+/*
+ * Binary log events
+ *
+ * One BINLOG_EVENT(name, format) per event, the ID of an event is its position
+ * in this list. tools/binlog_decode.py reads this file to render the records,
+ * so only append new events and keep one event per line.
+ *
+ * Format conversions: %d signed, %u unsigned, %x hex, and %q<n> for signed
+ * fixed point values with n decimal places (e.g. %q3 prints mm as m), %t for
+ * the name of a telemetry counter of telem.h.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+BINLOG_EVENT(BINLOG_START, "log start, timestamp clock %u Hz")
+BINLOG_EVENT(BINLOG_DROPPED, "%u log records dropped")
+BINLOG_EVENT(BINLOG_RANGE, "DIST: %q3 m")
+BINLOG_EVENT(BINLOG_RANGE_FILTER, "FLT %x r=%q3 m v=%q3 m/s")
+BINLOG_EVENT(BINLOG_PDOA, "PDOA val = %d")
+BINLOG_EVENT(BINLOG_AOA, "AOA pdoa=%d a=%q2 deg n=%u")
+BINLOG_EVENT(BINLOG_AOA_POS, "AOA a=%q2 deg x=%q3 m y=%q3 m")
+BINLOG_EVENT(BINLOG_POS, "POS x=%q3 m y=%q3 m z=%q3 m")
+BINLOG_EVENT(BINLOG_POS_QUAL, "POS rms=%u mm anchors=%u iter=%u")
+BINLOG_EVENT(BINLOG_TDOA_SYNC, "TDOA drift=%d ppb rms=%u dtu rc=%u")
+BINLOG_EVENT(BINLOG_CSMA, "CSMA res=%u nb=%u delay=%u us")
+BINLOG_EVENT(BINLOG_ARQ, "ARQ bytes=%u us=%u rep=%u")
+BINLOG_EVENT(BINLOG_INDIRECT, "IND %x lat=%u us")
+BINLOG_EVENT(BINLOG_POLL, "POLL fp=%u frames=%u wake=%u us")
+BINLOG_EVENT(BINLOG_TELEM, "TELEM %t +%u total %u")
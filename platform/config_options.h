@@ -11,34 +11,35 @@
  */
 
 #include <deca_device_api.h>
+#include <telem.h>
 
 #ifndef EXAMPLES_CONFIG_OPTIONS_H_
 #define EXAMPLES_CONFIG_OPTIONS_H_
 
-/* Index values for errors in array */
-#define CRC_ERR_IDX                0
-#define RSE_ERR_IDX                1
-#define PHE_ERR_IDX                2
-#define SFDTO_ERR_IDX              3
-#define PTO_ERR_IDX                4
-#define RTO_ERR_IDX                5
-#define SPICRC_ERR_IDX             6
-#define TXTO_ERR_IDX               7
-#define ARFE_ERR_IDX               8
-#define TS_MISMATCH_ERR_IDX        9
-#define BAD_FRAME_ERR_IDX          10
-#define PREAMBLE_COUNT_ERR_IDX     11
-#define CP_QUAL_ERR_IDX            12
-#define STS_PREAMBLE_ERR           13
-#define STS_PEAK_GROWTH_RATE_ERR   14
-#define STS_ADC_COUNT_ERR          15
-#define STS_SFD_COUNT_ERR          16
-#define STS_LATE_FIRST_PATH_ERR    17
-#define STS_LATE_COARSE_EST_ERR    18
-#define STS_COARSE_EST_EMPTY_ERR   19
-#define STS_HIGH_NOISE_THREASH_ERR 20
-#define STS_NON_TRIANGLE_ERR       21
-#define STS_LOG_REG_FAILED_ERR     22
+/* Error counters, counted with telem_inc(), see telem.h */
+#define CRC_ERR_IDX                TELEM_RX_CRC
+#define RSE_ERR_IDX                TELEM_RX_RSE
+#define PHE_ERR_IDX                TELEM_RX_PHE
+#define SFDTO_ERR_IDX              TELEM_RX_SFDTO
+#define PTO_ERR_IDX                TELEM_RX_PTO
+#define RTO_ERR_IDX                TELEM_RX_RTO
+#define SPICRC_ERR_IDX             TELEM_SPICRC
+#define TXTO_ERR_IDX               TELEM_TXTO
+#define ARFE_ERR_IDX               TELEM_ARFE
+#define TS_MISMATCH_ERR_IDX        TELEM_TS_MISMATCH
+#define BAD_FRAME_ERR_IDX          TELEM_BAD_FRAME
+#define PREAMBLE_COUNT_ERR_IDX     TELEM_PREAMBLE_COUNT
+#define CP_QUAL_ERR_IDX            TELEM_CP_QUAL
+#define STS_PREAMBLE_ERR           TELEM_STS_PREAMBLE
+#define STS_PEAK_GROWTH_RATE_ERR   TELEM_STS_PEAK_GROWTH_RATE
+#define STS_ADC_COUNT_ERR          TELEM_STS_ADC_COUNT
+#define STS_SFD_COUNT_ERR          TELEM_STS_SFD_COUNT
+#define STS_LATE_FIRST_PATH_ERR    TELEM_STS_LATE_FIRST_PATH
+#define STS_LATE_COARSE_EST_ERR    TELEM_STS_LATE_COARSE_EST
+#define STS_COARSE_EST_EMPTY_ERR   TELEM_STS_COARSE_EST_EMPTY
+#define STS_HIGH_NOISE_THREASH_ERR TELEM_STS_HIGH_NOISE_THRESH
+#define STS_NON_TRIANGLE_ERR       TELEM_STS_NON_TRIANGLE
+#define STS_LOG_REG_FAILED_ERR     TELEM_STS_LOG_REG_FAILED
 
 /*
  * Number of ranges to attempt in test
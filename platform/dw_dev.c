@@ -0,0 +1,301 @@
+/*
+ * Several DW3000 on one MCU, see dw_dev.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <devicetree.h>
+#include <drivers/gpio.h>
+#include <drivers/spi.h>
+
+#include <deca_device_api.h>
+#include <deca_interface.h>
+#include <dw_dev.h>
+
+#define DT_DRV_COMPAT decawave_dw3000
+
+#define DW_DEV_SLOW_HZ	 2000000 /* SPI rate before the PLL is locked */
+#define DW_DEV_NEST_MAX	 4
+#define DW_DEV_WAKEUP_US 500	 /* wake-up pulse, on WAKEUP or on the chip select */
+#define DW_DEV_IRQ_LOOPS 8	 /* ISR calls per work item, see dw_dev_irq_work() */
+
+struct dw_dev {
+	struct spi_dt_spec spi;
+	struct spi_config spi_slow;
+	const struct spi_config *spi_cfg; /* current rate */
+	struct gpio_dt_spec reset;
+	struct gpio_dt_spec irq;
+	struct gpio_dt_spec wakeup;	  /* optional */
+	struct gpio_callback irq_cb;
+	struct k_work irq_work;
+	dw_dev_isr_t isr;
+	uint32_t irqs;
+	struct dwchip_s chip;
+	struct dwt_probe_s probe;
+};
+
+#define DW_DEV_INST(n)                                                                             \
+	{                                                                                          \
+		.spi = SPI_DT_SPEC_INST_GET(n, SPI_WORD_SET(8) | SPI_TRANSFER_MSB, 0),             \
+		.reset = GPIO_DT_SPEC_INST_GET(n, reset_gpios),                                    \
+		.irq = GPIO_DT_SPEC_INST_GET(n, irq_gpios),                                        \
+		.wakeup = GPIO_DT_SPEC_INST_GET_OR(n, wakeup_gpios, { 0 }),                        \
+	},
+
+static struct dw_dev dw_devs[] = { DT_INST_FOREACH_STATUS_OKAY(DW_DEV_INST) };
+
+#define DW_DEV_NUM (sizeof(dw_devs) / sizeof(dw_devs[0]))
+
+K_MUTEX_DEFINE(dw_dev_mutex);
+static struct dw_dev *dw_dev_cur;
+static struct dw_dev *dw_dev_stack[DW_DEV_NEST_MAX];
+static unsigned int dw_dev_depth;
+
+/*
+ * SPI access functions of the driver: they carry no device, the transfers go
+ * to the device made current by dw_dev_lock()
+ */
+static int32_t dw_dev_spi_read(uint16_t hdr_len, uint8_t *hdr, uint16_t len, uint8_t *buf)
+{
+	const struct spi_buf tx_buf = { .buf = hdr, .len = hdr_len };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+	struct spi_buf rx_bufs[2] = {
+		{ .buf = NULL, .len = hdr_len },
+		{ .buf = buf, .len = len },
+	};
+	const struct spi_buf_set rx = { .buffers = rx_bufs, .count = 2 };
+
+	return spi_transceive(dw_dev_cur->spi.bus, dw_dev_cur->spi_cfg, &tx, &rx);
+}
+
+static int32_t dw_dev_spi_write(uint16_t hdr_len, const uint8_t *hdr, uint16_t len,
+				const uint8_t *buf)
+{
+	const struct spi_buf tx_bufs[2] = {
+		{ .buf = (uint8_t *)hdr, .len = hdr_len },
+		{ .buf = (uint8_t *)buf, .len = len },
+	};
+	const struct spi_buf_set tx = { .buffers = tx_bufs, .count = 2 };
+
+	return spi_write(dw_dev_cur->spi.bus, dw_dev_cur->spi_cfg, &tx);
+}
+
+static int32_t dw_dev_spi_write_crc(uint16_t hdr_len, const uint8_t *hdr, uint16_t len,
+				    const uint8_t *buf, uint8_t crc8)
+{
+	const struct spi_buf tx_bufs[3] = {
+		{ .buf = (uint8_t *)hdr, .len = hdr_len },
+		{ .buf = (uint8_t *)buf, .len = len },
+		{ .buf = &crc8, .len = 1 },
+	};
+	const struct spi_buf_set tx = { .buffers = tx_bufs, .count = 3 };
+
+	return spi_write(dw_dev_cur->spi.bus, dw_dev_cur->spi_cfg, &tx);
+}
+
+static void dw_dev_spi_slow(void)
+{
+	dw_dev_cur->spi_cfg = &dw_dev_cur->spi_slow;
+}
+
+static void dw_dev_spi_fast(void)
+{
+	dw_dev_cur->spi_cfg = &dw_dev_cur->spi.config;
+}
+
+static void dw_dev_wakeup_io(void)
+{
+	static uint8_t dummy[DW_DEV_WAKEUP_US * (DW_DEV_SLOW_HZ / 1000000) / 8];
+	uint8_t hdr = 0;
+
+	if (dw_dev_cur->wakeup.port) {
+		gpio_pin_set_dt(&dw_dev_cur->wakeup, 1);
+		k_busy_wait(DW_DEV_WAKEUP_US);
+		gpio_pin_set_dt(&dw_dev_cur->wakeup, 0);
+		return;
+	}
+
+	/* no WAKEUP line: hold the chip select low as long, with a read at the slow rate */
+	dw_dev_cur->spi_cfg = &dw_dev_cur->spi_slow;
+	dw_dev_spi_read(1, &hdr, sizeof(dummy), dummy);
+	dw_dev_cur->spi_cfg = &dw_dev_cur->spi.config;
+}
+
+static const struct dwt_spi_s dw_dev_spi_fct = {
+	.readfromspi = dw_dev_spi_read,
+	.writetospi = dw_dev_spi_write,
+	.writetospiwithcrc = dw_dev_spi_write_crc,
+	.setslowrate = dw_dev_spi_slow,
+	.setfastrate = dw_dev_spi_fast,
+};
+
+void dw_dev_lock(struct dw_dev *dev)
+{
+	k_mutex_lock(&dw_dev_mutex, K_FOREVER);
+	__ASSERT(dw_dev_depth < DW_DEV_NEST_MAX, "dw_dev_lock() nested too deep");
+	dw_dev_stack[dw_dev_depth++] = dw_dev_cur;
+	if (dev != dw_dev_cur) {
+		dw_dev_cur = dev;
+		dwt_update_dw(&dev->chip);
+	}
+}
+
+void dw_dev_unlock(struct dw_dev *dev)
+{
+	struct dw_dev *prev = dw_dev_stack[--dw_dev_depth];
+
+	ARG_UNUSED(dev);
+	if (prev != dw_dev_cur) {
+		dw_dev_cur = prev;
+		if (prev) {
+			dwt_update_dw(&prev->chip);
+		}
+	}
+	k_mutex_unlock(&dw_dev_mutex);
+}
+
+struct dw_dev *dw_dev_current(void)
+{
+	return dw_dev_cur;
+}
+
+static void dw_dev_irq_work(struct k_work *work)
+{
+	struct dw_dev *dev = CONTAINER_OF(work, struct dw_dev, irq_work);
+	int pending;
+	int n = 0;
+
+	dw_dev_lock(dev);
+	/* the line stays high while events are pending */
+	do {
+		dev->isr(dev);
+		pending = (gpio_pin_get_dt(&dev->irq) == 1);
+	} while (pending && ++n < DW_DEV_IRQ_LOOPS);
+	dw_dev_unlock(dev);
+
+	/*
+	 * A stuck line or a flood of events must not hold the system work queue
+	 * (and the other devices) for ever: queue the rest behind the other items.
+	 */
+	if (pending) {
+		k_work_submit(&dev->irq_work);
+	}
+}
+
+static void dw_dev_irq_cb(const struct device *port, struct gpio_callback *cb, uint32_t pins)
+{
+	struct dw_dev *dev = CONTAINER_OF(cb, struct dw_dev, irq_cb);
+
+	dev->irqs++;
+	k_work_submit(&dev->irq_work);
+}
+
+static void dw_dev_dwt_isr(struct dw_dev *dev)
+{
+	ARG_UNUSED(dev);
+	dwt_isr();
+}
+
+int dw_dev_init(void)
+{
+	struct dw_dev *dev;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < DW_DEV_NUM; i++) {
+		dev = &dw_devs[i];
+		if (!device_is_ready(dev->spi.bus) || !device_is_ready(dev->reset.port) ||
+		    !device_is_ready(dev->irq.port)) {
+			return -ENODEV;
+		}
+
+		dev->spi_slow = dev->spi.config;
+		if (dev->spi_slow.frequency > DW_DEV_SLOW_HZ) {
+			dev->spi_slow.frequency = DW_DEV_SLOW_HZ;
+		}
+		dev->spi_cfg = &dev->spi_slow;
+
+		/* RSTn is open drain, only driven during a reset */
+		ret = gpio_pin_configure_dt(&dev->reset, GPIO_INPUT);
+		if (!ret) {
+			ret = gpio_pin_configure_dt(&dev->irq, GPIO_INPUT);
+		}
+		if (!ret && dev->wakeup.port) {
+			ret = gpio_pin_configure_dt(&dev->wakeup, GPIO_OUTPUT_INACTIVE);
+		}
+		if (ret) {
+			return ret;
+		}
+
+		k_work_init(&dev->irq_work, dw_dev_irq_work);
+		gpio_init_callback(&dev->irq_cb, dw_dev_irq_cb, BIT(dev->irq.pin));
+
+		dev->probe.dw = &dev->chip;
+		dev->probe.spi = (void *)&dw_dev_spi_fct;
+		dev->probe.wakeup_device_with_io = dw_dev_wakeup_io;
+	}
+	return DW_DEV_NUM;
+}
+
+unsigned int dw_dev_count(void)
+{
+	return DW_DEV_NUM;
+}
+
+struct dw_dev *dw_dev_get(unsigned int idx)
+{
+	return (idx < DW_DEV_NUM) ? &dw_devs[idx] : NULL;
+}
+
+unsigned int dw_dev_index(const struct dw_dev *dev)
+{
+	return dev - dw_devs;
+}
+
+void dw_dev_reset(struct dw_dev *dev)
+{
+	gpio_pin_configure_dt(&dev->reset, GPIO_OUTPUT_ACTIVE);
+	k_msleep(1);
+	gpio_pin_configure_dt(&dev->reset, GPIO_INPUT);
+	k_msleep(2);
+}
+
+int dw_dev_probe(struct dw_dev *dev)
+{
+	int ret;
+
+	/* dwt_probe() makes the new struct dwchip_s the current one */
+	k_mutex_lock(&dw_dev_mutex, K_FOREVER);
+	dw_dev_cur = dev;
+	ret = dwt_probe(&dev->probe);
+	k_mutex_unlock(&dw_dev_mutex);
+	return ret;
+}
+
+void dw_dev_set_spi_slowrate(struct dw_dev *dev)
+{
+	dev->spi_cfg = &dev->spi_slow;
+}
+
+void dw_dev_set_spi_fastrate(struct dw_dev *dev)
+{
+	dev->spi_cfg = &dev->spi.config;
+}
+
+int dw_dev_set_isr(struct dw_dev *dev, dw_dev_isr_t isr)
+{
+	int ret;
+
+	dev->isr = isr ? isr : dw_dev_dwt_isr;
+	ret = gpio_add_callback(dev->irq.port, &dev->irq_cb);
+	if (!ret) {
+		ret = gpio_pin_interrupt_configure_dt(&dev->irq, GPIO_INT_EDGE_TO_ACTIVE);
+	}
+	return ret;
+}
+
+uint32_t dw_dev_irq_count(const struct dw_dev *dev)
+{
+	return dev->irqs;
+}
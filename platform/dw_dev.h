@@ -0,0 +1,73 @@
+/*
+ * Several DW3000 on one MCU
+ *
+ * The dw3000 driver module and the functions of port.h drive a single DW IC,
+ * the first "decawave,dw3000" node of the devicetree. This module drives
+ * every enabled node, each with its own chip select, reset and IRQ lines,
+ * e.g. a second radio on the same SPI bus:
+ *
+ *	&spi0 {
+ *		cs-gpios = <&gpio0 17 GPIO_ACTIVE_LOW>, <&gpio0 22 GPIO_ACTIVE_LOW>;
+ *		dw3000@1 {
+ *			compatible = "decawave,dw3000";
+ *			label = "DW3000_1";
+ *			spi-max-frequency = <8000000>;
+ *			reg = <1>;
+ *			reset-gpios = <&gpio0 24 GPIO_ACTIVE_LOW>;
+ *			irq-gpios = <&gpio0 13 GPIO_ACTIVE_HIGH>;
+ *		};
+ *	};
+ *
+ * The Qorvo driver keeps the state of each DW IC in its own struct dwchip_s
+ * and works on the current one, set with dwt_update_dw(). dw_dev_lock()
+ * makes a device current, routes the SPI transfers of the driver to its chip
+ * select and holds a mutex, so that threads and the IRQ handling of the other
+ * devices do not switch it meanwhile. Every dwt_*() call for a device is made
+ * between dw_dev_lock() and dw_dev_unlock(), the calls nest.
+ *
+ * The IRQ line of each device has its own work item, which runs the ISR of
+ * the device (dwt_isr() unless another one is set) with the device locked,
+ * so the callbacks registered with dwt_setcallbacks() while a device was
+ * current are the ones called for its events, and dw_dev_current() tells
+ * which device they are for. The radios receive and transmit concurrently,
+ * only the SPI accesses of the MCU are serialized.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DW_DEV_H_
+#define DW_DEV_H_
+
+#include <stdint.h>
+
+struct dw_dev;
+
+typedef void (*dw_dev_isr_t)(struct dw_dev *dev);
+
+/* Configure the GPIOs and SPI of every device, returns their number or a negative error */
+int dw_dev_init(void);
+unsigned int dw_dev_count(void);
+struct dw_dev *dw_dev_get(unsigned int idx);
+unsigned int dw_dev_index(const struct dw_dev *dev);
+
+/* Drive RSTn of the device low for a period, as reset_DWIC() */
+void dw_dev_reset(struct dw_dev *dev);
+
+/* dwt_probe() for the device, with its own struct dwchip_s */
+int dw_dev_probe(struct dw_dev *dev);
+
+/* Make the device current for the dwt_*() calls and exclude the other users */
+void dw_dev_lock(struct dw_dev *dev);
+void dw_dev_unlock(struct dw_dev *dev);
+struct dw_dev *dw_dev_current(void);
+
+void dw_dev_set_spi_slowrate(struct dw_dev *dev);
+void dw_dev_set_spi_fastrate(struct dw_dev *dev);
+
+/* Enable the IRQ line of the device with an ISR, dwt_isr() if NULL */
+int dw_dev_set_isr(struct dw_dev *dev, dw_dev_isr_t isr);
+
+/* IRQs of the device so far */
+uint32_t dw_dev_irq_count(const struct dw_dev *dev);
+
+#endif /* DW_DEV_H_ */
@@ -0,0 +1,415 @@
+/*
+ * Energy accounting of the DW IC, see energy.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <energy.h>
+#include <string.h>
+
+const char *const energy_state_name[ENERGY_NUM_STATES] = {
+	"deepsleep", "sleep", "idle_rc", "idle_pll", "tx", "rx", "sniff",
+};
+
+void energy_set_phy(struct energy_acct *ea, const struct uwb_phy *phy)
+{
+	ea->phy = *phy;
+	ea->i_na[ENERGY_DEEPSLEEP] = uwb_phy_current_na(phy, UWB_PHY_DEEPSLEEP);
+	ea->i_na[ENERGY_SLEEP] = uwb_phy_current_na(phy, UWB_PHY_SLEEP);
+	ea->i_na[ENERGY_IDLE_RC] = uwb_phy_current_na(phy, UWB_PHY_IDLE_RC);
+	ea->i_na[ENERGY_IDLE_PLL] = uwb_phy_current_na(phy, UWB_PHY_IDLE_PLL);
+	ea->i_na[ENERGY_TX] = uwb_phy_current_na(phy, UWB_PHY_TX);
+	ea->i_na[ENERGY_RX] = uwb_phy_current_na(phy, UWB_PHY_RX);
+	ea->i_na[ENERGY_SNIFF] = ea->i_na[ENERGY_RX];
+}
+
+void energy_init(struct energy_acct *ea, const struct uwb_phy *phy, uint32_t now_us)
+{
+	memset(ea, 0, sizeof(*ea));
+	energy_set_phy(ea, phy);
+	ea->state = ENERGY_IDLE_RC;
+	ea->t_state = now_us;
+	ea->t_start = now_us;
+}
+
+void energy_set_sniff(struct energy_acct *ea, uint8_t on_pac, uint8_t off)
+{
+	uint64_t on_ns = (uint64_t)(on_pac + 1) * ea->phy.pac * uwb_phy_symbol_ns(&ea->phy);
+	uint64_t off_ns = (uint64_t)off * UWB_PHY_SNIFF_OFF_NS;
+
+	/* the receiver is on for ON + 1 PACs, the OFF phase keeps the PLL running */
+	ea->i_na[ENERGY_SNIFF] = (uint32_t)((on_ns * ea->i_na[ENERGY_RX] +
+					     off_ns * ea->i_na[ENERGY_IDLE_PLL]) /
+					    (on_ns + off_ns));
+}
+
+/* close the current state at t_us, which may be in its future for a delayed TX */
+static void energy_close(struct energy_acct *ea, uint32_t t_us)
+{
+	int32_t dt = (int32_t)(t_us - ea->t_state);
+
+	if (dt > 0) {
+		ea->t_us[ea->state] += (uint32_t)dt;
+	}
+}
+
+void energy_enter(struct energy_acct *ea, enum energy_state state, uint32_t now_us)
+{
+	/* a state entered after a TX starts once the frame is sent */
+	if ((int32_t)(now_us - ea->t_state) < 0) {
+		now_us = ea->t_state;
+	}
+	energy_close(ea, now_us);
+	ea->state = state;
+	ea->t_state = now_us;
+	ea->entries[state]++;
+}
+
+void energy_tx(struct energy_acct *ea, uint32_t start_us, uint16_t len, enum energy_state next)
+{
+	uint32_t air_us = uwb_phy_airtime_us(&ea->phy, 0, len, NULL);
+
+	energy_close(ea, start_us);
+	ea->t_us[ENERGY_TX] += air_us;
+	ea->entries[ENERGY_TX]++;
+	ea->state = next;
+	ea->t_state = start_us + air_us;
+	ea->entries[next]++;
+}
+
+void energy_reset(struct energy_acct *ea, uint32_t now_us)
+{
+	memset(ea->t_us, 0, sizeof(ea->t_us));
+	memset(ea->entries, 0, sizeof(ea->entries));
+	ea->exchanges = 0;
+	ea->t_start = now_us;
+	if ((int32_t)(now_us - ea->t_state) > 0) {
+		ea->t_state = now_us;
+	}
+}
+
+void energy_summarize(const struct energy_acct *ea, uint32_t now_us, uint32_t battery_mah,
+		      struct energy_summary *s)
+{
+	uint64_t charge_fc = 0, t_us;
+	int32_t open;
+	int i;
+
+	memset(s, 0, sizeof(*s));
+	for (i = 0; i < ENERGY_NUM_STATES; i++) {
+		t_us = ea->t_us[i];
+		open = (int32_t)(now_us - ea->t_state);
+		if (i == ea->state && open > 0) {
+			t_us += (uint32_t)open;
+		}
+		charge_fc += t_us * ea->i_na[i]; /* nA x us */
+	}
+
+	s->elapsed_us = now_us - ea->t_start;
+	s->energy_nj = charge_fc / 1000 * ENERGY_SUPPLY_MV / 1000000;
+	if (s->elapsed_us == 0) {
+		return;
+	}
+	s->avg_na = (uint32_t)(charge_fc / s->elapsed_us);
+	s->mj_per_hour = (uint32_t)((uint64_t)s->avg_na * ENERGY_SUPPLY_MV * 3600 / 1000000000);
+	if (ea->exchanges) {
+		s->nj_per_exchange = (uint32_t)(s->energy_nj / ea->exchanges);
+	}
+	if (s->avg_na) {
+		s->life_h = (uint32_t)((uint64_t)battery_mah * 1000000 / s->avg_na);
+	}
+}
+
+#if ENERGY_ENABLED
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <deca_device_api.h>
+#include <port.h>
+
+/* the originals of the wrapped functions, see ld --wrap */
+int __real_dwt_initialise(int mode);
+int __real_dwt_configure(dwt_config_t *config);
+void __real_dwt_writetxfctrl(uint16_t len, uint16_t offset, uint8_t ranging);
+void __real_dwt_setdelayedtrxtime(uint32_t starttime);
+int __real_dwt_starttx(uint8_t mode);
+int __real_dwt_rxenable(int mode);
+void __real_dwt_readrxdata(uint8_t *buffer, uint16_t length, uint16_t offset);
+void __real_dwt_forcetrxoff(void);
+void __real_dwt_setsniffmode(int enable, uint8_t on, uint8_t off);
+void __real_dwt_configuresleep(uint16_t mode, uint8_t wake);
+void __real_dwt_entersleep(int idle_rc);
+void __real_dwt_entersleepaftertx(int enable);
+void __real_dwt_wakeup_ic(void);
+uint8_t __real_dwt_checkidlerc(void);
+void __real_dwt_restoreconfig(void);
+
+#define HI32_PER_US_X10 2496 /* units of the delayed TX time (256 device time units) per 10 us */
+
+static struct energy_acct energy_dw;
+static uint8_t energy_started;
+static uint8_t energy_sniff_on;
+static uint8_t energy_sleep_state = ENERGY_DEEPSLEEP; /* state of dwt_entersleep() */
+static uint8_t energy_wake_state = ENERGY_IDLE_RC;    /* state after the wake-up */
+static uint8_t energy_sleep_after_tx;
+static uint16_t energy_tx_len;
+static uint32_t energy_tx_time;
+
+static const uint16_t energy_plen[] = {
+	[DWT_PLEN_32] = 32,     [DWT_PLEN_64] = 64,     [DWT_PLEN_72] = 72,
+	[DWT_PLEN_128] = 128,   [DWT_PLEN_256] = 256,   [DWT_PLEN_512] = 512,
+	[DWT_PLEN_1024] = 1024, [DWT_PLEN_1536] = 1536, [DWT_PLEN_2048] = 2048,
+	[DWT_PLEN_4096] = 4096,
+};
+static const uint8_t energy_pac[] = {
+	[DWT_PAC4] = 4, [DWT_PAC8] = 8, [DWT_PAC16] = 16, [DWT_PAC32] = 32,
+};
+
+static void energy_enter_dw(enum energy_state state)
+{
+	unsigned int key;
+
+	if (!energy_started) {
+		return;
+	}
+	key = irq_lock();
+	energy_enter(&energy_dw, state, port_get_time_us());
+	irq_unlock(key);
+}
+
+int __wrap_dwt_initialise(int mode)
+{
+	static const struct uwb_phy phy = { 5, 128, 9, 1, 0, 8 }; /* until dwt_configure() */
+	int ret = __real_dwt_initialise(mode);
+
+	if (!energy_started) {
+		energy_init(&energy_dw, &phy, port_get_time_us());
+		energy_started = 1;
+	}
+	energy_enter_dw((mode & DWT_DW_IDLE) ? ENERGY_IDLE_PLL : ENERGY_IDLE_RC);
+	return ret;
+}
+
+int __wrap_dwt_configure(dwt_config_t *config)
+{
+	struct uwb_phy phy;
+	int ret = __real_dwt_configure(config);
+	unsigned int key;
+
+	if (ret == DWT_SUCCESS && energy_started) {
+		phy.channel = config->chan;
+		phy.plen = (config->txPreambLength < ARRAY_SIZE(energy_plen)) ?
+				   energy_plen[config->txPreambLength] : 128;
+		phy.code = config->txCode;
+		phy.rate_6m8 = (config->dataRate == DWT_BR_6M8);
+		phy.sts_len = 0;
+		phy.pac = (config->rxPAC < ARRAY_SIZE(energy_pac)) ? energy_pac[config->rxPAC] : 8;
+		key = irq_lock();
+		energy_set_phy(&energy_dw, &phy);
+		irq_unlock(key);
+		/* the PLL is locked by the configuration */
+		energy_enter_dw(ENERGY_IDLE_PLL);
+	}
+	return ret;
+}
+
+void __wrap_dwt_writetxfctrl(uint16_t len, uint16_t offset, uint8_t ranging)
+{
+	__real_dwt_writetxfctrl(len, offset, ranging);
+	energy_tx_len = len;
+}
+
+void __wrap_dwt_setdelayedtrxtime(uint32_t starttime)
+{
+	__real_dwt_setdelayedtrxtime(starttime);
+	energy_tx_time = starttime;
+}
+
+int __wrap_dwt_starttx(uint8_t mode)
+{
+	uint32_t start = port_get_time_us();
+	int32_t dt = 0;
+	enum energy_state next;
+	unsigned int key;
+	int ret;
+
+	/* start of a delayed TX, see NOTE 1 below */
+	if (energy_started && (mode & DWT_START_TX_DELAYED)) {
+		dt = (int32_t)(energy_tx_time - dwt_readsystimestamphi32());
+	}
+	ret = __real_dwt_starttx(mode);
+	if (ret != DWT_SUCCESS || !energy_started) {
+		return ret;
+	}
+	if (dt > 0) {
+		start += (uint32_t)((uint64_t)dt * 10 / HI32_PER_US_X10);
+	}
+
+	if (mode & DWT_RESPONSE_EXPECTED) {
+		next = energy_sniff_on ? ENERGY_SNIFF : ENERGY_RX;
+	} else if (energy_sleep_after_tx) {
+		next = energy_sleep_state;
+	} else {
+		next = ENERGY_IDLE_PLL;
+	}
+	key = irq_lock();
+	energy_tx(&energy_dw, start, energy_tx_len, next);
+	irq_unlock(key);
+	return ret;
+}
+
+int __wrap_dwt_rxenable(int mode)
+{
+	int ret = __real_dwt_rxenable(mode);
+
+	if (ret == DWT_SUCCESS) {
+		energy_enter_dw(energy_sniff_on ? ENERGY_SNIFF : ENERGY_RX);
+	}
+	return ret;
+}
+
+void __wrap_dwt_readrxdata(uint8_t *buffer, uint16_t length, uint16_t offset)
+{
+	__real_dwt_readrxdata(buffer, length, offset);
+	/* a frame was received, see NOTE 2 below */
+	if (energy_dw.state == ENERGY_RX || energy_dw.state == ENERGY_SNIFF) {
+		energy_enter_dw(ENERGY_IDLE_PLL);
+	}
+}
+
+void __wrap_dwt_forcetrxoff(void)
+{
+	__real_dwt_forcetrxoff();
+	energy_enter_dw(ENERGY_IDLE_PLL);
+}
+
+void __wrap_dwt_setsniffmode(int enable, uint8_t on, uint8_t off)
+{
+	unsigned int key;
+
+	__real_dwt_setsniffmode(enable, on, off);
+	energy_sniff_on = (enable != 0);
+	if (energy_started && enable) {
+		key = irq_lock();
+		energy_set_sniff(&energy_dw, on, off);
+		irq_unlock(key);
+	}
+}
+
+void __wrap_dwt_configuresleep(uint16_t mode, uint8_t wake)
+{
+	__real_dwt_configuresleep(mode, wake);
+	energy_sleep_state = (wake & DWT_SLEEP) ? ENERGY_SLEEP : ENERGY_DEEPSLEEP;
+}
+
+void __wrap_dwt_entersleep(int idle_rc)
+{
+	__real_dwt_entersleep(idle_rc);
+	energy_wake_state = (idle_rc == DWT_DW_IDLE_RC) ? ENERGY_IDLE_RC : ENERGY_IDLE_PLL;
+	energy_enter_dw(energy_sleep_state);
+}
+
+void __wrap_dwt_entersleepaftertx(int enable)
+{
+	__real_dwt_entersleepaftertx(enable);
+	energy_sleep_after_tx = (enable != 0);
+}
+
+void __wrap_dwt_wakeup_ic(void)
+{
+	energy_enter_dw(ENERGY_IDLE_RC);
+	__real_dwt_wakeup_ic();
+}
+
+uint8_t __wrap_dwt_checkidlerc(void)
+{
+	uint8_t ret = __real_dwt_checkidlerc();
+
+	/* woken up by the sleep counter */
+	if (ret && (energy_dw.state == ENERGY_SLEEP || energy_dw.state == ENERGY_DEEPSLEEP)) {
+		energy_enter_dw(ENERGY_IDLE_RC);
+	}
+	return ret;
+}
+
+void __wrap_dwt_restoreconfig(void)
+{
+	__real_dwt_restoreconfig();
+	energy_enter_dw(energy_wake_state);
+}
+
+void energy_exchange(void)
+{
+	energy_dw.exchanges++;
+	if (energy_dw.exchanges % ENERGY_REPORT_PERIOD == 0) {
+		energy_dump();
+	}
+}
+
+void energy_dump(void)
+{
+	struct energy_acct ea;
+	struct energy_summary s;
+	unsigned int key;
+	uint32_t now;
+	int i;
+
+	key = irq_lock();
+	ea = energy_dw;
+	now = port_get_time_us();
+	irq_unlock(key);
+	energy_summarize(&ea, now, ENERGY_BATTERY_MAH, &s);
+	if (s.elapsed_us == 0) {
+		return;
+	}
+
+	/* time share in 0.1 %, the open state included */
+	for (i = 0; i < ENERGY_NUM_STATES; i++) {
+		uint64_t t = ea.t_us[i];
+
+		if (i == ea.state && (int32_t)(now - ea.t_state) > 0) {
+			t += now - ea.t_state;
+		}
+		if (t == 0) {
+			continue;
+		}
+		printk("ENERGY %-9s n=%lu t=%lu.%lu%% I=%lu uA\n", energy_state_name[i],
+		       (unsigned long)ea.entries[i], (unsigned long)(t * 100 / s.elapsed_us),
+		       (unsigned long)(t * 1000 / s.elapsed_us % 10),
+		       (unsigned long)(ea.i_na[i] / 1000));
+	}
+	printk("ENERGY ch%u %s %s n=%lu E=%lu.%03lu uJ/xchg %lu.%03lu J/h I=%lu.%03lu uA "
+	       "life=%lu d (%u mAh)\n",
+	       ea.phy.channel, UWB_PHY_PRF_64(&ea.phy) ? "64M" : "16M", ea.phy.rate_6m8 ? "6M8" : "850k",
+	       (unsigned long)ea.exchanges, (unsigned long)(s.nj_per_exchange / 1000),
+	       (unsigned long)(s.nj_per_exchange % 1000), (unsigned long)(s.mj_per_hour / 1000),
+	       (unsigned long)(s.mj_per_hour % 1000), (unsigned long)(s.avg_na / 1000),
+	       (unsigned long)(s.avg_na % 1000), (unsigned long)(s.life_h / 24), ENERGY_BATTERY_MAH);
+	energy_clear();
+}
+
+void energy_clear(void)
+{
+	unsigned int key;
+
+	key = irq_lock();
+	energy_reset(&energy_dw, port_get_time_us());
+	irq_unlock(key);
+}
+
+#endif /* ENERGY_ENABLED */
+
+/*
+ * NOTES:
+ *
+ * 1. The wrapped calls only show when the MCU asks for a state change, so a
+ *    frame sent is accounted with its air time from the start of the TX,
+ *    computed from the delayed TX time and the system time for a delayed
+ *    TX, and the state after it (RX, SLEEP with dwt_entersleepaftertx(), or
+ *    IDLE_PLL) starts at its end. The RX after a TX is counted from the end
+ *    of the frame, the dwt_setrxaftertxdelay() delay is not taken off.
+ * 2. The receiver is counted on until the frame is read, or until the next
+ *    call which changes the state after an RX error or timeout, which the
+ *    driver calls do not show. Both overestimate the RX time by the latency
+ *    of the MCU, which stays small next to the frames in polled mode.
+ */
@@ -0,0 +1,105 @@
+/*
+ * Energy accounting of the DW IC
+ *
+ * Tracks the time the DW IC spends in each of its states (DEEPSLEEP, SLEEP,
+ * IDLE_RC, IDLE_PLL, TX, RX and SNIFF) and turns it into charge and energy
+ * with the supply current of each state for the configured channel, PRF and
+ * data rate, as given by uwb_phy_current_na(). The summary gives the energy per exchange, the energy per hour,
+ * the average current and the battery life this current projects.
+ *
+ * The accounting core only needs a microsecond clock and has no DW IC
+ * driver dependency, so a host simulator can drive it to compare
+ * configurations (see tools/energy_sim). On the target the driver calls
+ * which change the state of the DW IC are wrapped at link time (ld --wrap),
+ * as for the SPI profiler. The application calls ENERGY_EXCHANGE() once per
+ * exchange, whatever it defines as one (a blink, a frame received, a ranging
+ * round), and every ENERGY_REPORT_PERIOD exchanges the summary is printed
+ * with the time the DW IC spent in each state. The hooks are disabled by
+ * default and every macro expands to nothing, build with "cmake -DENERGY=1"
+ * to enable them.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+#include <stdint.h>
+#include <uwb_phy.h>
+
+#ifndef ENERGY_ENABLED
+#define ENERGY_ENABLED 0
+#endif
+
+#define ENERGY_REPORT_PERIOD 16   /* exchanges between two summaries */
+#ifndef ENERGY_BATTERY_MAH
+#define ENERGY_BATTERY_MAH   1000 /* battery of the projected life */
+#endif
+#define ENERGY_SUPPLY_MV     UWB_PHY_SUPPLY_MV
+
+enum energy_state {
+	ENERGY_DEEPSLEEP,
+	ENERGY_SLEEP,
+	ENERGY_IDLE_RC,  /* also INIT_RC and the wake-up */
+	ENERGY_IDLE_PLL,
+	ENERGY_TX,
+	ENERGY_RX,
+	ENERGY_SNIFF,    /* RX in SNIFF mode, ON and OFF phases averaged */
+	ENERGY_NUM_STATES
+};
+
+struct energy_acct {
+	struct uwb_phy phy;
+	uint32_t i_na[ENERGY_NUM_STATES]; /* supply current of each state */
+	uint8_t state;
+	uint32_t t_state;                 /* entry in the current state */
+	uint64_t t_us[ENERGY_NUM_STATES]; /* time spent in each state */
+	uint32_t entries[ENERGY_NUM_STATES];
+	uint32_t exchanges;
+	uint32_t t_start;
+};
+
+struct energy_summary {
+	uint32_t elapsed_us;
+	uint64_t energy_nj;
+	uint32_t avg_na;
+	uint32_t nj_per_exchange;
+	uint32_t mj_per_hour;
+	uint32_t life_h; /* with battery_mah, 0 if no current */
+};
+
+/*
+ * Accounting core. Times are microseconds of a free running clock,
+ * port_get_time_us() on the target, and wrap after about 71 minutes, so a
+ * summary has to be taken more often than that.
+ */
+void energy_init(struct energy_acct *ea, const struct uwb_phy *phy, uint32_t now_us);
+void energy_set_phy(struct energy_acct *ea, const struct uwb_phy *phy);
+void energy_set_sniff(struct energy_acct *ea, uint8_t on_pac, uint8_t off);
+void energy_enter(struct energy_acct *ea, enum energy_state state, uint32_t now_us);
+void energy_tx(struct energy_acct *ea, uint32_t start_us, uint16_t len, enum energy_state next);
+void energy_reset(struct energy_acct *ea, uint32_t now_us);
+void energy_summarize(const struct energy_acct *ea, uint32_t now_us, uint32_t battery_mah,
+		      struct energy_summary *s);
+
+extern const char *const energy_state_name[ENERGY_NUM_STATES];
+
+#if ENERGY_ENABLED
+
+void energy_exchange(void);
+void energy_dump(void);
+void energy_clear(void);
+
+#define ENERGY_EXCHANGE() energy_exchange()
+#define ENERGY_DUMP()     energy_dump()
+#define ENERGY_RESET()    energy_clear()
+
+#else
+
+#define ENERGY_EXCHANGE() ((void)0)
+#define ENERGY_DUMP()     ((void)0)
+#define ENERGY_RESET()    ((void)0)
+
+#endif
+
+#endif /* ENERGY_H_ */
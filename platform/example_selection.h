@@ -90,6 +90,50 @@ extern "C"
 //#define TEST_TX_POWER_ADJUSTMENT
 
 //#define TEST_SIMPLE_AES
+
+//#define TEST_ANT_DELAY_CAL
+
+//#define TEST_CIR_CAPTURE
+
+//#define TEST_TWR_BENCH_INITIATOR
+
+//#define TEST_TWR_BENCH_RESPONDER
+
+//#define TEST_SPI_BENCH
+
+//#define TEST_SS_TWR_RESPONDER_EVT
+
+//#define TEST_SS_TWR_RESPONDER_SNIFF
+
+//#define TEST_SS_TWR_INITIATOR_SCHED
+
+//#define TEST_SIMPLE_RX_MULTI
+
+//#define TEST_SS_TWR_INITIATOR_AOA
+
+//#define TEST_SS_TWR_RESPONDER_AOA
+
+//#define TEST_SS_TWR_INITIATOR_MULTILAT
+
+//#define TEST_TDOA_ANCHOR
+
+//#define TEST_TX_CSMA
+
+//#define TEST_ARQ_TX
+
+//#define TEST_ARQ_RX
+
+//#define TEST_INDIRECT_COORD
+
+//#define TEST_INDIRECT_DEVICE
+
+//#define TEST_FRAME_FILTERING_TX
+
+//#define TEST_FRAME_FILTERING_RX
+
+//#define TEST_RX_DBL_BUFF_PIPE
+
+//#define TEST_SNIFFER
 #ifdef __cplusplus
 }
 #endif
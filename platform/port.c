@@ -1,4 +1,10 @@
 #include <zephyr.h>
+#include <drivers/flash.h>
+#include <storage/flash_map.h>
+#include <drivers/uart.h>
+#if CONFIG_USE_SEGGER_RTT
+#include <SEGGER_RTT.h>
+#endif
 
 #include <deca_device_api.h>
 #include <dw3000_hw.h>
@@ -12,6 +18,30 @@ void Sleep(uint32_t x)
 	k_msleep(x);
 }
 
+uint32_t port_get_tick_ms(void)
+{
+	return k_uptime_get_32();
+}
+
+uint32_t port_get_time_us(void)
+{
+	return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+void port_sleep_until_us(uint32_t t_us)
+{
+	int32_t dt = (int32_t)(t_us - port_get_time_us());
+
+	if (dt > 0) {
+		k_usleep(dt);
+	}
+}
+
+void port_yield(void)
+{
+	k_yield();
+}
+
 void reset_DWIC(void)
 {
 #if 1
@@ -37,3 +67,148 @@ void port_set_dwic_isr(port_deca_isr_t deca_isr)
 {
 	dw3000_hw_init_interrupt();
 }
+
+/* Antenna delays are kept in the first page of the "storage" flash partition */
+#define ANT_DLY_MAGIC 0x41444C59 /* "ADLY" */
+
+struct ant_dly_record {
+	uint32_t magic;
+	uint16_t tx_dly;
+	uint16_t rx_dly;
+	uint32_t check;
+};
+
+static uint32_t ant_dly_check(const struct ant_dly_record *rec)
+{
+	return rec->magic ^ ((uint32_t)rec->tx_dly << 16 | rec->rx_dly);
+}
+
+int port_ant_delay_load(uint16_t *tx_dly, uint16_t *rx_dly)
+{
+	const struct flash_area *fa;
+	struct ant_dly_record rec;
+	int ret;
+
+	ret = flash_area_open(FLASH_AREA_ID(storage), &fa);
+	if (ret) {
+		return ret;
+	}
+
+	ret = flash_area_read(fa, 0, &rec, sizeof(rec));
+	flash_area_close(fa);
+	if (ret) {
+		return ret;
+	}
+
+	if (rec.magic != ANT_DLY_MAGIC || rec.check != ant_dly_check(&rec)) {
+		return -ENOENT;
+	}
+
+	*tx_dly = rec.tx_dly;
+	*rx_dly = rec.rx_dly;
+	return 0;
+}
+
+int port_ant_delay_store(uint16_t tx_dly, uint16_t rx_dly)
+{
+	const struct flash_area *fa;
+	struct flash_pages_info info;
+	struct ant_dly_record rec = {
+		.magic = ANT_DLY_MAGIC,
+		.tx_dly = tx_dly,
+		.rx_dly = rx_dly,
+	};
+	int ret;
+
+	rec.check = ant_dly_check(&rec);
+
+	ret = flash_area_open(FLASH_AREA_ID(storage), &fa);
+	if (ret) {
+		return ret;
+	}
+
+	ret = flash_get_page_info_by_offs(device_get_binding(fa->fa_dev_name), fa->fa_off, &info);
+	if (!ret) {
+		ret = flash_area_erase(fa, 0, info.size);
+	}
+	if (!ret) {
+		ret = flash_area_write(fa, 0, &rec, sizeof(rec));
+	}
+
+	flash_area_close(fa);
+	return ret;
+}
+
+/*
+ * Binary data streams to the host, e.g. for logs or captures, separate from the
+ * text console. Each stream uses its own RTT up channel when RTT is enabled
+ * (channel 0 is the console). Without RTT the data stream goes to the console
+ * UART, and the log stream is not available: its records, written from a
+ * thread at any time, would break the lines of the console.
+ * Writes never block on RTT: a buffer is written completely or not at all, so
+ * callers check port_stream_space() first and account for the data they drop.
+ */
+#if CONFIG_USE_SEGGER_RTT
+
+#define STREAM_RTT_CHANNEL(s) (1 + (s))
+#define STREAM_RTT_BUF_SIZE 4096
+
+static uint8_t stream_rtt_buf[2][STREAM_RTT_BUF_SIZE];
+static const char *const stream_rtt_name[2] = { "DW3000 log", "DW3000 data" };
+
+int port_stream_init(uint8_t stream)
+{
+	if (stream > PORT_STREAM_DATA) {
+		return -EINVAL;
+	}
+
+	return SEGGER_RTT_ConfigUpBuffer(STREAM_RTT_CHANNEL(stream), stream_rtt_name[stream],
+					 stream_rtt_buf[stream], STREAM_RTT_BUF_SIZE,
+					 SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+uint32_t port_stream_space(uint8_t stream)
+{
+	return SEGGER_RTT_GetAvailWriteSpace(STREAM_RTT_CHANNEL(stream));
+}
+
+uint32_t port_stream_write(uint8_t stream, const uint8_t *data, uint32_t len)
+{
+	return SEGGER_RTT_Write(STREAM_RTT_CHANNEL(stream), data, len);
+}
+
+#else
+
+static const struct device *stream_uart;
+
+int port_stream_init(uint8_t stream)
+{
+	if (stream != PORT_STREAM_DATA) {
+		return -ENOTSUP;
+	}
+
+	stream_uart = device_get_binding(DT_LABEL(DT_CHOSEN(zephyr_console)));
+	return stream_uart ? 0 : -ENODEV;
+}
+
+uint32_t port_stream_space(uint8_t stream)
+{
+	/* polled UART output blocks until sent, there is always room */
+	return UINT32_MAX;
+}
+
+uint32_t port_stream_write(uint8_t stream, const uint8_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	if (!stream_uart) {
+		return 0;
+	}
+
+	for (i = 0; i < len; i++) {
+		uart_poll_out(stream_uart, data[i]);
+	}
+	return len;
+}
+
+#endif
@@ -36,9 +36,24 @@
 typedef void (*port_deca_isr_t)(void);
 
 void Sleep(uint32_t Delay);
+uint32_t port_get_tick_ms(void);
+uint32_t port_get_time_us(void);
+void port_sleep_until_us(uint32_t t_us);
+void port_yield(void);
 void reset_DWIC(void);
 void port_set_dw_ic_spi_slowrate(void);
 void port_set_dw_ic_spi_fastrate(void);
 void port_set_dwic_isr(port_deca_isr_t deca_isr);
 
+int port_ant_delay_load(uint16_t *tx_dly, uint16_t *rx_dly);
+int port_ant_delay_store(uint16_t tx_dly, uint16_t rx_dly);
+
+/* Binary streams to the host */
+#define PORT_STREAM_LOG  0 /* Binary log records, see binlog.h */
+#define PORT_STREAM_DATA 1 /* Bulk data, e.g. CIR captures */
+
+int port_stream_init(uint8_t stream);
+uint32_t port_stream_space(uint8_t stream);
+uint32_t port_stream_write(uint8_t stream, const uint8_t *data, uint32_t len);
+
 #endif /* PORT_H_ */
@@ -0,0 +1,112 @@
+/*
+ * Cycle count instrumentation of hot paths, see prof.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <prof.h>
+#include <string.h>
+
+#if PROF_ENABLED
+
+#if defined(__ZEPHYR__)
+#include <zephyr.h>
+#include <sys/printk.h>
+#define PROF_LOCK()    irq_lock()
+#define PROF_UNLOCK(k) irq_unlock(k)
+#define PROF_PRINT     printk
+#else
+#include <stdio.h>
+#define PROF_LOCK()    0
+#define PROF_UNLOCK(k) (void)(k)
+#define PROF_PRINT     printf
+#endif
+
+struct prof_hist {
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t bucket[PROF_NUM_BUCKETS];
+};
+
+#define PROF_PROBE_NAME(id, name) name,
+static const char *const prof_name[PROF_NUM_PROBES] = { PROF_PROBE_LIST(PROF_PROBE_NAME) };
+#undef PROF_PROBE_NAME
+
+static struct prof_hist prof_hist[PROF_NUM_PROBES];
+
+void prof_init(void)
+{
+	prof_cycles_init();
+	prof_reset();
+}
+
+void prof_record(uint8_t probe, uint32_t cycles)
+{
+	struct prof_hist *h = &prof_hist[probe];
+	uint32_t b = cycles ? 32 - __builtin_clz(cycles) : 0;
+	unsigned int key;
+
+	if (b >= PROF_NUM_BUCKETS) {
+		b = PROF_NUM_BUCKETS - 1;
+	}
+
+	key = PROF_LOCK();
+	if (h->count == 0 || cycles < h->min) {
+		h->min = cycles;
+	}
+	if (cycles > h->max) {
+		h->max = cycles;
+	}
+	h->count++;
+	h->sum += cycles;
+	h->bucket[b]++;
+	PROF_UNLOCK(key);
+}
+
+void prof_dump(void)
+{
+	struct prof_hist h;
+	unsigned int key;
+	int i, b;
+
+	for (i = 0; i < PROF_NUM_PROBES; i++) {
+		key = PROF_LOCK();
+		h = prof_hist[i];
+		PROF_UNLOCK(key);
+
+		if (h.count == 0) {
+			continue;
+		}
+
+		PROF_PRINT("PROF %-16s n=%lu min=%lu avg=%lu max=%lu %s\n", prof_name[i],
+			   (unsigned long)h.count, (unsigned long)h.min,
+			   (unsigned long)(h.sum / h.count), (unsigned long)h.max, PROF_UNIT);
+
+		/* one line per bucket that was hit: upper bound and count */
+		for (b = 0; b < PROF_NUM_BUCKETS; b++) {
+			if (h.bucket[b] == 0) {
+				continue;
+			}
+			if (b == PROF_NUM_BUCKETS - 1) {
+				PROF_PRINT("     >=%-8lu %lu\n", 1UL << (b - 1),
+					   (unsigned long)h.bucket[b]);
+			} else {
+				PROF_PRINT("     < %-8lu %lu\n", 1UL << b,
+					   (unsigned long)h.bucket[b]);
+			}
+		}
+	}
+}
+
+void prof_reset(void)
+{
+	unsigned int key;
+
+	key = PROF_LOCK();
+	memset(prof_hist, 0, sizeof(prof_hist));
+	PROF_UNLOCK(key);
+}
+
+#endif
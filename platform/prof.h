@@ -0,0 +1,108 @@
+/*
+ * Cycle count instrumentation of hot paths
+ *
+ * PROF_START(probe) and PROF_STOP(probe) around a code section add its
+ * duration to the histogram of the probe, PROF_DUMP() prints all probes that
+ * were hit and PROF_RESET() clears them. PROF_START() declares the start time
+ * as a local variable, so a probe can be started once per block. Durations
+ * are counted in CPU cycles with the DWT cycle counter on Cortex-M and in
+ * nanoseconds with clock_gettime() on host builds. Histogram buckets are
+ * powers of 2, bucket n counts durations from 2^(n-1) to 2^n - 1.
+ *
+ * Instrumentation is disabled by default and every macro expands to nothing,
+ * build with "cmake -DPROF=1" to enable it. A start and stop pair costs about
+ * 40 cycles when enabled.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef PROF_H_
+#define PROF_H_
+
+#include <stdint.h>
+
+#ifndef PROF_ENABLED
+#define PROF_ENABLED 0
+#endif
+
+/* Probe ID and name, add new probes here */
+#define PROF_PROBE_LIST(P)                                                                        \
+	P(PROF_EXCHANGE, "exchange")                                                              \
+	P(PROF_TX_DATA, "tx data")                                                                \
+	P(PROF_WAIT_STATUS, "wait status")                                                        \
+	P(PROF_READ_TS, "read ts")                                                                \
+	P(PROF_TOF, "tof math")                                                                   \
+	P(PROF_RESP_TURNAROUND, "resp turnaround")                                                \
+	P(PROF_REPORT, "report")                                                                  \
+	P(PROF_MAC_AES, "mac aes")
+
+#define PROF_PROBE_ID(id, name) id,
+enum prof_probe { PROF_PROBE_LIST(PROF_PROBE_ID) PROF_NUM_PROBES };
+#undef PROF_PROBE_ID
+
+#define PROF_NUM_BUCKETS 24 /* last bucket counts everything above 2^22 */
+
+/*
+ * The cycle counter is available whether the probes are enabled or not, for
+ * other instrumentation (see spi_prof.h). prof_cycles_init() starts it.
+ */
+#if defined(CONFIG_CPU_CORTEX_M)
+#define PROF_DEMCR              (*(volatile uint32_t *)0xE000EDFC)
+#define PROF_DEMCR_TRCENA       (1UL << 24)
+#define PROF_DWT_CTRL           (*(volatile uint32_t *)0xE0001000)
+#define PROF_DWT_CTRL_CYCCNTENA (1UL << 0)
+#define PROF_DWT_CYCCNT         (*(volatile uint32_t *)0xE0001004)
+#define PROF_UNIT               "cyc"
+
+static inline void prof_cycles_init(void)
+{
+	PROF_DEMCR |= PROF_DEMCR_TRCENA;
+	PROF_DWT_CTRL |= PROF_DWT_CTRL_CYCCNTENA;
+}
+
+static inline uint32_t prof_cycles(void)
+{
+	return PROF_DWT_CYCCNT;
+}
+#else
+#include <time.h>
+
+#define PROF_UNIT "ns"
+
+static inline void prof_cycles_init(void)
+{
+}
+
+static inline uint32_t prof_cycles(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+#endif
+
+#if PROF_ENABLED
+
+void prof_init(void);
+void prof_record(uint8_t probe, uint32_t cycles);
+void prof_dump(void);
+void prof_reset(void);
+
+#define PROF_INIT()        prof_init()
+#define PROF_START(probe)  uint32_t prof_start_##probe = prof_cycles()
+#define PROF_STOP(probe)   prof_record(probe, prof_cycles() - prof_start_##probe)
+#define PROF_DUMP()        prof_dump()
+#define PROF_RESET()       prof_reset()
+
+#else
+
+#define PROF_INIT()        ((void)0)
+#define PROF_START(probe)  ((void)0)
+#define PROF_STOP(probe)   ((void)0)
+#define PROF_DUMP()        ((void)0)
+#define PROF_RESET()       ((void)0)
+
+#endif
+
+#endif /* PROF_H_ */
@@ -0,0 +1,166 @@
+/*
+ * Continuous reception with the double RX buffer of the DW IC, see rx_pipe.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+
+#include <deca_device_api.h>
+#include <dw_dev.h>
+#include <port.h>
+#include <rx_pipe.h>
+
+static struct rx_pipe_frame ring[RX_PIPE_SLOTS];
+static uint32_t head; /* written by the IRQ handling only */
+static uint32_t tail; /* written by the consumer only */
+static K_SEM_DEFINE(rx_pipe_sem, 0, RX_PIPE_SLOTS);
+
+static struct rx_pipe_stats stats;
+static uint8_t host_buf; /* RX buffer the host reads, toggled by dwt_signal_rx_buff_free() */
+static uint32_t pipe_flags;
+
+static void rx_pipe_read_diag(struct rx_pipe_diag *d)
+{
+	dwt_rxdiag_t diag;
+	dwt_nlos_alldiag_t all;
+
+	dwt_readdiagnostics(&diag);
+	d->cir_power = diag.ipatovPower;
+	d->f1 = diag.ipatovF1;
+	d->f2 = diag.ipatovF2;
+	d->f3 = diag.ipatovF3;
+	d->accum_count = diag.ipatovAccumCount;
+	d->fp_index = diag.ipatovFpIndex;
+	d->xtal_offset = diag.xtalOffset;
+
+	/* the DGC decision is not part of dwt_rxdiag_t */
+	all.diag_type = IPATOV;
+	dwt_nlos_alldiag(&all);
+	d->dgc = all.D;
+}
+
+static void rx_pipe_frame(uint32_t status, uint32_t t0)
+{
+	struct rx_pipe_frame *f;
+	uint16_t len, fill;
+
+	len = dwt_getframelength();
+	if (len > RX_PIPE_FRAME_MAX + FCS_LEN) {
+		stats.too_long++;
+		return;
+	}
+	if (head - tail >= RX_PIPE_SLOTS) {
+		stats.overruns++;
+		return;
+	}
+
+	/* the frame info, timestamp and data are those of the host buffer */
+	f = &ring[head & (RX_PIPE_SLOTS - 1)];
+	f->status = status;
+	f->time_us = t0;
+	f->buf = host_buf;
+	f->len = len >= FCS_LEN ? len - FCS_LEN : 0;
+	f->rx_ts = 0;
+	dwt_readrxtimestamp((uint8_t *)&f->rx_ts);
+	dwt_readrxdata(f->data, f->len, 0);
+	if (pipe_flags & RX_PIPE_DIAG) {
+		rx_pipe_read_diag(&f->diag);
+	}
+
+	head++;
+	k_sem_give(&rx_pipe_sem);
+
+	stats.frames++;
+	stats.bytes += f->len;
+	fill = head - tail;
+	if (fill > stats.fill_max) {
+		stats.fill_max = fill;
+	}
+}
+
+static void rx_pipe_isr(struct dw_dev *dev)
+{
+	uint32_t t0, t, status;
+
+	ARG_UNUSED(dev);
+	t0 = port_get_time_us();
+	status = dwt_readsysstatuslo();
+
+	if (status & DWT_INT_RXFCG_BIT_MASK) {
+		/*
+		 * The receiver is off since the frame, turn it on into the other
+		 * buffer before anything else, then read this one and release it.
+		 */
+		dwt_writesysstatuslo(SYS_STATUS_ALL_RX_GOOD);
+		dwt_rxenable(DWT_START_RX_IMMEDIATE);
+		t = port_get_time_us() - t0;
+		if (t > stats.rearm_us_max) {
+			stats.rearm_us_max = t;
+		}
+
+		rx_pipe_frame(status, t0);
+		dwt_signal_rx_buff_free();
+		host_buf ^= 1;
+
+		t = port_get_time_us() - t0;
+		if (t > stats.busy_us_max) {
+			stats.busy_us_max = t;
+		}
+	} else if (status & SYS_STATUS_ALL_RX_ERR) {
+		dwt_writesysstatuslo(SYS_STATUS_ALL_RX_ERR);
+		dwt_rxenable(DWT_START_RX_IMMEDIATE);
+		stats.rx_errors++;
+	}
+}
+
+int rx_pipe_start(struct dw_dev *dev, uint32_t flags)
+{
+	int ret;
+
+	pipe_flags = flags;
+
+	/* the IRQ handling is installed first, it waits for the lock */
+	ret = dw_dev_set_isr(dev, rx_pipe_isr);
+	if (ret) {
+		return ret;
+	}
+
+	dw_dev_lock(dev);
+	dwt_setrxtimeout(0);
+	dwt_setpreambledetecttimeout(0);
+	dwt_setinterrupt(DWT_INT_RXFCG_BIT_MASK | SYS_STATUS_ALL_RX_ERR, 0, DWT_ENABLE_INT);
+	dwt_writesysstatuslo(DWT_INT_RCINIT_BIT_MASK | DWT_INT_SPIRDY_BIT_MASK);
+	dwt_setdblrxbuffmode(DBL_BUF_STATE_EN, DBL_BUF_MODE_MAN);
+	host_buf = 0;
+	dwt_rxenable(DWT_START_RX_IMMEDIATE);
+	dw_dev_unlock(dev);
+	return 0;
+}
+
+struct rx_pipe_frame *rx_pipe_get(int32_t timeout_ms)
+{
+	if (k_sem_take(&rx_pipe_sem, timeout_ms < 0 ? K_FOREVER : K_MSEC(timeout_ms))) {
+		return NULL;
+	}
+	return &ring[tail & (RX_PIPE_SLOTS - 1)];
+}
+
+void rx_pipe_release(void)
+{
+	tail++;
+}
+
+void rx_pipe_get_stats(struct rx_pipe_stats *s, int clear_max)
+{
+	unsigned int key;
+
+	key = irq_lock();
+	*s = stats;
+	if (clear_max) {
+		stats.fill_max = 0;
+		stats.rearm_us_max = 0;
+		stats.busy_us_max = 0;
+	}
+	irq_unlock(key);
+}
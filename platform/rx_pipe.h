@@ -0,0 +1,84 @@
+/*
+ * Continuous reception with the double RX buffer of the DW IC
+ *
+ * The receiver is kept on with the double buffer in manual re-enable mode
+ * (DBL_BUF_MODE_MAN), the mode the DW3000 supports. On each good frame the
+ * IRQ handling, run from the work item of the device (see dw_dev.h), turns
+ * the receiver on again into the other buffer first, then reads the frame
+ * length, RX timestamp and data of the buffer just filled, releases it with
+ * dwt_signal_rx_buff_free() and queues the frame. The reception of the next
+ * frame thus overlaps the readout of the previous one, and the processing of
+ * the frames is left to a thread of the application, which takes them from a
+ * ring with rx_pipe_get() and gives them back with rx_pipe_release().
+ *
+ * Frames that arrive while the ring is full are read and dropped, and
+ * counted, so the DW IC is never stalled by a slow consumer.
+ *
+ * With RX_PIPE_DIAG the RX diagnostics of each frame are read as well, from
+ * the register set of its buffer, which lengthens the handling of a frame by
+ * the SPI reads of dwt_readdiagnostics() and dwt_nlos_alldiag().
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef RX_PIPE_H_
+#define RX_PIPE_H_
+
+#include <stdint.h>
+
+struct dw_dev;
+
+#define RX_PIPE_SLOTS	  32  /* ring size in frames, must be a power of 2 */
+#define RX_PIPE_FRAME_MAX 127 /* longer frames (extended length mode) are counted and dropped */
+
+#define RX_PIPE_DIAG 0x01 /* flag of rx_pipe_start(): read the RX diagnostics of each frame */
+
+/* RX diagnostics of the Ipatov preamble, see dwt_rxdiag_t */
+struct rx_pipe_diag {
+	uint32_t cir_power;
+	uint32_t f1, f2, f3; /* first path amplitudes */
+	uint16_t accum_count;
+	uint16_t fp_index;   /* first path index, 10.6 fixed point */
+	int16_t xtal_offset;
+	uint8_t dgc;	     /* DGC decision, 0 to 7 */
+};
+
+struct rx_pipe_frame {
+	uint64_t rx_ts;	  /* RX timestamp, DW IC time units (40 bits) */
+	uint32_t status;  /* SYS_STATUS low word at the frame event */
+	uint32_t time_us; /* MCU time of the event, port_get_time_us() */
+	uint16_t len;	  /* bytes in data, FCS excluded */
+	uint8_t buf;	  /* RX buffer of the DW IC the frame was received in, 0 or 1 */
+	struct rx_pipe_diag diag; /* with RX_PIPE_DIAG only */
+	uint8_t data[RX_PIPE_FRAME_MAX];
+};
+
+struct rx_pipe_stats {
+	uint32_t frames;    /* queued */
+	uint32_t bytes;
+	uint32_t rx_errors; /* PHY header, CRC, SFD timeout etc. */
+	uint32_t overruns;  /* good frames dropped, ring full */
+	uint32_t too_long;  /* good frames dropped, longer than RX_PIPE_FRAME_MAX */
+	uint16_t fill_max;  /* most frames queued at once */
+	uint16_t rearm_us_max; /* longest time from the IRQ handling to the receiver on again */
+	uint16_t busy_us_max;  /* longest IRQ handling of a frame */
+};
+
+/*
+ * Start the reception on a device already initialised and configured with
+ * dwt_configure(). Installs the IRQ handling of the device (dw_dev_set_isr()),
+ * the frame filter and other settings are left to the caller, e.g.
+ * dwt_configciadiag() for RX_PIPE_DIAG. Returns 0 or a negative error.
+ */
+int rx_pipe_start(struct dw_dev *dev, uint32_t flags);
+
+/* Oldest frame received, NULL if none after timeout_ms (-1 waits forever) */
+struct rx_pipe_frame *rx_pipe_get(int32_t timeout_ms);
+
+/* Give back the frame returned by rx_pipe_get(), before taking the next one */
+void rx_pipe_release(void);
+
+/* Statistics since the start, the maximum values are cleared if clear_max */
+void rx_pipe_get_stats(struct rx_pipe_stats *stats, int clear_max);
+
+#endif /* RX_PIPE_H_ */
@@ -0,0 +1,207 @@
+/*
+ * SPI transaction profiler, see spi_prof.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <prof.h>
+#include <spi_prof.h>
+#include <string.h>
+
+#if SPI_PROF_ENABLED
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <dw3000_spi.h>
+
+/* the originals of the wrapped functions, see ld --wrap */
+int32_t __real_dw3000_spi_read(uint16_t headerLength, uint8_t *headerBuffer,
+			       uint16_t readLength, uint8_t *readBuffer);
+int32_t __real_dw3000_spi_write(uint16_t headerLength, const uint8_t *headerBuffer,
+				uint16_t bodyLength, const uint8_t *bodyBuffer);
+int32_t __real_dw3000_spi_write_crc(uint16_t headerLength, const uint8_t *headerBuffer,
+				    uint16_t bodyLength, const uint8_t *bodyBuffer,
+				    uint8_t crc8);
+
+/* SPI header, see the DW3000 user manual */
+#define SPI_HDR_WRITE     0x80
+#define SPI_HDR_LONG      0x40
+#define SPI_HDR_FAST_CMD  0x01 /* with SPI_HDR_WRITE on a 1 byte header */
+
+static struct spi_prof_rec spi_prof_rec[SPI_PROF_NUM_RECS];
+static uint32_t spi_prof_num; /* total number of transactions recorded */
+static struct spi_prof_sum spi_prof_sum[SPI_PROF_NUM_FILES][2];
+static struct spi_prof_sum spi_prof_cmd;
+
+static const char *const spi_prof_dir_name[] = { "rd", "wr", "cmd" };
+
+static void spi_prof_record(const uint8_t *hdr, uint16_t hdr_len, uint16_t len,
+			    uint32_t cycles)
+{
+	struct spi_prof_rec *rec;
+	struct spi_prof_sum *sum;
+	unsigned int key;
+	uint8_t dir;
+
+	if (hdr_len == 1 && (hdr[0] & (SPI_HDR_WRITE | SPI_HDR_LONG | SPI_HDR_FAST_CMD)) ==
+				    (SPI_HDR_WRITE | SPI_HDR_FAST_CMD)) {
+		dir = SPI_PROF_CMD;
+	} else {
+		dir = (hdr[0] & SPI_HDR_WRITE) ? SPI_PROF_WR : SPI_PROF_RD;
+	}
+
+	key = irq_lock();
+	rec = &spi_prof_rec[spi_prof_num++ % SPI_PROF_NUM_RECS];
+	rec->cycles = cycles;
+	rec->len = len;
+	rec->file = (hdr[0] >> 1) & 0x1F;
+	rec->offset = (hdr_len > 1) ? ((hdr[0] & 0x01) << 6) | (hdr[1] >> 2) : 0;
+	rec->dir = dir;
+	rec->hdr_len = hdr_len;
+
+	sum = (dir == SPI_PROF_CMD) ? &spi_prof_cmd : &spi_prof_sum[rec->file][dir];
+	sum->count++;
+	sum->bytes += hdr_len + len;
+	sum->cycles += cycles;
+	if (cycles > sum->max) {
+		sum->max = cycles;
+	}
+	irq_unlock(key);
+}
+
+int32_t __wrap_dw3000_spi_read(uint16_t headerLength, uint8_t *headerBuffer,
+			       uint16_t readLength, uint8_t *readBuffer)
+{
+	uint32_t start = prof_cycles();
+	int32_t ret;
+
+	ret = __real_dw3000_spi_read(headerLength, headerBuffer, readLength, readBuffer);
+	spi_prof_record(headerBuffer, headerLength, readLength, prof_cycles() - start);
+	return ret;
+}
+
+int32_t __wrap_dw3000_spi_write(uint16_t headerLength, const uint8_t *headerBuffer,
+				uint16_t bodyLength, const uint8_t *bodyBuffer)
+{
+	uint32_t start = prof_cycles();
+	int32_t ret;
+
+	ret = __real_dw3000_spi_write(headerLength, headerBuffer, bodyLength, bodyBuffer);
+	spi_prof_record(headerBuffer, headerLength, bodyLength, prof_cycles() - start);
+	return ret;
+}
+
+int32_t __wrap_dw3000_spi_write_crc(uint16_t headerLength, const uint8_t *headerBuffer,
+				    uint16_t bodyLength, const uint8_t *bodyBuffer,
+				    uint8_t crc8)
+{
+	uint32_t start = prof_cycles();
+	int32_t ret;
+
+	ret = __real_dw3000_spi_write_crc(headerLength, headerBuffer, bodyLength, bodyBuffer,
+					  crc8);
+	/* the CRC byte is counted with the body */
+	spi_prof_record(headerBuffer, headerLength, bodyLength + 1, prof_cycles() - start);
+	return ret;
+}
+
+void spi_prof_init(void)
+{
+	prof_cycles_init();
+	spi_prof_reset();
+}
+
+void spi_prof_reset(void)
+{
+	unsigned int key;
+
+	key = irq_lock();
+	spi_prof_num = 0;
+	memset(spi_prof_sum, 0, sizeof(spi_prof_sum));
+	memset(&spi_prof_cmd, 0, sizeof(spi_prof_cmd));
+	irq_unlock(key);
+}
+
+static void spi_prof_add(struct spi_prof_sum *to, const struct spi_prof_sum *s)
+{
+	to->count += s->count;
+	to->bytes += s->bytes;
+	to->cycles += s->cycles;
+	if (s->max > to->max) {
+		to->max = s->max;
+	}
+}
+
+void spi_prof_total(struct spi_prof_sum *sum)
+{
+	unsigned int key;
+	int f, d;
+
+	memset(sum, 0, sizeof(*sum));
+	key = irq_lock();
+	for (f = 0; f < SPI_PROF_NUM_FILES; f++) {
+		for (d = 0; d < 2; d++) {
+			spi_prof_add(sum, &spi_prof_sum[f][d]);
+		}
+	}
+	spi_prof_add(sum, &spi_prof_cmd);
+	irq_unlock(key);
+}
+
+static void spi_prof_print(const char *what, int file, const struct spi_prof_sum *s)
+{
+	if (s->count == 0) {
+		return;
+	}
+	printk("SPI %-3s 0x%02x n=%lu bytes=%lu avg=%lu max=%lu %s\n", what, file,
+	       (unsigned long)s->count, (unsigned long)s->bytes,
+	       (unsigned long)(s->cycles / s->count), (unsigned long)s->max, PROF_UNIT);
+}
+
+void spi_prof_dump(void)
+{
+	static struct spi_prof_sum sum[SPI_PROF_NUM_FILES][2]; /* too large for the stack */
+	struct spi_prof_sum cmd, total;
+	unsigned int key;
+	int f;
+
+	key = irq_lock();
+	memcpy(sum, spi_prof_sum, sizeof(sum));
+	cmd = spi_prof_cmd;
+	irq_unlock(key);
+
+	/* avg and max are per transaction, bytes include the header */
+	for (f = 0; f < SPI_PROF_NUM_FILES; f++) {
+		spi_prof_print("rd", f, &sum[f][SPI_PROF_RD]);
+		spi_prof_print("wr", f, &sum[f][SPI_PROF_WR]);
+	}
+	spi_prof_print("cmd", 0, &cmd);
+
+	spi_prof_total(&total);
+	printk("SPI total n=%lu bytes=%lu cycles=%llu %s\n", (unsigned long)total.count,
+	       (unsigned long)total.bytes, (unsigned long long)total.cycles, PROF_UNIT);
+}
+
+void spi_prof_dump_records(void)
+{
+	static struct spi_prof_rec rec[SPI_PROF_NUM_RECS];
+	uint32_t num, first, i;
+	unsigned int key;
+
+	key = irq_lock();
+	memcpy(rec, spi_prof_rec, sizeof(rec));
+	num = spi_prof_num;
+	irq_unlock(key);
+
+	/* oldest first, fast commands print the command as register file */
+	first = (num > SPI_PROF_NUM_RECS) ? num - SPI_PROF_NUM_RECS : 0;
+	for (i = first; i < num; i++) {
+		const struct spi_prof_rec *r = &rec[i % SPI_PROF_NUM_RECS];
+
+		printk("SPI #%lu %-3s 0x%02x:0x%02x len=%u %lu %s\n", (unsigned long)i,
+		       spi_prof_dir_name[r->dir], r->file, r->offset, r->len,
+		       (unsigned long)r->cycles, PROF_UNIT);
+	}
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * SPI transaction profiler
+ *
+ * Records every SPI transaction between the DW IC driver and the device:
+ * register file and offset (or fast command), direction, body length and
+ * duration in CPU cycles (see prof_cycles()). The last SPI_PROF_NUM_RECS
+ * transactions are kept in a ring buffer and all of them are summed up per
+ * register file and direction. spi_prof_dump() prints the sums and
+ * spi_prof_dump_records() the ring buffer.
+ *
+ * The SPI functions of the dw3000 driver module are wrapped at link time
+ * (ld --wrap), so neither the driver nor the examples are changed. The
+ * profiler is disabled by default and every macro expands to nothing,
+ * build with "cmake -DSPI_PROF=1" to enable it.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SPI_PROF_H_
+#define SPI_PROF_H_
+
+#include <stdint.h>
+
+#ifndef SPI_PROF_ENABLED
+#define SPI_PROF_ENABLED 0
+#endif
+
+#define SPI_PROF_NUM_RECS 64
+#define SPI_PROF_NUM_FILES 32 /* register files addressable by the SPI header */
+
+enum spi_prof_dir {
+	SPI_PROF_RD,
+	SPI_PROF_WR,
+	SPI_PROF_CMD, /* fast command, no body */
+};
+
+struct spi_prof_rec {
+	uint32_t cycles;
+	uint16_t len;     /* body length in bytes, header excluded */
+	uint8_t file;     /* register file, or fast command */
+	uint8_t offset;   /* offset in the register file */
+	uint8_t dir;      /* enum spi_prof_dir */
+	uint8_t hdr_len;  /* 1 or 2 bytes */
+};
+
+struct spi_prof_sum {
+	uint32_t count;
+	uint32_t bytes;
+	uint64_t cycles;
+	uint32_t max;
+};
+
+#if SPI_PROF_ENABLED
+
+void spi_prof_init(void);
+void spi_prof_reset(void);
+void spi_prof_total(struct spi_prof_sum *sum);
+void spi_prof_dump(void);
+void spi_prof_dump_records(void);
+
+#define SPI_PROF_INIT()  spi_prof_init()
+#define SPI_PROF_RESET() spi_prof_reset()
+#define SPI_PROF_DUMP()  spi_prof_dump()
+
+#else
+
+#define SPI_PROF_INIT()  ((void)0)
+#define SPI_PROF_RESET() ((void)0)
+#define SPI_PROF_DUMP()  ((void)0)
+
+#endif
+
+#endif /* SPI_PROF_H_ */
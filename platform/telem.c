@@ -0,0 +1,217 @@
+/*
+ * Link health telemetry, see telem.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <zephyr.h>
+#include <sys/printk.h>
+
+#include <binlog.h>
+#include <dw_dev.h>
+#include <port.h>
+#include <telem.h>
+
+#define TELEM_THREAD_STACK_SIZE 1024
+#define TELEM_TEXT_LEN 256
+
+/* 4095 events at most between two reads of the 12-bit event counters */
+#define TELEM_HW_PERIOD_MS 500
+
+#define TELEM_COUNTER_NAME(id, name) name,
+static const char *const telem_names[] = { TELEM_COUNTER_LIST(TELEM_COUNTER_NAME) };
+#undef TELEM_COUNTER_NAME
+
+static atomic_t counters[TELEM_NUM_COUNTERS];
+static struct dw_dev *volatile hw_dev;
+
+static uint32_t telem_period_ms;
+static uint32_t telem_flags;
+static volatile bool telem_running;
+
+K_THREAD_STACK_DEFINE(telem_stack, TELEM_THREAD_STACK_SIZE);
+static struct k_thread telem_thread;
+
+void telem_inc(enum telem_counter id)
+{
+	atomic_inc(&counters[id]);
+}
+
+void telem_add(enum telem_counter id, uint32_t n)
+{
+	atomic_add(&counters[id], (atomic_val_t)n);
+}
+
+uint32_t telem_get(enum telem_counter id)
+{
+	return (uint32_t)atomic_get(&counters[id]);
+}
+
+const char *telem_name(enum telem_counter id)
+{
+	return id < TELEM_NUM_COUNTERS ? telem_names[id] : "?";
+}
+
+void telem_hw_enable(void)
+{
+	dwt_configeventcounters(1);
+}
+
+void telem_hw_update(dwt_deviceentcnts_t *cnt)
+{
+	dwt_deviceentcnts_t c;
+
+	/* re-enabling the counters clears them, events in between are lost */
+	dwt_readeventcounters(&c);
+	dwt_configeventcounters(1);
+
+	telem_add(TELEM_HW_PHE, c.PHE);
+	telem_add(TELEM_HW_RSL, c.RSL);
+	telem_add(TELEM_HW_CRCG, c.CRCG);
+	telem_add(TELEM_HW_CRCB, c.CRCB);
+	telem_add(TELEM_HW_ARFE, c.ARFE);
+	telem_add(TELEM_HW_OVER, c.OVER);
+	telem_add(TELEM_HW_SFDTO, c.SFDTO);
+	telem_add(TELEM_HW_PTO, c.PTO);
+	telem_add(TELEM_HW_RTO, c.RTO);
+	telem_add(TELEM_HW_TXF, c.TXF);
+	telem_add(TELEM_HW_HPW, c.HPW);
+	telem_add(TELEM_HW_CRCE, c.CRCE);
+	telem_add(TELEM_HW_PREJ, c.PREJ);
+	telem_add(TELEM_HW_SFDD, c.SFDD);
+	telem_add(TELEM_HW_STSE, c.STSE);
+
+	if (cnt) {
+		*cnt = c;
+	}
+}
+
+void telem_hw_attach(struct dw_dev *dev)
+{
+	hw_dev = dev;
+	if (dev && telem_running) {
+		/* it may be sleeping a whole period */
+		k_wakeup(&telem_thread);
+	}
+}
+
+void telem_snapshot(struct telem_snapshot *s)
+{
+	int i;
+
+	s->time_ms = port_get_tick_ms();
+	s->period_ms = 0;
+	for (i = 0; i < TELEM_NUM_COUNTERS; i++) {
+		s->cnt[i] = (uint32_t)atomic_get(&counters[i]);
+	}
+}
+
+void telem_delta(const struct telem_snapshot *cur, const struct telem_snapshot *prev,
+		 struct telem_snapshot *delta)
+{
+	int i;
+
+	delta->time_ms = cur->time_ms;
+	delta->period_ms = cur->time_ms - prev->time_ms;
+	for (i = 0; i < TELEM_NUM_COUNTERS; i++) {
+		delta->cnt[i] = cur->cnt[i] - prev->cnt[i];
+	}
+}
+
+size_t telem_format(char *buf, size_t len, const struct telem_snapshot *s)
+{
+	size_t pos = 0;
+	int i, n;
+
+	if (len == 0) {
+		return 0;
+	}
+	buf[0] = '\0';
+
+	for (i = 0; i < TELEM_NUM_COUNTERS && pos < len; i++) {
+		if (s->cnt[i] == 0) {
+			continue;
+		}
+		n = snprintf(buf + pos, len - pos, "%s%s=%lu", pos ? " " : "", telem_names[i],
+			     (unsigned long)s->cnt[i]);
+		if (n < 0) {
+			break;
+		}
+		pos += n;
+	}
+	return pos < len ? pos : len - 1;
+}
+
+static void telem_export(const struct telem_snapshot *delta, const struct telem_snapshot *total)
+{
+	static char text[TELEM_TEXT_LEN];
+	int i;
+
+	if (telem_flags & TELEM_EXPORT_BINLOG) {
+		for (i = 0; i < TELEM_NUM_COUNTERS; i++) {
+			if (delta->cnt[i]) {
+				BINLOG3(BINLOG_TELEM, i, delta->cnt[i], total->cnt[i]);
+			}
+		}
+	}
+
+	if (telem_flags & TELEM_EXPORT_TEXT) {
+		telem_format(text, sizeof(text), delta);
+		printk("TELEM %lu ms %s\n", (unsigned long)delta->period_ms, text[0] ? text : "-");
+	}
+}
+
+static void telem_run(void *p1, void *p2, void *p3)
+{
+	static struct telem_snapshot prev, cur, delta;
+	struct dw_dev *dev;
+	uint32_t next_ms;
+	int32_t wait_ms;
+
+	telem_snapshot(&prev);
+	next_ms = prev.time_ms + telem_period_ms;
+
+	while (1) {
+		/* without a device to read, wake up only to export */
+		wait_ms = (int32_t)(next_ms - port_get_tick_ms());
+		if (hw_dev && wait_ms > TELEM_HW_PERIOD_MS) {
+			wait_ms = TELEM_HW_PERIOD_MS;
+		}
+		if (wait_ms > 0) {
+			k_msleep(wait_ms);
+		}
+
+		dev = hw_dev;
+		if (dev) {
+			dw_dev_lock(dev);
+			telem_hw_update(NULL);
+			dw_dev_unlock(dev);
+		}
+
+		if ((int32_t)(port_get_tick_ms() - next_ms) < 0) {
+			continue;
+		}
+		next_ms += telem_period_ms;
+
+		telem_snapshot(&cur);
+		telem_delta(&cur, &prev, &delta);
+		telem_export(&delta, &cur);
+		prev = cur;
+	}
+}
+
+int telem_start(uint32_t period_ms, uint32_t flags)
+{
+	if (period_ms == 0 || telem_period_ms) {
+		return -EINVAL;
+	}
+	telem_period_ms = period_ms;
+	telem_flags = flags;
+
+	k_thread_create(&telem_thread, telem_stack, K_THREAD_STACK_SIZEOF(telem_stack), telem_run,
+			NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, K_NO_WAIT);
+	telem_running = true;
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Link health telemetry
+ *
+ * One set of 32-bit counters for everything that goes wrong on the link: the
+ * RX errors found in the status register by the software (see
+ * check_for_status_errors() of the examples), the event counters of the DW IC,
+ * SPI CRC errors and delayed transmissions started too late. Counters are
+ * incremented with atomic operations, from threads, interrupts and DW IC
+ * callbacks alike, and never wrap in practice.
+ *
+ * The event counters of the DW IC are 8 or 12 bits wide and saturate:
+ * telem_hw_update() adds them to the telemetry and clears them, it is called
+ * by whoever owns the device, often enough to stay below 255 events (e.g. at
+ * each reception, or every second), or every 500 ms by the telemetry thread
+ * for a device given to telem_hw_attach(). Without such a device the thread
+ * only wakes up once per period, so that the low power examples stay asleep.
+ *
+ * telem_start() runs a low priority thread that takes a snapshot of the
+ * counters every period and exports the counters that changed since the
+ * previous one, as BINLOG_TELEM records of the binary log (rendered by
+ * tools/binlog_decode.py with the counter names below) and/or as one text
+ * line on the console:
+ *   TELEM 10000 ms rto=12 hw_crc_good=210 hw_preamble_rej=3
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TELEM_H_
+#define TELEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deca_device_api.h>
+
+struct dw_dev;
+
+/*
+ * Counter ID and name, tools/binlog_decode.py reads this list: keep one
+ * counter per line and only append. The first ones are the error indices of
+ * config_options.h.
+ */
+#define TELEM_COUNTER_LIST(C)                                                                     \
+	C(TELEM_RX_CRC, "crc")                                                                    \
+	C(TELEM_RX_RSE, "rse")                                                                    \
+	C(TELEM_RX_PHE, "phe")                                                                    \
+	C(TELEM_RX_SFDTO, "sfdto")                                                                \
+	C(TELEM_RX_PTO, "pto")                                                                    \
+	C(TELEM_RX_RTO, "rto")                                                                    \
+	C(TELEM_SPICRC, "spicrc")                                                                 \
+	C(TELEM_TXTO, "txto")                                                                     \
+	C(TELEM_ARFE, "arfe")                                                                     \
+	C(TELEM_TS_MISMATCH, "ts_mismatch")                                                       \
+	C(TELEM_BAD_FRAME, "bad_frame")                                                           \
+	C(TELEM_PREAMBLE_COUNT, "preamble_count")                                                 \
+	C(TELEM_CP_QUAL, "cp_qual")                                                               \
+	C(TELEM_STS_PREAMBLE, "sts")                                                              \
+	C(TELEM_STS_PEAK_GROWTH_RATE, "sts_peak_growth")                                          \
+	C(TELEM_STS_ADC_COUNT, "sts_adc_count")                                                   \
+	C(TELEM_STS_SFD_COUNT, "sts_sfd_count")                                                   \
+	C(TELEM_STS_LATE_FIRST_PATH, "sts_late_fp")                                               \
+	C(TELEM_STS_LATE_COARSE_EST, "sts_late_coarse")                                           \
+	C(TELEM_STS_COARSE_EST_EMPTY, "sts_coarse_empty")                                         \
+	C(TELEM_STS_HIGH_NOISE_THRESH, "sts_high_noise")                                          \
+	C(TELEM_STS_NON_TRIANGLE, "sts_non_triangle")                                             \
+	C(TELEM_STS_LOG_REG_FAILED, "sts_log_reg")                                                \
+	C(TELEM_TX_LATE, "tx_late")                                                               \
+	C(TELEM_HW_PHE, "hw_phe")                                                                 \
+	C(TELEM_HW_RSL, "hw_rse")                                                                 \
+	C(TELEM_HW_CRCG, "hw_crc_good")                                                           \
+	C(TELEM_HW_CRCB, "hw_crc_bad")                                                            \
+	C(TELEM_HW_ARFE, "hw_arfe")                                                               \
+	C(TELEM_HW_OVER, "hw_overrun")                                                            \
+	C(TELEM_HW_SFDTO, "hw_sfdto")                                                             \
+	C(TELEM_HW_PTO, "hw_pto")                                                                 \
+	C(TELEM_HW_RTO, "hw_rto")                                                                 \
+	C(TELEM_HW_TXF, "hw_tx")                                                                  \
+	C(TELEM_HW_HPW, "hw_half_period")                                                         \
+	C(TELEM_HW_CRCE, "hw_spicrc")                                                             \
+	C(TELEM_HW_PREJ, "hw_preamble_rej")                                                       \
+	C(TELEM_HW_SFDD, "hw_sfd_det")                                                            \
+	C(TELEM_HW_STSE, "hw_sts")
+
+#define TELEM_COUNTER_ID(id, name) id,
+enum telem_counter { TELEM_COUNTER_LIST(TELEM_COUNTER_ID) TELEM_NUM_COUNTERS };
+#undef TELEM_COUNTER_ID
+
+/* Flags of telem_start() */
+#define TELEM_EXPORT_BINLOG 0x01 /* one BINLOG_TELEM record per counter changed */
+#define TELEM_EXPORT_TEXT   0x02 /* one line on the console per period */
+
+/* Export started by main(), "cmake -DTELEM_PERIOD_MS=0" to disable it */
+#ifndef TELEM_PERIOD_MS
+#define TELEM_PERIOD_MS 10000
+#endif
+#ifndef TELEM_EXPORT
+#define TELEM_EXPORT TELEM_EXPORT_BINLOG
+#endif
+
+struct telem_snapshot {
+	uint32_t time_ms;   /* port_get_tick_ms() of the snapshot */
+	uint32_t period_ms; /* of a delta, time since the previous snapshot */
+	uint32_t cnt[TELEM_NUM_COUNTERS];
+};
+
+void telem_inc(enum telem_counter id);
+void telem_add(enum telem_counter id, uint32_t n);
+uint32_t telem_get(enum telem_counter id);
+const char *telem_name(enum telem_counter id);
+
+/*
+ * Enable and clear the event counters of the DW IC, once after dwt_configure().
+ * Events counted by the DW IC and not yet added by telem_hw_update() are lost.
+ */
+void telem_hw_enable(void);
+
+/*
+ * Add the event counters of the DW IC to the telemetry and clear them. If cnt
+ * is not NULL it gets the events counted since the previous call. The caller
+ * owns the device, see dw_dev_lock().
+ */
+void telem_hw_update(dwt_deviceentcnts_t *cnt);
+
+/*
+ * Device whose event counters the telemetry thread adds every 500 ms, under
+ * dw_dev_lock(). NULL to stop, e.g. for examples driving the device without
+ * the dw_dev layer, which call telem_hw_update() themselves.
+ */
+void telem_hw_attach(struct dw_dev *dev);
+
+/* Current values of all counters, each read atomically */
+void telem_snapshot(struct telem_snapshot *s);
+
+/* Changes from prev to cur */
+void telem_delta(const struct telem_snapshot *cur, const struct telem_snapshot *prev,
+		 struct telem_snapshot *delta);
+
+/*
+ * Compact text of the counters that are not zero, "name=value" separated by
+ * spaces, truncated to len. Returns the length of the text.
+ */
+size_t telem_format(char *buf, size_t len, const struct telem_snapshot *s);
+
+/* Start the periodic export, flags are TELEM_EXPORT_* */
+int telem_start(uint32_t period_ms, uint32_t flags);
+
+#endif /* TELEM_H_ */
@@ -0,0 +1,98 @@
+/*
+ * Air interface of the DW IC, see uwb_phy.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stddef.h>
+#include <uwb_phy.h>
+
+/* frame format, 64 and 16 MHz PRF, see NOTE 1 below */
+#define SYMBOL_64_NS   1018
+#define SYMBOL_16_NS   994
+#define BIT_850K_NS    1026
+#define BIT_6M8_NS     128
+#define SFD_SYMBOLS    8
+#define PHR_BITS       21
+#define RS_BLOCK_BITS  330
+#define RS_PARITY_BITS 48
+
+/*
+ * Typical supply currents at 3.3 V, in nA, see NOTE 2 below. The 16 MHz PRF
+ * sends and correlates fewer pulses and saves a few mA.
+ */
+#define I_DEEPSLEEP_NA 250
+#define I_SLEEP_NA     850
+#define I_IDLE_RC_NA   4000000
+#define I_PRF16_TX_NA  3000000 /* saved by the 16 MHz PRF */
+#define I_PRF16_RX_NA  2000000
+
+static const uint32_t i_idle_pll_na[2] = { 9000000, 10000000 }; /* channel 5, 9 */
+static const uint32_t i_tx_na[2][2] = {
+	{ 38000000, 40000000 }, /* channel 5, 850 kbps and 6.8 Mbps */
+	{ 42000000, 44000000 }, /* channel 9 */
+};
+static const uint32_t i_rx_na[2] = { 50000000, 55000000 };
+
+uint32_t uwb_phy_symbol_ns(const struct uwb_phy *phy)
+{
+	return UWB_PHY_PRF_64(phy) ? SYMBOL_64_NS : SYMBOL_16_NS;
+}
+
+uint32_t uwb_phy_airtime_us(const struct uwb_phy *phy, int sts, uint16_t len, uint32_t *preamble_us)
+{
+	uint32_t symbol_ns = uwb_phy_symbol_ns(phy);
+	uint32_t preamble_ns = (phy->plen + SFD_SYMBOLS) * symbol_ns;
+	uint32_t ns = preamble_ns;
+	uint32_t bits;
+
+	if (sts) {
+		ns += phy->sts_len * symbol_ns;
+	}
+	if (len) {
+		bits = len * 8;
+		bits += (bits + RS_BLOCK_BITS - 1) / RS_BLOCK_BITS * RS_PARITY_BITS;
+		ns += PHR_BITS * BIT_850K_NS + bits * (phy->rate_6m8 ? BIT_6M8_NS : BIT_850K_NS);
+	}
+	if (preamble_us != NULL) {
+		*preamble_us = preamble_ns / 1000;
+	}
+	return (ns + 999) / 1000;
+}
+
+uint32_t uwb_phy_current_na(const struct uwb_phy *phy, enum uwb_phy_state state)
+{
+	int ch = (phy->channel == 9);
+
+	switch (state) {
+	case UWB_PHY_DEEPSLEEP:
+		return I_DEEPSLEEP_NA;
+	case UWB_PHY_SLEEP:
+		return I_SLEEP_NA;
+	case UWB_PHY_IDLE_RC:
+		return I_IDLE_RC_NA;
+	case UWB_PHY_IDLE_PLL:
+		return i_idle_pll_na[ch];
+	case UWB_PHY_TX:
+		return i_tx_na[ch][phy->rate_6m8 != 0] - (UWB_PHY_PRF_64(phy) ? 0 : I_PRF16_TX_NA);
+	case UWB_PHY_RX:
+		return i_rx_na[ch] - (UWB_PHY_PRF_64(phy) ? 0 : I_PRF16_RX_NA);
+	default:
+		return 0;
+	}
+}
+
+/*
+ * NOTES:
+ *
+ * 1. The preamble and the 8 symbol SFD of the 4z configurations take
+ *    1018 ns per symbol at 64 MHz PRF, 994 ns at 16 MHz, and the STS is
+ *    sent with the same symbols. The 21 bit PHR is always sent at
+ *    850 kbps, 1026 ns per bit, and the data at the frame rate, 1026 or
+ *    128 ns per bit, with 48 Reed-Solomon parity bits per block of up to
+ *    330 data bits. The model ignores the gaps of the STS.
+ * 2. The currents are typical figures of the DW3000 data sheet, shared by
+ *    the energy accounting of platform/energy.c, the SNIFF controller and
+ *    the scheduled tag. Check them against the data sheet of the part and
+ *    measure the board for real figures.
+ */
@@ -0,0 +1,61 @@
+/*
+ * Air interface of the DW IC
+ *
+ * Describes the PHY configuration of a frame (channel, preamble, data rate,
+ * STS), models the time it spends on air and gives the typical supply
+ * current of the DW IC in each of its states with that configuration, for
+ * the examples which size RX windows, delays or duty cycles or estimate
+ * their energy from them. No DW IC driver dependency, so the host tools link
+ * the same model (see tools/twr_bench_sim and tools/energy_sim).
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef UWB_PHY_H_
+#define UWB_PHY_H_
+
+#include <stdint.h>
+
+#define UWB_PHY_SNIFF_OFF_NS 1024 /* unit of the SNIFF mode OFF time, 128/125 us */
+#define UWB_PHY_SUPPLY_MV    3300 /* supply of the currents below */
+
+enum uwb_phy_state {
+	UWB_PHY_DEEPSLEEP,
+	UWB_PHY_SLEEP,
+	UWB_PHY_IDLE_RC,  /* also INIT_RC and the wake-up */
+	UWB_PHY_IDLE_PLL, /* also the OFF phase of SNIFF mode */
+	UWB_PHY_TX,
+	UWB_PHY_RX,
+	UWB_PHY_NUM_STATES
+};
+
+struct uwb_phy {
+	uint8_t channel;  /* 5 or 9 */
+	uint16_t plen;    /* preamble length in symbols */
+	uint8_t code;     /* preamble code, 9 to 24 for the 64 MHz PRF */
+	uint8_t rate_6m8; /* 1 for 6.8 Mbps, 0 for 850 kbps */
+	uint16_t sts_len; /* STS length in symbols, for the frames with an STS */
+	uint8_t pac;      /* PAC size in symbols, for SNIFF mode */
+};
+
+#define UWB_PHY_PRF_64(phy) ((phy)->code >= 9)
+
+/* duration of a preamble symbol in ns */
+uint32_t uwb_phy_symbol_ns(const struct uwb_phy *phy);
+
+/*
+ * Duration of a frame on air in us, rounded up. sts is 1 if the frame
+ * carries an STS, len the frame length including the FCS, 0 for a frame
+ * without PHR and data (STS mode 3). If preamble_us is not NULL it receives
+ * the duration of the preamble and SFD, i.e. the time from the start of the
+ * frame to its RMARKER.
+ */
+uint32_t uwb_phy_airtime_us(const struct uwb_phy *phy, int sts, uint16_t len, uint32_t *preamble_us);
+
+/*
+ * Typical supply current of the DW IC in a state at UWB_PHY_SUPPLY_MV, in
+ * nA. TX and RX depend on the channel and PRF, TX also on the data rate.
+ */
+uint32_t uwb_phy_current_na(const struct uwb_phy *phy, enum uwb_phy_state state);
+
+#endif /* UWB_PHY_H_ */
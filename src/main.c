@@ -8,6 +8,10 @@
 #include <sys/printk.h>
 
 #include <dw3000_hw.h>
+#include <binlog.h>
+#include <prof.h>
+#include <spi_prof.h>
+#include <telem.h>
 #include "../examples_info/examples_defines.h"
 
 extern example_ptr example_pointer;
@@ -21,9 +25,19 @@ void main(void)
 {
 	printk("DW3000 Examples on %s\n", CONFIG_BOARD);
 
+	PROF_INIT();
+	SPI_PROF_INIT();
 	dw3000_hw_init();
 	dw3000_hw_reset();
 
+	if (binlog_init() < 0) {
+		printk("Binary log not available\n");
+	}
+
+	if (TELEM_PERIOD_MS) {
+		telem_start(TELEM_PERIOD_MS, TELEM_EXPORT);
+	}
+
 	build_examples();
 
 	if (example_pointer != NULL) {
@@ -0,0 +1,251 @@
+/*
+ * Accuracy of the antenna delay calibration solver of
+ * examples/shared_data/ant_delay_cal.c on a host
+ *
+ * Each run places the nodes at random in a room, gives each one a random
+ * antenna delay error and measures every pair as the averaged DS-TWR of
+ * ex_21_ant_delay_cal would: the true time-of-flight plus the errors of the
+ * two nodes plus Gaussian noise, rounded to Q4 device time units. Pairs can
+ * be lost (too few good exchanges) and are then not added. The result of
+ * ant_cal_solve() is compared with the floating point least-squares solution
+ * of the same pairs, and with the errors injected, and ant_cal_apply() with
+ * the delay that would have been exact.
+ *
+ * Prints the runs solved and under-determined, the iterations, the maximum
+ * difference from the least-squares solution and the RMS and maximum error
+ * from the injected delays, in device time units (15.65 ps). Returns 1 if the
+ * solver and the least-squares solution disagree on a system being determined,
+ * if the solver did not converge, if it is more than LIMIT_LSQ_Q4 away from the
+ * least-squares solution, or if the error is above the limit given with -m.
+ *
+ * Build from the repository root with
+ *   gcc -O2 -Iexamples/shared_data -o ant_delay_cal_sim \
+ *       tools/ant_delay_cal_sim/ant_delay_cal_sim.c examples/shared_data/ant_delay_cal.c -lm
+ * and run e.g. "./ant_delay_cal_sim -n 4 -l 200 -m 40".
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <ant_delay_cal.h>
+#include <shared_defines.h>
+
+#define SIM_DTU_PER_S  63897600000.0
+#define SIM_Q4         (1 << ANT_CAL_FRAC_BITS)
+#define SIM_ROOM_MM    15000 /* side of the room the nodes are placed in */
+#define SIM_MIN_DIST   500   /* closest two nodes can be, in millimetres */
+#define SIM_ANT_DLY    16385 /* antenna delay programmed before the calibration */
+#define SIM_SINGULAR   1e-9  /* pivot below which the normal equations are singular */
+
+/* Rounding of the Gauss-Seidel iterations, in Q4 device time units */
+#define LIMIT_LSQ_Q4 2
+
+static int num_nodes = 4;
+static double noise_dtu = 5;
+static double err_dtu = 150;
+static uint32_t loss_permille;
+static unsigned int seed = 1;
+
+static double uniform(double lo, double hi)
+{
+	return lo + (hi - lo) * rand_r(&seed) / (double)RAND_MAX;
+}
+
+/* Gaussian noise of standard deviation noise_dtu */
+static double noise(void)
+{
+	double u1 = (rand_r(&seed) + 1.0) / (RAND_MAX + 2.0);
+	double u2 = (rand_r(&seed) + 1.0) / (RAND_MAX + 2.0);
+
+	return noise_dtu * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/*
+ * Least-squares solution of e_i + e_j = err_ij over the measured pairs, by
+ * Gaussian elimination of the normal equations. Returns -1 if they are singular.
+ */
+static int ref_solve(const ant_cal_t *cal, double *e)
+{
+	double a[ANT_CAL_MAX_NODES][ANT_CAL_MAX_NODES + 1] = { { 0 } };
+	int n = cal->num_nodes;
+	int i, j, k, p;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < n; j++) {
+			if (!cal->valid[i][j]) {
+				continue;
+			}
+			a[i][i] += 1;
+			a[i][j] += 1;
+			a[i][n] += cal->err_q4[i][j];
+		}
+	}
+
+	for (k = 0; k < n; k++) {
+		p = k;
+		for (i = k + 1; i < n; i++) {
+			if (fabs(a[i][k]) > fabs(a[p][k])) {
+				p = i;
+			}
+		}
+		if (fabs(a[p][k]) < SIM_SINGULAR) {
+			return -1;
+		}
+		for (j = 0; j <= n; j++) {
+			double t = a[k][j];
+
+			a[k][j] = a[p][j];
+			a[p][j] = t;
+		}
+		for (i = 0; i < n; i++) {
+			double f;
+
+			if (i == k) {
+				continue;
+			}
+			f = a[i][k] / a[k][k];
+			for (j = k; j <= n; j++) {
+				a[i][j] -= f * a[k][j];
+			}
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		e[i] = a[i][n] / a[i][i];
+	}
+	return 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-n nodes] [-r runs] [-e noise_dtu] [-d max_delay_err_dtu]\n"
+		"          [-l loss_permille] [-m max_err_dtu] [-s seed]\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long runs = 10000, solved = 0, undet = 0, mismatch = 0, stuck = 0, iters = 0, r;
+	double max_lsq = 0, max_err = 0, sq = 0, limit = 0, err;
+	int32_t max_apply = 0;
+	int opt, i, j;
+
+	while ((opt = getopt(argc, argv, "n:r:e:d:l:m:s:")) != -1) {
+		switch (opt) {
+		case 'n':
+			num_nodes = atoi(optarg);
+			break;
+		case 'r':
+			runs = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			noise_dtu = strtod(optarg, NULL);
+			break;
+		case 'd':
+			err_dtu = strtod(optarg, NULL);
+			break;
+		case 'l':
+			loss_permille = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			limit = strtod(optarg, NULL);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (num_nodes < 3 || num_nodes > ANT_CAL_MAX_NODES) {
+		fprintf(stderr, "nodes must be between 3 and %d\n", ANT_CAL_MAX_NODES);
+		return 2;
+	}
+
+	for (r = 0; r < runs; r++) {
+		static ant_cal_t cal;
+		double x[ANT_CAL_MAX_NODES], y[ANT_CAL_MAX_NODES];
+		double e_true[ANT_CAL_MAX_NODES], e_ref[ANT_CAL_MAX_NODES];
+		int32_t e_q4[ANT_CAL_MAX_NODES], residual_q4;
+		int iter, ref;
+
+		ant_cal_init(&cal, num_nodes);
+
+		for (i = 0; i < num_nodes; i++) {
+			do {
+				x[i] = uniform(0, SIM_ROOM_MM);
+				y[i] = uniform(0, SIM_ROOM_MM);
+				for (j = 0; j < i; j++) {
+					if (hypot(x[i] - x[j], y[i] - y[j]) < SIM_MIN_DIST) {
+						break;
+					}
+				}
+			} while (j < i);
+			e_true[i] = uniform(-err_dtu, err_dtu);
+		}
+
+		for (i = 0; i < num_nodes; i++) {
+			for (j = i + 1; j < num_nodes; j++) {
+				/* the distances of the example are surveyed to the millimetre */
+				uint32_t dist_mm = (uint32_t)lround(hypot(x[i] - x[j], y[i] - y[j]));
+				double tof = dist_mm / 1000.0 / SPEED_OF_LIGHT * SIM_DTU_PER_S;
+
+				if ((uint32_t)(rand_r(&seed) % 1000) < loss_permille) {
+					continue;
+				}
+				tof += e_true[i] + e_true[j] + noise();
+				ant_cal_add_pair(&cal, i, j, (int32_t)lround(tof * SIM_Q4), dist_mm);
+			}
+		}
+
+		iter = ant_cal_solve(&cal, e_q4, &residual_q4);
+		ref = ref_solve(&cal, e_ref);
+		if ((iter < 0) != (ref < 0)) {
+			mismatch++;
+			continue;
+		}
+		if (iter < 0) {
+			undet++;
+			continue;
+		}
+		solved++;
+		iters += iter;
+		if (iter == ANT_CAL_MAX_ITER) {
+			stuck++;
+		}
+
+		for (i = 0; i < num_nodes; i++) {
+			int32_t exact = SIM_ANT_DLY + (int32_t)lround(e_true[i]);
+			int32_t d;
+
+			err = fabs(e_q4[i] - e_ref[i]);
+			if (err > max_lsq) {
+				max_lsq = err;
+			}
+			err = fabs((double)e_q4[i] / SIM_Q4 - e_true[i]);
+			if (err > max_err) {
+				max_err = err;
+			}
+			sq += err * err;
+
+			d = abs((int32_t)ant_cal_apply(SIM_ANT_DLY, e_q4[i]) - exact);
+			if (d > max_apply) {
+				max_apply = d;
+			}
+		}
+	}
+
+	printf("runs %lu solved %lu under-determined %lu mismatch %lu, iterations mean %.1f, %lu not converged\n",
+	       runs, solved, undet, mismatch, solved ? (double)iters / solved : 0.0, stuck);
+	printf("least-squares max difference %.2f DTU\n", max_lsq / SIM_Q4);
+	printf("delay error rms %.2f max %.2f DTU (%.0f ps), applied delay max error %ld DTU\n",
+	       solved ? sqrt(sq / (solved * num_nodes)) : 0.0, max_err, max_err * 15.65, (long)max_apply);
+
+	return (mismatch || stuck || max_lsq > LIMIT_LSQ_Q4 || (limit > 0 && max_err > limit)) ? 1 : 0;
+}
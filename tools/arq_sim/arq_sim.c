@@ -0,0 +1,352 @@
+/*
+ * Goodput of the ARQ engine of examples/shared_data/arq.c on a simulated
+ * lossy link
+ *
+ * Runs a sender and a receiver engine in two threads of one process, on a
+ * simulated clock: only one thread runs at a time, and the clock jumps to the
+ * next event (end of a transmission, of an SPI transfer, of a timeout, or
+ * the next microsecond of a busy wait) when both wait. The air time of the
+ * frames is modelled by uwb_phy_airtime_us() at 6.8 Mbps, the SPI transfers of
+ * the DW IC as a fixed overhead plus the bytes at the SPI clock. A frame is
+ * received if the receiver was enabled before its preamble started, and is
+ * lost (RX error) with the configured probability, data and acknowledgements
+ * alike. The write callback of the receiver takes a configurable time, e.g.
+ * to model a flash write.
+ *
+ * Prints the transfer time and the goodput, against the 6.8 Mbps of the PHY
+ * and against back to back 1023-byte frames (the PHY goodput), and checks the
+ * data received.
+ *
+ * Build from the repository root with
+ *   gcc -O2 -Iexamples/shared_data -Iplatform -o arq_sim \
+ *       tools/arq_sim/arq_sim.c examples/shared_data/arq.c \
+ *       platform/uwb_phy.c -lpthread
+ * and run e.g. "./arq_sim -n 262144 -l 5".
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arq.h>
+#include <uwb_phy.h>
+
+#define SIM_SPI_US    5 /* SPI transaction overhead */
+#define SIM_TX_START_US 10 /* Immediate transmission to start of preamble */
+#define SIM_NEVER     0xFFFFFFFFUL
+#define SIM_AIR_LEN   16
+
+struct sim_tx {
+	uint32_t start_us;
+	uint32_t end_us;
+	int from;
+	int lost;
+	uint16_t len;
+	uint8_t data[ARQ_FRAME_LEN_MAX];
+};
+
+struct sim_node {
+	arq_t arq;
+	uint32_t wake_us;     /* End of a busy time, SIM_NEVER if receiving */
+	uint32_t rx_start_us; /* Receiver enabled */
+	uint32_t rx_end_us;   /* Receiver timeout */
+	int rx_armed;
+	int done;
+	uint16_t tx_len;
+	uint8_t tx[ARQ_FRAME_LEN_MAX]; /* TX buffer */
+	uint8_t last[ARQ_FRAME_LEN_MAX]; /* RX buffer */
+};
+
+static struct sim_node nodes[2];
+static struct sim_tx air[SIM_AIR_LEN];
+static unsigned int air_next;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static __thread int self;
+static int turn;
+static uint32_t now_us, write_us, spi_mhz = 36;
+static struct uwb_phy phy = { 5, 128, 9, 1, 0, 8 };
+static double loss;
+static uint8_t *blob, *copy;
+static uint32_t blob_len;
+static int32_t rx_result;
+
+static uint32_t sim_spi_us(unsigned int len)
+{
+	return SIM_SPI_US + len * 8 / spi_mhz;
+}
+
+/* First frame the receiver of node n gets, and when */
+static const struct sim_tx *sim_rx_frame(const struct sim_node *n, int id)
+{
+	const struct sim_tx *best = NULL;
+	unsigned int i;
+
+	for (i = 0; i < SIM_AIR_LEN; i++) {
+		const struct sim_tx *t = &air[i];
+
+		if (t->len == 0 || t->from == id || (int32_t)(t->start_us - n->rx_start_us) < 0 ||
+		    (n->rx_end_us != SIM_NEVER && (int32_t)(t->start_us - n->rx_end_us) > 0)) {
+			continue;
+		}
+		if (!best || (int32_t)(t->start_us - best->start_us) < 0) {
+			best = t;
+		}
+	}
+	return best;
+}
+
+static uint32_t sim_next_us(int id)
+{
+	struct sim_node *n = &nodes[id];
+	const struct sim_tx *t;
+
+	if (n->done) {
+		return SIM_NEVER;
+	}
+	if (n->wake_us != SIM_NEVER) {
+		return n->wake_us;
+	}
+	t = sim_rx_frame(n, id);
+	return t ? t->end_us : n->rx_end_us;
+}
+
+/* Let the clock run to the next event, of this thread or of the other one. Called with the lock held. */
+static void sim_yield(void)
+{
+	uint32_t t0 = sim_next_us(0), t1 = sim_next_us(1);
+
+	if (t0 == SIM_NEVER && t1 == SIM_NEVER) {
+		turn = -1;
+		pthread_cond_broadcast(&cond);
+		return;
+	}
+	turn = (t1 == SIM_NEVER || (t0 != SIM_NEVER && (int32_t)(t1 - t0) >= 0)) ? 0 : 1;
+	now_us = turn ? t1 : t0;
+	pthread_cond_broadcast(&cond);
+	while (turn != self && turn != -1) {
+		pthread_cond_wait(&cond, &lock);
+	}
+}
+
+static void sim_sleep(uint32_t us)
+{
+	nodes[self].wake_us = now_us + us;
+	sim_yield();
+	nodes[self].wake_us = now_us;
+}
+
+static uint32_t sim_time_us(void)
+{
+	uint32_t t;
+
+	/* Every read of the clock takes a microsecond, so that busy waits end */
+	pthread_mutex_lock(&lock);
+	sim_sleep(1);
+	t = now_us;
+	pthread_mutex_unlock(&lock);
+	return t;
+}
+
+static void sim_load(const uint8_t *frame, uint16_t len)
+{
+	struct sim_node *n = &nodes[self];
+
+	pthread_mutex_lock(&lock);
+	n->tx_len = len;
+	memcpy(n->tx, frame, len - ARQ_FCS_LEN);
+	sim_sleep(sim_spi_us(len));
+	pthread_mutex_unlock(&lock);
+}
+
+static int sim_send(uint32_t rx_timeout_uus)
+{
+	struct sim_node *n = &nodes[self];
+	struct sim_tx *t;
+
+	pthread_mutex_lock(&lock);
+	t = &air[air_next];
+	air_next = (air_next + 1) % SIM_AIR_LEN;
+	t->start_us = now_us + SIM_TX_START_US;
+	t->end_us = t->start_us + uwb_phy_airtime_us(&phy, 0, n->tx_len, NULL);
+	t->from = self;
+	t->lost = (rand() < loss * RAND_MAX);
+	t->len = n->tx_len;
+	memcpy(t->data, n->tx, n->tx_len - ARQ_FCS_LEN);
+	sim_sleep(t->end_us - now_us);
+
+	n->rx_armed = (rx_timeout_uus != 0);
+	n->rx_start_us = now_us;
+	n->rx_end_us = now_us + rx_timeout_uus * 1026 / 1000;
+	pthread_mutex_unlock(&lock);
+	return ARQ_OK;
+}
+
+static int sim_receive(uint8_t *buf, uint16_t size, uint32_t timeout_uus)
+{
+	struct sim_node *n = &nodes[self];
+	const struct sim_tx *t;
+	int ret;
+
+	pthread_mutex_lock(&lock);
+	if (!n->rx_armed) {
+		n->rx_start_us = now_us;
+		n->rx_end_us = timeout_uus ? now_us + timeout_uus * 1026 / 1000 : SIM_NEVER;
+	}
+	n->rx_armed = 0;
+	n->wake_us = SIM_NEVER;
+	sim_yield();
+	n->wake_us = now_us;
+
+	t = sim_rx_frame(n, self);
+	if (!t || t->end_us != now_us) {
+		ret = ARQ_TIMEOUT;
+	} else if (t->lost) {
+		ret = ARQ_ERROR;
+	} else {
+		memcpy(n->last, t->data, t->len);
+		if (size > t->len) {
+			size = t->len;
+		}
+		memcpy(buf, t->data, size);
+		sim_sleep(sim_spi_us(size));
+		ret = t->len;
+	}
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+static void sim_read(uint8_t *buf, uint16_t offset, uint16_t len)
+{
+	pthread_mutex_lock(&lock);
+	memcpy(buf, &nodes[self].last[offset], len);
+	sim_sleep(sim_spi_us(len));
+	pthread_mutex_unlock(&lock);
+}
+
+static const arq_radio_t sim_radio = {
+	.load = sim_load,
+	.send = sim_send,
+	.receive = sim_receive,
+	.read = sim_read,
+	.time_us = sim_time_us,
+};
+
+static void sim_blob_read(void *ctx, uint32_t offset, uint8_t *buf, uint16_t len)
+{
+	(void)ctx;
+	memcpy(buf, &blob[offset], len);
+}
+
+static void sim_blob_write(void *ctx, uint32_t offset, const uint8_t *buf, uint16_t len)
+{
+	(void)ctx;
+	if (offset + len <= blob_len) {
+		memcpy(&copy[offset], buf, len);
+	}
+	pthread_mutex_lock(&lock);
+	sim_sleep(write_us);
+	pthread_mutex_unlock(&lock);
+}
+
+static void *sim_thread(void *arg)
+{
+	struct sim_node *n;
+	int ret;
+
+	self = (int)(intptr_t)arg;
+	n = &nodes[self];
+	pthread_mutex_lock(&lock);
+	while (turn != self) {
+		pthread_cond_wait(&cond, &lock);
+	}
+	pthread_mutex_unlock(&lock);
+
+	if (self == 0) {
+		ret = arq_send(&n->arq, blob_len, sim_blob_read, NULL);
+		if (ret != ARQ_OK) {
+			printf("send failed %d\n", ret);
+		}
+	} else {
+		rx_result = arq_receive(&n->arq, sim_blob_write, NULL, 1000);
+	}
+
+	pthread_mutex_lock(&lock);
+	n->done = 1;
+	sim_yield();
+	pthread_mutex_unlock(&lock);
+	return NULL;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-n bytes] [-l loss_percent] [-w write_us] [-p preamble] [-s spi_mhz] [-r seed]\n", prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const arq_stats_t *st = &nodes[0].arq.stats;
+	pthread_t threads[2];
+	double frame_us;
+	uint32_t i;
+	int opt;
+
+	blob_len = 256 * 1024;
+	srand(1);
+	while ((opt = getopt(argc, argv, "n:l:w:p:s:r:")) != -1) {
+		switch (opt) {
+		case 'n':
+			blob_len = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			loss = atof(optarg) / 100;
+			break;
+		case 'w':
+			write_us = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			phy.plen = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			spi_mhz = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			srand(strtoul(optarg, NULL, 0));
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (blob_len > 0xFFFFUL * ARQ_PAYLOAD_MAX || loss < 0 || loss >= 1 || spi_mhz == 0 || phy.plen == 0) {
+		usage(argv[0]);
+	}
+
+	blob = malloc(blob_len + 1);
+	copy = calloc(blob_len + 1, 1);
+	for (i = 0; i < blob_len; i++) {
+		blob[i] = (uint8_t)rand();
+	}
+
+	arq_init(&nodes[0].arq, &sim_radio, 0xDECA, 0x0001, 0x0002);
+	arq_init(&nodes[1].arq, &sim_radio, 0xDECA, 0x0002, 0x0001);
+	nodes[0].wake_us = 0;
+	nodes[1].wake_us = 0;
+	turn = 0;
+	pthread_create(&threads[0], NULL, sim_thread, (void *)(intptr_t)0);
+	pthread_create(&threads[1], NULL, sim_thread, (void *)(intptr_t)1);
+	pthread_join(threads[0], NULL);
+	pthread_join(threads[1], NULL);
+
+	frame_us = uwb_phy_airtime_us(&phy, 0, ARQ_FRAME_LEN_MAX, NULL);
+	printf("%u bytes in %u us, %u frames (%u repeats), %u requests, %u polls, %u timeouts\n", blob_len, st->time_us, st->frames,
+	       st->repeats, st->requests, st->polls, st->timeouts);
+	printf("goodput %.2f Mbps, %.0f%% of 6.8 Mbps, %.0f%% of back to back frames (%.2f Mbps)\n", blob_len * 8.0 / st->time_us,
+	       blob_len * 800.0 / st->time_us / 6.8, 100.0 * blob_len * 8.0 / st->time_us / (ARQ_PAYLOAD_MAX * 8 / frame_us),
+	       ARQ_PAYLOAD_MAX * 8 / frame_us);
+	printf("received %d bytes, %s\n", rx_result, (rx_result == (int32_t)blob_len && !memcmp(blob, copy, blob_len)) ? "data ok" : "DATA MISMATCH");
+	return 0;
+}
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+#
+# Decode the binary log of platform/binlog.c into text
+#
+# Reads the raw stream from a file or stdin, e.g. as written by
+#   JLinkRTTLogger -Device NRF52832_XXAA -If SWD -Speed 4000 -RTTChannel 1 log.bin
+# and prints one line per record with the time in seconds since the first
+# record. The event formats are taken from platform/binlog_events.h and the
+# names of the telemetry counters from platform/telem.h.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC = 0xB7
+HDR = struct.Struct("<BIHBB")
+MAX_ARGS = 3
+DEFAULT_CLOCK_HZ = 64000000
+
+PLATFORM = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "platform")
+EVENTS_H = os.path.join(PLATFORM, "binlog_events.h")
+TELEM_H = os.path.join(PLATFORM, "telem.h")
+
+
+def load_events(path):
+    events = []
+    with open(path) as f:
+        for line in f:
+            m = re.match(r'\s*BINLOG_EVENT\(\s*(\w+)\s*,\s*"(.*)"\s*\)', line)
+            if m:
+                events.append((m.group(1), m.group(2)))
+    return events
+
+
+def load_counters(path):
+    counters = []
+    try:
+        with open(path) as f:
+            for line in f:
+                m = re.match(r'\s*C\(\s*TELEM_\w+\s*,\s*"(.*)"\s*\)', line)
+                if m:
+                    counters.append(m.group(1))
+    except OSError:
+        pass
+    return counters
+
+
+def render(fmt, args, counters):
+    args = list(args)
+
+    def conv(m):
+        if not args:
+            return m.group(0)
+        val = args.pop(0)
+        kind = m.group(1)
+        if kind == "u":
+            return str(val & 0xFFFFFFFF)
+        if kind == "x":
+            return "%04X" % (val & 0xFFFFFFFF)
+        if kind == "t":
+            return counters[val] if 0 <= val < len(counters) else "counter%d" % val
+        if kind.startswith("q"):
+            places = int(kind[1:])
+            return "%.*f" % (places, val / 10 ** places)
+        return str(val)
+
+    return re.sub(r"%(d|u|x|t|q\d)", conv, fmt)
+
+
+def decode(data, events, counters, clock_hz, out):
+    pos = 0
+    seq = None
+    start = None
+    last_ts = 0
+    wraps = 0
+    lost_bytes = 0
+
+    while pos + HDR.size <= len(data):
+        sync, ts, ev, nargs, rec_seq = HDR.unpack_from(data, pos)
+        if sync != SYNC or nargs > MAX_ARGS or ev >= len(events):
+            pos += 1
+            lost_bytes += 1
+            continue
+        end = pos + HDR.size + 4 * nargs
+        if end > len(data):
+            break
+        args = struct.unpack_from("<%di" % nargs, data, pos + HDR.size)
+        pos = end
+
+        if lost_bytes:
+            out.write("# skipped %d bytes\n" % lost_bytes)
+            lost_bytes = 0
+        if seq is not None and rec_seq != (seq + 1) & 0xFF:
+            out.write("# sequence gap, %d records missing\n" % ((rec_seq - seq - 1) & 0xFF))
+        seq = rec_seq
+
+        name, fmt = events[ev]
+        if name == "BINLOG_START":
+            clock_hz = args[0] or clock_hz
+            start = None
+            wraps = 0
+        if start is None:
+            start = ts
+        elif ts < last_ts:
+            wraps += 1
+        last_ts = ts
+
+        t = ((wraps << 32) + ts - start) / clock_hz
+        out.write("%12.6f %s\n" % (t, render(fmt, args, counters)))
+
+    return data[pos:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the DW3000 examples binary log")
+    parser.add_argument("file", nargs="?", help="raw log file, stdin if omitted")
+    parser.add_argument("--events", default=EVENTS_H, help="path to binlog_events.h")
+    parser.add_argument("--telem", default=TELEM_H, help="path to telem.h, for the counter names")
+    parser.add_argument("--clock", type=int, default=DEFAULT_CLOCK_HZ,
+                        help="timestamp clock in Hz until a start record is seen")
+    args = parser.parse_args()
+
+    events = load_events(args.events)
+    src = open(args.file, "rb") if args.file else sys.stdin.buffer
+    decode(src.read(), events, load_counters(args.telem), args.clock, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
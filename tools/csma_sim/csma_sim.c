@@ -0,0 +1,300 @@
+/*
+ * Throughput of the CSMA-CA engine of examples/shared_data/csma.c on a
+ * simulated shared channel
+ *
+ * Runs one engine per simulated device in a single process, on a channel
+ * with microsecond time steps. Each device queues frames at random (Poisson)
+ * times, all devices together offering a given share of the channel time,
+ * and the engine sends them with CCA. The CCA fails if the preamble of
+ * another frame is on air during it (the DW IC only detects preambles). A
+ * frame is lost if another frame is on air during its preamble, or if the
+ * data of another frame overlaps its data, as a preamble does not disturb the
+ * reception of data (-s: any overlap loses the frame). The air time of the
+ * frames is modelled as by uwb_phy_airtime_us(), at 6.8 Mbps.
+ *
+ * One line per offered load gives the throughput (share of the channel time
+ * carrying frames received), the frames lost in collisions, the channel
+ * access failures, the frames not queued (queue full) and the channel access
+ * delay. With -a the devices transmit without CCA or backoff (ALOHA), for
+ * comparison.
+ *
+ * Build from the repository root with
+ *   gcc -O2 -Iexamples/shared_data -Iplatform -o csma_sim \
+ *       tools/csma_sim/csma_sim.c examples/shared_data/csma.c \
+ *       platform/uwb_phy.c -lm
+ * and run e.g. "./csma_sim -n 20 -t 10".
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <csma.h>
+#include <uwb_phy.h>
+
+#define SIM_MAX_NODES 64
+#define SIM_AIR_LEN   256 /* Frames kept on the air history, more than can overlap */
+
+struct sim_tx {
+	uint32_t start_us;
+	uint32_t pre_end_us;
+	uint32_t end_us;
+	int node;
+};
+
+struct sim_node {
+	csma_t csma;
+	uint32_t wake_us;     /* Next call of csma_process() */
+	uint32_t arrival_us;  /* Next frame queued */
+	uint32_t cca_end_us;  /* End of the CCA in progress */
+	int tx;               /* Index in the air history of the frame being sent, -1 during the CCA */
+	uint32_t overflows;
+	uint32_t lost;
+	uint32_t delivered;
+};
+
+static struct sim_node nodes[SIM_MAX_NODES];
+static struct sim_tx air[SIM_AIR_LEN];
+static unsigned int air_next;
+static uint32_t now_us, frame_air_us, frame_pre_us, cca_us;
+static int cur, aloha, strict;
+static uint8_t frame[] = { 0xC5, 0, 'D', 'E', 'C', 'A', 'W', 'A', 'V', 'E', 0, 0 };
+
+static uint32_t sim_time_us(void)
+{
+	return now_us;
+}
+
+static int sim_overlap(uint32_t a0, uint32_t a1, uint32_t b0, uint32_t b1)
+{
+	return (int32_t)(a0 - b1) < 0 && (int32_t)(b0 - a1) < 0;
+}
+
+static int sim_cca_tx(const uint8_t *f, uint16_t len)
+{
+	(void)f;
+	(void)len;
+	nodes[cur].cca_end_us = now_us + (aloha ? 0 : cca_us);
+	nodes[cur].tx = -1;
+	return CSMA_TX_PENDING;
+}
+
+/* Frame lost if another one disturbs it, see the header */
+static int sim_collided(const struct sim_tx *t)
+{
+	unsigned int i;
+
+	for (i = 0; i < SIM_AIR_LEN; i++) {
+		const struct sim_tx *o = &air[i];
+
+		if (o == t || o->end_us == o->start_us ||
+		    !sim_overlap(o->start_us, o->end_us, t->start_us, t->end_us)) {
+			continue;
+		}
+		if (strict || sim_overlap(o->start_us, o->end_us, t->start_us, t->pre_end_us) ||
+		    sim_overlap(o->pre_end_us, o->end_us, t->pre_end_us, t->end_us)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int sim_tx_status(void)
+{
+	struct sim_node *n = &nodes[cur];
+	unsigned int i;
+
+	if (n->tx < 0) {
+		if ((int32_t)(now_us - n->cca_end_us) < 0) {
+			return CSMA_TX_PENDING;
+		}
+		/* End of the CCA: busy if a preamble was on air during it */
+		for (i = 0; i < SIM_AIR_LEN && !aloha; i++) {
+			if (air[i].end_us != air[i].start_us &&
+			    sim_overlap(air[i].start_us, air[i].pre_end_us, n->cca_end_us - cca_us, n->cca_end_us)) {
+				return CSMA_TX_BUSY;
+			}
+		}
+		n->tx = air_next;
+		air[air_next].start_us = now_us;
+		air[air_next].pre_end_us = now_us + frame_pre_us;
+		air[air_next].end_us = now_us + frame_air_us;
+		air[air_next].node = cur;
+		air_next = (air_next + 1) % SIM_AIR_LEN;
+		return CSMA_TX_PENDING;
+	}
+	if ((int32_t)(now_us - air[n->tx].end_us) < 0) {
+		return CSMA_TX_PENDING;
+	}
+	if (sim_collided(&air[n->tx])) {
+		n->lost++;
+	} else {
+		n->delivered++;
+	}
+	return CSMA_TX_DONE;
+}
+
+static const csma_radio_t sim_radio = {
+	.cca_tx = sim_cca_tx,
+	.tx_status = sim_tx_status,
+	.time_us = sim_time_us,
+};
+
+static uint32_t sim_exp_us(double mean_us)
+{
+	return (uint32_t)(-mean_us * log((rand() + 1.0) / (RAND_MAX + 2.0))) + 1;
+}
+
+static void sim_run(unsigned int n_nodes, double load, uint32_t run_us, const csma_params_t *params)
+{
+	double mean_us = frame_air_us * n_nodes / load;
+	uint64_t delivered = 0, lost = 0, sent = 0, failed = 0, overflows = 0, delay_sum = 0, queued = 0;
+	uint32_t delay_max = 0, end_us;
+	csma_params_t p = *params;
+	unsigned int i;
+
+	if (aloha) {
+		p.min_be = 0;
+		p.max_be = 0;
+	}
+	memset(air, 0, sizeof(air));
+	air_next = 0;
+	now_us = 0;
+	for (i = 0; i < n_nodes; i++) {
+		memset(&nodes[i], 0, sizeof(nodes[i]));
+		csma_init(&nodes[i].csma, &sim_radio, &p, rand() | 1);
+		nodes[i].arrival_us = sim_exp_us(mean_us);
+		nodes[i].wake_us = CSMA_IDLE;
+	}
+
+	/* Warm up for a tenth of the run, then count */
+	end_us = run_us + run_us / 10;
+	for (now_us = 0; now_us < end_us; now_us++) {
+		if (now_us == run_us / 10) {
+			for (i = 0; i < n_nodes; i++) {
+				memset(&nodes[i].csma.stats, 0, sizeof(nodes[i].csma.stats));
+				nodes[i].overflows = nodes[i].lost = nodes[i].delivered = 0;
+			}
+		}
+		for (i = 0; i < n_nodes; i++) {
+			struct sim_node *n = &nodes[i];
+
+			cur = i;
+			if (now_us == n->arrival_us) {
+				if (csma_queue(&n->csma, frame, sizeof(frame), NULL, NULL) != CSMA_OK) {
+					n->overflows++;
+				}
+				n->arrival_us = now_us + sim_exp_us(mean_us);
+				n->wake_us = now_us;
+			}
+			if (n->wake_us != CSMA_IDLE && (int32_t)(now_us - n->wake_us) >= 0) {
+				uint32_t w = csma_process(&n->csma);
+
+				n->wake_us = (w == CSMA_IDLE) ? CSMA_IDLE : now_us + (w ? w : 1);
+			}
+		}
+	}
+
+	for (i = 0; i < n_nodes; i++) {
+		const csma_stats_t *st = &nodes[i].csma.stats;
+
+		queued += st->queued;
+		sent += st->sent;
+		failed += st->failed;
+		delay_sum += st->delay_sum_us;
+		if (st->delay_max_us > delay_max) {
+			delay_max = st->delay_max_us;
+		}
+		delivered += nodes[i].delivered;
+		lost += nodes[i].lost;
+		overflows += nodes[i].overflows;
+	}
+	queued += overflows;
+	printf("load %4.2f throughput %4.2f lost %5.1f%% fail %5.1f%% ovf %5.1f%% delay mean %6.0f max %6u us\n", load,
+	       (double)delivered * frame_air_us / run_us, sent ? 100.0 * lost / sent : 0,
+	       queued ? 100.0 * failed / queued : 0, queued ? 100.0 * overflows / queued : 0,
+	       sent ? (double)delay_sum / sent : 0, delay_max);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-n nodes] [-t seconds] [-l load] [-p preamble] [-f frame_len]\n"
+		"       [-b min_be] [-B max_be] [-m max_backoffs] [-u unit_us] [-a] [-s] [-r seed]\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	struct uwb_phy phy = { 5, 128, 9, 1, 0, 8 };
+	csma_params_t params = { CSMA_MIN_BE, CSMA_MAX_BE, CSMA_MAX_BACKOFFS, CSMA_UNIT_BACKOFF_US };
+	unsigned int n_nodes = 10, seconds = 10, len = sizeof(frame);
+	double load = 0;
+	int opt;
+
+	srand(1);
+	while ((opt = getopt(argc, argv, "n:t:l:p:f:b:B:m:u:asr:")) != -1) {
+		switch (opt) {
+		case 'n':
+			n_nodes = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			seconds = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			load = atof(optarg);
+			break;
+		case 'p':
+			phy.plen = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			len = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			params.min_be = strtoul(optarg, NULL, 0);
+			break;
+		case 'B':
+			params.max_be = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			params.max_backoffs = strtoul(optarg, NULL, 0);
+			break;
+		case 'u':
+			params.unit_us = strtoul(optarg, NULL, 0);
+			break;
+		case 'a':
+			aloha = 1;
+			break;
+		case 's':
+			strict = 1;
+			break;
+		case 'r':
+			srand(strtoul(optarg, NULL, 0));
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (n_nodes == 0 || n_nodes > SIM_MAX_NODES || seconds == 0 || seconds > 1000 || len < 5 ||
+	    params.max_be > 16 || params.min_be > params.max_be) {
+		usage(argv[0]);
+	}
+
+	frame_air_us = uwb_phy_airtime_us(&phy, 0, len, &frame_pre_us);
+	cca_us = (CSMA_CCA_PACS * phy.pac * uwb_phy_symbol_ns(&phy) + 999) / 1000;
+	printf("# %u nodes, frame %u us (preamble %u us), CCA %u us, %s\n", n_nodes, frame_air_us, frame_pre_us,
+	       cca_us, aloha ? "ALOHA" : "CSMA-CA");
+
+	if (load > 0) {
+		sim_run(n_nodes, load, seconds * 1000000, &params);
+	} else {
+		for (load = 0.1; load < 1.55; load += (load < 0.95) ? 0.1 : 0.25) {
+			sim_run(n_nodes, load, seconds * 1000000, &params);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * Energy simulator of the DW IC, on top of the accounting of platform/energy.c
+ *
+ * Replays the sequence of states of an application on a simulated clock and
+ * prints the energy per exchange, the energy per hour, the average current
+ * and the projected battery life, so that configurations can be compared
+ * before trials on the target. The applications follow the examples:
+ *
+ *   blink      tx_sleep: DEEPSLEEP between blinks, woken up by the MCU
+ *   blink_rc   tx_sleep_idleRC: as blink, back to IDLE_RC after the wake-up
+ *   blink_idle blinks from IDLE_PLL, the DW IC never sleeps
+ *   tag        ss_twr_initiator_sched: poll and response, DEEPSLEEP between
+ *   listen     continuous RX, frames received at a given rate
+ *   sniff      rx_sniff: as listen in SNIFF mode
+ *
+ * Without -c, -d, -l and -f every channel, data rate, PRF and preamble
+ * length is simulated, one line each, e.g. to sort by current:
+ *   ./energy_sim -a tag -p 100 | sort -t= -k4 -n
+ *
+ * Build from the repository root with
+ *   gcc -O2 -Iplatform -o energy_sim tools/energy_sim/energy_sim.c platform/energy.c \
+ *       platform/uwb_phy.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <energy.h>
+
+#define SIM_EXCHANGES   1000
+#define SIM_MAX_US      3600000000UL /* within the wrap of the 32 bit clock of the accounting */
+#define SIM_WAKEUP_US   2000 /* Sleep(2) of the examples after dwt_wakeup_ic() */
+#define SIM_RESTORE_US  200  /* dwt_restoreconfig() */
+#define SIM_PREPARE_US  60   /* writing the frame and starting the TX */
+#define SIM_READ_US     100  /* reading a frame */
+#define SIM_RESP_DLY_US 667  /* poll to response RMARKER of the SS TWR responder (650 UUS) */
+#define SIM_BLINK_LEN   12
+#define SIM_POLL_LEN    12
+#define SIM_RESP_LEN    20
+
+enum sim_app { SIM_BLINK, SIM_BLINK_RC, SIM_BLINK_IDLE, SIM_TAG, SIM_LISTEN, SIM_SNIFF };
+
+static const char *const sim_app_name[] = {
+	"blink", "blink_rc", "blink_idle", "tag", "listen", "sniff",
+};
+
+static const uint16_t sim_plen[] = { 64, 128, 256, 512, 1024 };
+
+struct sim_cfg {
+	enum sim_app app;
+	uint32_t period_us; /* between exchanges */
+	uint8_t sniff_on;
+	uint8_t sniff_off;
+	uint32_t battery_mah;
+};
+
+/* wake-up by the MCU, returns the time the DW IC is ready */
+static uint32_t sim_wakeup(struct energy_acct *ea, uint32_t t, enum energy_state ready)
+{
+	energy_enter(ea, ENERGY_IDLE_RC, t);
+	t += SIM_WAKEUP_US + SIM_RESTORE_US;
+	energy_enter(ea, ready, t);
+	return t;
+}
+
+static void sim_run(const struct sim_cfg *cfg, const struct uwb_phy *phy)
+{
+	struct energy_acct ea;
+	struct energy_summary s;
+	uint32_t t = 0, start, n;
+	uint32_t i;
+
+	energy_init(&ea, phy, t);
+	energy_enter(&ea, ENERGY_IDLE_PLL, t);
+	if (cfg->app == SIM_SNIFF) {
+		energy_set_sniff(&ea, cfg->sniff_on, cfg->sniff_off);
+	}
+	if (cfg->app == SIM_BLINK || cfg->app == SIM_BLINK_RC || cfg->app == SIM_TAG) {
+		energy_enter(&ea, ENERGY_DEEPSLEEP, t);
+	}
+	energy_reset(&ea, t);
+
+	n = SIM_MAX_US / cfg->period_us;
+	if (n > SIM_EXCHANGES) {
+		n = SIM_EXCHANGES;
+	}
+	for (i = 0; i < n; i++) {
+		start = t;
+		switch (cfg->app) {
+		case SIM_BLINK:
+		case SIM_BLINK_RC:
+		case SIM_BLINK_IDLE:
+			if (cfg->app != SIM_BLINK_IDLE) {
+				t = sim_wakeup(&ea, t, (cfg->app == SIM_BLINK) ? ENERGY_IDLE_PLL :
+										 ENERGY_IDLE_RC);
+			}
+			t += SIM_PREPARE_US;
+			energy_tx(&ea, t, SIM_BLINK_LEN, ENERGY_IDLE_PLL);
+			t += uwb_phy_airtime_us(phy, 0, SIM_BLINK_LEN, NULL);
+			if (cfg->app != SIM_BLINK_IDLE) {
+				energy_enter(&ea, ENERGY_DEEPSLEEP, t);
+			}
+			break;
+		case SIM_TAG:
+			t = sim_wakeup(&ea, t, ENERGY_IDLE_PLL) + SIM_PREPARE_US;
+			energy_tx(&ea, t, SIM_POLL_LEN, ENERGY_RX);
+			/* the response ends its RMARKER delay plus its payload after the poll RMARKER */
+			t += SIM_RESP_DLY_US + uwb_phy_airtime_us(phy, 0, SIM_RESP_LEN, NULL);
+			energy_enter(&ea, ENERGY_IDLE_PLL, t);
+			t += SIM_READ_US;
+			energy_enter(&ea, ENERGY_DEEPSLEEP, t);
+			break;
+		case SIM_LISTEN:
+		case SIM_SNIFF:
+			energy_enter(&ea, (cfg->app == SIM_SNIFF) ? ENERGY_SNIFF : ENERGY_RX, t);
+			/* the frame is received at the end of the period */
+			t += cfg->period_us - SIM_READ_US;
+			energy_enter(&ea, ENERGY_IDLE_PLL, t);
+			t += SIM_READ_US;
+			break;
+		}
+		ea.exchanges++;
+		if ((int32_t)(start + cfg->period_us - t) > 0) {
+			t = start + cfg->period_us;
+		}
+	}
+
+	energy_summarize(&ea, t, cfg->battery_mah, &s);
+	printf("%-10s ch%u %s %-4s plen=%-4u E=%lu.%03lu uJ/xchg %lu.%03lu J/h I=%lu.%03lu uA "
+	       "life=%lu d\n",
+	       sim_app_name[cfg->app], phy->channel, UWB_PHY_PRF_64(phy) ? "64M" : "16M",
+	       phy->rate_6m8 ? "6M8" : "850k", phy->plen,
+	       (unsigned long)(s.nj_per_exchange / 1000), (unsigned long)(s.nj_per_exchange % 1000),
+	       (unsigned long)(s.mj_per_hour / 1000), (unsigned long)(s.mj_per_hour % 1000),
+	       (unsigned long)(s.avg_na / 1000), (unsigned long)(s.avg_na % 1000),
+	       (unsigned long)(s.life_h / 24));
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-a blink|blink_rc|blink_idle|tag|listen|sniff] [-p period_ms (up to 1 h)]\n"
+		"       [-c channel] [-d 6m8|850k] [-f 16|64] [-l plen] [-o sniff_on,sniff_off]\n"
+		"       [-b battery_mah]\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	struct sim_cfg cfg = { SIM_BLINK, 1000000, 2, 16, 1000 };
+	int channel = 0, rate = -1, prf = 0, plen = 0;
+	struct uwb_phy phy = { 0 };
+	unsigned int a, c, d, f, l;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:p:c:d:f:l:o:b:")) != -1) {
+		switch (opt) {
+		case 'a':
+			for (a = 0; a < sizeof(sim_app_name) / sizeof(sim_app_name[0]); a++) {
+				if (strcmp(optarg, sim_app_name[a]) == 0) {
+					break;
+				}
+			}
+			if (a == sizeof(sim_app_name) / sizeof(sim_app_name[0])) {
+				usage(argv[0]);
+			}
+			cfg.app = a;
+			break;
+		case 'p':
+			cfg.period_us = strtoul(optarg, NULL, 0) * 1000;
+			break;
+		case 'c':
+			channel = atoi(optarg);
+			break;
+		case 'd':
+			rate = (strcmp(optarg, "6m8") == 0);
+			break;
+		case 'f':
+			prf = atoi(optarg);
+			break;
+		case 'l':
+			plen = atoi(optarg);
+			break;
+		case 'o':
+			if (sscanf(optarg, "%hhu,%hhu", &cfg.sniff_on, &cfg.sniff_off) != 2) {
+				usage(argv[0]);
+			}
+			break;
+		case 'b':
+			cfg.battery_mah = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (cfg.period_us == 0 || cfg.period_us > SIM_MAX_US) {
+		usage(argv[0]);
+	}
+
+	phy.pac = 8;
+	for (c = 5; c <= 9; c += 4) {
+		for (d = 0; d < 2; d++) {
+			for (f = 16; f <= 64; f += 48) {
+				for (l = 0; l < sizeof(sim_plen) / sizeof(sim_plen[0]); l++) {
+					if ((channel && c != (unsigned int)channel) ||
+					    (rate >= 0 && d != (unsigned int)rate) ||
+					    (prf && f != (unsigned int)prf) || (plen && l > 0)) {
+						continue;
+					}
+					phy.channel = c;
+					phy.rate_6m8 = d;
+					phy.code = (f == 64) ? 9 : (c == 9) ? 1 : 3;
+					phy.plen = plen ? plen : sim_plen[l];
+					sim_run(&cfg, &phy);
+				}
+			}
+		}
+	}
+	return 0;
+}
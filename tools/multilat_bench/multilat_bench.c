@@ -0,0 +1,192 @@
+/*
+ * Accuracy and speed of the multilateration solver of
+ * examples/shared_data/multilat.c on a host
+ *
+ * For each anchor geometry, tags are placed at random in the area covered by
+ * the anchors, their ranges computed and disturbed by Gaussian noise and by
+ * an occasional NLOS bias, and the position solved. One line per geometry
+ * gives the position error (mean, 95th percentile, max), the mean RMS of the
+ * residuals of the solutions with and without an NLOS range, the mean number
+ * of Gauss-Newton iterations, the failures and the time per solution:
+ *
+ *   square2d  4 anchors at the corners of a 20 m square, 2D
+ *   line2d    4 anchors close to a line, 2D: poor geometry
+ *   ceiling   4 anchors at the corners of a 20 m square at 3 m, 3D
+ *   mixed     ceiling with 2 anchors lowered to 1 m, 3D
+ *   hall      8 anchors around a 40 x 20 m hall at 2 to 4 m, 3D
+ *
+ * Build from the repository root with
+ *   gcc -O2 -Iexamples/shared_data -o multilat_bench \
+ *       tools/multilat_bench/multilat_bench.c examples/shared_data/multilat.c -lm
+ * and run e.g. "./multilat_bench -s 100 -b 5 -n 10000".
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <multilat.h>
+
+#define BENCH_MAX_RUNS 100000
+
+struct bench_geom {
+	const char *name;
+	int dim;
+	unsigned int n;
+	multilat_anchor_t anchors[MULTILAT_MAX_ANCHORS];
+	int32_t z_mm; /* height of the tags in 3D */
+};
+
+static const struct bench_geom bench_geoms[] = {
+	{ "square2d", 2, 4, { { 1, 0, 0, 0 }, { 2, 2000, 0, 0 }, { 3, 2000, 2000, 0 }, { 4, 0, 2000, 0 } }, 0 },
+	{ "line2d", 2, 4, { { 1, 0, 0, 0 }, { 2, 700, 50, 0 }, { 3, 1400, 0, 0 }, { 4, 2000, 60, 0 } }, 0 },
+	{ "ceiling", 3, 4,
+	  { { 1, 0, 0, 300 }, { 2, 2000, 0, 300 }, { 3, 2000, 2000, 300 }, { 4, 0, 2000, 300 } },
+	  1000 },
+	{ "mixed", 3, 4,
+	  { { 1, 0, 0, 300 }, { 2, 2000, 0, 100 }, { 3, 2000, 2000, 300 }, { 4, 0, 2000, 100 } },
+	  1500 },
+	{ "hall", 3, 8,
+	  { { 1, 0, 0, 400 }, { 2, 2000, 0, 200 }, { 3, 4000, 0, 400 }, { 4, 4000, 1000, 200 },
+	    { 5, 4000, 2000, 400 }, { 6, 2000, 2000, 200 }, { 7, 0, 2000, 400 }, { 8, 0, 1000, 200 } },
+	  1200 },
+};
+
+static double bench_gauss(void)
+{
+	double u1 = (rand() + 1.0) / (RAND_MAX + 2.0), u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+	return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+	double da = *(const double *)a, db = *(const double *)b;
+
+	return (da > db) - (da < db);
+}
+
+static void bench_run(const struct bench_geom *g, unsigned int runs, double sigma_mm,
+		      unsigned int nlos_pct, double nlos_mm)
+{
+	static double err[BENCH_MAX_RUNS];
+	double x_max = 0, y_max = 0, sum = 0, rms_los = 0, rms_nlos = 0, ns;
+	unsigned long iters = 0;
+	unsigned int i, k, ok = 0, fails = 0, los = 0, nlos = 0;
+	struct timespec t0, t1, dt = { 0, 0 };
+
+	for (k = 0; k < g->n; k++) {
+		x_max = fmax(x_max, g->anchors[k].x_cm * 10.0);
+		y_max = fmax(y_max, g->anchors[k].y_cm * 10.0);
+	}
+
+	for (i = 0; i < runs; i++) {
+		int32_t range_mm[MULTILAT_MAX_ANCHORS];
+		double x = rand() * x_max / RAND_MAX, y = rand() * y_max / RAND_MAX;
+		double z = (g->dim == 3) ? g->z_mm : 0;
+		int biased = 0;
+		multilat_result_t res;
+
+		for (k = 0; k < g->n; k++) {
+			double dx = x - g->anchors[k].x_cm * 10.0, dy = y - g->anchors[k].y_cm * 10.0;
+			double dz = (g->dim == 3) ? z - g->anchors[k].z_cm * 10.0 : 0;
+			double r = sqrt(dx * dx + dy * dy + dz * dz) + sigma_mm * bench_gauss();
+
+			if ((unsigned int)(rand() % 100) < nlos_pct) {
+				r += nlos_mm;
+				biased = 1;
+			}
+			range_mm[k] = (int32_t)lrint(r);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		if (multilat_solve(g->anchors, range_mm, g->n, g->dim, &res) != 0) {
+			fails++;
+			continue;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		dt.tv_sec += t1.tv_sec - t0.tv_sec;
+		dt.tv_nsec += t1.tv_nsec - t0.tv_nsec;
+
+		err[ok] = sqrt((res.x_mm - x) * (res.x_mm - x) + (res.y_mm - y) * (res.y_mm - y) +
+			       (res.z_mm - z) * (res.z_mm - z));
+		sum += err[ok];
+		iters += res.iter;
+		if (biased) {
+			rms_nlos += res.rms_mm;
+			nlos++;
+		} else {
+			rms_los += res.rms_mm;
+			los++;
+		}
+		ok++;
+	}
+	if (ok == 0) {
+		printf("%-9s all %u solutions failed\n", g->name, fails);
+		return;
+	}
+
+	qsort(err, ok, sizeof(err[0]), bench_cmp);
+	ns = (dt.tv_sec * 1e9 + dt.tv_nsec) / ok;
+	printf("%-9s %uD n=%u err mean=%.0f p95=%.0f max=%.0f mm rms los=%.0f nlos=%.0f mm "
+	       "iter=%.1f fail=%u t=%.0f ns\n",
+	       g->name, (unsigned int)g->dim, g->n, sum / ok, err[(ok * 95) / 100], err[ok - 1],
+	       los ? rms_los / los : 0, nlos ? rms_nlos / nlos : 0, (double)iters / ok, fails, ns);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-g geometry] [-n runs] [-s sigma_mm] [-b nlos_pct] [-m nlos_mm]\n"
+		"       [-r seed]\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int runs = 10000, nlos_pct = 0, i;
+	double sigma_mm = 100, nlos_mm = 500;
+	const char *geom = NULL;
+	int opt;
+
+	srand(1);
+	while ((opt = getopt(argc, argv, "g:n:s:b:m:r:")) != -1) {
+		switch (opt) {
+		case 'g':
+			geom = optarg;
+			break;
+		case 'n':
+			runs = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			sigma_mm = atof(optarg);
+			break;
+		case 'b':
+			nlos_pct = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			nlos_mm = atof(optarg);
+			break;
+		case 'r':
+			srand(strtoul(optarg, NULL, 0));
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (runs == 0 || runs > BENCH_MAX_RUNS) {
+		usage(argv[0]);
+	}
+
+	for (i = 0; i < sizeof(bench_geoms) / sizeof(bench_geoms[0]); i++) {
+		if (!geom || strcmp(geom, bench_geoms[i].name) == 0) {
+			bench_run(&bench_geoms[i], runs, sigma_mm, nlos_pct, nlos_mm);
+		}
+	}
+	return 0;
+}
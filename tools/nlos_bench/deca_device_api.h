@@ -0,0 +1,49 @@
+/*
+ * Subset of the DW3000 driver API used by examples/shared_data/nlos.c, so
+ * that tools/nlos_bench builds on a host without the driver. The values
+ * follow deca_device_api.h of the driver.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NLOS_BENCH_DECA_DEVICE_API_H_
+#define NLOS_BENCH_DECA_DEVICE_API_H_
+
+#include <stdint.h>
+
+#define DWT_DW3000_DEV_ID      0xDECA0302
+#define DWT_DW3000_PDOA_DEV_ID 0xDECA0312
+
+#define DWT_STS_MODE_OFF 0x0
+#define DWT_PDOA_M0      0x0
+#define DWT_PDOA_M3      0x3
+
+typedef enum { IPATOV = 0x0, STS1 = 0x1, STS2 = 0x2 } dwt_diag_type_e;
+
+/* only the fields read by nlos.c */
+typedef struct {
+	uint8_t rxCode;
+	uint8_t stsMode;
+	uint8_t pdoaMode;
+} dwt_config_t;
+
+typedef struct {
+	uint32_t accumCount;
+	uint32_t F1;
+	uint32_t F2;
+	uint32_t F3;
+	uint32_t cir_power;
+	uint8_t D;
+	dwt_diag_type_e diag_type;
+	uint8_t result;
+} dwt_nlos_alldiag_t;
+
+typedef struct {
+	uint32_t index_fp_u32;
+	uint32_t index_pp_u32;
+} dwt_nlos_ipdiag_t;
+
+uint8_t dwt_nlos_alldiag(dwt_nlos_alldiag_t *all_diag);
+void dwt_nlos_ipdiag(dwt_nlos_ipdiag_t *index);
+
+#endif /* NLOS_BENCH_DECA_DEVICE_API_H_ */
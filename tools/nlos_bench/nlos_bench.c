@@ -0,0 +1,263 @@
+/*
+ * Accuracy and speed of the fixed point NLOS estimation of
+ * examples/shared_data/nlos.c on a host
+ *
+ * Compares nlos_10log10_q8() with the floating point 10 * log10() over the
+ * whole 64-bit range, then nlos_evaluate() with the floating point formulas
+ * it replaced (DW3000 User Manual 4.7.1 and 4.7.2, App Notes "APS006 PART 3")
+ * on random diagnostics: first path amplitudes, a CIR power giving an RSL -
+ * FSL difference from -2 to 16 dB, accumulated symbols, DGC decision, index
+ * difference, with Ipatov only, STS and STS in PDoA mode 3, 16 and 64 MHz PRF.
+ * Prints the maximum error of the logarithm, of the signal levels and of the
+ * probability, the time per estimation of both, and returns 1 if an error is
+ * above its limit (0.01 dB for the logarithm, see nlos.h, 1 % for the
+ * probability). The probability jumps at the 4.8 dB threshold, from the
+ * linear part to the index based one: the frames within LIMIT_EDGE_DB of a
+ * threshold, where the rounding of the levels can take the other branch, are
+ * counted apart.
+ *
+ * The driver header is replaced by the subset in this directory. Build from
+ * the repository root with
+ *   gcc -O2 -Itools/nlos_bench -Iexamples/shared_data -o nlos_bench \
+ *       tools/nlos_bench/nlos_bench.c examples/shared_data/nlos.c -lm
+ * and run e.g. "./nlos_bench -n 1000000".
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <deca_device_api.h>
+#include <nlos.h>
+
+/* Constants of the floating point formulas */
+#define REF_SIG_LVL_FACTOR    0.4
+#define REF_SIG_LVL_THRESHOLD 12.0
+#define REF_ALPHA_PRF_16      113.8
+#define REF_ALPHA_PRF_64      120.7
+#define REF_LOG_CONSTANT_C0   63.2
+#define REF_IP_MIN_THRESHOLD  3.3
+#define REF_IP_MAX_THRESHOLD  6.0
+#define REF_CONSTANT_PR_IP_A  0.39178
+#define REF_CONSTANT_PR_IP_B  1.31719
+
+#define LIMIT_LOG_DB   0.01
+#define LIMIT_PROB_PCT 1.0
+#define LIMIT_EDGE_DB  0.01
+
+struct ref_result {
+	double rsl[NLOS_NUM_CIR];
+	double fsl[NLOS_NUM_CIR];
+	double diff[NLOS_NUM_CIR]; /* RSL - FSL */
+	double prob;
+};
+
+static unsigned int seed = 1;
+
+/* nlos_read_input() is not used, the diagnostics are generated */
+uint8_t dwt_nlos_alldiag(dwt_nlos_alldiag_t *all_diag)
+{
+	(void)all_diag;
+	return 0;
+}
+
+void dwt_nlos_ipdiag(dwt_nlos_ipdiag_t *index)
+{
+	(void)index;
+}
+
+static double uniform(double lo, double hi)
+{
+	return lo + (hi - lo) * rand_r(&seed) / (double)RAND_MAX;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* The floating point estimation nlos.c used before, on the same inputs */
+static void ref_evaluate(const nlos_input_t *in, struct ref_result *res)
+{
+	double sl_diff[NLOS_NUM_CIR] = { 0 };
+	double index_diff;
+	int i;
+
+	for (i = 0; i < NLOS_NUM_CIR; i++) {
+		const nlos_cir_diag_t *c = &in->cir[i];
+		double alpha, n, f1, f2, f3;
+
+		res->rsl[i] = res->fsl[i] = NAN;
+		res->diff[i] = 0;
+		if (i >= in->num_cir) {
+			continue;
+		}
+		alpha = (i == 0 && !in->prf64) ? -REF_ALPHA_PRF_16 : -(REF_ALPHA_PRF_64 + 1);
+		n = (double)c->accum_count * c->accum_count;
+		f1 = c->f1 / 4;
+		f2 = c->f2 / 4;
+		f3 = c->f3 / 4;
+
+		res->rsl[i] = 10 * log10(c->cir_power / n) + alpha + REF_LOG_CONSTANT_C0 + c->d * 6;
+		res->fsl[i] = 10 * log10((f1 * f1 + f2 * f2 + f3 * f3) / n) + alpha + c->d * 6;
+		sl_diff[i] = res->diff[i] = res->rsl[i] - res->fsl[i];
+	}
+
+	for (i = 0; i < NLOS_NUM_CIR; i++) {
+		if (sl_diff[i] > REF_SIG_LVL_THRESHOLD) {
+			res->prob = 100;
+			return;
+		}
+	}
+	for (i = 0; i < NLOS_NUM_CIR; i++) {
+		if (sl_diff[i] > REF_SIG_LVL_THRESHOLD * REF_SIG_LVL_FACTOR) {
+			res->prob = 100 * ((sl_diff[i] / REF_SIG_LVL_THRESHOLD - REF_SIG_LVL_FACTOR) /
+					   (1 - REF_SIG_LVL_FACTOR));
+			return;
+		}
+	}
+
+	index_diff = ((double)in->index_pp - (double)in->index_fp) / 32;
+	if (index_diff <= REF_IP_MIN_THRESHOLD) {
+		res->prob = 0;
+	} else if (index_diff >= REF_IP_MAX_THRESHOLD) {
+		res->prob = 100;
+	} else {
+		res->prob = 100 * (REF_CONSTANT_PR_IP_A * index_diff - REF_CONSTANT_PR_IP_B);
+		if (res->prob < 0) {
+			res->prob = 0;
+		}
+	}
+}
+
+/* Random diagnostics, see the header comment */
+static void gen_input(nlos_input_t *in)
+{
+	int i;
+
+	in->num_cir = 1 + rand_r(&seed) % NLOS_NUM_CIR;
+	in->prf64 = rand_r(&seed) % 2;
+	in->dw3000 = 1;
+	in->index_fp = 700 * 32 + rand_r(&seed) % (16 * 32);
+	in->index_pp = in->index_fp + rand_r(&seed) % (8 * 32);
+
+	for (i = 0; i < in->num_cir; i++) {
+		nlos_cir_diag_t *c = &in->cir[i];
+		double fp_power, cir_power, diff;
+		uint32_t f1, f2, f3;
+
+		c->accum_count = (uint32_t)uniform(32, 1024);
+		c->d = rand_r(&seed) % 8;
+		c->f1 = (uint32_t)uniform(1 << 12, 1 << 20);
+		c->f2 = (uint32_t)uniform(1 << 12, 1 << 20);
+		c->f3 = (uint32_t)uniform(1 << 12, 1 << 20);
+
+		/* CIR power for an RSL - FSL difference across the thresholds */
+		f1 = c->f1 >> 2;
+		f2 = c->f2 >> 2;
+		f3 = c->f3 >> 2;
+		fp_power = (double)f1 * f1 + (double)f2 * f2 + (double)f3 * f3;
+		diff = uniform(-2, 16);
+		cir_power = fp_power * pow(10, (diff - REF_LOG_CONSTANT_C0) / 10);
+		c->cir_power = (cir_power < 1) ? 1 : (cir_power > 4e9) ? 4000000000U : (uint32_t)cir_power;
+	}
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-n runs] [-s seed]\n", prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	double max_log = 0, max_lvl = 0, max_prob = 0, sum_prob = 0, err;
+	unsigned long runs = 100000, edges = 0, i, bit;
+	volatile double sink_ref = 0;
+	volatile int sink_fix = 0;
+	uint64_t t0, t_fix = 0, t_ref = 0;
+	nlos_input_t in;
+	nlos_result_t res;
+	struct ref_result ref;
+	int opt, c;
+
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+		case 'n':
+			runs = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	/* logarithm: every power of 2 and random values in each octave */
+	for (bit = 0; bit < 64; bit++) {
+		for (i = 0; i < 1000; i++) {
+			uint64_t x = (1ULL << bit) |
+				     ((((uint64_t)rand_r(&seed) << 32) | rand_r(&seed)) & ((1ULL << bit) - 1));
+
+			err = fabs(nlos_10log10_q8(x) / 256.0 - 10 * log10((double)x));
+			if (err > max_log) {
+				max_log = err;
+			}
+		}
+	}
+
+	for (i = 0; i < runs; i++) {
+		gen_input(&in);
+
+		t0 = now_ns();
+		nlos_evaluate(&in, &res);
+		t_fix += now_ns() - t0;
+		sink_fix += res.prob_pct;
+
+		t0 = now_ns();
+		ref_evaluate(&in, &ref);
+		t_ref += now_ns() - t0;
+		sink_ref += ref.prob;
+
+		for (c = 0; c < in.num_cir; c++) {
+			err = fabs(res.rsl_q8[c] / 256.0 - ref.rsl[c]);
+			if (err > max_lvl) {
+				max_lvl = err;
+			}
+			err = fabs(res.fsl_q8[c] / 256.0 - ref.fsl[c]);
+			if (err > max_lvl) {
+				max_lvl = err;
+			}
+		}
+		err = fabs(res.prob_pct - ref.prob);
+		for (c = 0; c < in.num_cir; c++) {
+			if (fabs(ref.diff[c] - REF_SIG_LVL_THRESHOLD * REF_SIG_LVL_FACTOR) < LIMIT_EDGE_DB ||
+			    fabs(ref.diff[c] - REF_SIG_LVL_THRESHOLD) < LIMIT_EDGE_DB) {
+				break;
+			}
+		}
+		if (c < in.num_cir) {
+			edges++;
+			continue;
+		}
+		sum_prob += err;
+		if (err > max_prob) {
+			max_prob = err;
+		}
+	}
+
+	printf("10log10 max error %.4f dB\n", max_log);
+	printf("levels max error %.4f dB, probability mean error %.3f %% max %.3f %% (%lu runs, %lu at a threshold)\n",
+	       max_lvl, (runs > edges) ? sum_prob / (runs - edges) : 0.0, max_prob, runs, edges);
+	printf("time per estimation: fixed point %.0f ns, floating point %.0f ns\n",
+	       runs ? (double)t_fix / runs : 0.0, runs ? (double)t_ref / runs : 0.0);
+
+	return (max_log > LIMIT_LOG_DB || max_prob > LIMIT_PROB_PCT) ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+#
+# Convert the frames streamed by examples/ex_02j_sniffer/sniffer.c to pcap
+#
+# Reads the raw stream, e.g. as written by
+#   JLinkRTTLogger -Device NRF52832_XXAA -If SWD -Speed 4000 -RTTChannel 2 sniff.bin
+# and writes a pcap file with the IEEE 802.15.4 TAP link type, which Wireshark
+# dissects: each frame has a TAP header with the FCS type (none, the sniffer
+# strips it), the channel, the start of frame time and, when the stream has
+# the diagnostics, the received signal level. Bytes between records (e.g. text
+# lines when the stream shares the console UART) are skipped. The frames lost
+# by the sniffer are reported on stderr.
+#
+# The RX timestamps of the DW IC wrap every 17.2 s: frames further apart than
+# that are placed too early.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import argparse
+import math
+import struct
+import sys
+import time
+
+SYNC = 0xA5F1
+HDR = struct.Struct("<HBBHH5sB")
+DIAG = struct.Struct("<IIIIHHhBx")
+FLAG_DIAG = 0x01
+FRAME_MAX = 127
+
+TS_MASK = (1 << 40) - 1
+DTU_NS = 1e9 / (499.2e6 * 128)
+
+LINKTYPE_IEEE802_15_4_TAP = 283
+TAP_FCS_TYPE = 0
+TAP_RSS = 1
+TAP_CHANNEL = 3
+TAP_SOF_TS = 5
+TAP_CHANNEL_FREQ = 11
+TAP_FCS_NONE = 0
+UWB_PAGE = 4
+CHANNEL_MHZ = {5: 6489.6, 9: 7987.2}
+
+# Received signal level, see the DW3000 User Manual: A for the 64 MHz PRF, 10 * log10(2^21)
+RSL_A_PRF64 = 121.7
+RSL_A_PRF16 = 113.8
+RSL_K = 10 * math.log10(2 ** 21)
+
+
+def read_records(data):
+    pos = 0
+    while pos + HDR.size <= len(data):
+        sync, length, flags, seq, lost, ts, chan = HDR.unpack_from(data, pos)
+        if sync != SYNC or length > FRAME_MAX or flags & ~FLAG_DIAG:
+            pos += 1
+            continue
+        end = pos + HDR.size + (DIAG.size if flags & FLAG_DIAG else 0) + length
+        if end > len(data):
+            break
+        diag = DIAG.unpack_from(data, pos + HDR.size) if flags & FLAG_DIAG else None
+        frame = data[end - length : end]
+        pos = end
+        yield seq, lost, int.from_bytes(ts, "little"), chan, diag, frame
+
+
+def rsl_dbm(diag, a):
+    power, f1, f2, f3, n, fp_index, xtal, dgc = diag
+    if power == 0 or n == 0:
+        return None
+    return 10 * math.log10(power / (n * n)) + RSL_K + 6 * dgc - a
+
+
+def tlv(tlv_type, value):
+    pad = -len(value) & 3
+    return struct.pack("<HH", tlv_type, len(value)) + value + b"\0" * pad
+
+
+def tap_header(chan, sof_ns, rss):
+    tlvs = tlv(TAP_FCS_TYPE, bytes([TAP_FCS_NONE]))
+    tlvs += tlv(TAP_CHANNEL, struct.pack("<HB", chan, UWB_PAGE))
+    if chan in CHANNEL_MHZ:
+        tlvs += tlv(TAP_CHANNEL_FREQ, struct.pack("<f", CHANNEL_MHZ[chan] * 1000))
+    tlvs += tlv(TAP_SOF_TS, struct.pack("<Q", sof_ns))
+    if rss is not None:
+        tlvs += tlv(TAP_RSS, struct.pack("<f", rss))
+    return struct.pack("<BBH", 0, 0, 4 + len(tlvs)) + tlvs
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a sniffer stream to pcap (IEEE 802.15.4 TAP)")
+    parser.add_argument("input", help="raw stream of the sniffer")
+    parser.add_argument("output", help="pcap file to write")
+    parser.add_argument("--epoch", type=float, default=None, help="time of the first frame, seconds since 1970 (default: now)")
+    parser.add_argument("--prf16", action="store_true", help="16 MHz PRF (preamble codes 3 and 4), for the signal level")
+    args = parser.parse_args()
+
+    a = RSL_A_PRF16 if args.prf16 else RSL_A_PRF64
+    epoch_ns = int((time.time() if args.epoch is None else args.epoch) * 1e9)
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    frames = lost = gaps = 0
+    first = last = None
+    wraps = 0
+    last_seq = None
+    with open(args.output, "wb") as out:
+        # Nanosecond resolution pcap
+        out.write(struct.pack("<IHHiIII", 0xA1B23C4D, 2, 4, 0, 0, 65535, LINKTYPE_IEEE802_15_4_TAP))
+        for seq, rec_lost, ts, chan, diag, frame in read_records(data):
+            lost += rec_lost
+            if last_seq is not None and seq != (last_seq + 1) & 0xFFFF:
+                gaps += 1
+            last_seq = seq
+
+            if last is not None and ts < last:
+                wraps += 1
+            last = ts
+            dtu = wraps * (TS_MASK + 1) + ts
+            if first is None:
+                first = dtu
+            sof_ns = int((dtu - first) * DTU_NS)
+
+            rss = rsl_dbm(diag, a) if diag else None
+            pkt = tap_header(chan, sof_ns, rss) + frame
+            t = epoch_ns + sof_ns
+            out.write(struct.pack("<IIII", t // 1000000000, t % 1000000000, len(pkt), len(pkt)))
+            out.write(pkt)
+            frames += 1
+
+    sys.stderr.write("%d frames, %d lost by the sniffer, %d gaps in the record numbers\n" % (frames, lost, gaps))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+#
+# Decode the blink records streamed by examples/ex_23_tdoa/tdoa_anchor.c
+#
+# Reads the raw streams of the anchors, one file per anchor, e.g. as written by
+#   JLinkRTTLogger -Device NRF52832_XXAA -If SWD -Speed 4000 -RTTChannel 2 a0.bin
+# groups the records by tag ID and blink sequence number, and prints one line
+# per blink with the time difference of arrival of each anchor relative to the
+# reference anchor, in metres. Blinks not received by the reference anchor, and
+# timestamps not yet synchronised, are skipped.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import argparse
+import struct
+import sys
+
+SYNC = 0xAD0A
+REC = struct.Struct("<HBB8s5sBH")
+FLAG_SYNCED = 0x01
+TS_MASK = (1 << 40) - 1
+DTU_S = 1.0 / (499.2e6 * 128)
+C_M_S = 299702547.0
+MATCH_DTU = 639000  # 10 us, far more than the time differences of arrival and the synchronisation error
+
+
+def ts_diff(a, b):
+    d = (a - b) & TS_MASK
+    return d - (1 << 40) if d >= 1 << 39 else d
+
+
+def read_records(data):
+    pos = 0
+    while pos + REC.size <= len(data):
+        sync, anchor, seq, tag, ts, flags, rms = REC.unpack_from(data, pos)
+        if sync != SYNC:
+            pos += 1
+            continue
+        pos += REC.size
+        yield anchor, seq, tag, int.from_bytes(ts, "little"), flags, rms
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Time differences of arrival of the blinks from the TDoA anchors")
+    parser.add_argument("files", nargs="+", help="raw stream of each anchor")
+    args = parser.parse_args()
+
+    # The sequence numbers wrap every 256 blinks, and the anchors did not start at the same time: a record
+    # joins the blink of the same tag and sequence number whose synchronised timestamp is nearest, if
+    # within MATCH_DTU, so that the laps are the same for all streams.
+    blinks = []
+    by_seq = {}
+    anchors = set()
+    for name in args.files:
+        with open(name, "rb") as f:
+            for anchor, seq, tag, ts, flags, rms in read_records(f.read()):
+                if not flags & FLAG_SYNCED:
+                    continue
+                best = None
+                for blink in by_seq.get((tag, seq), []):
+                    d = abs(ts_diff(ts, blink["ts"]))
+                    if d <= MATCH_DTU and (best is None or d < best[0]):
+                        best = (d, blink)
+                if best is None:
+                    blink = {"tag": tag, "seq": seq, "ts": ts, "anchors": {}}
+                    by_seq.setdefault((tag, seq), []).append(blink)
+                    blinks.append(blink)
+                else:
+                    blink = best[1]
+                blink["anchors"][anchor] = ts
+                anchors.add(anchor)
+
+    anchors = sorted(a for a in anchors if a != 0)
+    sys.stdout.write("# tag seq " + " ".join("a%d-a0" % a for a in anchors) + " (m)\n")
+    for blink in blinks:
+        ts = blink["anchors"]
+        if 0 not in ts:
+            continue
+        cols = []
+        for a in anchors:
+            if a in ts:
+                cols.append("%8.3f" % (ts_diff(ts[a], ts[0]) * DTU_S * C_M_S))
+            else:
+                cols.append("%8s" % "-")
+        sys.stdout.write("%s %3d %s\n" % (blink["tag"].decode("ascii", "replace"), blink["seq"], " ".join(cols)))
+
+
+if __name__ == "__main__":
+    main()
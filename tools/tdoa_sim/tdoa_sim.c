@@ -0,0 +1,171 @@
+/*
+ * Accuracy of the TDoA clock synchronisation of examples/shared_data/tdoa_sync.c
+ *
+ * Simulates a reference anchor sending a sync beacon every period and one
+ * anchor whose clock runs with a drift and starts close to the 40-bit wrap of
+ * the device time. The anchor timestamps the beacons with Gaussian noise and
+ * feeds them to tdoa_sync_beacon(). Each
+ * blink, halfway between two beacons, is converted to the reference clock with
+ * tdoa_sync_convert() and compared with the exact time of its arrival in the
+ * reference clock. The blinks are timestamped without noise, so that the error
+ * is the one of the synchronisation, the noise of the blink timestamps adding
+ * to it on real anchors. Beacons can be lost, or received late (e.g. a reflected
+ * path) to exercise the outlier gate.
+ *
+ * Prints the beacons used, rejected and restarts, the blinks converted and the
+ * RMS and maximum conversion error in device time units (15.65 ps), and
+ * returns 1 if the maximum error is above the limit given with -m.
+ *
+ * Build from the repository root with
+ *   gcc -O2 -Iexamples/shared_data -o tdoa_sim \
+ *       tools/tdoa_sim/tdoa_sim.c examples/shared_data/tdoa_sync.c -lm
+ * and run e.g. "./tdoa_sim -p 20 -n 6 -t 60 -m 24".
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <tdoa_sync.h>
+
+#define SIM_DTU_PER_S   63897600000.0
+#define SIM_WRAP_DTU    1099511627776.0 /* 2^40 */
+#define SIM_REF_DIST_MM 12500           /* reference anchor to anchor */
+#define SIM_TAG_DIST_MM 7300            /* tag to anchor */
+#define SIM_LATE_DTU    20000           /* delay of a late beacon, about 300 ns */
+
+static double drift_ppm = 20;
+static double noise_dtu = 6;
+static double period_s = 0.1;
+static double duration_s = 60;
+static uint32_t loss_permille;
+static uint32_t late_permille;
+static unsigned int seed = 1;
+
+/* Gaussian noise of standard deviation noise_dtu */
+static double noise(void)
+{
+	double u1 = (rand_r(&seed) + 1.0) / (RAND_MAX + 2.0);
+	double u2 = (rand_r(&seed) + 1.0) / (RAND_MAX + 2.0);
+
+	return noise_dtu * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/* 40-bit device time of a clock, exact time t in seconds */
+static uint64_t dev_ts(double t, double ppm, double offset_dtu, double noise)
+{
+	double dtu = fmod(t * SIM_DTU_PER_S * (1.0 + ppm * 1e-6) + offset_dtu + noise, SIM_WRAP_DTU);
+
+	return (uint64_t)llround(dtu) & TDOA_TS_MASK;
+}
+
+/* Signed difference of two 40-bit timestamps */
+static int64_t ts_diff(uint64_t a, uint64_t b)
+{
+	int64_t d = (int64_t)((a - b) & TDOA_TS_MASK);
+
+	return (d & 0x8000000000LL) ? d - 0x10000000000LL : d;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-p drift_ppm] [-n noise_dtu] [-b beacon_period_ms] [-t duration_s]\n"
+		"          [-l loss_permille] [-o late_permille] [-m max_err_dtu] [-s seed]\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t ref_tof = TDOA_MM_TO_DTU(SIM_REF_DIST_MM);
+	double tag_tof_s = SIM_TAG_DIST_MM / 1000.0 / 299702547.0;
+	/* the anchor clock wraps a few seconds into the run, the reference one later */
+	double local_offset = SIM_WRAP_DTU - 3.0 * SIM_DTU_PER_S;
+	double ref_offset = SIM_WRAP_DTU - 11.0 * SIM_DTU_PER_S;
+	uint32_t blinks = 0, converted = 0, max_err = 0;
+	double sq = 0, limit = 0;
+	static tdoa_sync_t sync;
+	uint8_t seq = 0;
+	double t;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:n:b:t:l:o:m:s:")) != -1) {
+		switch (opt) {
+		case 'p':
+			drift_ppm = strtod(optarg, NULL);
+			break;
+		case 'n':
+			noise_dtu = strtod(optarg, NULL);
+			break;
+		case 'b':
+			period_s = strtod(optarg, NULL) / 1000.0;
+			break;
+		case 't':
+			duration_s = strtod(optarg, NULL);
+			break;
+		case 'l':
+			loss_permille = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			late_permille = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			limit = strtod(optarg, NULL);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	tdoa_sync_init(&sync);
+
+	for (t = 0; t < duration_s; t += period_s) {
+		uint64_t ref_tx, local_rx, local_blink, ref_blink, conv;
+		double late = 0, tb;
+		int64_t err;
+
+		/* beacon: sent at t by the reference, received ref_tof later by the anchor */
+		seq++;
+		if ((uint32_t)(rand_r(&seed) % 1000) >= loss_permille) {
+			if ((uint32_t)(rand_r(&seed) % 1000) < late_permille) {
+				late = SIM_LATE_DTU;
+			}
+			ref_tx = dev_ts(t, 0, ref_offset, 0);
+			local_rx = dev_ts(t + ref_tof / SIM_DTU_PER_S, drift_ppm, local_offset, noise() + late);
+			tdoa_sync_beacon(&sync, seq, ref_tx, ref_tof, local_rx);
+		}
+
+		/* blink halfway to the next beacon, sent at tb by the tag */
+		tb = t + period_s / 2;
+		blinks++;
+		local_blink = dev_ts(tb + tag_tof_s, drift_ppm, local_offset, 0);
+		if (tdoa_sync_convert(&sync, local_blink, &conv)) {
+			continue;
+		}
+		ref_blink = dev_ts(tb + tag_tof_s, 0, ref_offset, 0);
+		err = ts_diff(conv, ref_blink);
+		if (err < 0) {
+			err = -err;
+		}
+		if ((uint32_t)err > max_err) {
+			max_err = (uint32_t)err;
+		}
+		sq += (double)err * err;
+		converted++;
+	}
+
+	printf("beacons %lu lost %lu rejected %lu restarts %lu drift %.3f ppm (fitted %.3f)\n",
+	       (unsigned long)sync.beacons, (unsigned long)sync.lost, (unsigned long)sync.rejected,
+	       (unsigned long)sync.restarts, drift_ppm, sync.drift_q32 / 4294.967296);
+	printf("blinks %lu converted %lu error rms %.1f max %lu DTU (%.0f ps)\n",
+	       (unsigned long)blinks, (unsigned long)converted,
+	       converted ? sqrt(sq / converted) : 0.0, (unsigned long)max_err, max_err * 15.65);
+
+	return (limit > 0 && max_err > limit) ? 1 : 0;
+}
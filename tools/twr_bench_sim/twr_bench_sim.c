@@ -0,0 +1,407 @@
+/*
+ * Simulated radio for the ranging benchmark of examples/shared_data/twr_bench.c
+ *
+ * Runs the benchmark initiator and responder in two processes of a Linux
+ * host, as the engine keeps its state in static variables, talking through a
+ * simulated ether in shared memory. Device time follows the host monotonic
+ * clock, so the turnaround and late transmission figures reflect the real
+ * CPU time of the host, and the air time of the frames is the one modelled
+ * by uwb_phy_airtime_us(). A frame is received if the receiver was enabled
+ * before its preamble started, with the same preset and variant, and is not
+ * dropped by the configured loss rate. A delayed transmission is late if its
+ * preamble would have started in the past.
+ *
+ * Build from the repository root with
+ *   gcc -O2 -DBINLOG_ENABLED=0 -Iexamples/shared_data -Iplatform -o twr_bench_sim \
+ *       tools/twr_bench_sim/twr_bench_sim.c examples/shared_data/twr_bench.c \
+ *       examples/shared_data/range_stats.c platform/uwb_phy.c -lpthread -lm
+ * and run e.g. "./twr_bench_sim -r 500 -t 10 -l 5 -p 10 | grep '^{'".
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <twr_bench.h>
+
+#define SIM_DTU_PER_NS   63.8976
+#define SIM_DTU_MASK     0xFFFFFFFFFFULL
+#define SIM_TX_START_NS  10000 /* immediate transmission to start of preamble */
+#define SIM_UUS_NS       1026
+#define SIM_ETHER_FRAMES 8
+
+struct sim_frame {
+	uint32_t id;
+	int sender;
+	twr_bench_preset_t preset;
+	twr_bench_variant_e variant;
+	uint8_t data[TWR_BENCH_FRAME_LEN];
+	uint16_t len;
+	uint64_t start_ns;   /* start of the preamble at the sender */
+	uint64_t rmarker_ns;
+	uint64_t end_ns;
+};
+
+struct sim_node {
+	int index;
+	double ppm;
+	int64_t offset_ns;
+	twr_bench_preset_t preset;
+	twr_bench_variant_e variant;
+	uint32_t last_id;      /* frames up to this one were seen or missed */
+	int rx_armed;
+	uint64_t rx_start_ns;
+	uint64_t rx_deadline_ns; /* 0 for no timeout */
+	uint64_t tx_end_ns;
+	uint64_t tx_ts;
+	uint64_t rx_ts;
+	uint32_t wait_us;
+	unsigned int seed;
+};
+
+struct sim_ether {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct sim_frame frame[SIM_ETHER_FRAMES];
+	uint32_t next_id;
+};
+
+static struct sim_ether *ether;
+static struct sim_node nodes[2];
+static struct sim_node *self;
+static uint32_t tof_ns = 10;
+static uint32_t loss_permille;
+static double drift_ppm;
+
+void test_run_info(unsigned char *data)
+{
+	printf("%s\n", data);
+	fflush(stdout);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t t)
+{
+	struct timespec ts = { .tv_sec = t / 1000000000ULL, .tv_nsec = t % 1000000000ULL };
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL))
+		;
+}
+
+/* device time of a node, in DTU, at a host time */
+static uint64_t dev_time(const struct sim_node *n, uint64_t t_ns)
+{
+	double dtu = ((double)t_ns + n->offset_ns) * SIM_DTU_PER_NS * (1.0 + n->ppm * 1e-6);
+
+	return (uint64_t)dtu & SIM_DTU_MASK;
+}
+
+/* host time of a device time, taken as the closest one to now */
+static uint64_t host_time(const struct sim_node *n, uint64_t dtu, uint64_t now)
+{
+	int64_t delta = (int64_t)((dtu - dev_time(n, now)) << 24) >> 24;
+
+	double ns = delta / (SIM_DTU_PER_NS * (1.0 + n->ppm * 1e-6));
+
+	return now + (int64_t)(ns < 0 ? ns - 0.5 : ns + 0.5);
+}
+
+static int sim_configure(const twr_bench_preset_t *preset, twr_bench_variant_e variant)
+{
+	self->preset = *preset;
+	self->variant = variant;
+	self->rx_armed = 0;
+	return TWR_BENCH_OK;
+}
+
+static int sim_send(uint8_t *frame, uint16_t len, uint32_t tx_time, uint32_t rx_after_tx_uus,
+		    uint32_t rx_timeout_uus)
+{
+	uint16_t air_len = len + ((self->variant == TWR_BENCH_SS_TWR_AES) ? TWR_BENCH_AES_OVERHEAD : 0);
+	int sts = TWR_BENCH_VARIANT_STS(self->variant);
+	uint32_t preamble_us, air_us;
+	uint64_t now = now_ns();
+	struct sim_frame *f;
+
+	air_us = uwb_phy_airtime_us(&self->preset.phy, sts, air_len, &preamble_us);
+
+	pthread_mutex_lock(&ether->lock);
+	f = &ether->frame[ether->next_id % SIM_ETHER_FRAMES];
+	if (tx_time) {
+		/* the antenna delay is added to the programmed time, as by the DW IC */
+		uint64_t tx_dtu = (((uint64_t)(tx_time & 0xFFFFFFFEUL)) << 8) + TWR_BENCH_ANT_DLY;
+
+		f->rmarker_ns = host_time(self, tx_dtu, now);
+		if (f->rmarker_ns < now + preamble_us * 1000ULL) {
+			self->rx_armed = 0;
+			pthread_mutex_unlock(&ether->lock);
+			return TWR_BENCH_LATE;
+		}
+		f->start_ns = f->rmarker_ns - preamble_us * 1000ULL;
+		self->tx_ts = tx_dtu & SIM_DTU_MASK;
+	} else {
+		f->start_ns = now + SIM_TX_START_NS;
+		f->rmarker_ns = f->start_ns + preamble_us * 1000ULL;
+		self->tx_ts = dev_time(self, f->rmarker_ns);
+	}
+	f->end_ns = f->start_ns + air_us * 1000ULL;
+	f->id = ++ether->next_id;
+	f->sender = self->index;
+	f->preset = self->preset;
+	f->variant = self->variant;
+	memcpy(f->data, frame, len);
+	f->len = len;
+	self->tx_end_ns = f->end_ns;
+	self->last_id = f->id;
+
+	self->rx_armed = (rx_timeout_uus != 0);
+	if (self->rx_armed) {
+		self->rx_start_ns = f->end_ns + (uint64_t)rx_after_tx_uus * SIM_UUS_NS;
+		self->rx_deadline_ns = self->rx_start_ns + (uint64_t)rx_timeout_uus * SIM_UUS_NS;
+	}
+	pthread_cond_broadcast(&ether->cond);
+	pthread_mutex_unlock(&ether->lock);
+	return TWR_BENCH_OK;
+}
+
+static void sim_wait_tx_done(void)
+{
+	uint64_t start = now_ns();
+
+	if (self->tx_end_ns > start) {
+		sleep_until_ns(self->tx_end_ns);
+	}
+	self->wait_us += (now_ns() - start) / 1000;
+}
+
+/* next frame the receiver picks up, or NULL; called with the ether locked */
+static struct sim_frame *sim_find_frame(void)
+{
+	struct sim_frame *f;
+	uint32_t id;
+
+	for (id = self->last_id + 1; id <= ether->next_id; id++) {
+		f = &ether->frame[(id - 1) % SIM_ETHER_FRAMES];
+		self->last_id = id;
+		if (f->id != id || f->sender == self->index || f->variant != self->variant ||
+		    memcmp(&f->preset, &self->preset, sizeof(f->preset))) {
+			continue;
+		}
+		if (f->start_ns + tof_ns < self->rx_start_ns) {
+			continue;
+		}
+		if (self->rx_deadline_ns && f->rmarker_ns + tof_ns > self->rx_deadline_ns) {
+			continue;
+		}
+		if ((uint32_t)(rand_r(&self->seed) % 1000) < loss_permille) {
+			continue;
+		}
+		return f;
+	}
+	return NULL;
+}
+
+static int sim_receive(uint8_t *buf, uint16_t size, uint32_t timeout_uus)
+{
+	uint64_t start = now_ns();
+	struct sim_frame *f, copy;
+	struct timespec ts;
+	int len = TWR_BENCH_TIMEOUT;
+
+	if (!self->rx_armed) {
+		self->rx_start_ns = start;
+		self->rx_deadline_ns = timeout_uus ? start + (uint64_t)timeout_uus * SIM_UUS_NS : 0;
+	}
+	self->rx_armed = 0;
+
+	pthread_mutex_lock(&ether->lock);
+	while (1) {
+		f = sim_find_frame();
+		if (f != NULL) {
+			copy = *f;
+			break;
+		}
+		if (self->rx_deadline_ns && now_ns() >= self->rx_deadline_ns) {
+			break;
+		}
+		if (self->rx_deadline_ns) {
+			ts.tv_sec = self->rx_deadline_ns / 1000000000ULL;
+			ts.tv_nsec = self->rx_deadline_ns % 1000000000ULL;
+			pthread_cond_timedwait(&ether->cond, &ether->lock, &ts);
+		} else {
+			pthread_cond_wait(&ether->cond, &ether->lock);
+		}
+	}
+	pthread_mutex_unlock(&ether->lock);
+
+	if (f != NULL) {
+		sleep_until_ns(copy.end_ns + tof_ns);
+		self->rx_ts = dev_time(self, copy.rmarker_ns + tof_ns);
+		len = (copy.len <= size) ? copy.len : TWR_BENCH_ERROR;
+		if (len > 0) {
+			memcpy(buf, copy.data, copy.len);
+		}
+	} else if (self->rx_deadline_ns) {
+		sleep_until_ns(self->rx_deadline_ns);
+	}
+	self->wait_us += (now_ns() - start) / 1000;
+	return len;
+}
+
+static uint64_t sim_tx_timestamp(void)
+{
+	return self->tx_ts;
+}
+
+static uint64_t sim_rx_timestamp(void)
+{
+	return self->rx_ts;
+}
+
+/* clock offset of the other node in parts per 2^26, positive if it is faster */
+static int16_t sim_clock_offset(void)
+{
+	double ppm = nodes[!self->index].ppm - self->ppm;
+
+	return (int16_t)(ppm * 1e-6 * (1 << 26));
+}
+
+static uint32_t sim_sys_time(void)
+{
+	return (uint32_t)(dev_time(self, now_ns()) >> 8);
+}
+
+static uint32_t sim_time_us(void)
+{
+	return (uint32_t)(now_ns() / 1000);
+}
+
+static uint32_t sim_take_wait_us(void)
+{
+	uint32_t w = self->wait_us;
+
+	self->wait_us = 0;
+	return w;
+}
+
+static void sim_sleep_ms(uint32_t ms)
+{
+	usleep(ms * 1000);
+}
+
+static void sim_sleep_until_us(uint32_t t_us)
+{
+	uint64_t now = now_ns();
+	int32_t dt = (int32_t)(t_us - (uint32_t)(now / 1000));
+
+	if (dt > 0) {
+		sleep_until_ns(now + dt * 1000ULL);
+	}
+}
+
+static const twr_bench_radio_t sim_radio = {
+	.configure = sim_configure,
+	.send = sim_send,
+	.wait_tx_done = sim_wait_tx_done,
+	.receive = sim_receive,
+	.tx_timestamp = sim_tx_timestamp,
+	.rx_timestamp = sim_rx_timestamp,
+	.clock_offset = sim_clock_offset,
+	.sys_time = sim_sys_time,
+	.time_us = sim_time_us,
+	.take_wait_us = sim_take_wait_us,
+	.sleep_ms = sim_sleep_ms,
+	.sleep_until_us = sim_sleep_until_us,
+};
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-r run_ms] [-t tof_ns] [-l loss_permille] [-p responder_ppm]\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t run_ms = TWR_BENCH_RUN_MS;
+	pthread_mutexattr_t mattr;
+	pthread_condattr_t cattr;
+	pid_t responder;
+	int opt, ret;
+
+	while ((opt = getopt(argc, argv, "r:t:l:p:")) != -1) {
+		switch (opt) {
+		case 'r':
+			run_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			tof_ns = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			loss_permille = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			drift_ppm = strtod(optarg, NULL);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	/* the ether is shared by both processes, receive timeouts are on the monotonic clock */
+	ether = mmap(NULL, sizeof(*ether), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (ether == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	pthread_mutexattr_init(&mattr);
+	pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+	pthread_mutex_init(&ether->lock, &mattr);
+	pthread_condattr_init(&cattr);
+	pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+	pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+	pthread_cond_init(&ether->cond, &cattr);
+
+	/* the responder clock is offset by an arbitrary amount and drifts */
+	nodes[0].index = 0;
+	nodes[0].seed = 1;
+	nodes[1].index = 1;
+	nodes[1].ppm = drift_ppm;
+	nodes[1].offset_ns = 123456789;
+	nodes[1].seed = 2;
+
+	fflush(stdout);
+	responder = fork();
+	if (responder < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (responder == 0) {
+		self = &nodes[1];
+		return twr_bench_run_responder(&sim_radio);
+	}
+
+	self = &nodes[0];
+	ret = twr_bench_run_initiator(&sim_radio, run_ms);
+	if (ret == 0) {
+		waitpid(responder, NULL, 0);
+	} else {
+		kill(responder, SIGTERM);
+	}
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+#
+# Capacity of one SS-TWR responder serving several initiators
+#
+# Discrete event simulation of N initiators polling one responder
+# periodically, with random phases and jitter, as the SS TWR initiator
+# example does. The air time of the poll and response frames follows the
+# model of platform/uwb_phy.c (NOTE 1). Three responders are compared:
+#
+#   event    examples/ex_06b_ss_twr_responder/ss_twr_responder_evt.c, the
+#            DW IC turns the receiver on at the end of the response
+#   polling  ss_twr_responder.c, the host waits for the end of the response
+#            and turns the receiver on again
+#   sleep    ds_twr_responder_sts.c, the host sleeps for most of the
+#            ranging period of the initiator after each exchange
+#
+# A poll is lost when it overlaps another frame (collision), when the
+# responder is not listening (busy) or when the response cannot be
+# programmed within the response delay (late). A response is lost when a
+# poll of another initiator overlaps it. For each number of initiators the
+# offered polls, completed exchanges per second and the losses are printed.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import argparse
+import bisect
+import random
+
+SYMBOL_NS = 1018
+SFD_SYMBOLS = 8
+PHR_BITS = 21
+BIT_850K_NS = 1026
+BIT_6M8_NS = 128
+RS_BLOCK_BITS = 330
+RS_PARITY_BITS = 48
+UUS_NS = 1026
+
+POLL_LEN = 12
+RESP_LEN = 20
+
+
+def airtime_us(plen, rate_6m8, length):
+    """Air time of a frame and time to its RMARKER, in us (uwb_phy_airtime_us())"""
+    pre_ns = (plen + SFD_SYMBOLS) * SYMBOL_NS
+    bits = length * 8
+    bits += (bits + RS_BLOCK_BITS - 1) // RS_BLOCK_BITS * RS_PARITY_BITS
+    ns = pre_ns + PHR_BITS * BIT_850K_NS + bits * (BIT_6M8_NS if rate_6m8 else BIT_850K_NS)
+    return ns / 1000.0, pre_ns / 1000.0
+
+
+class Sim:
+    def __init__(self, args, mode, n):
+        self.a = args
+        self.mode = mode
+        self.n = n
+        self.rng = random.Random(args.seed)
+        self.poll_air, self.poll_pre = airtime_us(args.plen, not args.rate_850k, POLL_LEN)
+        self.resp_air, self.resp_pre = airtime_us(args.plen, not args.rate_850k, RESP_LEN)
+        self.resp_dly = args.resp_dly_uus * UUS_NS / 1000.0
+        self.period = args.period_ms * 1000.0
+        self.stats = dict(polls=0, ok=0, collision=0, busy=0, late=0, resp_lost=0)
+
+    def schedule(self):
+        """Start times of all polls, sorted"""
+        a = self.a
+        end = a.time_s * 1e6
+        starts = []
+        for i in range(self.n):
+            t = self.rng.uniform(0, self.period)
+            while t < end:
+                starts.append(t)
+                t += self.period + self.rng.uniform(-a.jitter_us, a.jitter_us)
+        starts.sort()
+        return starts
+
+    def latency(self):
+        """Time from the end of the poll to the call of dwt_starttx()"""
+        a = self.a
+        if self.mode == "event":
+            lat = a.isr_us + (self.rng.expovariate(1.0 / a.isr_jitter_us) if a.isr_jitter_us else 0.0)
+        else:
+            lat = a.poll_loop_us * self.rng.random()
+        return lat + a.proc_us
+
+    def run(self):
+        a = self.a
+        s = self.stats
+        starts = self.schedule()
+        # latest time at which the response must be programmed, after the end of the poll
+        deadline = self.resp_dly - (self.poll_air - self.poll_pre) - self.resp_pre - a.tx_margin_us
+        listen_at = 0.0
+
+        for k, t in enumerate(starts):
+            s["polls"] += 1
+            if t < listen_at:
+                s["busy"] += 1
+                continue
+            # the receiver is on, the poll is lost if any other frame overlaps it
+            if (k > 0 and starts[k - 1] > t - self.poll_air) or \
+                    (k + 1 < len(starts) and starts[k + 1] < t + self.poll_air):
+                s["collision"] += 1
+                continue
+            rx_end = t + self.poll_air
+            lat = self.latency()
+            if lat > deadline:
+                # the transmission is abandoned and the receiver turned on again
+                s["late"] += 1
+                listen_at = rx_end + lat + (a.rearm_us if self.mode != "event" else 0.0)
+                continue
+            tx = t + self.poll_pre + self.resp_dly - self.resp_pre
+            tx_end = tx + self.resp_air
+            listen_at = tx_end
+            if self.mode == "polling":
+                listen_at += a.rearm_us
+            elif self.mode == "sleep":
+                listen_at += a.sleep_ms * 1000.0
+            # the initiator misses the response if another poll overlaps it
+            j = bisect.bisect_right(starts, tx - self.poll_air)
+            if j < len(starts) and starts[j] < tx_end:
+                s["resp_lost"] += 1
+            else:
+                s["ok"] += 1
+        return s
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.split("\n")[1] if __doc__ else None)
+    p.add_argument("-m", "--mode", choices=["event", "polling", "sleep", "all"], default="all")
+    p.add_argument("-n", "--initiators", default="1,2,4,8,16,32,64,128,256",
+                   help="comma separated numbers of initiators")
+    p.add_argument("--period-ms", type=float, default=100.0, help="ranging period of each initiator")
+    p.add_argument("--jitter-us", type=float, default=1000.0, help="random jitter of the period")
+    p.add_argument("--time-s", type=float, default=20.0, help="simulated time")
+    p.add_argument("--plen", type=int, default=128, help="preamble length in symbols")
+    p.add_argument("--rate-850k", action="store_true", help="850 kbps instead of 6.8 Mbps")
+    p.add_argument("--resp-dly-uus", type=float, default=650.0, help="POLL_RX_TO_RESP_TX_DLY_UUS")
+    p.add_argument("--tx-margin-us", type=float, default=20.0, help="dwt_starttx() margin before the TX time")
+    p.add_argument("--proc-us", type=float, default=250.0,
+                   help="SPI and CPU time from reading the poll to dwt_starttx()")
+    p.add_argument("--isr-us", type=float, default=40.0, help="interrupt to callback latency (event)")
+    p.add_argument("--isr-jitter-us", type=float, default=20.0,
+                   help="mean of the exponential extra callback latency (event)")
+    p.add_argument("--poll-loop-us", type=float, default=10.0, help="status polling interval (polling, sleep)")
+    p.add_argument("--rearm-us", type=float, default=30.0,
+                   help="host time to see the TX end and enable RX (polling, sleep)")
+    p.add_argument("--sleep-ms", type=float, default=None,
+                   help="sleep after each exchange (sleep), default period - 10 ms")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+    if args.sleep_ms is None:
+        args.sleep_ms = max(args.period_ms - 10.0, 0.0)
+
+    poll_air, _ = airtime_us(args.plen, not args.rate_850k, POLL_LEN)
+    resp_air, _ = airtime_us(args.plen, not args.rate_850k, RESP_LEN)
+    print("poll %.1f us, response %.1f us, response delay %.1f us, period %.1f ms" %
+          (poll_air, resp_air, args.resp_dly_uus * UUS_NS / 1000.0, args.period_ms))
+
+    modes = ["event", "polling", "sleep"] if args.mode == "all" else [args.mode]
+    for mode in modes:
+        print()
+        print("%-8s %5s %9s %9s %7s %9s %6s %6s %9s" %
+              ("mode", "n", "polls/s", "xchg/s", "ok%", "collision", "busy", "late", "resp lost"))
+        for n in [int(x) for x in args.initiators.split(",")]:
+            s = Sim(args, mode, n).run()
+            polls = max(s["polls"], 1)
+            print("%-8s %5d %9.1f %9.1f %7.1f %9d %6d %6d %9d" %
+                  (mode, n, s["polls"] / args.time_s, s["ok"] / args.time_s, 100.0 * s["ok"] / polls,
+                   s["collision"], s["busy"], s["late"], s["resp_lost"]))
+
+
+if __name__ == "__main__":
+    main()